@@ -322,6 +322,7 @@ void CGameAISystem::UpdateSubSystems(float frameTime)
 	m_AICounters.Update( frameTime );
 	m_AISquadManager.Update(frameTime);
 	m_environmentDisturbanceManager.Update();
+	m_shipSteeringManager.Update(frameTime);
 	m_advantagePointOccupancyControl.Update();
 }
 
@@ -333,6 +334,7 @@ void CGameAISystem::ResetSubSystems(bool bUnload)
 	m_AICounters.Reset( bUnload );
 	m_AISquadManager.Reset();
 	m_environmentDisturbanceManager.Reset();
+	m_shipSteeringManager.Reset(bUnload);
 
 	if (bUnload)
 	{
@@ -14,6 +14,7 @@
 #include "AISquadManager.h"
 #include "EnvironmentDisturbanceManager.h"
 #include "AICorpse.h"
+#include "ShipSteeringManager.h"
 
 class CGameAISystem
 {
@@ -40,6 +41,7 @@ public:
 	CAICounters& GetAICounters() { return m_AICounters; }
 	AISquadManager& GetAISquadManager() { return m_AISquadManager; }
 	GameAI::EnvironmentDisturbanceManager& GetEnvironmentDisturbanceManager() { return m_environmentDisturbanceManager; }
+	CShipSteeringManager& GetShipSteeringManager() { return m_shipSteeringManager; }
 
 #ifdef INCLUDE_GAME_AI_RECORDER
 	CGameAIRecorder &GetGameAIRecorder() { return m_gameAIRecorder; }
@@ -71,6 +73,7 @@ private:
 	CTargetTrackThreatModifier m_targetTrackThreatModifier;
 	AISquadManager m_AISquadManager;
 	GameAI::EnvironmentDisturbanceManager m_environmentDisturbanceManager;
+	CShipSteeringManager m_shipSteeringManager;
 	State m_state;
 
 	CAICorpseManager* m_pCorpsesManager;
@@ -0,0 +1,1122 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Shared steering for AI ships
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#include "StdAfx.h"
+#include "CryUnitTest.h"
+#include "ShipSteeringManager.h"
+#include "GameCVars.h"
+#include "Utility/CryWatch.h"
+#include "Utility/BenchmarkTimer.h"
+#include <algorithm>
+
+namespace
+{
+	// Neighbours counter clockwise from +x, opposite directions are 4 apart
+	const int kNeighbourX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+	const int kNeighbourY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+	const float kNeighbourCost[8] = { 1.f, 1.41421356f, 1.f, 1.41421356f, 1.f, 1.41421356f, 1.f, 1.41421356f };
+	const Vec2 kNeighbourDir[8] =
+	{
+		Vec2(1.f, 0.f), Vec2(0.70710678f, 0.70710678f), Vec2(0.f, 1.f), Vec2(-0.70710678f, 0.70710678f),
+		Vec2(-1.f, 0.f), Vec2(-0.70710678f, -0.70710678f), Vec2(0.f, -1.f), Vec2(0.70710678f, -0.70710678f),
+	};
+
+	const int kGridSamplesPerFrame = 8192;
+	const int kGoalReuseCells = 8;				// ships heading this close to each other's goal share a field
+	const int kDirectCells = 10;					// this close to the goal ships head straight for it, before a shared field takes them elsewhere
+	const int kHashBuckets = 1024;				// power of two
+	const float kAvoidanceMargin = 2.f;	// on the sum of the radii
+	const float kAvoidanceWeight = 2.f;
+	const float kMinSpeedScale = 0.2f;		// ships giving way to each other never stop completely
+	const int kShoreCells = 3;						// routes keep this many cells off the shore where they can
+	const float kShoreCost = 1.f;					// extra cost of a cell right next to land, less further out
+
+	bool IsLevelNavigable(float x, float y, float draft, void* pUser)
+	{
+		const float terrainZ = gEnv->p3DEngine->GetTerrainElevation(x, y);
+		const Vec3 pos(x, y, terrainZ);
+
+		// no water reports a level far below the terrain
+		return gEnv->p3DEngine->GetWaterLevel(&pos) - terrainZ >= draft;
+	}
+
+	int GetCellDistance(int cellA, int cellB, int width)
+	{
+		return max(abs(cellA % width - cellB % width), abs(cellA / width - cellB / width));
+	}
+
+	// Pushes away from a disc passed closer than minDist within the horizon, returns how pressing that is
+	float AvoidDisc(const Vec2& relPos, const Vec2& relVel, float minDist, float horizon, Vec2& avoid)
+	{
+		const float speedSq = relVel.GetLength2();
+		const float distSq = relPos.GetLength2();
+		if (distSq > sqr(minDist + sqrt_tpl(speedSq) * horizon))
+			return 0.f;
+
+		// already too close, whatever the velocities: ships sailing side by side close in too slowly for the
+		// closest approach to tell
+		if (distSq < sqr(minDist))
+		{
+			const float dist = sqrt_tpl(distSq);
+			const float threat = 1.f - dist / minDist;
+			avoid += ((dist > 0.01f) ? relPos * (-1.f / dist) : Vec2(1.f, 0.f)) * threat;
+			return threat;
+		}
+
+		// the other's position relative to ours at the closest approach
+		const float t = (speedSq > 0.0001f) ? clamp(relPos.Dot(relVel) / speedSq, 0.f, horizon) : 0.f;
+		const Vec2 closest = relPos - relVel * t;
+		const float closestDist = closest.GetLength();
+		if (closestDist >= minDist)
+			return 0.f;
+
+		Vec2 away;
+		if (closestDist > 0.01f * minDist)
+		{
+			away = closest * (-1.f / closestDist);
+		}
+		else
+		{
+			// head on, give way to starboard
+			const float relSpeed = sqrt_tpl(speedSq);
+			away = (relSpeed > 0.01f) ? Vec2(relVel.y, -relVel.x) * (1.f / relSpeed) : Vec2(1.f, 0.f);
+		}
+
+		const float threat = (1.f - t / horizon) * (1.f - closestDist / minDist);
+		avoid += away * threat;
+		return threat;
+	}
+}
+
+//------------------------------------------------------------------------
+CShipSteeringManager::CShipSteeringManager()
+: m_levelGrid(false)
+, m_numAgents(0)
+, m_hashCellSize(64.f)
+, m_invHashCellSize(1.f / 64.f)
+, m_frame(0)
+, m_numFieldBuilds(0)
+, m_numExpansions(0)
+, m_numPairTests(0)
+, m_updateMs(0.f)
+{
+	m_hashHeads.resize(kHashBuckets, -1);
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::Reset(bool bUnload)
+{
+	// handles given out so far go stale, ships register again
+	for (size_t i = 0, count = m_agents.size(); i < count; ++i)
+	{
+		m_agents[i].used = false;
+		++m_agents[i].salt;
+	}
+	for (size_t i = 0, count = m_obstacles.size(); i < count; ++i)
+	{
+		m_obstacles[i].used = false;
+		++m_obstacles[i].salt;
+	}
+
+	m_freeAgents.clear();
+	m_freeObstacles.clear();
+	for (int i = (int)m_agents.size() - 1; i >= 0; --i)
+		m_freeAgents.push_back(i);
+	for (int i = (int)m_obstacles.size() - 1; i >= 0; --i)
+		m_freeObstacles.push_back(i);
+	m_numAgents = 0;
+
+	for (int i = 0; i < kMaxFlowFields; ++i)
+		m_fields[i] = SFlowField();
+	m_build.field = -1;
+	m_numFieldBuilds = 0;
+
+	// the terrain may have changed in the editor
+	if (m_levelGrid || bUnload)
+	{
+		m_grid = SGrid();
+		m_levelGrid = false;
+	}
+	else if (m_grid.IsInitialized())
+	{
+		std::fill(m_grid.obstacles.begin(), m_grid.obstacles.end(), 0);
+		++m_grid.revision;
+	}
+
+	if (bUnload)
+	{
+		stl::free_container(m_agents);
+		stl::free_container(m_freeAgents);
+		stl::free_container(m_obstacles);
+		stl::free_container(m_freeObstacles);
+		stl::free_container(m_build.cost);
+		stl::free_container(m_build.dirs);
+		stl::free_container(m_build.open);
+	}
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::InitGrid(const Vec2& origin, float size, float cellSize, float draft, TNavigableFunc navigableFunc, void* pUser)
+{
+	const int numCellsPerSide = clamp((int)ceilf(size / cellSize), 1, 2048);
+	const int numCells = numCellsPerSide * numCellsPerSide;
+
+	m_grid.width = numCellsPerSide;
+	m_grid.height = numCellsPerSide;
+	m_grid.cellSize = cellSize;
+	m_grid.invCellSize = 1.f / cellSize;
+	m_grid.draft = draft;
+	m_grid.origin = origin;
+	m_grid.water.assign(numCells, 0);
+	m_grid.obstacles.assign(numCells, 0);
+	m_grid.shore.clear();
+	m_grid.numSampled = 0;
+	m_grid.pNavigableFunc = navigableFunc;
+	m_grid.pUser = pUser;
+	++m_grid.revision;
+
+	for (int i = 0; i < kMaxFlowFields; ++i)
+		m_fields[i] = SFlowField();
+	m_build.field = -1;
+
+	for (int i = 0, count = (int)m_agents.size(); i < count; ++i)
+		m_agents[i].field = -1;
+
+	for (size_t i = 0, count = m_obstacles.size(); i < count; ++i)
+	{
+		if (m_obstacles[i].used)
+			RasteriseObstacle(m_obstacles[i], 1);
+	}
+
+	m_levelGrid = false;
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::InitLevelGrid()
+{
+	const int terrainSize = gEnv->p3DEngine->GetTerrainSize();
+	if (terrainSize <= 0)
+		return;
+
+	InitGrid(Vec2(0.f, 0.f), (float)terrainSize, max(g_pGameCVars->ai_shipSteeringCellSize, 1.f), g_pGameCVars->ai_shipSteeringDraft, &IsLevelNavigable, NULL);
+	m_levelGrid = true;
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::SampleGrid(int budget)
+{
+	SGrid& grid = m_grid;
+	const int end = min(grid.numSampled + budget, grid.width * grid.height);
+
+	for (int cell = grid.numSampled; cell < end; ++cell)
+	{
+		const float x = grid.origin.x + ((cell % grid.width) + 0.5f) * grid.cellSize;
+		const float y = grid.origin.y + ((cell / grid.width) + 0.5f) * grid.cellSize;
+		grid.water[cell] = grid.pNavigableFunc(x, y, grid.draft, grid.pUser) ? 1 : 0;
+	}
+
+	grid.numSampled = end;
+
+	if (grid.IsComplete())
+	{
+		ComputeShoreDistance();
+	}
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::ComputeShoreDistance()
+{
+	SGrid& grid = m_grid;
+	const int width = grid.width;
+	const int height = grid.height;
+
+	// cells to the nearest land, counted diagonally as well and capped, in a forward and a backward sweep
+	const uint8 far = (uint8)(kShoreCells + 1);
+	grid.shore.resize(width * height);
+	for (int cell = 0, numCells = width * height; cell < numCells; ++cell)
+		grid.shore[cell] = grid.water[cell] ? far : 0;
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			uint8& shore = grid.shore[y * width + x];
+			if (x > 0)
+				shore = min(shore, (uint8)(grid.shore[y * width + x - 1] + 1));
+			if (y > 0)
+			{
+				for (int dx = max(x - 1, 0); dx <= min(x + 1, width - 1); ++dx)
+					shore = min(shore, (uint8)(grid.shore[(y - 1) * width + dx] + 1));
+			}
+		}
+	}
+
+	for (int y = height - 1; y >= 0; --y)
+	{
+		for (int x = width - 1; x >= 0; --x)
+		{
+			uint8& shore = grid.shore[y * width + x];
+			if (x < width - 1)
+				shore = min(shore, (uint8)(grid.shore[y * width + x + 1] + 1));
+			if (y < height - 1)
+			{
+				for (int dx = max(x - 1, 0); dx <= min(x + 1, width - 1); ++dx)
+					shore = min(shore, (uint8)(grid.shore[(y + 1) * width + dx] + 1));
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::RasteriseObstacle(const SObstacle& obstacle, int delta)
+{
+	SGrid& grid = m_grid;
+
+	// every cell the disc reaches into
+	const float radius = obstacle.radius + 0.5f * grid.cellSize;
+	const int x0 = max(0, (int)floorf((obstacle.centre.x - radius - grid.origin.x) * grid.invCellSize));
+	const int y0 = max(0, (int)floorf((obstacle.centre.y - radius - grid.origin.y) * grid.invCellSize));
+	const int x1 = min(grid.width - 1, (int)floorf((obstacle.centre.x + radius - grid.origin.x) * grid.invCellSize));
+	const int y1 = min(grid.height - 1, (int)floorf((obstacle.centre.y + radius - grid.origin.y) * grid.invCellSize));
+
+	for (int y = y0; y <= y1; ++y)
+	{
+		for (int x = x0; x <= x1; ++x)
+		{
+			const Vec2 cellCentre(grid.origin.x + (x + 0.5f) * grid.cellSize, grid.origin.y + (y + 0.5f) * grid.cellSize);
+			if ((cellCentre - obstacle.centre).GetLength2() <= sqr(radius))
+			{
+				grid.obstacles[y * grid.width + x] += delta;
+			}
+		}
+	}
+
+	++grid.revision;
+}
+
+//------------------------------------------------------------------------
+int CShipSteeringManager::GetCell(const Vec2& pos) const
+{
+	const int x = clamp((int)floorf((pos.x - m_grid.origin.x) * m_grid.invCellSize), 0, m_grid.width - 1);
+	const int y = clamp((int)floorf((pos.y - m_grid.origin.y) * m_grid.invCellSize), 0, m_grid.height - 1);
+
+	return y * m_grid.width + x;
+}
+
+//------------------------------------------------------------------------
+const CShipSteeringManager::SAgent* CShipSteeringManager::FindAgent(TAgentId id) const
+{
+	const int index = GetIndex(id);
+	if (index < 0 || index >= (int)m_agents.size())
+		return NULL;
+
+	const SAgent& agent = m_agents[index];
+	return (agent.used && agent.salt == GetSalt(id)) ? &agent : NULL;
+}
+
+//------------------------------------------------------------------------
+CShipSteeringManager::TAgentId CShipSteeringManager::AddAgent()
+{
+	int index;
+	if (!m_freeAgents.empty())
+	{
+		index = m_freeAgents.back();
+		m_freeAgents.pop_back();
+	}
+	else
+	{
+		index = (int)m_agents.size();
+		m_agents.push_back(SAgent());
+	}
+
+	CRY_ASSERT(index < 0xffff);
+
+	SAgent& agent = m_agents[index];
+	const uint16 salt = agent.salt + 1;
+	agent = SAgent();
+	agent.salt = salt;
+	agent.used = true;
+	++m_numAgents;
+
+	return MakeId(index, salt);
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::RemoveAgent(TAgentId id)
+{
+	if (SAgent* pAgent = FindAgent(id))
+	{
+		pAgent->used = false;
+		m_freeAgents.push_back(GetIndex(id));
+		--m_numAgents;
+	}
+}
+
+//------------------------------------------------------------------------
+bool CShipSteeringManager::SetAgentState(TAgentId id, const SAgentState& state)
+{
+	SAgent* pAgent = FindAgent(id);
+	if (!pAgent)
+		return false;
+
+	pAgent->state = state;
+	return true;
+}
+
+//------------------------------------------------------------------------
+bool CShipSteeringManager::GetSteering(TAgentId id, SSteering& steering) const
+{
+	const SAgent* pAgent = FindAgent(id);
+	if (!pAgent)
+		return false;
+
+	steering = pAgent->steering;
+	return steering.valid;
+}
+
+//------------------------------------------------------------------------
+CShipSteeringManager::TObstacleId CShipSteeringManager::AddObstacle(const Vec3& centre, float radius)
+{
+	int index;
+	if (!m_freeObstacles.empty())
+	{
+		index = m_freeObstacles.back();
+		m_freeObstacles.pop_back();
+	}
+	else
+	{
+		index = (int)m_obstacles.size();
+		m_obstacles.push_back(SObstacle());
+	}
+
+	SObstacle& obstacle = m_obstacles[index];
+	obstacle.centre.set(centre.x, centre.y);
+	obstacle.radius = radius;
+	obstacle.used = true;
+	++obstacle.salt;
+
+	if (m_grid.IsInitialized())
+		RasteriseObstacle(obstacle, 1);
+
+	return MakeId(index, obstacle.salt);
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::RemoveObstacle(TObstacleId id)
+{
+	const int index = GetIndex(id);
+	if (index < 0 || index >= (int)m_obstacles.size())
+		return;
+
+	SObstacle& obstacle = m_obstacles[index];
+	if (!obstacle.used || obstacle.salt != GetSalt(id))
+		return;
+
+	if (m_grid.IsInitialized())
+		RasteriseObstacle(obstacle, -1);
+
+	obstacle.used = false;
+	m_freeObstacles.push_back(index);
+}
+
+//------------------------------------------------------------------------
+bool CShipSteeringManager::MoveObstacle(TObstacleId id, const Vec3& centre, float radius)
+{
+	const int index = GetIndex(id);
+	if (index < 0 || index >= (int)m_obstacles.size())
+		return false;
+
+	SObstacle& obstacle = m_obstacles[index];
+	if (!obstacle.used || obstacle.salt != GetSalt(id))
+		return false;
+
+	if (obstacle.centre.x == centre.x && obstacle.centre.y == centre.y && obstacle.radius == radius)
+		return true;
+
+	if (m_grid.IsInitialized())
+		RasteriseObstacle(obstacle, -1);
+
+	obstacle.centre.set(centre.x, centre.y);
+	obstacle.radius = radius;
+
+	if (m_grid.IsInitialized())
+		RasteriseObstacle(obstacle, 1);
+
+	return true;
+}
+
+//------------------------------------------------------------------------
+int CShipSteeringManager::AcquireField(int goalCell)
+{
+	int best = -1;
+	int bestDistance = kGoalReuseCells + 1;
+	for (int i = 0; i < kMaxFlowFields; ++i)
+	{
+		if (m_fields[i].goalCell >= 0)
+		{
+			const int distance = GetCellDistance(m_fields[i].goalCell, goalCell, m_grid.width);
+			if (distance < bestDistance)
+			{
+				best = i;
+				bestDistance = distance;
+			}
+		}
+	}
+
+	if (best >= 0)
+		return best;
+
+	// a free slot, otherwise the one unused for longest. With every field in use the ship heads straight
+	// for its goal until one frees up, rather than evicting fields that are still being followed
+	int slot = 0;
+	for (int i = 0; i < kMaxFlowFields; ++i)
+	{
+		if (m_fields[i].goalCell < 0)
+		{
+			slot = i;
+			break;
+		}
+
+		if (m_fields[i].lastUsed < m_fields[slot].lastUsed)
+			slot = i;
+	}
+
+	if (m_fields[slot].goalCell >= 0 && m_fields[slot].lastUsed == m_frame)
+		return -1;
+
+	if (m_build.field == slot)
+		m_build.field = -1;
+
+	SFlowField& field = m_fields[slot];
+	field.goalCell = goalCell;
+	field.ready = false;
+	field.lastUsed = m_frame;
+
+	return slot;
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::StartBuild()
+{
+	// fields nobody has yet come first, then outdated ones by how recently they were used
+	int next = -1;
+	for (int i = 0; i < kMaxFlowFields; ++i)
+	{
+		const SFlowField& field = m_fields[i];
+		if (field.goalCell < 0 || (field.ready && field.revision == m_grid.revision))
+			continue;
+
+		if (next < 0 || (!field.ready && m_fields[next].ready) || (field.ready == m_fields[next].ready && field.lastUsed > m_fields[next].lastUsed))
+			next = i;
+	}
+
+	if (next < 0)
+		return;
+
+	const int numCells = m_grid.width * m_grid.height;
+	const int goalCell = m_fields[next].goalCell;
+
+	m_build.field = next;
+	m_build.revision = m_grid.revision;
+	m_build.cost.assign(numCells, FLT_MAX);
+	m_build.dirs.assign(numCells, kNoPath);
+	m_build.open.clear();
+
+	m_build.cost[goalCell] = 0.f;
+	m_build.dirs[goalCell] = kAtGoal;
+
+	SOpenNode node;
+	node.cost = 0.f;
+	node.cell = goalCell;
+	m_build.open.push_back(node);
+
+	++m_numFieldBuilds;
+}
+
+//------------------------------------------------------------------------
+int CShipSteeringManager::ContinueBuild(int budget)
+{
+	// Dijkstra outwards from the goal, each cell points back the way it was reached
+	const SGrid& grid = m_grid;
+	const int width = grid.width;
+	const int height = grid.height;
+	std::vector<float>& cost = m_build.cost;
+	std::vector<uint8>& dirs = m_build.dirs;
+	std::vector<SOpenNode>& open = m_build.open;
+
+	int expansions = 0;
+	while (!open.empty() && expansions < budget)
+	{
+		std::pop_heap(open.begin(), open.end());
+		const SOpenNode node = open.back();
+		open.pop_back();
+
+		if (node.cost > cost[node.cell])
+			continue;
+
+		++expansions;
+
+		const int x = node.cell % width;
+		const int y = node.cell / width;
+		for (int k = 0; k < 8; ++k)
+		{
+			const int nx = x + kNeighbourX[k];
+			const int ny = y + kNeighbourY[k];
+			if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+				continue;
+
+			const int neighbour = ny * width + nx;
+			if (!grid.IsNavigable(neighbour))
+				continue;
+
+			// no cutting corners past land
+			if ((k & 1) && (!grid.IsNavigable(y * width + nx) || !grid.IsNavigable(ny * width + x)))
+				continue;
+
+			const float shoreCost = kShoreCost * max(0, kShoreCells + 1 - grid.shore[neighbour]) * (1.f / kShoreCells);
+			const float neighbourCost = node.cost + kNeighbourCost[k] + shoreCost;
+			if (neighbourCost < cost[neighbour])
+			{
+				cost[neighbour] = neighbourCost;
+				dirs[neighbour] = (uint8)((k + 4) & 7);
+
+				SOpenNode next;
+				next.cost = neighbourCost;
+				next.cell = neighbour;
+				open.push_back(next);
+				std::push_heap(open.begin(), open.end());
+			}
+		}
+	}
+
+	if (open.empty())
+	{
+		SFlowField& field = m_fields[m_build.field];
+		field.dirs.swap(dirs);
+		field.revision = m_build.revision;
+		field.ready = true;
+		m_build.field = -1;
+	}
+
+	m_numExpansions += expansions;
+	return expansions;
+}
+
+//------------------------------------------------------------------------
+bool CShipSteeringManager::SampleField(const SFlowField& field, const Vec2& pos, Vec2& dir) const
+{
+	const SGrid& grid = m_grid;
+
+	// blend the four cells around pos, cells without a path don't take part
+	const float fx = (pos.x - grid.origin.x) * grid.invCellSize - 0.5f;
+	const float fy = (pos.y - grid.origin.y) * grid.invCellSize - 0.5f;
+	const int x0 = (int)floorf(fx);
+	const int y0 = (int)floorf(fy);
+	const float tx = fx - x0;
+	const float ty = fy - y0;
+
+	Vec2 sum(ZERO);
+	float weight = 0.f;
+	for (int j = 0; j < 2; ++j)
+	{
+		for (int i = 0; i < 2; ++i)
+		{
+			const int x = x0 + i;
+			const int y = y0 + j;
+			if (x < 0 || y < 0 || x >= grid.width || y >= grid.height)
+				continue;
+
+			const uint8 d = field.dirs[y * grid.width + x];
+			if (d >= 8)
+				continue;
+
+			const float w = (i ? tx : 1.f - tx) * (j ? ty : 1.f - ty);
+			sum += kNeighbourDir[d] * w;
+			weight += w;
+		}
+	}
+
+	const float length = sum.GetLength();
+	if (weight < 0.25f || length < 0.01f)
+		return false;
+
+	dir = sum * (1.f / length);
+	return true;
+}
+
+//------------------------------------------------------------------------
+uint32 CShipSteeringManager::GetHashBucket(int x, int y) const
+{
+	return ((uint32)x * 73856093u ^ (uint32)y * 19349663u) & (kHashBuckets - 1);
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::BuildSpatialHash()
+{
+	// buckets wide enough that every agent one can close in on within the horizon is in the 3x3 around it
+	const float horizon = max(g_pGameCVars->ai_shipSteeringAvoidTime, 0.1f);
+	float maxRadius = 1.f;
+	float maxSpeed = 0.f;
+	for (size_t i = 0, count = m_agents.size(); i < count; ++i)
+	{
+		if (m_agents[i].used)
+		{
+			maxRadius = max(maxRadius, m_agents[i].state.radius);
+			maxSpeed = max(maxSpeed, m_agents[i].state.maxSpeed);
+		}
+	}
+
+	m_hashCellSize = 2.f * maxRadius * kAvoidanceMargin + 2.f * maxSpeed * horizon;
+	m_invHashCellSize = 1.f / m_hashCellSize;
+
+	std::fill(m_hashHeads.begin(), m_hashHeads.end(), -1);
+	for (int i = 0, count = (int)m_agents.size(); i < count; ++i)
+	{
+		SAgent& agent = m_agents[i];
+		if (agent.used)
+		{
+			const uint32 bucket = GetHashBucket((int)floorf(agent.state.pos.x * m_invHashCellSize), (int)floorf(agent.state.pos.y * m_invHashCellSize));
+			agent.next = m_hashHeads[bucket];
+			m_hashHeads[bucket] = i;
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::ComputeSteering(SAgent& agent)
+{
+	const SAgentState& state = agent.state;
+	SSteering& steering = agent.steering;
+
+	if (!state.hasGoal)
+	{
+		steering.valid = false;
+		return;
+	}
+
+	const Vec2 pos(state.pos.x, state.pos.y);
+	const Vec2 toGoal(state.goal.x - pos.x, state.goal.y - pos.y);
+	const float goalDistance = toGoal.GetLength();
+
+	Vec2 dir = (goalDistance > 0.01f) ? toGoal * (1.f / goalDistance) : Vec2(1.f, 0.f);
+	if (agent.field >= 0)
+	{
+		const SFlowField& field = m_fields[agent.field];
+		Vec2 flowDir;
+		if (field.ready && SampleField(field, pos, flowDir))
+			dir = flowDir;
+	}
+
+	// closest approach to the ships and obstacles around
+	const float horizon = max(g_pGameCVars->ai_shipSteeringAvoidTime, 0.1f);
+	const Vec2 prefVel = dir * fabsf(state.desiredSpeed);
+	Vec2 avoid(ZERO);
+	float speedScale = 1.f;
+
+	const int hx = (int)floorf(pos.x * m_invHashCellSize);
+	const int hy = (int)floorf(pos.y * m_invHashCellSize);
+	uint32 buckets[9];
+	int numBuckets = 0;
+	for (int dy = -1; dy <= 1; ++dy)
+	{
+		for (int dx = -1; dx <= 1; ++dx)
+		{
+			// neighbouring cells can share a bucket
+			const uint32 bucket = GetHashBucket(hx + dx, hy + dy);
+			if (std::find(buckets, buckets + numBuckets, bucket) == buckets + numBuckets)
+				buckets[numBuckets++] = bucket;
+		}
+	}
+
+	for (int b = 0; b < numBuckets; ++b)
+	{
+		for (int i = m_hashHeads[buckets[b]]; i >= 0; i = m_agents[i].next)
+		{
+			const SAgent& other = m_agents[i];
+			if (&other == &agent)
+				continue;
+
+			++m_numPairTests;
+
+			const Vec2 relPos(other.state.pos.x - pos.x, other.state.pos.y - pos.y);
+			const Vec2 relVel(prefVel.x - other.state.vel.x, prefVel.y - other.state.vel.y);
+			const float minDist = (state.radius + other.state.radius) * kAvoidanceMargin;
+			const float threat = AvoidDisc(relPos, relVel, minDist, horizon, avoid);
+
+			// only the ones ahead hold us back. Of two ships abeam, merging into the same route, the later
+			// registered one falls in astern
+			const float ahead = relPos.Dot(dir);
+			if (threat > 0.f && (ahead > 0.f || (ahead > -0.5f * minDist && &other < &agent)))
+				speedScale = min(speedScale, 1.f - threat);
+		}
+	}
+
+	for (size_t i = 0, count = m_obstacles.size(); i < count; ++i)
+	{
+		const SObstacle& obstacle = m_obstacles[i];
+		if (obstacle.used)
+		{
+			const Vec2 relPos = obstacle.centre - pos;
+			const float threat = AvoidDisc(relPos, prefVel, state.radius * kAvoidanceMargin + obstacle.radius, horizon, avoid);
+			if (threat > 0.f && relPos.Dot(dir) > 0.f)
+				speedScale = min(speedScale, 1.f - threat);
+		}
+	}
+
+	// giving way must not put the ship on the shore the route keeps it off
+	const Vec2 steer = dir + avoid * kAvoidanceWeight;
+	const float steerLength = steer.GetLength();
+	if (steerLength > 0.01f)
+	{
+		const Vec2 steerDir = steer * (1.f / steerLength);
+		if (!m_grid.IsComplete() || m_grid.IsNavigable(GetCell(pos + steerDir * (state.radius + m_grid.cellSize))))
+			dir = steerDir;
+	}
+
+	steering.dir.Set(dir.x, dir.y, 0.f);
+	steering.speedScale = max(speedScale, kMinSpeedScale);
+	steering.valid = true;
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::Update(float frameTime)
+{
+	if (m_numAgents == 0)
+		return;
+
+	FUNCTION_PROFILER(GetISystem(), PROFILE_AI);
+
+	const CTimeValue start = gEnv->pTimer->GetAsyncTime();
+
+	++m_frame;
+	m_numExpansions = 0;
+	m_numPairTests = 0;
+
+	if (!m_grid.IsInitialized())
+		InitLevelGrid();
+
+	if (m_grid.IsInitialized() && !m_grid.IsComplete())
+		SampleGrid(kGridSamplesPerFrame);
+
+	const bool gridComplete = m_grid.IsComplete();
+
+	// the field each agent follows, close to the goal they head straight there
+	for (size_t i = 0, count = m_agents.size(); i < count; ++i)
+	{
+		SAgent& agent = m_agents[i];
+		if (!agent.used)
+			continue;
+
+		const SAgentState& state = agent.state;
+		if (!gridComplete || !state.hasGoal || Vec2(state.goal.x - state.pos.x, state.goal.y - state.pos.y).GetLength2() < sqr(kDirectCells * m_grid.cellSize))
+		{
+			agent.field = -1;
+			continue;
+		}
+
+		const int goalCell = GetCell(Vec2(state.goal.x, state.goal.y));
+		if (agent.field < 0 || m_fields[agent.field].goalCell < 0 || GetCellDistance(m_fields[agent.field].goalCell, goalCell, m_grid.width) > kGoalReuseCells)
+			agent.field = AcquireField(goalCell);
+
+		if (agent.field >= 0)
+			m_fields[agent.field].lastUsed = m_frame;
+	}
+
+	if (gridComplete)
+	{
+		int budget = max(g_pGameCVars->ai_shipSteeringBudget, 1);
+		while (budget > 0)
+		{
+			if (m_build.field < 0)
+			{
+				StartBuild();
+				if (m_build.field < 0)
+					break;
+			}
+
+			budget -= max(ContinueBuild(budget), 1);
+		}
+	}
+
+	BuildSpatialHash();
+
+	for (size_t i = 0, count = m_agents.size(); i < count; ++i)
+	{
+		if (m_agents[i].used)
+			ComputeSteering(m_agents[i]);
+	}
+
+	m_updateMs = (gEnv->pTimer->GetAsyncTime() - start).GetMilliSeconds();
+
+	if (g_pGameCVars->ai_shipSteeringDebug)
+	{
+		UpdateDebug();
+	}
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::UpdateDebug() const
+{
+	int numReady = 0;
+	int numOutdated = 0;
+	for (int i = 0; i < kMaxFlowFields; ++i)
+	{
+		if (m_fields[i].ready)
+		{
+			++numReady;
+			if (m_fields[i].revision != m_grid.revision)
+				++numOutdated;
+		}
+	}
+
+	const int numCells = m_grid.width * m_grid.height;
+	CryWatch("ShipSteering: %d agents, %d obstacles, grid %dx%d %.0f%% sampled, %.3f ms", m_numAgents, (int)(m_obstacles.size() - m_freeObstacles.size()),
+		m_grid.width, m_grid.height, numCells ? 100.f * m_grid.numSampled / numCells : 0.f, m_updateMs);
+	CryWatch("ShipSteering: %d of %d flow fields ready, %d outdated, %d built since reset, %d cells expanded, %d ship pairs tested",
+		numReady, (int)kMaxFlowFields, numOutdated, m_numFieldBuilds, m_numExpansions, m_numPairTests);
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->Add(*this);
+	pSizer->AddContainer(m_grid.water);
+	pSizer->AddContainer(m_grid.obstacles);
+	pSizer->AddContainer(m_grid.shore);
+	for (int i = 0; i < kMaxFlowFields; ++i)
+		pSizer->AddContainer(m_fields[i].dirs);
+	pSizer->AddContainer(m_build.cost);
+	pSizer->AddContainer(m_build.dirs);
+	pSizer->AddContainer(m_build.open);
+	pSizer->AddContainer(m_agents);
+	pSizer->AddContainer(m_freeAgents);
+	pSizer->AddContainer(m_obstacles);
+	pSizer->AddContainer(m_freeObstacles);
+	pSizer->AddContainer(m_hashHeads);
+}
+
+//------------------------------------------------------------------------
+namespace
+{
+	// 2 km of sea, an island in the middle everyone has to pass and a few smaller ones
+	const float kBenchWorldSize = 2048.f;
+
+	struct SBenchIsland
+	{
+		float x, y, radius;
+	};
+
+	const SBenchIsland kBenchIslands[] =
+	{
+		{ 1024.f, 1024.f, 250.f },
+		{ 600.f, 1400.f, 120.f },
+		{ 1450.f, 650.f, 140.f },
+		{ 1400.f, 1450.f, 90.f },
+		{ 650.f, 620.f, 100.f },
+	};
+
+	bool IsBenchOnLand(float x, float y)
+	{
+		for (int i = 0; i < (int)ARRAY_COUNT(kBenchIslands); ++i)
+		{
+			if (sqr(x - kBenchIslands[i].x) + sqr(y - kBenchIslands[i].y) < sqr(kBenchIslands[i].radius))
+				return true;
+		}
+
+		return false;
+	}
+
+	bool IsBenchNavigable(float x, float y, float draft, void* pUser)
+	{
+		return !IsBenchOnLand(x, y);
+	}
+
+	struct SBenchShip
+	{
+		CShipSteeringManager::TAgentId id;
+		Vec2 pos;
+		Vec2 goal;
+		float heading;
+		float speed;
+		bool arrived;
+		bool grounded;
+	};
+
+	struct SBenchResult
+	{
+		CBenchmarkTimer timer;
+		int collisions;
+		int grounded;
+		int arrived;
+	};
+
+	// Four fleets sailing across the archipelago, shared by the benchmark and the unit tests
+	void RunBenchmarkPass(int numShips, int numFrames, bool steered, SBenchResult& result)
+	{
+		const float dt = 1.f / 30.f;
+		const float radius = 12.f;
+		const float maxSpeed = 12.f;
+		const float desiredSpeed = 10.f;
+		const float turnRate = 0.35f;
+		const float accel = 2.f;
+		const float arriveDistance = 20.f;
+
+		CShipSteeringManager manager;
+		manager.InitGrid(Vec2(0.f, 0.f), kBenchWorldSize, max(g_pGameCVars->ai_shipSteeringCellSize, 1.f), 2.f, &IsBenchNavigable, NULL);
+
+		// four fleets in columns of four, from each side of the map to the opposite one
+		const Vec2 fleetStart[4] = { Vec2(150.f, 1024.f), Vec2(1900.f, 1024.f), Vec2(1024.f, 150.f), Vec2(1024.f, 1900.f) };
+		std::vector<SBenchShip> ships(numShips);
+		for (int i = 0; i < numShips; ++i)
+		{
+			const int fleet = i % 4;
+			const int slot = i / 4;
+			const Vec2 start = fleetStart[fleet];
+			const Vec2 goal = fleetStart[fleet ^ 1];
+			const Vec2 forward = (goal - start).GetNormalized();
+			const Vec2 side(forward.y, -forward.x);
+			const Vec2 offset = side * ((slot % 4) * 40.f - 60.f) - forward * ((slot / 4) * 40.f);
+
+			SBenchShip& ship = ships[i];
+			ship.id = manager.AddAgent();
+			ship.pos = start + offset;
+			ship.goal = goal + offset;
+			ship.heading = atan2_tpl(forward.y, forward.x);
+			ship.speed = 0.f;
+			ship.arrived = false;
+			ship.grounded = false;
+		}
+
+		std::vector<uint8> inContact(numShips * numShips, 0);
+		CShipSteeringManager::TObstacleId obstacle = CShipSteeringManager::kInvalidId;
+
+		result.timer = CBenchmarkTimer();
+		result.collisions = 0;
+
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			// something drops anchor across the fleets' way for a third of the run
+			if (frame == numFrames / 3)
+				obstacle = manager.AddObstacle(Vec3(1024.f, 1500.f, 0.f), 60.f);
+			else if (frame == 2 * numFrames / 3)
+				manager.RemoveObstacle(obstacle);
+
+			result.timer.Start();
+
+			for (int i = 0; i < numShips; ++i)
+			{
+				const SBenchShip& ship = ships[i];
+				CShipSteeringManager::SAgentState state;
+				state.pos.Set(ship.pos.x, ship.pos.y, 0.f);
+				state.vel.Set(cos_tpl(ship.heading) * ship.speed, sin_tpl(ship.heading) * ship.speed, 0.f);
+				state.goal.Set(ship.goal.x, ship.goal.y, 0.f);
+				state.radius = radius;
+				state.maxSpeed = maxSpeed;
+				state.desiredSpeed = desiredSpeed;
+				state.hasGoal = !ship.arrived;
+				manager.SetAgentState(ship.id, state);
+			}
+
+			if (steered)
+				manager.Update(dt);
+
+			CShipSteeringManager::SSteering steering;
+			for (int i = 0; i < numShips; ++i)
+			{
+				SBenchShip& ship = ships[i];
+				if (ship.arrived)
+				{
+					ship.speed = max(0.f, ship.speed - accel * dt);
+				}
+				else
+				{
+					Vec2 dir = (ship.goal - ship.pos).GetNormalized();
+					float speedScale = 1.f;
+					if (manager.GetSteering(ship.id, steering))
+					{
+						dir.set(steering.dir.x, steering.dir.y);
+						speedScale = steering.speedScale;
+					}
+
+					float turn = atan2_tpl(dir.y, dir.x) - ship.heading;
+					turn = (turn > gf_PI) ? turn - gf_PI2 : ((turn < -gf_PI) ? turn + gf_PI2 : turn);
+					ship.heading += clamp(turn, -turnRate * dt, turnRate * dt);
+					ship.speed += clamp(desiredSpeed * speedScale - ship.speed, -accel * dt, accel * dt);
+				}
+			}
+
+			result.timer.Stop();
+
+			for (int i = 0; i < numShips; ++i)
+			{
+				SBenchShip& ship = ships[i];
+				ship.pos += Vec2(cos_tpl(ship.heading), sin_tpl(ship.heading)) * (ship.speed * dt);
+				ship.arrived = ship.arrived || (ship.goal - ship.pos).GetLength2() < sqr(arriveDistance);
+				ship.grounded = ship.grounded || IsBenchOnLand(ship.pos.x, ship.pos.y);
+			}
+
+			for (int i = 0; i < numShips; ++i)
+			{
+				for (int j = i + 1; j < numShips; ++j)
+				{
+					const bool contact = (ships[i].pos - ships[j].pos).GetLength2() < sqr(2.f * radius);
+					uint8& wasInContact = inContact[i * numShips + j];
+					if (contact && !wasInContact)
+						++result.collisions;
+					wasInContact = contact ? 1 : 0;
+				}
+			}
+		}
+
+		result.grounded = 0;
+		result.arrived = 0;
+		for (int i = 0; i < numShips; ++i)
+		{
+			result.grounded += ships[i].grounded ? 1 : 0;
+			result.arrived += ships[i].arrived ? 1 : 0;
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+void CShipSteeringManager::RunBenchmark(int numShips, int numFrames)
+{
+	numShips = clamp(numShips, 1, 1024);
+	numFrames = max(numFrames, 1);
+
+	SBenchResult steered;
+	RunBenchmarkPass(numShips, numFrames, true, steered);
+
+	CryLog("[ai_shipSteeringBench] %d ships, %d frames at 30 Hz, %.0f m cells, budget %d cells per frame: %.4f ms per frame, worst %.4f ms",
+		numShips, numFrames, max(g_pGameCVars->ai_shipSteeringCellSize, 1.f), g_pGameCVars->ai_shipSteeringBudget,
+		steered.timer.GetAverageMs(), steered.timer.GetWorstMs());
+}
+
+//------------------------------------------------------------------------
+CRY_UNIT_TEST_SUITE(CryShipSteeringTest)
+{
+	// Steered fleets keep clear of the islands and of each other better than fleets heading straight for their goals
+	CRY_UNIT_TEST(SteeringAvoidsLandAndShips)
+	{
+		const int numShips = 16;
+		const int numFrames = 6000;
+
+		SBenchResult direct;
+		SBenchResult steered;
+		RunBenchmarkPass(numShips, numFrames, false, direct);
+		RunBenchmarkPass(numShips, numFrames, true, steered);
+
+		CRY_UNIT_TEST_ASSERT(direct.grounded > 0);
+		CRY_UNIT_TEST_ASSERT(steered.grounded < direct.grounded);
+		CRY_UNIT_TEST_ASSERT(steered.collisions <= direct.collisions);
+	}
+}
@@ -0,0 +1,216 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Shared steering for AI ships. The level is covered by a coarse grid of
+cells deep enough to sail, sampled over a few frames after load. For the
+goals ships are heading to, flow fields pointing every cell along the
+shortest water route are built within a per frame budget and cached, so
+a ship looks its heading up in constant time. Ships close to each other
+are found through a spatial hash and turn and slow down to pass.
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#ifndef __SHIPSTEERINGMANAGER_H__
+#define __SHIPSTEERINGMANAGER_H__
+
+#pragma once
+
+class CShipSteeringManager
+{
+public:
+	// Handles stay unique across removal, a stale one is ignored
+	typedef uint32 TAgentId;
+	typedef uint32 TObstacleId;
+
+	enum
+	{
+		kInvalidId = 0,
+		kMaxFlowFields = 8,
+	};
+
+	// Whether a ship with the given draft can sail at x, y
+	typedef bool (*TNavigableFunc)(float x, float y, float draft, void* pUser);
+
+	struct SAgentState
+	{
+		SAgentState() : pos(ZERO), vel(ZERO), goal(ZERO), radius(5.f), maxSpeed(10.f), desiredSpeed(0.f), hasGoal(false) {}
+
+		Vec3 pos;
+		Vec3 vel;
+		Vec3 goal;
+		float radius;
+		float maxSpeed;
+		float desiredSpeed;
+		bool hasGoal;					// without a goal the agent is only avoided by the others
+	};
+
+	struct SSteering
+	{
+		SSteering() : dir(ZERO), speedScale(1.f), valid(false) {}
+
+		Vec3 dir;							// horizontal, normalized
+		float speedScale;			// applied to the desired speed, < 1 while giving way
+		bool valid;
+	};
+
+	CShipSteeringManager();
+
+	void Update(float frameTime);
+	void Reset(bool bUnload);
+
+	// Without a call the grid covers the terrain of the level and uses the terrain and water heights
+	void InitGrid(const Vec2& origin, float size, float cellSize, float draft, TNavigableFunc navigableFunc, void* pUser);
+
+	TAgentId AddAgent();
+	void RemoveAgent(TAgentId id);
+	// False once the handle went stale, after a reset
+	bool SetAgentState(TAgentId id, const SAgentState& state);
+	// The steering computed by the last update
+	bool GetSteering(TAgentId id, SSteering& steering) const;
+
+	// Blocks the cells under the disc for the flow fields, ships also avoid it directly
+	TObstacleId AddObstacle(const Vec3& centre, float radius);
+	void RemoveObstacle(TObstacleId id);
+	// Only an obstacle that moved or changed size is rasterised again. False once the handle went stale, after a reset
+	bool MoveObstacle(TObstacleId id, const Vec3& centre, float radius);
+
+	// Sails synthetic fleets across a synthetic archipelago without physics and logs the cost per frame
+	static void RunBenchmark(int numShips, int numFrames);
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+private:
+	enum
+	{
+		kNoPath = 0xff,
+		kAtGoal = 0xfe,
+	};
+
+	struct SGrid
+	{
+		SGrid() : width(0), height(0), cellSize(16.f), invCellSize(1.f/16.f), draft(2.f), origin(ZERO), numSampled(0), revision(0), pNavigableFunc(NULL), pUser(NULL) {}
+
+		bool IsInitialized() const { return width > 0; }
+		bool IsComplete() const { return IsInitialized() && numSampled == width * height; }
+		bool IsNavigable(int cell) const { return water[cell] && !obstacles[cell]; }
+
+		int width, height;
+		float cellSize, invCellSize;
+		float draft;
+		Vec2 origin;
+		std::vector<uint8> water;				// deep enough, sampled once
+		std::vector<uint16> obstacles;	// obstacle discs covering the cell
+		std::vector<uint8> shore;				// cells to the nearest land, up to a few, once sampling is complete
+		int numSampled;									// cells are sampled in order, a few thousand per frame
+		uint32 revision;								// bumped whenever obstacles change
+		TNavigableFunc pNavigableFunc;
+		void* pUser;
+	};
+
+	struct SFlowField
+	{
+		SFlowField() : goalCell(-1), revision(0), lastUsed(0), ready(false) {}
+
+		int goalCell;
+		std::vector<uint8> dirs;				// per cell, the neighbour to sail to next, or kNoPath
+		uint32 revision;								// grid revision it was built against, an outdated field is used until rebuilt
+		uint32 lastUsed;
+		bool ready;
+	};
+
+	struct SOpenNode
+	{
+		float cost;
+		int cell;
+
+		bool operator<(const SOpenNode& rhs) const { return cost > rhs.cost; }
+	};
+
+	// One field is built at a time, continued each frame until done
+	struct SFieldBuild
+	{
+		SFieldBuild() : field(-1), revision(0) {}
+
+		int field;
+		uint32 revision;
+		std::vector<float> cost;
+		std::vector<uint8> dirs;
+		std::vector<SOpenNode> open;
+	};
+
+	struct SAgent
+	{
+		SAgent() : salt(0), used(false), field(-1), next(-1) {}
+
+		SAgentState state;
+		SSteering steering;
+		uint16 salt;
+		bool used;
+		int field;
+		int next;												// spatial hash chain
+	};
+
+	struct SObstacle
+	{
+		SObstacle() : centre(ZERO), radius(0.f), salt(0), used(false) {}
+
+		Vec2 centre;
+		float radius;
+		uint16 salt;
+		bool used;
+	};
+
+	static uint32 MakeId(int index, uint16 salt) { return ((uint32)salt << 16) | (uint32)(index + 1); }
+	static int GetIndex(uint32 id) { return (int)(id & 0xffff) - 1; }
+	static uint16 GetSalt(uint32 id) { return (uint16)(id >> 16); }
+	const SAgent* FindAgent(TAgentId id) const;
+	SAgent* FindAgent(TAgentId id) { return const_cast<SAgent*>(static_cast<const CShipSteeringManager*>(this)->FindAgent(id)); }
+
+	void InitLevelGrid();
+	void SampleGrid(int budget);
+	void ComputeShoreDistance();
+	void RasteriseObstacle(const SObstacle& obstacle, int delta);
+	int GetCell(const Vec2& pos) const;
+
+	int AcquireField(int goalCell);
+	void StartBuild();
+	int ContinueBuild(int budget);
+	bool SampleField(const SFlowField& field, const Vec2& pos, Vec2& dir) const;
+
+	void BuildSpatialHash();
+	uint32 GetHashBucket(int x, int y) const;
+	void ComputeSteering(SAgent& agent);
+
+	void UpdateDebug() const;
+
+	SGrid m_grid;
+	SFlowField m_fields[kMaxFlowFields];
+	SFieldBuild m_build;
+	bool m_levelGrid;								// grid set up from the level rather than by InitGrid
+
+	std::vector<SAgent> m_agents;
+	std::vector<int> m_freeAgents;
+	std::vector<SObstacle> m_obstacles;
+	std::vector<int> m_freeObstacles;
+	int m_numAgents;
+
+	// agents by position, buckets sized for the closest approach horizon
+	std::vector<int> m_hashHeads;
+	float m_hashCellSize;
+	float m_invHashCellSize;
+
+	uint32 m_frame;
+
+	// stats of the last update, shown with ai_shipSteeringDebug
+	int m_numFieldBuilds;
+	int m_numExpansions;
+	int m_numPairTests;
+	float m_updateMs;
+};
+
+#endif // __SHIPSTEERINGMANAGER_H__
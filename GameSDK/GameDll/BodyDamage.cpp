@@ -4,6 +4,7 @@
 
 #include "Actor.h"
 #include "GameRules.h"
+#include "Utility/BenchmarkTimer.h"
 
 #define BODYDAMAGE_LIVING_ENTITY_CAPSULE_PARTID 100
 
@@ -505,6 +506,7 @@ bool CBodyDamageProfile::Init(const SBodyCharacterInfo& characterInfo, bool load
 			LoadMultipliers(m_damageRootNode);
 			LoadImpulseFilters(m_damageRootNode, *characterInfo.pICharacterModelSkeleton);
 			LoadExplosionMultipliers(m_damageRootNode);
+			BuildPartLookup();
 
 			if (loadEffectiveMaterials) 
 				effectiveMaterials.FinalizeMapping();
@@ -809,68 +811,142 @@ const CBodyDamageProfile::CPart* CBodyDamageProfile::FindPartWithBoneName(const
 }
 
 
-const CBodyDamageProfile::CPart* CBodyDamageProfile::FindPart( IEntity& characterEntity, const int partId, int material ) const
+void CBodyDamageProfile::BuildPartLookup()
 {
-	const CPart* part = NULL;
+	m_partLookup.clear();
+	m_partLookup.reserve(m_partsByJointId.size());
+
+	// Multipliers and impulse filters move to flat tables in part id order, kept with parallel part ids to find them
+	std::vector<PartId> multiplierPartIds;
+	multiplierPartIds.reserve(m_partIdsToMultipliers.size());
+	m_partMultipliers.clear();
+	m_partMultipliers.reserve(m_partIdsToMultipliers.size());
+	for (TPartIdsToMultipliers::const_iterator itMultiplier = m_partIdsToMultipliers.begin(); itMultiplier != m_partIdsToMultipliers.end(); ++itMultiplier)
+	{
+		multiplierPartIds.push_back(itMultiplier->first);
+		m_partMultipliers.push_back(itMultiplier->second);
+	}
 
-	const JointId jointId = JointId::GetJointIdFromPartId( characterEntity, partId );
+	std::vector<PartId> filterPartIds;
+	filterPartIds.reserve(m_impulseFilters.size());
+	m_impulseFilterTable.clear();
+	m_impulseFilterTable.reserve(m_impulseFilters.size());
+	for (TImpulseFilters::const_iterator itFilter = m_impulseFilters.begin(); itFilter != m_impulseFilters.end(); ++itFilter)
+	{
+		filterPartIds.push_back(itFilter->first);
+		m_impulseFilterTable.push_back(itFilter->second);
+	}
 
-	TPartsByJointIdRange partsRange = m_partsByJointId.equal_range(jointId);
-	for (; partsRange.first != partsRange.second; ++partsRange.first)
+	// Resolve every (joint, material) pair the way the multimap walk used to: the first part listing the
+	// material wins, otherwise the last part without materials for that joint is used
+	int jointBegin = 0;
+	JointId currentJointId;
+	for (TPartsByJointId::const_iterator itParts = m_partsByJointId.begin(); itParts != m_partsByJointId.end(); ++itParts)
 	{
-		const CPartInfo& currentPart = partsRange.first->second;
+		const JointId& jointId = itParts->first;
+		if (!(jointId == currentJointId) || (itParts == m_partsByJointId.begin()))
+		{
+			currentJointId = jointId;
+			jointBegin = m_partLookup.size();
+		}
+
+		const CPart& part = itParts->second.GetPart();
+		std::vector<PartId>::const_iterator foundMultiplier = std::lower_bound(multiplierPartIds.begin(), multiplierPartIds.end(), part.GetId());
+		const SBodyPartDamageMultiplier* pMultiplier = ((foundMultiplier != multiplierPartIds.end()) && (*foundMultiplier == part.GetId())) ? &m_partMultipliers[foundMultiplier - multiplierPartIds.begin()] : NULL;
 
-		const TMaterialIds& materialIds = currentPart.GetMaterialIds();
+		const TMaterialIds& materialIds = itParts->second.GetMaterialIds();
 		if (materialIds.empty())
 		{
-			part = &currentPart.GetPart();
+			SPartLookupEntry entry(jointId, SPartLookupEntry::ANY_MATERIAL, part, pMultiplier);
+
+			TPartLookup::iterator itExisting = std::find_if(m_partLookup.begin() + jointBegin, m_partLookup.end(), CPartLookupByMaterialFunctor(SPartLookupEntry::ANY_MATERIAL));
+			if (itExisting != m_partLookup.end())
+				*itExisting = entry;
+			else
+				m_partLookup.push_back(entry);
 		}
 		else
 		{
-			TMaterialIds::const_iterator foundMaterial = std::find(materialIds.begin(), materialIds.end(), material);
-			if (foundMaterial != materialIds.end())
+			for (TMaterialIds::const_iterator itMaterial = materialIds.begin(); itMaterial != materialIds.end(); ++itMaterial)
 			{
-				if (CBodyManagerCVars::g_bodyDamage_log)
-					LogFoundMaterial(*foundMaterial, currentPart, partId);
-
-				part = &currentPart.GetPart();
-				break;
+				if (std::find_if(m_partLookup.begin() + jointBegin, m_partLookup.end(), CPartLookupByMaterialFunctor(*itMaterial)) == m_partLookup.end())
+				{
+					m_partLookup.push_back(SPartLookupEntry(jointId, *itMaterial, part, pMultiplier));
+				}
 			}
 		}
 	}
 
-	return part;
+	std::sort(m_partLookup.begin(), m_partLookup.end());
+
+	for (TPartLookup::iterator itEntry = m_partLookup.begin(); itEntry != m_partLookup.end(); ++itEntry)
+	{
+		std::pair<std::vector<PartId>::const_iterator, std::vector<PartId>::const_iterator> filters = std::equal_range(filterPartIds.begin(), filterPartIds.end(), itEntry->pPart->GetId());
+		itEntry->firstImpulseFilter = (uint16)(filters.first - filterPartIds.begin());
+		itEntry->numImpulseFilters = (uint16)(filters.second - filters.first);
+	}
+
+	// Only the compiled tables are used from now on
+	m_partsByJointId.clear();
+	m_partIdsToMultipliers.clear();
+	m_impulseFilters.clear();
 }
 
-float CBodyDamageProfile::GetDamageMultiplier(IEntity& characterEntity, const HitInfo& hitInfo) const
+const CBodyDamageProfile::SPartLookupEntry* CBodyDamageProfile::FindPartEntry(const JointId& jointId, int material) const
+{
+	const TPartLookup::const_iterator itEnd = m_partLookup.end();
+
+	TPartLookup::const_iterator itEntry = std::lower_bound(m_partLookup.begin(), itEnd, SPartLookupEntry(jointId, material));
+	if ((itEntry != itEnd) && (itEntry->jointId == jointId) && (itEntry->material == material))
+		return &(*itEntry);
+
+	// The generic entry of a joint sorts before all its material specific ones
+	itEntry = std::lower_bound(m_partLookup.begin(), itEntry, SPartLookupEntry(jointId, SPartLookupEntry::ANY_MATERIAL));
+	if ((itEntry != itEnd) && (itEntry->jointId == jointId) && (itEntry->material == SPartLookupEntry::ANY_MATERIAL))
+		return &(*itEntry);
+
+	return NULL;
+}
+
+const CBodyDamageProfile::SPartLookupEntry* CBodyDamageProfile::FindPart( IEntity& characterEntity, const int partId, int material ) const
 {
-	float result = GetDefaultDamageMultiplier( hitInfo );
-	const char* partName = "None";
+	const JointId jointId = JointId::GetJointIdFromPartId( characterEntity, partId );
 
-	if (const CPart* part = FindPart( characterEntity, hitInfo.partId, hitInfo.material ))
+	const SPartLookupEntry* pEntry = FindPartEntry(jointId, material);
+
+	if (pEntry && (pEntry->material != SPartLookupEntry::ANY_MATERIAL) && CBodyManagerCVars::g_bodyDamage_log)
+		LogFoundMaterial(pEntry->material, *pEntry->pPart, partId);
+
+	return pEntry;
+}
+
+float CBodyDamageProfile::GetDamageMultiplier(const SPartLookupEntry* pEntry, const HitInfo& hitInfo) const
+{
+	if (pEntry && pEntry->pMultiplier)
 	{
-		partName = part->GetName().c_str();
+		const SBodyPartDamageMultiplier& bodyPartDamageInfo = *pEntry->pMultiplier;
 
-		TPartIdsToMultipliers::const_iterator foundMultiplier = m_partIdsToMultipliers.find(part->GetId());
-		if (foundMultiplier != m_partIdsToMultipliers.end())
+		float bulletMultiplier = 1.0f;
+		const EBulletHitClass hitClass = hitInfo.aimed ? eBHC_Aimed : eBHC_Normal;
+		if (FindDamageMultiplierForBullet(bodyPartDamageInfo.bulletMultipliers, hitInfo.projectileClassId, hitClass, bulletMultiplier))
 		{
-			const SBodyPartDamageMultiplier& bodyPartDamageInfo = foundMultiplier->second;
-			
-			float bulletMultiplier = 1.0f;
-			const EBulletHitClass hitClass = hitInfo.aimed ? eBHC_Aimed : eBHC_Normal;
-			if (FindDamageMultiplierForBullet(bodyPartDamageInfo.bulletMultipliers, hitInfo.projectileClassId, hitClass, bulletMultiplier))
-			{
-				result = bulletMultiplier;
-			}
-			else
-			{
-				result = GetBestMultiplierForHitType(bodyPartDamageInfo, hitInfo.type, hitClass);
-			}
+			return bulletMultiplier;
 		}
+		
+		return GetBestMultiplierForHitType(bodyPartDamageInfo, hitInfo.type, hitClass);
 	}
 
+	return GetDefaultDamageMultiplier( hitInfo );
+}
+
+float CBodyDamageProfile::GetDamageMultiplier(IEntity& characterEntity, const HitInfo& hitInfo) const
+{
+	const SPartLookupEntry* pEntry = FindPart( characterEntity, hitInfo.partId, hitInfo.material );
+
+	const float result = GetDamageMultiplier(pEntry, hitInfo);
+
 	if (CBodyManagerCVars::g_bodyDamage_log)
-		LogDamageMultiplier(characterEntity, hitInfo, partName, result);
+		LogDamageMultiplier(characterEntity, hitInfo, pEntry ? pEntry->pPart->GetName().c_str() : "None", result);
 
 	return result;
 }
@@ -941,36 +1017,37 @@ float CBodyDamageProfile::GetDefaultDamageMultiplier( const HitInfo& hitInfo ) c
 }
 
 void CBodyDamageProfile::GetHitImpulseFilter( IEntity& characterEntity, const HitInfo &hitInfo, SBodyDamageImpulseFilter &impulseFilter) const
+{
+	const SPartLookupEntry *pEntry = !m_impulseFilterTable.empty() ? FindPart( characterEntity,  hitInfo.partId, hitInfo.material ) : NULL;
+
+	GetImpulseFilter( pEntry, hitInfo.projectileClassId, impulseFilter );
+}
+
+void CBodyDamageProfile::GetImpulseFilter(const SPartLookupEntry* pEntry, uint16 projectileClassId, SBodyDamageImpulseFilter& impulseFilter) const
 {
 	bool bFound = false;
 
-	if (!m_impulseFilters.empty() )
+	if( pEntry )
 	{
-		const CPart *part = FindPart( characterEntity,  hitInfo.partId, hitInfo.material );
-		if( part )
+		const int filterEnd = pEntry->firstImpulseFilter + pEntry->numImpulseFilters;
+		for( int i = pEntry->firstImpulseFilter; i < filterEnd; ++i )
 		{
-			const PartId partID = part->GetId();
-
-			TImpulseFilters::const_iterator iFilter = m_impulseFilters.find( partID );
-			const TImpulseFilters::const_iterator iEnd = m_impulseFilters.end();
-			for( ; (iFilter!=iEnd) && (iFilter->first == partID); ++iFilter )
+			const SBodyDamageImpulseFilter& filter = m_impulseFilterTable[i];
+			if( (filter.projectileClassID != uint16(~0) ) 
+			 && (filter.projectileClassID == projectileClassId) )
 			{
-				if( (iFilter->second.projectileClassID != uint16(~0) ) 
-				 && (iFilter->second.projectileClassID == hitInfo.projectileClassId) )
-				{
-					impulseFilter = iFilter->second;
-					bFound = true;
-					break;
-				}
-				else
-				if( iFilter->second.projectileClassID == uint16(~0) )
-				{
-					impulseFilter = iFilter->second;
-					bFound = true;
-				}
+				impulseFilter = filter;
+				bFound = true;
+				break;
+			}
+			else
+			if( filter.projectileClassID == uint16(~0) )
+			{
+				impulseFilter = filter;
+				bFound = true;
 			}
 		}
-	}	
+	}
 
 	if( !bFound )
 	{
@@ -981,11 +1058,60 @@ void CBodyDamageProfile::GetHitImpulseFilter( IEntity& characterEntity, const Hi
 }
 
 
+float CBodyDamageProfile::RunBenchmark(int numHits) const
+{
+	const int numEntries = m_partLookup.size();
+	if ((numEntries == 0) || (numHits <= 0))
+		return 0.0f;
+
+	// Hits land on the joints of the profile with their materials, some with a material no part lists
+	// and some with a projectile that has its own multiplier on the part
+	std::vector<JointId> jointIds(numHits);
+	std::vector<HitInfo> hits(numHits);
+	for (int i = 0; i < numHits; ++i)
+	{
+		const SPartLookupEntry& entry = m_partLookup[cry_rand() % numEntries];
+		HitInfo& hitInfo = hits[i];
+
+		jointIds[i] = entry.jointId;
+		hitInfo.material = ((entry.material == SPartLookupEntry::ANY_MATERIAL) || ((cry_rand() & 3) == 0)) ? (int)(cry_rand() & 0xff) : entry.material;
+		hitInfo.type = ((cry_rand() & 7) == 0) ? CGameRules::EHitType::Collision : CGameRules::EHitType::Bullet;
+		hitInfo.aimed = (cry_rand() & 1) != 0;
+		hitInfo.projectileClassId = uint16(~0);
+		if (entry.pMultiplier && !entry.pMultiplier->bulletMultipliers.empty() && (cry_rand() & 1))
+			hitInfo.projectileClassId = entry.pMultiplier->bulletMultipliers[cry_rand() % entry.pMultiplier->bulletMultipliers.size()].projectileClassId;
+	}
+
+	float checksum = 0.0f;
+	uint32 flags = 0;
+	SBodyDamageImpulseFilter impulseFilter;
+
+	CBenchmarkTimer timer;
+	timer.Start();
+
+	for (int i = 0; i < numHits; ++i)
+	{
+		const SPartLookupEntry* pEntry = FindPartEntry(jointIds[i], hits[i].material);
+
+		checksum += GetDamageMultiplier(pEntry, hits[i]);
+		GetImpulseFilter(pEntry, hits[i].projectileClassId, impulseFilter);
+		checksum += impulseFilter.multiplier;
+		flags |= pEntry ? pEntry->partFlags : 0;
+	}
+
+	const float ms = timer.Stop();
+
+	CryLog("[g_bodyDamageBench] profile %d: %d entries, %d multipliers, %d impulse filters, %.3f ms (checksum %.2f, flags %x)",
+		m_id, numEntries, (int)m_partMultipliers.size(), (int)m_impulseFilterTable.size(), ms, checksum, flags);
+
+	return ms;
+}
+
 uint32 CBodyDamageProfile::GetPartFlags( IEntity& characterEntity, const HitInfo& hitInfo) const
 {
-	if (const CPart* part = FindPart( characterEntity, hitInfo.partId, hitInfo.material ))
+	if (const SPartLookupEntry* pEntry = FindPart( characterEntity, hitInfo.partId, hitInfo.material ))
 	{
-		return part->GetFlags();
+		return pEntry->partFlags;
 	}
 
 	return 0;
@@ -1034,7 +1160,7 @@ void CBodyDamageProfile::LogExplosionDamageMultiplier(IEntity& characterEntity,
 	CryLog("BodyDamage Explosion: Player [%s] Multiplier [%f]", characterEntity.GetName(), multiplierValue);
 }
 
-void CBodyDamageProfile::LogFoundMaterial(int materialId, const CPartInfo& part, const int partId) const
+void CBodyDamageProfile::LogFoundMaterial(int materialId, const CPart& part, const int partId) const
 {
 	IMaterialManager *pMaterialManager = gEnv->p3DEngine->GetMaterialManager();
 	assert(pMaterialManager);
@@ -1044,7 +1170,7 @@ void CBodyDamageProfile::LogFoundMaterial(int materialId, const CPartInfo& part,
 		materialName = surfaceType->GetName();
 
 	CryLog("BodyDamage: Matched MaterialId [%d] MaterialName [%s] Part [%s] JointId [%d] JointName", 
-		materialId, materialName, part.GetPart().GetName().c_str(), partId);
+		materialId, materialName, part.GetName().c_str(), partId);
 }
 
 bool CBodyDamageProfile::Reload(const SBodyCharacterInfo& characterInfo, const SBodyDamageDef &bodyDamageDef, TBodyDamageProfileId id)
@@ -1054,6 +1180,9 @@ bool CBodyDamageProfile::Reload(const SBodyCharacterInfo& characterInfo, const S
 	m_parts.clear();
 	m_partsByJointId.clear();
 	m_partIdsToMultipliers.clear();
+	m_partLookup.clear();
+	m_partMultipliers.clear();
+	m_impulseFilterTable.clear();
 	m_impulseFilters.clear();
 
 	if (characterInfo.pPhysicalEntity)
@@ -1070,7 +1199,9 @@ void CBodyDamageProfile::GetMemoryUsage( ICrySizer *pSizer ) const
 	pSizer->AddObject(this, sizeof(*this));
 	pSizer->AddContainer(m_parts);	
 	//pSizer->AddContainer(m_partsByJointId);
-	pSizer->AddContainer(m_partIdsToMultipliers);
+	pSizer->AddContainer(m_partLookup);
+	pSizer->AddContainer(m_partMultipliers);
+	pSizer->AddContainer(m_impulseFilterTable);
 	pSizer->AddContainer(m_effectiveMaterialsMapping);		
 }
 
@@ -139,6 +139,8 @@ class CBodyDamageProfile : public _reference_target_t
 			defaultMultiplier[eBHC_Aimed]  = defaultValue;
 		}
 
+		void GetMemoryUsage( ICrySizer *pSizer ) const{}
+
 		float defaultMultiplier[eBHC_Max]; 
 		float meleeMultiplier;
 		float collisionMultiplier;
@@ -254,6 +256,66 @@ class CBodyDamageProfile : public _reference_target_t
 	typedef std::map<MatMappingId, SMaterialMappingEntry> TMaterialMappingEntries;
 	typedef std::multimap<PartId,SBodyDamageImpulseFilter> TImpulseFilters;
 
+	// Compiled from the maps above once loading is done, which are then dropped
+	typedef std::vector<SBodyPartDamageMultiplier> TPartMultipliers;
+	typedef std::vector<SBodyDamageImpulseFilter> TImpulseFilterTable;
+
+	// Flattened (joint, material) -> part resolution, built once the parts and multipliers are loaded.
+	// Entries with ANY_MATERIAL hold the part used when no material specific part matches the hit.
+	// Everything a hit needs is reached from the entry without walking a node based container
+	struct SPartLookupEntry
+	{
+		static const MaterialId ANY_MATERIAL = -1;
+
+		SPartLookupEntry(const JointId& _jointId, MaterialId _material, const CPart& part, const SBodyPartDamageMultiplier* _pMultiplier)
+			: jointId(_jointId)
+			, material(_material)
+			, pPart(&part)
+			, pMultiplier(_pMultiplier)
+			, partFlags(part.GetFlags())
+			, firstImpulseFilter(0)
+			, numImpulseFilters(0)
+		{
+		}
+
+		SPartLookupEntry(const JointId& _jointId, MaterialId _material)
+			: jointId(_jointId)
+			, material(_material)
+			, pPart(NULL)
+			, pMultiplier(NULL)
+			, partFlags(0)
+			, firstImpulseFilter(0)
+			, numImpulseFilters(0)
+		{
+		}
+
+		bool operator<(const SPartLookupEntry& other) const
+		{
+			return (jointId < other.jointId) || ((jointId == other.jointId) && (material < other.material));
+		}
+
+		void GetMemoryUsage( ICrySizer *pSizer ) const{}
+
+		JointId jointId;
+		MaterialId material;
+		const CPart* pPart;
+		const SBodyPartDamageMultiplier* pMultiplier;	// into m_partMultipliers
+		uint32 partFlags;
+		uint16 firstImpulseFilter;										// range of m_impulseFilterTable, in file order
+		uint16 numImpulseFilters;
+	};
+
+	class CPartLookupByMaterialFunctor : std::unary_function<const SPartLookupEntry&, bool>
+	{
+	public:
+		CPartLookupByMaterialFunctor(MaterialId material) : m_material(material) {}
+		bool operator()(const SPartLookupEntry& entry) const { return entry.material == m_material; }
+	private:
+		MaterialId m_material;
+	};
+
+	typedef std::vector<SPartLookupEntry> TPartLookup;
+
 public:
 	static const int ATTACHMENT_BASE_ID = 1000;
 
@@ -282,6 +344,9 @@ public:
 
 	const CPart* FindPartWithBoneName(const char* boneName) const;
 
+	// Resolves random hits against the compiled tables, returns the time taken in ms
+	float RunBenchmark(int numHits) const;
+
 private:
 	XmlNodeRef LoadXml(const char* fileName) const;
 	void LoadDamage(const char* bodyDamageFileName);
@@ -295,10 +360,14 @@ private:
 	void LoadImpulseFilter(const XmlNodeRef& filterNode, ICharacterModelSkeleton& skeletonPose);
 	void LoadImpulse( const XmlNodeRef& filterNode, ICharacterModelSkeleton& skeletonPose, const PartId partID );
 	void IndexParts();
-	const CPart* FindPart( IEntity& characterEntity, const int partId, int material) const;
+	void BuildPartLookup();
+	const SPartLookupEntry* FindPartEntry(const JointId& jointId, int material) const;
+	const SPartLookupEntry* FindPart( IEntity& characterEntity, const int partId, int material) const;
+	float GetDamageMultiplier(const SPartLookupEntry* pEntry, const HitInfo& hitInfo) const;
+	void GetImpulseFilter(const SPartLookupEntry* pEntry, uint16 projectileClassId, SBodyDamageImpulseFilter& impulseFilter) const;
 	void LogDamageMultiplier(IEntity& characterEntity, const HitInfo& hitInfo, const char* partName, const float multiplierValue) const;
 	void LogExplosionDamageMultiplier(IEntity& characterEntity, const float multiplierValue) const;
-	void LogFoundMaterial(int materialId, const CPartInfo& part, const int partId) const;
+	void LogFoundMaterial(int materialId, const CPart& part, const int partId) const;
 
 	bool FindDamageMultiplierForBullet(const TProjectileMultipliers& bulletMultipliers, uint16 projectileClassId, EBulletHitClass hitClass, float& multiplier) const;
 	float GetBestMultiplierForHitType(const SBodyPartDamageMultiplier& damageMultipliers, int hitType, EBulletHitClass hitClass) const;
@@ -316,6 +385,9 @@ private:
 	TParts m_parts;
 	TPartsByJointId m_partsByJointId;
 	TPartIdsToMultipliers m_partIdsToMultipliers;
+	TPartLookup m_partLookup;
+	TPartMultipliers m_partMultipliers;
+	TImpulseFilterTable m_impulseFilterTable;
 	TMaterialMappingEntries m_effectiveMaterialsMapping;
 	TImpulseFilters m_impulseFilters;
 	TProjectileMultipliers m_explosionMultipliers;
@@ -41,6 +41,8 @@ struct SBodyDamageImpulseFilter
 	uint16 projectileClassID;
 
 	SBodyDamageImpulseFilter() : multiplier(1.0f), passOnMultiplier(0.0f), passOnPartId(-1), projectileClassID(uint16(~0)) {}
+
+	void GetMemoryUsage( ICrySizer *pSizer ) const{}
 };
 
 enum EBodyDamagePIDFlags
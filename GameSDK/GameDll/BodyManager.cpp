@@ -131,6 +131,35 @@ void CBodyDamageManager::ReloadBodyDestruction()
 	}
 }
 
+void CBodyDamageManager::RunBenchmark(int numHits) const
+{
+	// The multipliers of melee and collision hits come from the hit types of the game rules
+	if (!g_pGame->GetGameRules())
+	{
+		CryLog("[g_bodyDamageBench] needs a level to be loaded");
+		return;
+	}
+
+	int numProfiles = 0;
+	float totalMs = 0.0f;
+
+	TBodyDamageProfiles::const_iterator itProfileEnd = m_bodyDamageProfiles.end();
+	for (TBodyDamageProfiles::const_iterator itProfile = m_bodyDamageProfiles.begin(); itProfile != itProfileEnd; ++itProfile)
+	{
+		const CBodyDamageProfile* pBodyDamageProfile = *itProfile;
+		if (pBodyDamageProfile && pBodyDamageProfile->IsInitialized())
+		{
+			totalMs += pBodyDamageProfile->RunBenchmark(numHits);
+			++numProfiles;
+		}
+	}
+
+	// Profiles are shared by every actor using the same definition, the bindings show how many use them
+	CryLog("[g_bodyDamageBench] %d hits on each of %d initialized profiles (%d definitions, %d bound entities), %.1f ns per hit",
+		numHits, numProfiles, (int)m_bodyDamageDefinitions.size(), (int)m_bodyDamageProfileIdEntityBindings.size(),
+		(numProfiles > 0) ? (totalMs * 1000000.0f) / ((float)numHits * numProfiles) : 0.0f);
+}
+
 TBodyDamageProfileId CBodyDamageManager::GetBodyDamage(IEntity& characterEntity, const char* damageTable /* = NULL */ )
 {
 	TBodyDamageProfileId result = INVALID_BODYDAMAGEPROFILEID;
@@ -40,6 +40,9 @@ public:
 	void ReloadBodyDamage(TBodyDamageProfileId profileId, IEntity& entity);
 	void ReloadBodyDestruction();
 
+	// Resolves numHits random hits against each initialized body damage profile and logs the cost
+	void RunBenchmark(int numHits) const;
+
 	//================== BODY PARTS/DAMAGE ======================================
 
 	// Returns the profile Id for the body damage to be used by this player
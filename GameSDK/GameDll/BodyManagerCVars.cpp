@@ -25,6 +25,7 @@ void CBodyManagerCVars::RegisterCommands()
 {
 	REGISTER_COMMAND("g_bodyDamage_reload", ReloadBodyDamage, VF_CHEAT, "Reloads bodyDamage for the specified actor, or for everyone if not specified");
 	REGISTER_COMMAND("g_bodyDestruction_reload", ReloadBodyDestruction, VF_CHEAT, "Reloads all body destruction data files");
+	REGISTER_COMMAND("g_bodyDamageBench", RunBenchmark, VF_CHEAT, "Resolves random hits against every loaded body damage profile and logs the cost\nUsage: g_bodyDamageBench [hits = 100000]");
 }
 
 void CBodyManagerCVars::UnregisterCommands(IConsole* pConsole)
@@ -33,6 +34,7 @@ void CBodyManagerCVars::UnregisterCommands(IConsole* pConsole)
 	{
 		pConsole->RemoveCommand("g_bodyDamage_reload");
 		pConsole->RemoveCommand("g_bodyDestruction_reload");
+		pConsole->RemoveCommand("g_bodyDamageBench");
 	}
 }
 
@@ -113,6 +115,16 @@ void CBodyManagerCVars::ReloadBodyDamage(IConsoleCmdArgs* pArgs)
 	}
 }
 
+void CBodyManagerCVars::RunBenchmark(IConsoleCmdArgs* pArgs)
+{
+	const int numHits = (pArgs->GetArgCount() > 1) ? max(atoi(pArgs->GetArg(1)), 1) : 100000;
+
+	CBodyDamageManager *pBodyDamageManager = g_pGame->GetBodyDamageManager();
+	assert(pBodyDamageManager);
+
+	pBodyDamageManager->RunBenchmark(numHits);
+}
+
 void CBodyManagerCVars::ReloadBodyDestruction(IConsoleCmdArgs* pArgs)
 {
 
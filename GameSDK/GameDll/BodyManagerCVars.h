@@ -50,6 +50,7 @@ private:
 	static void Reload(IEntity* pEntity);
 	static void ReloadBodyDamage(IConsoleCmdArgs* pArgs);
 	static void ReloadBodyDestruction(IConsoleCmdArgs* pArgs);
+	static void RunBenchmark(IConsoleCmdArgs* pArgs);
 
 	static int g_bodyDamage_log;
 	static int g_bodyDestruction_debug;
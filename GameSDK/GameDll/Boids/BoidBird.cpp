@@ -18,6 +18,7 @@
 #include "BirdsFlock.h"
 #include <ICryAnimation.h>
 #include "IBreakableManager.h"
+#include "Environment/WaterQueryCache.h"
 
 #define MAX_BIRDS_DISTANCE 300
 
@@ -95,7 +96,7 @@ void CBoidBird::UpdatePhysics( float dt,SBoidContext &bc )
 		m_pos = ppos.pos;
 		Vec3 pos = m_pos;
 		// When hitting water surface, increase physics density.
-		if (!m_inwater && m_pos.z+bc.fBoidRadius <= bc.engine->GetWaterLevel( &pos ))
+		if (!m_inwater && m_pos.z+bc.fBoidRadius <= g_pGame->GetWaterQueryCache()->GetWaterLevel(pos, CWaterQueryCache::eWQ_Boids))
 		{
 			m_inwater = true;
 			pe_simulation_params sym;
@@ -29,6 +29,7 @@
 #include <CryPath.h>
 #include <ISound.h>
 #include "GameCache.h"
+#include "Environment/WaterQueryCache.h"
 
 #define  PHYS_FOREIGN_ID_BOID PHYS_FOREIGN_ID_USER-1
 
@@ -83,7 +84,7 @@ CFlock::CFlock( IEntity *pEntity,EFlockType flockType )
 
 	m_bc.engine = gEnv->p3DEngine;
 	m_bc.physics = gEnv->pPhysicalWorld;
-	m_bc.waterLevel = m_bc.engine->GetWaterLevel(&m_origin);
+	m_bc.waterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(m_origin, CWaterQueryCache::eWQ_Boids);
 	m_bc.fBoidMass = 1;
 	m_bc.fBoidRadius = 1;
 	m_bc.fBoidThickness = 1;
@@ -339,7 +340,7 @@ void CFlock::Update( CCamera *pCamera )
 
 	m_bc.playerPos = GetISystem()->GetViewCamera().GetMatrix().GetTranslation(); // Player position is position of camera.
 	m_bc.flockPos = m_origin;
-	m_bc.waterLevel = m_bc.engine->GetWaterLevel( &m_origin );
+	m_bc.waterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(m_origin, CWaterQueryCache::eWQ_Boids);
 
 	m_bounds.min = Vec3(FLT_MAX,FLT_MAX,FLT_MAX);
 	m_bounds.max = Vec3(-FLT_MAX,-FLT_MAX,-FLT_MAX);
@@ -29,6 +29,7 @@ History:
 #include "FireMode.h"
 #include "Melee.h"
 #include "ItemAnimation.h"
+#include "Ship.h"
 
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -108,7 +109,9 @@ m_rotatingSoundID(INVALID_SOUNDID),
 m_RotationSoundTimeOut(0),
 m_lastXAngle(0),
 m_lastZAngle(0),
-m_lastUsedFrame(-1)
+m_lastUsedFrame(-1),
+recoilImpulse(10.0f),
+m_shipId(0)
 {
 	RegisterActionsCannon();
 }
@@ -120,6 +123,8 @@ CCannon::~CCannon()
 		m_stats.dropped = true; //prevent StopUse calling Drop
 		StopUse(GetOwnerId());
 	}
+
+	UnregisterFromShip();
 }
 
 
@@ -172,6 +177,7 @@ void CCannon::OnReset()
 	   properties->GetValue("fRecoilDistance",recoilDistance);
 	   properties->GetValue("fRecoilStep",recoilStep);
 	   properties->GetValue("fRecoverStep",recoverStep);
+	   properties->GetValue("fRecoilImpulse",recoilImpulse);
 	}
 
 
@@ -201,6 +207,8 @@ void CCannon::OnReset()
 	recoilPos = returnPos - (recoilDistance * weaponTM.GetColumn1());
 	moveDistance = 0;
 
+	RegisterWithShip();
+
 
 	//The next lines are to cache the trail effect for rockets
     CItemParticleEffectCache& particleCache = g_pGame->GetGameSharedParametersStorage()->GetItemResourceCache().GetParticleEffectCache();
@@ -215,7 +223,7 @@ void CCannon::OnReset()
 //HoO
 void CCannon::OnShoot(EntityId userId, EntityId ammoId, IEntityClass* pAmmoType, const Vec3 &pos, const Vec3 &dir, const Vec3&vel)
 {
-	if (!Recovering && !Recoiling) { //if the cannon is still recovering from the last shot or currently firing, don't fire
+	if (!IsRecoiling()) { //if the cannon is still recovering from the last shot or currently firing, don't fire
 	BaseClass::OnShoot(userId, ammoId, pAmmoType, pos, dir, vel);
 
 	const ItemString& soundName = m_stats.fp ? m_sharedparams->pMountParams->shoot_sound_fp : m_sharedparams->pMountParams->shoot_sound_tp;
@@ -231,8 +239,15 @@ void CCannon::OnShoot(EntityId userId, EntityId ammoId, IEntityClass* pAmmoType,
 		}
 	}
 
-	moveDistance = 0;
-	Recoiling = true;
+	if (CShip* pShip = GetShip())
+	{
+		pShip->FireCannon(GetEntityId(), -GetEntity()->GetLocalTM().GetColumn1(), pos, dir);
+	}
+	else
+	{
+		moveDistance = 0;
+		Recoiling = true;
+	}
 
 	/*IScriptSystem* pSS = gEnv->pScriptSystem;
 	IScriptTable *pScriptTable = this->GetEntity()->GetScriptTable();
@@ -317,6 +332,64 @@ void CCannon::RecoilImpulse(const Vec3& firingPos, const Vec3& firingDir)
 		pPhysicalEntity->Action(&impulse);
 	}
 }
+
+void CCannon::RegisterWithShip()
+{
+	IEntity* pParent = GetEntity()->GetParent();
+	const EntityId parentId = pParent ? pParent->GetId() : 0;
+
+	if (m_shipId && m_shipId != parentId)
+	{
+		UnregisterFromShip();
+	}
+
+	CShip* pShip = parentId ? static_cast<CShip*>(g_pGame->GetIGameFramework()->QueryGameObjectExtension(parentId, "Ship")) : NULL;
+	if (pShip)
+	{
+		CCannonBattery::SCannonParams params;
+		params.recoilDistance = recoilDistance;
+		params.recoilStep = recoilStep;
+		params.recoverStep = recoverStep;
+		params.recoilImpulse = recoilImpulse;
+
+		pShip->GetCannonBattery().AddCannon(GetEntityId(), returnPos, params);
+		m_shipId = parentId;
+	}
+}
+
+void CCannon::UnregisterFromShip()
+{
+	if (CCannonBattery* pBattery = GetBattery())
+	{
+		pBattery->RemoveCannon(GetEntityId());
+	}
+
+	m_shipId = 0;
+}
+
+CShip* CCannon::GetShip() const
+{
+	if (!m_shipId || !g_pGame)
+		return NULL;
+
+	return static_cast<CShip*>(g_pGame->GetIGameFramework()->QueryGameObjectExtension(m_shipId, "Ship"));
+}
+
+CCannonBattery* CCannon::GetBattery() const
+{
+	CShip* pShip = GetShip();
+	return pShip ? &pShip->GetCannonBattery() : NULL;
+}
+
+bool CCannon::IsRecoiling() const
+{
+	if (CCannonBattery* pBattery = GetBattery())
+	{
+		return pBattery->IsRecoiling(GetEntityId());
+	}
+
+	return Recoiling || Recovering;
+}
 //HoO - End
 
 
@@ -355,7 +428,7 @@ void CCannon::OnAction(EntityId actorId, const ActionId& actionId, int activatio
 	bool handled = CannonActionHandler.Dispatch(this, actorId, actionId, activationMode, value, filtered);
 	if(!handled || !filtered)
 	{	
-		if (actionId == "attack1" && (Recoiling || Recovering))
+		if (actionId == "attack1" && IsRecoiling())
 		{	
 			//do nothing because the cannon is recoiling or recovering right now
 		}
@@ -669,6 +742,7 @@ void CCannon::UnlinkMountedGun()
 		{
 			m_linkedParentId = GetEntity()->GetParent()->GetId();
 			GetEntity()->DetachThis();
+			UnregisterFromShip();
 		}
 	}
 	m_stats.mounted = false;
@@ -746,9 +820,9 @@ void CCannon::Update( SEntityUpdateContext& ctx, int slot )
 		}
 	}
 
-	//HoO - Recoil
+	//HoO - Recoil, cannons mounted on a ship are moved by its battery instead
 	// 
-	if (Recoiling || Recovering || Recovered) 
+	if (!m_shipId && (Recoiling || Recovering || Recovered)) 
 	{
 		const Matrix34& weaponTM = GetEntity()->GetLocalTM();
 		//const Vec3 point3 = point1 - (recoilDistance * weaponTM.GetColumn1());
@@ -875,6 +949,17 @@ void CCannon::ProcessEvent(SEntityEvent& event)
 			}
 		}
 	}
+	else if (event.event == ENTITY_EVENT_ATTACH_THIS)
+	{
+		// Cannons put on a ship after the reset (spawned, or remounted) recoil from where they were attached
+		returnPos = GetEntity()->GetPos();
+		recoilPos = returnPos - (recoilDistance * GetEntity()->GetWorldTM().GetColumn1());
+		RegisterWithShip();
+	}
+	else if (event.event == ENTITY_EVENT_DETACH_THIS)
+	{
+		UnregisterFromShip();
+	}
 
 	BaseClass::ProcessEvent(event);
 }
@@ -20,6 +20,9 @@ History:
 
 #include "HeavyWeapon.h"
 
+class CCannonBattery;
+class CShip;
+
 class CCannon : public CHeavyWeapon
 {
 private:
@@ -124,6 +127,13 @@ private:
 	void SetUnMountedConfiguration();
 	tSoundID PlayRotationSound();
 
+	//HoO - cannons mounted on a ship leave their recoil to the ship's battery and only update while in use
+	void RegisterWithShip();
+	void UnregisterFromShip();
+	CShip* GetShip() const;
+	CCannonBattery* GetBattery() const;
+	bool IsRecoiling() const;
+
 	bool Recoiling; //HoO - used to see if the gun is recoiling
 	bool Recovering; //HoO - used to see if the gun is recovering from the recoil
 	bool Recovered; //HoO - used to see if the item is done recovering and should return to the exact starting position, this keeps cannons from wandering off
@@ -131,6 +141,8 @@ private:
 	float recoverStep;
 	float recoilDistance;
 	float moveDistance;
+	float recoilImpulse;
+	EntityId m_shipId;
 
 
 	//Input handling
@@ -0,0 +1,228 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id:$
+$DateTime$
+Description:  Recoil of all cannons mounted on a ship
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#include "StdAfx.h"
+#include "CannonBattery.h"
+
+CCannonBattery::CCannonBattery()
+: m_volleyImpulse(ZERO)
+, m_volleyMoment(ZERO)
+, m_volleyPending(false)
+{
+}
+
+void CCannonBattery::AddCannon(EntityId cannonId, const Vec3& restPos, const SCannonParams& params)
+{
+	int index = FindCannon(cannonId);
+	if (index < 0)
+	{
+		index = (int)m_ids.size();
+
+		m_ids.push_back(cannonId);
+		m_restPos.push_back(restPos);
+		m_recoilDir.push_back(Vec3(ZERO));
+		m_moveDistance.push_back(0.f);
+		m_recoilDistance.push_back(0.f);
+		m_recoilStep.push_back(0.f);
+		m_recoverStep.push_back(0.f);
+		m_recoilImpulse.push_back(0.f);
+		m_state.push_back(eState_Idle);
+	}
+
+	m_restPos[index] = restPos;
+	m_recoilDistance[index] = params.recoilDistance;
+	m_recoilStep[index] = params.recoilStep;
+	m_recoverStep[index] = params.recoverStep;
+	m_recoilImpulse[index] = params.recoilImpulse;
+}
+
+void CCannonBattery::RemoveCannon(EntityId cannonId)
+{
+	const int index = FindCannon(cannonId);
+	if (index < 0)
+		return;
+
+	const int last = (int)m_ids.size() - 1;
+
+	// Drop the cannon from the active list, and point any reference to the last cannon at its new slot
+	for (int i = (int)m_active.size() - 1; i >= 0; --i)
+	{
+		if (m_active[i] == index)
+		{
+			m_active[i] = m_active.back();
+			m_active.pop_back();
+		}
+	}
+	for (int i = 0, count = (int)m_active.size(); i < count; ++i)
+	{
+		if (m_active[i] == last)
+			m_active[i] = index;
+	}
+
+	m_ids[index] = m_ids[last];
+	m_restPos[index] = m_restPos[last];
+	m_recoilDir[index] = m_recoilDir[last];
+	m_moveDistance[index] = m_moveDistance[last];
+	m_recoilDistance[index] = m_recoilDistance[last];
+	m_recoilStep[index] = m_recoilStep[last];
+	m_recoverStep[index] = m_recoverStep[last];
+	m_recoilImpulse[index] = m_recoilImpulse[last];
+	m_state[index] = m_state[last];
+
+	m_ids.pop_back();
+	m_restPos.pop_back();
+	m_recoilDir.pop_back();
+	m_moveDistance.pop_back();
+	m_recoilDistance.pop_back();
+	m_recoilStep.pop_back();
+	m_recoverStep.pop_back();
+	m_recoilImpulse.pop_back();
+	m_state.pop_back();
+}
+
+void CCannonBattery::Clear()
+{
+	m_ids.clear();
+	m_restPos.clear();
+	m_recoilDir.clear();
+	m_moveDistance.clear();
+	m_recoilDistance.clear();
+	m_recoilStep.clear();
+	m_recoverStep.clear();
+	m_recoilImpulse.clear();
+	m_state.clear();
+	m_active.clear();
+
+	m_volleyImpulse.zero();
+	m_volleyMoment.zero();
+	m_volleyPending = false;
+}
+
+bool CCannonBattery::Fire(EntityId cannonId, const Vec3& recoilDir, const Vec3& firingPos, const Vec3& firingDir)
+{
+	const int index = FindCannon(cannonId);
+	if (index < 0 || m_state[index] != eState_Idle)
+		return false;
+
+	m_recoilDir[index] = recoilDir;
+	m_moveDistance[index] = 0.f;
+	m_state[index] = eState_Recoiling;
+	m_active.push_back(index);
+
+	const Vec3 impulse = -firingDir * m_recoilImpulse[index];
+	m_volleyImpulse += impulse;
+	m_volleyMoment += firingPos.Cross(impulse);
+	m_volleyPending = true;
+
+	return true;
+}
+
+bool CCannonBattery::IsRecoiling(EntityId cannonId) const
+{
+	const int index = FindCannon(cannonId);
+	return (index >= 0) && (m_state[index] != eState_Idle);
+}
+
+void CCannonBattery::Update(IEntity* pHullEntity)
+{
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
+	if (m_volleyPending)
+	{
+		IPhysicalEntity* pHullPhysics = pHullEntity ? pHullEntity->GetPhysics() : NULL;
+
+		pe_status_dynamics hullDynamics;
+		if (pHullPhysics && pHullPhysics->GetStatus(&hullDynamics))
+		{
+			pe_action_impulse volley;
+			volley.impulse = m_volleyImpulse;
+			volley.angImpulse = m_volleyMoment - hullDynamics.centerOfMass.Cross(m_volleyImpulse);
+			pHullPhysics->Action(&volley);
+		}
+
+		m_volleyImpulse.zero();
+		m_volleyMoment.zero();
+		m_volleyPending = false;
+	}
+
+	// Same curve the cannon entities used to run on their own: a fixed step back per update, then a fixed step home
+	IEntitySystem* pEntitySystem = gEnv->pEntitySystem;
+
+	int numActive = (int)m_active.size();
+	for (int i = 0; i < numActive; )
+	{
+		const int index = m_active[i];
+
+		IEntity* pCannon = pEntitySystem->GetEntity(m_ids[index]);
+		if (!pCannon)
+		{
+			m_state[index] = eState_Idle;
+			m_active[i] = m_active[--numActive];
+			continue;
+		}
+
+		float& moveDistance = m_moveDistance[index];
+		Vec3 pos = m_restPos[index] + m_recoilDir[index] * moveDistance;
+
+		if (m_state[index] == eState_Recoiling)
+		{
+			moveDistance += m_recoilStep[index];
+			if (moveDistance >= m_recoilDistance[index])
+			{
+				m_state[index] = eState_Recovering;
+			}
+		}
+		else
+		{
+			moveDistance -= m_recoverStep[index];
+			if (moveDistance <= 0.f)
+			{
+				moveDistance = 0.f;
+				pos = m_restPos[index];
+				m_state[index] = eState_Idle;
+			}
+		}
+
+		pCannon->SetPos(pos);
+
+		if (m_state[index] == eState_Idle)
+		{
+			m_active[i] = m_active[--numActive];
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	m_active.resize(numActive);
+}
+
+int CCannonBattery::FindCannon(EntityId cannonId) const
+{
+	std::vector<EntityId>::const_iterator it = std::find(m_ids.begin(), m_ids.end(), cannonId);
+	return (it != m_ids.end()) ? (int)(it - m_ids.begin()) : -1;
+}
+
+void CCannonBattery::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddContainer(m_ids);
+	pSizer->AddContainer(m_restPos);
+	pSizer->AddContainer(m_recoilDir);
+	pSizer->AddContainer(m_moveDistance);
+	pSizer->AddContainer(m_recoilDistance);
+	pSizer->AddContainer(m_recoilStep);
+	pSizer->AddContainer(m_recoverStep);
+	pSizer->AddContainer(m_recoilImpulse);
+	pSizer->AddContainer(m_state);
+	pSizer->AddContainer(m_active);
+}
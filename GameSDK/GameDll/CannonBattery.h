@@ -0,0 +1,83 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id:$
+$DateTime$
+Description:  Recoil of all cannons mounted on a ship. Cannon state is kept
+in contiguous arrays owned by the ship, only the cannons that are moving
+are visited each frame and the recoil of a volley reaches the hull as a
+single impulse.
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#pragma once
+
+#ifndef _CANNON_BATTERY_H_
+#define _CANNON_BATTERY_H_
+
+class CCannonBattery
+{
+public:
+	struct SCannonParams
+	{
+		SCannonParams() : recoilDistance(0.f), recoilStep(0.f), recoverStep(0.f), recoilImpulse(10.f) {}
+
+		float recoilDistance;
+		float recoilStep;				// per update, as tuned on the cannon entities
+		float recoverStep;
+		float recoilImpulse;
+	};
+
+	CCannonBattery();
+
+	// restPos is the cannon position in its parent's space
+	void AddCannon(EntityId cannonId, const Vec3& restPos, const SCannonParams& params);
+	void RemoveCannon(EntityId cannonId);
+	void Clear();
+
+	// Starts the recoil of a cannon, recoilDir is in the parent's space. Returns false if it is still moving
+	bool Fire(EntityId cannonId, const Vec3& recoilDir, const Vec3& firingPos, const Vec3& firingDir);
+	bool IsRecoiling(EntityId cannonId) const;
+
+	bool NeedsUpdate() const { return !m_active.empty() || m_volleyPending; }
+	// Advances the moving cannons and applies the summed recoil of this frame's shots to the hull
+	void Update(IEntity* pHullEntity);
+
+	int GetNumCannons() const { return (int)m_ids.size(); }
+	int GetNumActive() const { return (int)m_active.size(); }
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+private:
+	enum EState
+	{
+		eState_Idle = 0,
+		eState_Recoiling,
+		eState_Recovering,
+	};
+
+	int FindCannon(EntityId cannonId) const;
+
+	std::vector<EntityId>	m_ids;
+	std::vector<Vec3>			m_restPos;
+	std::vector<Vec3>			m_recoilDir;
+	std::vector<float>		m_moveDistance;
+	std::vector<float>		m_recoilDistance;
+	std::vector<float>		m_recoilStep;
+	std::vector<float>		m_recoverStep;
+	std::vector<float>		m_recoilImpulse;
+	std::vector<uint8>		m_state;
+
+	// Indices of the cannons currently recoiling or recovering
+	std::vector<int>			m_active;
+
+	// Recoil of the current volley: the summed impulse and its moment about the world origin
+	Vec3									m_volleyImpulse;
+	Vec3									m_volleyMoment;
+	bool									m_volleyPending;
+};
+
+#endif
@@ -15,6 +15,7 @@
 */
 
 #include "StdAfx.h"
+#include "CryUnitTest.h"
 #include "DownloadMgr.h"
 #include "StringUtils.h"
 #include "Utility/StringUtils.h"
@@ -29,6 +30,7 @@
 static const int		k_localizedResourceSlop=5;								// add a bit of slop to allow localised resources to be added without contributing to fragmentation by causing the vector to realloc. arbitrary number, not critical this is accurate
 static const int		k_httpHeaderSize=512;											// should be large enough to hold the HTTP response and info on the payload length
 static const float	k_downloadableResourceHTTPTimeout=8.0f;		// time server has to not respond for before the download is marked as a fail
+static const char		*k_downloadCacheFolder="%USER%/DownloadCache";
 
 #if DOWNLOAD_MGR_DBG
 static const char		*k_dlm_list="dlm_list";
@@ -50,6 +52,8 @@ static const char *k_platformPrefix="pc";
 CDownloadableResource::CDownloadableResource() :
 	m_port(0),
 	m_maxDownloadSize(0),
+	m_priority(k_defaultPriority),
+	m_cacheable(false),
 	m_broadcastedState(k_notBroadcasted),
 	m_pService(NULL),
 	m_pBuffer(NULL),
@@ -57,7 +61,17 @@ CDownloadableResource::CDownloadableResource() :
 	m_bufferSize(0),
 	m_contentLength(0),
 	m_contentOffset(0),
+	m_streamedLength(0),
 	m_state(k_notStarted),
+	m_pResumeData(NULL),
+	m_resumeLength(0),
+	m_retriesLeft(0),
+	m_retryDelay(0.f),
+	m_acceptsRanges(false),
+	m_notModified(false),
+	m_requestInFlight(false),
+	m_retryPending(false),
+	m_scheduled(false),
 	m_abortDownload(false),
 	m_doingHTTPParse(false)
 #if defined(DEDICATED_SERVER)
@@ -76,6 +90,7 @@ CDownloadableResource::~CDownloadableResource()
 	}
 	CRY_ASSERT_MESSAGE((m_state&k_callbackInProgressMask)==0,"Deleting a resource which is being downloaded - CRASH LIKELY!");	// shouldn't happen due to ref counting
 	SAFE_DELETE_ARRAY(m_pBuffer);
+	SAFE_DELETE_ARRAY(m_pResumeData);
 }
 
 void CDownloadableResource::Reset()
@@ -121,6 +136,19 @@ CDownloadMgr::~CDownloadMgr()
 		pPatchPakManager->UnregisterPatchPakManagerEventListener(this);
 	}
 #endif
+
+	// nothing is left to issue requests that are still waiting
+	for (TResourceVector::iterator iter=m_queuedDownloads.begin(); iter!=m_queuedDownloads.end(); ++iter)
+	{
+		(*iter)->m_state=CDownloadableResource::k_failedAborted;
+	}
+	for (TResourceVector::iterator iter=m_activeDownloads.begin(); iter!=m_activeDownloads.end(); ++iter)
+	{
+		if (!(*iter)->m_requestInFlight && (*iter)->m_retryPending)
+		{
+			(*iter)->m_state=CDownloadableResource::k_failedAborted;
+		}
+	}
 }
 
 void CDownloadMgr::Reset()
@@ -185,6 +213,7 @@ void CDownloadableResource::DispatchCallbacks()
 	{
 		if (m_state==CDownloadableResource::k_dataAvailable)
 		{
+			WriteCachedData();
 			BroadcastSuccess();
 		}
 		else if (m_state&CDownloadableResource::k_dataPermanentFailMask)
@@ -200,6 +229,8 @@ void CDownloadMgr::Update(
 	// perform callback broadcasts from the main thread
 	DispatchCallbacks();
 
+	UpdateScheduler();
+
 #if defined(DEDICATED_SERVER)
 	if (gEnv->IsDedicated())
 	{
@@ -394,6 +425,11 @@ void CDownloadableResource::LoadConfig(
 
 	inNode->getAttr("port",m_port);
 	inNode->getAttr("maxSize",m_maxDownloadSize);
+	inNode->getAttr("priority",m_priority);
+
+	// configured resources are cached unless they opt out
+	m_cacheable=true;
+	inNode->getAttr("cache",m_cacheable);
 
 #define ReadXMLStr(key,out)		if (inNode->getAttr(key,str)) { out=str.c_str(); }
 	ReadXMLStr("server",m_server);
@@ -569,6 +605,30 @@ bool CDownloadableResource::StoreData(
 	return finishedWithStream;
 }
 
+// passes received payload on to the stream sink rather than storing it
+bool CDownloadableResource::StreamData(
+	const char						*pInData,
+	int										inDataLen)
+{
+	bool							finishedWithStream=false;
+	int								len=min(inDataLen,m_contentLength-m_streamedLength);
+
+	if (pInData && len>0)
+	{
+		if (m_pStreamSink->DataReceived(this,pInData,len))
+		{
+			m_streamedLength+=len;
+		}
+		else
+		{
+			m_state=k_failedAborted;
+			finishedWithStream=true;
+		}
+	}
+
+	return finishedWithStream;
+}
+
 bool CDownloadableResource::ReceiveHTTPHeader(
 	bool							inReceivedEndOfStream)
 {
@@ -579,15 +639,27 @@ bool CDownloadableResource::ReceiveHTTPHeader(
 		// see if we've received the http header yet
 		static const char	k_httpOKv10[]="HTTP/1.0 200";
 		static const char	k_httpOKv11[]="HTTP/1.1 200";
+		static const char	k_httpPartialContentv11[]="HTTP/1.1 206";
+		static const char	k_httpNotModifiedv10[]="HTTP/1.0 304";
+		static const char	k_httpNotModifiedv11[]="HTTP/1.1 304";
 		static const char	k_httpContentLength[]="Content-Length: ";
 
-		if (m_bufferUsed>=k_httpHeaderSize || inReceivedEndOfStream)
+		if (!m_etag.empty() && m_bufferUsed>=(sizeof(k_httpNotModifiedv10)-1) && (memcmp(k_httpNotModifiedv10,m_pBuffer,sizeof(k_httpNotModifiedv10)-1)==0 || memcmp(k_httpNotModifiedv11,m_pBuffer,sizeof(k_httpNotModifiedv11)-1)==0))
+		{
+			// our cached copy is still current, no body follows so don't wait for a full size header
+			if (inReceivedEndOfStream || CryStringUtils::strnstr(m_pBuffer,"\r\n\r\n",m_bufferUsed))
+			{
+				finishedWithStream=ReceiveNotModified();
+			}
+		}
+		else if (m_bufferUsed>=k_httpHeaderSize || inReceivedEndOfStream)
 		{
 			bool			badHeader=true;
 			bool waitingOnContentLength=false;
+			bool			partialContent=(m_resumeLength>0 && m_bufferUsed>=(sizeof(k_httpPartialContentv11)-1) && memcmp(k_httpPartialContentv11,m_pBuffer,sizeof(k_httpPartialContentv11)-1)==0);
 
-			// check for http/ok response
-			if (m_bufferUsed>=(sizeof(k_httpOKv10)-1) && (memcmp(k_httpOKv10,m_pBuffer,sizeof(k_httpOKv10)-1)==0 || memcmp(k_httpOKv11,m_pBuffer,sizeof(k_httpOKv11)-1)==0))
+			// check for http/ok response, or the rest of the payload after a range request
+			if (m_bufferUsed>=(sizeof(k_httpOKv10)-1) && (memcmp(k_httpOKv10,m_pBuffer,sizeof(k_httpOKv10)-1)==0 || memcmp(k_httpOKv11,m_pBuffer,sizeof(k_httpOKv11)-1)==0 || partialContent))
 			{
 				// check for data payload information
 				char		lengthStr[12];
@@ -676,7 +748,48 @@ bool CDownloadableResource::ReceiveHTTPHeader(
 				{
 					if (!waitingOnContentLength)
 					{
+						CryFixedStringT<64>		acceptRanges;
+						FindHeaderField("Accept-Ranges: ",acceptRanges);
+						m_acceptsRanges=(acceptRanges=="bytes");
+						FindHeaderField("ETag: ",m_responseETag);
+
 						m_state=k_awaitingPayload;
+
+						if (partialContent)
+						{
+							CryFixedStringT<64>		contentRange;
+							FindHeaderField("Content-Range: bytes ",contentRange);
+
+							if (atoi(contentRange.c_str())!=m_resumeLength)
+							{
+								m_state=k_failedReplyHasBadHeader;
+								finishedWithStream=true;
+							}
+							else if (m_contentLength+m_resumeLength>=m_maxDownloadSize)
+							{
+								m_state=k_failedReplyContentTooLong;
+								finishedWithStream=true;
+							}
+							else
+							{
+								ResumePayload();
+							}
+						}
+						else if (m_resumeLength>0)
+						{
+							// the server ignored the range and is sending all of it again
+							if (m_pStreamSink)
+							{
+								// can't take back what the sink has been given
+								m_state=k_failedReplyHasBadHeader;
+								finishedWithStream=true;
+							}
+							else
+							{
+								SAFE_DELETE_ARRAY(m_pResumeData);
+								m_resumeLength=0;
+							}
+						}
 					}
 				}
 			}
@@ -686,6 +799,94 @@ bool CDownloadableResource::ReceiveHTTPHeader(
 	return finishedWithStream;
 }
 
+// looks for a field in the header of the reply, once the end of the header has been found
+void CDownloadableResource::FindHeaderField(
+	const char							*pInField,
+	CryFixedStringT<64>			&outValue)
+{
+	const char		*pFound=CryStringUtils::strnstr(m_pBuffer,pInField,m_contentOffset);
+	char					value[64];
+
+	outValue.clear();
+
+	if (pFound && cry_copyStringUntilFindChar(value,pFound+strlen(pInField),sizeof(value),'\r')!=0)
+	{
+		outValue=value;
+	}
+}
+
+// splices the payload kept from the failed attempt in front of the rest, now that the server is sending it
+void CDownloadableResource::ResumePayload()
+{
+	m_contentLength+=m_resumeLength;
+
+	if (!m_pStreamSink)
+	{
+		int			received=m_bufferUsed-m_contentOffset;
+		int			newSize=max(m_bufferSize,m_contentOffset+m_contentLength);
+		char		*pNewBuffer=new char[newSize];
+
+		memcpy(pNewBuffer,m_pBuffer,m_contentOffset);
+		memcpy(pNewBuffer+m_contentOffset,m_pResumeData,m_resumeLength);
+		memcpy(pNewBuffer+m_contentOffset+m_resumeLength,m_pBuffer+m_contentOffset,received);
+
+		SAFE_DELETE_ARRAY(m_pBuffer);
+		m_pBuffer=pNewBuffer;
+		m_bufferSize=newSize;
+		m_bufferUsed+=m_resumeLength;
+
+		SAFE_DELETE_ARRAY(m_pResumeData);
+	}
+
+	m_resumeLength=0;
+}
+
+// takes the payload from the cached copy after a 304 reply
+bool CDownloadableResource::ReceiveNotModified()
+{
+	CryFixedStringT<ICryPak::g_nMaxPath>	path;
+	ICryPak		*pPak=gEnv->pCryPak;
+
+	GetCachePath(path,"dat");
+
+	FILE			*pFile=pPak->FOpen(path.c_str(),"rb",ICryPak::FLAGS_PATH_REAL);
+	int				size=pFile ? int(pPak->FGetSize(pFile)) : 0;
+
+	if (size>0 && size<m_maxDownloadSize)
+	{
+		char		*pNewBuffer=new char[size];
+
+		if (pPak->FReadRaw(pNewBuffer,1,size,pFile)==size_t(size))
+		{
+			SAFE_DELETE_ARRAY(m_pBuffer);
+			m_pBuffer=pNewBuffer;
+			m_bufferUsed=m_bufferSize=m_contentLength=size;
+			m_contentOffset=0;
+			m_notModified=true;
+			m_state=k_dataAvailable;
+		}
+		else
+		{
+			delete [] pNewBuffer;
+		}
+	}
+
+	if (pFile)
+	{
+		pPak->FClose(pFile);
+	}
+
+	if (m_state!=k_dataAvailable)
+	{
+		// don't ask for it conditionally again
+		GetCachePath(path,"etag");
+		pPak->RemoveFile(path.c_str());
+		m_state=k_failedInternalError;
+	}
+
+	return true;
+}
+
 // static
 // called when a response is receieved from the http server
 // parses http header and receives expected bytes from server
@@ -711,19 +912,33 @@ bool CDownloadableResource::ReceiveDataCallback(
 		if (pResource->m_abortDownload)
 		{
 			pResource->m_state=k_failedAborted;
-			pResource->Release();		// balances AddRef() in StartDownloading()
+			pResource->FinishRequest();
 			finishedWithStream=true;
 		}
 		else if (res==eCTCPSR_Ok )
 		{
-			finishedWithStream=pResource->StoreData(pData,dataLen);
-
-			if (!finishedWithStream)
+			if (pResource->m_pStreamSink && pResource->m_state==k_awaitingPayload)
 			{
-				finishedWithStream=pResource->ReceiveHTTPHeader(endOfStream);
+				finishedWithStream=pResource->StreamData(pData,int(dataLen));
+			}
+			else
+			{
+				finishedWithStream=pResource->StoreData(pData,dataLen);
+
+				if (!finishedWithStream)
+				{
+					finishedWithStream=pResource->ReceiveHTTPHeader(endOfStream);
+				}
+
+				if (!finishedWithStream && pResource->m_pStreamSink && pResource->m_state==k_awaitingPayload)
+				{
+					// hand over any payload that arrived along with the header, only the header is kept
+					finishedWithStream=pResource->StreamData(pResource->m_pBuffer+pResource->m_contentOffset,pResource->m_bufferUsed-pResource->m_contentOffset);
+					pResource->m_bufferUsed=pResource->m_contentOffset;
+				}
 			}
 
-			if (pResource->m_state==k_awaitingPayload && (pResource->m_bufferUsed-pResource->m_contentOffset)>=pResource->m_contentLength)
+			if (pResource->m_state==k_awaitingPayload && pResource->GetPayloadReceived()>=pResource->m_contentLength)
 			{
 				pResource->m_state=k_dataAvailable;
 			}
@@ -741,13 +956,13 @@ bool CDownloadableResource::ReceiveDataCallback(
 					pResource->m_state=k_failedReplyContentTruncated;
 				}
 				finishedWithStream=true;
-				pResource->Release();	// balances AddRef() in StartDownloading()
+				pResource->FinishRequest();
 			}
 		}
 		else
 		{
 			pResource->m_state=k_failedServerUnreachable;
-			pResource->Release();		// balances AddRef() in StartDownloading()
+			pResource->FinishRequest();
 			finishedWithStream=true;
 		}
 	}
@@ -755,6 +970,78 @@ bool CDownloadableResource::ReceiveDataCallback(
 	return finishedWithStream;
 }
 
+// called from the callback thread once a request has finished, with whatever result
+// balances AddRef() in IssueRequest(), or in InitHTTPParser() for resources only used to parse a reply
+void CDownloadableResource::FinishRequest()
+{
+	if (m_requestInFlight)
+	{
+		// the download mgr holds on to the resource until it has issued the retry
+		if (m_scheduled && PrepareRetry())
+		{
+			m_retryPending=true;
+		}
+		m_requestInFlight=false;
+	}
+
+	Release();
+}
+
+// after a soft failure sets the resource up to be requested again, asking only for the rest of the payload if the server takes range requests
+bool CDownloadableResource::PrepareRetry()
+{
+	bool		retry=false;
+
+	if ((m_state&k_dataRetryMask) && !m_abortDownload && m_retriesLeft>0)
+	{
+		int			received=0;
+
+		if (m_pStreamSink)
+		{
+			received=m_streamedLength;
+		}
+		else if (m_resumeLength>0)
+		{
+			received=m_resumeLength;				// this attempt failed before it got as far as the payload
+		}
+		else if (m_contentOffset>0)
+		{
+			received=m_bufferUsed-m_contentOffset;
+		}
+
+		const bool	resume=(received>0 && m_acceptsRanges);
+
+		// a stream sink can't be rewound, so it can only start again if it hasn't been given anything yet
+		if (resume || received==0 || !m_pStreamSink)
+		{
+			if (!m_pStreamSink)
+			{
+				if (!resume)
+				{
+					SAFE_DELETE_ARRAY(m_pResumeData);
+				}
+				else if (!m_pResumeData)
+				{
+					m_pResumeData=new char[received];
+					memcpy(m_pResumeData,m_pBuffer+m_contentOffset,received);
+				}
+			}
+
+			m_resumeLength=resume ? received : 0;
+
+			SAFE_DELETE_ARRAY(m_pBuffer);
+			m_bufferUsed=m_bufferSize=0;
+			m_contentLength=m_contentOffset=0;
+
+			m_retriesLeft--;
+			m_state=k_awaitingHTTPResponse;
+			retry=true;
+		}
+	}
+
+	return retry;
+}
+
 CDownloadableResourcePtr CDownloadMgr::FindResourceByName(
 	const char			*inResourceName)
 {
@@ -853,6 +1140,8 @@ CDownloadableResourcePtr CDownloadMgr::FindLocalizedResourceByName(
 					result->m_descName.Format("%s_%s",templateResource->m_descName.c_str(),pLanguage->GetString());		// don't want to reuse name of template resource - so make a unique one
 					result->m_port=templateResource->m_port;
 					result->m_maxDownloadSize=templateResource->m_maxDownloadSize;
+					result->m_priority=templateResource->m_priority;
+					result->m_cacheable=templateResource->m_cacheable;
 					result->m_isLocalisedInstanceOf=templateResource;
 
 					m_resources.push_back(result);
@@ -927,84 +1216,227 @@ void CDownloadableResource::StartDownloading()
 		}
 		else
 		{
-			STCPServiceDataPtr		pTransaction(NULL);
-			ICryLobby* pLobby = gEnv->pNetwork->GetLobby();
+			CDownloadMgr		*pMgr=g_pGame ? g_pGame->GetDownloadMgr() : NULL;
+
+			m_retriesLeft=max(g_pGameCVars->g_downloadMgrMaxRetries,0);
+			m_retryDelay=max(g_pGameCVars->g_downloadMgrRetryDelay,0.f);
+			m_retryTime.SetValue(0);
 
-			if (!pLobby)
+			if (pMgr)
 			{
-				GameWarning("Error: No Lobby available - CDownloadableResource");
-				return;
+				// in progress from now on, even if it has to wait its turn
+				m_state=k_awaitingHTTPResponse;
+				m_scheduled=true;
+				pMgr->ScheduleDownload(this);
 			}
+			else
+			{
+				IssueRequest();
+			}
+		}
+	}
+}
+
+// sends the http request, for the whole resource or for the rest of it after a failed attempt
+void CDownloadableResource::IssueRequest()
+{
+	STCPServiceDataPtr		pTransaction(NULL);
+	bool									hasServer=false;
 
-			ICryLobbyService* pLobbyService = pLobby->GetLobbyService();
+#if DOWNLOAD_MGR_TEST_SERVER
+	CDownloadTestServer		*pTestServer=CDownloadTestServer::GetRunning();
+	if (pTestServer && strcmp(m_server.c_str(),pTestServer->GetHost())!=0)
+	{
+		pTestServer=NULL;
+	}
+	hasServer=(pTestServer!=NULL);
+#endif
 
-			if(pLobbyService)
-				m_pService=gEnv->pNetwork->GetLobby()->GetLobbyService()->GetTCPService(m_server,m_port,m_urlPrefix);
+	if (!hasServer)
+	{
+		ICryLobby* pLobby = gEnv->pNetwork->GetLobby();
+
+		if (!pLobby)
+		{
+			GameWarning("Error: No Lobby available - CDownloadableResource");
+			m_state=k_notStarted;
+			return;
+		}
+
+		ICryLobbyService* pLobbyService = pLobby->GetLobbyService();
+
+		if(pLobbyService)
+			m_pService=gEnv->pNetwork->GetLobby()->GetLobbyService()->GetTCPService(m_server,m_port,m_urlPrefix);
+
+		hasServer=(m_pService!=NULL);
+	}
+
+	if (hasServer)
+	{
+		static const int					MAX_HEADER_SIZE=512;
+		CryFixedStringT<MAX_HEADER_SIZE>	httpHeader;
+		CryFixedStringT<64> agentStr;
+		CryFixedStringT<128> conditionalHeaders;
+
+		GetUserAgentString(agentStr);
+
+		if (m_resumeLength>0)
+		{
+			conditionalHeaders.Format("Range: bytes=%d-\n",m_resumeLength);
+		}
+		else
+		{
+			LoadCachedETag();
+			if (!m_etag.empty())
+			{
+				conditionalHeaders.Format("If-None-Match: %s\n",m_etag.c_str());
+			}
+		}
 
-			if (m_pService)
+		// For HTTP 1.0.
+		/*httpHeader.Format(
+		"GET /%s%s HTTP/1.0\n"
+		"\n",
+		m_urlPrefix.c_str(),
+		m_url.c_str());*/
+
+		// For HTTP 1.1. Needed to download data from servers that are "multi-homed"
+		httpHeader.Format(
+			"GET /%s%s HTTP/1.1\n"
+			"Pragma: no-cache\n"
+			"User-Agent: %s\n"
+			"Host: %s:%d\n"
+			"%s"
+			"\n",
+			m_urlPrefix.c_str(),
+			m_url.c_str(),
+			agentStr.c_str(),
+			m_server.c_str(),
+			m_port,
+			conditionalHeaders.c_str());
+
+		pTransaction=new STCPServiceData();
+
+		if (pTransaction)
+		{
+			int		len=httpHeader.length();
+			pTransaction->length=len;
+			pTransaction->pData=new char[len];
+			if (pTransaction->pData)
 			{
-				static const int					MAX_HEADER_SIZE=400;
-				CryFixedStringT<MAX_HEADER_SIZE>	httpHeader;
-				CryFixedStringT<64> agentStr;
-
-				GetUserAgentString(agentStr);
-
-				// For HTTP 1.0.
-				/*httpHeader.Format(
-				"GET /%s%s HTTP/1.0\n"
-				"\n",
-				m_urlPrefix.c_str(),
-				m_url.c_str());*/
-
-				// For HTTP 1.1. Needed to download data from servers that are "multi-homed"
-				httpHeader.Format(
-					"GET /%s%s HTTP/1.1\n"
-					"Pragma: no-cache\n"
-					"User-Agent: %s\n"
-					"Host: %s:%d\n"
-					"\n",
-					m_urlPrefix.c_str(),
-					m_url.c_str(),
-					agentStr.c_str(),
-					m_server.c_str(),
-					m_port);
-
-				pTransaction=new STCPServiceData();
-
-				if (pTransaction)
-				{
-					int		len=httpHeader.length();
-					pTransaction->length=len;
-					pTransaction->pData=new char[len];
-					if (pTransaction->pData)
-					{
-						memcpy(pTransaction->pData,httpHeader.c_str(),len);
-						pTransaction->tcpServReplyCb=ReceiveDataCallback;
-						pTransaction->pUserArg=this;		// do ref counting manually for callback data
-						this->AddRef();
+				memcpy(pTransaction->pData,httpHeader.c_str(),len);
+				pTransaction->tcpServReplyCb=ReceiveDataCallback;
+				pTransaction->pUserArg=this;		// do ref counting manually for callback data
+				this->AddRef();
 #if DOWNLOAD_MGR_DBG
-						m_downloadStarted=gEnv->pTimer->GetAsyncCurTime();
+				m_downloadStarted=gEnv->pTimer->GetAsyncCurTime();
 #endif
-						m_state=k_awaitingHTTPResponse;
-						if (!m_pService->UploadData(pTransaction))
-						{
-							this->Release();
-							pTransaction=NULL;
-						}
-					}
-					else
-					{
-						pTransaction=NULL;
-					}
+				m_state=k_awaitingHTTPResponse;
+				m_requestInFlight=true;
+
+				bool		uploaded;
+#if DOWNLOAD_MGR_TEST_SERVER
+				if (pTestServer)
+				{
+					uploaded=pTestServer->RequestReceived(pTransaction);
+				}
+				else
+#endif
+				{
+					uploaded=m_pService->UploadData(pTransaction);
 				}
-			}
 
-			if (!pTransaction)
+				if (!uploaded)
+				{
+					m_requestInFlight=false;
+					this->Release();
+					pTransaction=NULL;
+				}
+			}
+			else
 			{
-				m_state=k_failedInternalError;
+				pTransaction=NULL;
 			}
 		}
 	}
+
+	if (!pTransaction)
+	{
+		m_state=k_failedInternalError;
+	}
+}
+
+void CDownloadableResource::GetCachePath(
+	CryFixedStringT<ICryPak::g_nMaxPath>	&outPath,
+	const char						*pInExtension)
+{
+	char		path[ICryPak::g_nMaxPath];
+	path[sizeof(path) - 1] = 0;
+	gEnv->pCryPak->AdjustFileName(k_downloadCacheFolder, path, ICryPak::FLAGS_PATH_REAL | ICryPak::FLAGS_FOR_WRITING);
+
+	outPath.Format("%s/%s.%s",path,m_descName.c_str(),pInExtension);
+}
+
+// the etag of the cached copy, if there is a complete one
+void CDownloadableResource::LoadCachedETag()
+{
+	m_etag.clear();
+
+	if (m_cacheable && g_pGameCVars->g_downloadMgrCache)
+	{
+		CryFixedStringT<ICryPak::g_nMaxPath>	path;
+		ICryPak		*pPak=gEnv->pCryPak;
+
+		GetCachePath(path,"etag");
+		FILE			*pFile=pPak->FOpen(path.c_str(),"rb",ICryPak::FLAGS_PATH_REAL);
+
+		if (pFile)
+		{
+			char			etag[64];
+			size_t		len=pPak->FReadRaw(etag,1,sizeof(etag)-1,pFile);
+			pPak->FClose(pFile);
+
+			etag[len]=0;
+			m_etag=etag;
+		}
+	}
+}
+
+// keeps a freshly downloaded copy along with its etag, so the next request can be conditional
+void CDownloadableResource::WriteCachedData()
+{
+	if (m_cacheable && g_pGameCVars->g_downloadMgrCache && !m_notModified && !m_pStreamSink && !m_responseETag.empty())
+	{
+		CryFixedStringT<ICryPak::g_nMaxPath>	dataPath;
+		CryFixedStringT<ICryPak::g_nMaxPath>	etagPath;
+		ICryPak		*pPak=gEnv->pCryPak;
+
+		GetCachePath(dataPath,"dat");
+		GetCachePath(etagPath,"etag");
+
+		// the etag goes last, a copy without one is never used
+		pPak->RemoveFile(etagPath.c_str());
+		pPak->MakeDir(PathUtil::GetPath(dataPath.c_str()).c_str());
+
+		bool			written=false;
+		FILE			*pFile=pPak->FOpen(dataPath.c_str(),"wb",ICryPak::FLAGS_PATH_REAL);
+
+		if (pFile)
+		{
+			written=(pPak->FWrite(m_pBuffer+m_contentOffset,1,m_contentLength,pFile)==size_t(m_contentLength));
+			pPak->FClose(pFile);
+		}
+
+		if (written && (pFile=pPak->FOpen(etagPath.c_str(),"wb",ICryPak::FLAGS_PATH_REAL))!=NULL)
+		{
+			pPak->FWrite(m_responseETag.c_str(),1,m_responseETag.length(),pFile);
+			pPak->FClose(pFile);
+		}
+		else
+		{
+			CryLog("Failed to cache downloaded resource %s to %s",m_descName.c_str(),dataPath.c_str());
+		}
+	}
 }
 
 bool CDownloadableResource::Purge()
@@ -1018,8 +1450,11 @@ bool CDownloadableResource::Purge()
 		m_abortDownload=false;
 
 		SAFE_DELETE_ARRAY(m_pBuffer);
+		SAFE_DELETE_ARRAY(m_pResumeData);
 		m_bufferUsed=m_bufferSize=0;
-		m_contentLength=m_contentOffset=0;
+		m_contentLength=m_contentOffset=m_streamedLength=m_resumeLength=0;
+		m_notModified=false;
+		m_responseETag.clear();
 
 		ok=true;
 	}
@@ -1043,13 +1478,24 @@ void CDownloadableResource::SetDownloadInfo(const char* pUrl, const char* pUrlPr
 	m_url = pUrl;
 }
 
+void CDownloadableResource::SetStreamSink(
+	IDataStreamSink		*pInSink)
+{
+	CRY_ASSERT_MESSAGE(m_state==k_notStarted,"You cannot change the stream sink of a CDownloadableResource once it has started downloading");
+
+	if (m_state==k_notStarted)
+	{
+		m_pStreamSink=pInSink;
+	}
+}
+
 CDownloadableResource::TState CDownloadableResource::GetRawData(
 	char				**pOutData,
 	int					*pOutLen)
 {
 	StartDownloading();
 
-	if (m_state==k_dataAvailable)
+	if (m_state==k_dataAvailable && !m_pStreamSink)
 	{
 		*pOutData=m_pBuffer+m_contentOffset;
 		*pOutLen=m_contentLength;
@@ -1143,7 +1589,7 @@ CDownloadableResource::TState CDownloadableResource::GetDecryptedData(
 	StartDownloading();
 
 	bool success = false;
-	if (m_state==k_dataAvailable)
+	if (m_state==k_dataAvailable && !m_pStreamSink)
 	{
 		char* pEncryptedBuffer = m_pBuffer+m_contentOffset;
 		int encryptedLength = m_contentLength;
@@ -1183,7 +1629,7 @@ CDownloadableResource::TState CDownloadableResource::GetProgress(
 {
 	if (m_state&(k_dataAvailable|k_awaitingPayload))
 	{
-		*outBytesDownloaded=m_bufferUsed-m_contentOffset;
+		*outBytesDownloaded=GetPayloadReceived();
 		*outTotalBytesToDownload=m_contentLength;
 	}
 	else
@@ -1195,10 +1641,12 @@ CDownloadableResource::TState CDownloadableResource::GetProgress(
 }
 
 void CDownloadableResource::AddDataListener(
-	IDataListener	*pInListener)
+	IDataListener	*pInListener,
+	int						inPriority)
 {
 	CRY_ASSERT_MESSAGE(std::find(m_listeners.begin(), m_listeners.end(), pInListener) == m_listeners.end(), "A downloadable resource should not have two instances of the same listener");
 	m_listeners.push_back(pInListener);
+	m_priority=max(m_priority,inPriority);
 
 	switch (m_broadcastedState)
 	{
@@ -1254,6 +1702,95 @@ void CDownloadableResource::CancelDownload()
 	}
 }
 
+void CDownloadMgr::ScheduleDownload(
+	CDownloadableResourcePtr	pInResource)
+{
+	m_queuedDownloads.push_back(pInResource);
+	UpdateScheduler();
+}
+
+static bool CompareDownloadPriority(
+	const CDownloadableResourcePtr	&inA,
+	const CDownloadableResourcePtr	&inB)
+{
+	return inA->GetPriority()>inB->GetPriority();
+}
+
+void CDownloadMgr::UpdateScheduler()
+{
+	const CTimeValue	now=gEnv->pTimer->GetAsyncTime();
+	int								numInFlight=0;
+
+	// finished requests make room, the ones that failed softly go back in the queue
+	for (TResourceVector::iterator iter=m_activeDownloads.begin(); iter!=m_activeDownloads.end(); )
+	{
+		CDownloadableResourcePtr	pPtr=*iter;
+
+		// in flight is cleared after retry pending is set, so check it first
+		if (pPtr->m_requestInFlight)
+		{
+			numInFlight++;
+			++iter;
+		}
+		else
+		{
+			if (pPtr->m_retryPending)
+			{
+				// back off, a server that is struggling isn't helped by asking it again straight away
+				CryLog("Retrying download of resource %s from byte %d in %.1f secs, %d retries left",pPtr->GetDescription(),pPtr->m_pStreamSink ? pPtr->m_streamedLength : pPtr->m_resumeLength,pPtr->m_retryDelay,pPtr->m_retriesLeft);
+				pPtr->m_retryPending=false;
+				pPtr->m_retryTime=now+CTimeValue(pPtr->m_retryDelay);
+				pPtr->m_retryDelay*=2.f;
+				m_queuedDownloads.push_back(pPtr);
+			}
+			iter=m_activeDownloads.erase(iter);
+		}
+	}
+
+	for (TResourceVector::iterator iter=m_queuedDownloads.begin(); iter!=m_queuedDownloads.end(); )
+	{
+		CDownloadableResourcePtr	pPtr=*iter;
+
+		if (pPtr->m_abortDownload)
+		{
+			// cancelled whilst waiting, listeners have already been told
+			pPtr->m_state=CDownloadableResource::k_failedAborted;
+			iter=m_queuedDownloads.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+
+	std::stable_sort(m_queuedDownloads.begin(),m_queuedDownloads.end(),CompareDownloadPriority);
+
+	const int					maxInFlight=max(g_pGameCVars->g_downloadMgrMaxConcurrent,1);
+
+	for (TResourceVector::iterator iter=m_queuedDownloads.begin(); iter!=m_queuedDownloads.end() && numInFlight<maxInFlight; )
+	{
+		CDownloadableResourcePtr	pPtr=*iter;
+
+		if (pPtr->m_retryTime>now)
+		{
+			// still backing off, lower priority requests can go first
+			++iter;
+		}
+		else
+		{
+			iter=m_queuedDownloads.erase(iter);
+
+			pPtr->IssueRequest();
+
+			if (pPtr->m_requestInFlight)
+			{
+				m_activeDownloads.push_back(pPtr);
+				numInFlight++;
+			}
+		}
+	}
+}
+
 void CDownloadMgr::WaitForDownloadsToFinish(const char** resources, int numResources, float timeout)
 {
 	CDownloadableResourcePtr* pResources=new CDownloadableResourcePtr[numResources];
@@ -1289,6 +1826,7 @@ void CDownloadMgr::WaitForDownloadsToFinish(const char** resources, int numResou
 			break;
 		}
 		CrySleep(100);
+		UpdateScheduler();
 	};
 	delete [] pResources;
 	DispatchCallbacks();
@@ -1397,8 +1935,9 @@ void CDownloadMgr::DbgList(
 			}
 		}
 
-		CryLogAlways("Resource %d : %s : state %s    : content %d B / %d B (%.2f bytes/sec) (%.2f elapsed)",
-			count,pPtr->m_descName.c_str(), ss, pPtr->m_bufferUsed-pPtr->m_contentOffset, pPtr->m_contentLength, pPtr->GetTransferRate(),timeElapsed);
+		CryLogAlways("Resource %d : %s : state %s    : content %d B / %d B (%.2f bytes/sec) (%.2f elapsed) : priority %d, %d retries left%s%s",
+			count,pPtr->m_descName.c_str(), ss, pPtr->GetPayloadReceived(), pPtr->m_contentLength, pPtr->GetTransferRate(),timeElapsed,
+			pPtr->m_priority, pPtr->m_retriesLeft, (std::find(pDlm->m_queuedDownloads.begin(),pDlm->m_queuedDownloads.end(),pPtr)!=pDlm->m_queuedDownloads.end()) ? ", queued" : "", pPtr->m_notModified ? ", cached" : "");
 
 		count++;
 	}
@@ -1507,7 +2046,7 @@ void CDownloadableResource::DebugContentsToString(CryFixedStringT<512> &outStr)
 		}
 	}
 	outStr.Format("Resource %s : state %s    : content %d B / %d B (%.2f bytes/sec) (elapsed %.2f sec)",
-					 m_descName.c_str(), ss, m_bufferUsed-m_contentOffset, m_contentLength, GetTransferRate(),timeElapsed);
+					 m_descName.c_str(), ss, GetPayloadReceived(), m_contentLength, GetTransferRate(),timeElapsed);
 }
 
 void CDownloadableResource::DebugWatchContents()
@@ -1530,7 +2069,7 @@ float CDownloadableResource::GetTransferRate()
 
 			if (took>0.0f)
 			{
-				trate=float(m_bufferUsed)/float(took);
+				trate=float(m_contentOffset+GetPayloadReceived())/float(took);
 			}
 		}
 		else
@@ -1540,7 +2079,7 @@ float CDownloadableResource::GetTransferRate()
 
 			if (taken>0.0f)
 			{
-				trate=float(m_bufferUsed)/float(taken);
+				trate=float(m_contentOffset+GetPayloadReceived())/float(taken);
 			}
 		}
 	}
@@ -1549,3 +2088,350 @@ float CDownloadableResource::GetTransferRate()
 }
 
 #endif
+
+#if DOWNLOAD_MGR_TEST_SERVER
+CDownloadTestServer	*CDownloadTestServer::s_pRunning=NULL;
+
+CDownloadTestServer::CDownloadTestServer(
+	const char				*pInHost,
+	int								inMaxRetries,
+	float							inRetryDelay) :
+	m_host(pInHost),
+	m_savedMaxRetries(g_pGameCVars->g_downloadMgrMaxRetries),
+	m_savedMaxConcurrent(g_pGameCVars->g_downloadMgrMaxConcurrent),
+	m_savedCache(g_pGameCVars->g_downloadMgrCache),
+	m_savedRetryDelay(g_pGameCVars->g_downloadMgrRetryDelay)
+{
+	CRY_ASSERT_MESSAGE(!s_pRunning,"Only one CDownloadTestServer can run at a time");
+	s_pRunning=this;
+
+	g_pGameCVars->g_downloadMgrMaxRetries=inMaxRetries;
+	g_pGameCVars->g_downloadMgrMaxConcurrent=INT_MAX;
+	g_pGameCVars->g_downloadMgrCache=1;
+	g_pGameCVars->g_downloadMgrRetryDelay=inRetryDelay;
+}
+
+CDownloadTestServer::~CDownloadTestServer()
+{
+	// requests left unanswered are aborted, so their resources get their reference back and don't retry over the network
+	for (std::vector<STCPServiceDataPtr>::iterator iter=m_pendingRequests.begin(); iter!=m_pendingRequests.end(); ++iter)
+	{
+		STCPServiceDataPtr		pRequest=*iter;
+
+		static_cast<CDownloadableResource*>(pRequest->pUserArg)->m_abortDownload=true;
+		pRequest->tcpServReplyCb(eCTCPSR_Ok,pRequest->pUserArg,pRequest,NULL,0,true);
+	}
+
+	g_pGameCVars->g_downloadMgrMaxRetries=m_savedMaxRetries;
+	g_pGameCVars->g_downloadMgrMaxConcurrent=m_savedMaxConcurrent;
+	g_pGameCVars->g_downloadMgrCache=m_savedCache;
+	g_pGameCVars->g_downloadMgrRetryDelay=m_savedRetryDelay;
+
+	s_pRunning=NULL;
+}
+
+string CDownloadTestServer::MakeReply(
+	const char				*pInStatus,
+	const char				*pInHeaders,
+	const char				*pInPayload,
+	int								inPayloadLen)
+{
+	string						reply;
+
+	reply.Format("HTTP/1.1 %s\r\nContent-Length: %d\r\n%s\r\n",pInStatus,inPayloadLen,pInHeaders);
+	reply.append(pInPayload,inPayloadLen);
+
+	return reply;
+}
+
+void CDownloadTestServer::QueueReply(
+	const string			&inReply,
+	int								inChunkSize,
+	int								inDropAfter)
+{
+	SReply						reply;
+
+	reply.data=inReply;
+	reply.chunkSize=max(inChunkSize,1);
+	reply.dropAfter=(inDropAfter>=0) ? min(inDropAfter,int(inReply.length())) : int(inReply.length());
+	reply.unreachable=false;
+
+	m_replies.push_back(reply);
+}
+
+void CDownloadTestServer::QueueUnreachable()
+{
+	SReply						reply;
+
+	reply.chunkSize=1;
+	reply.dropAfter=0;
+	reply.unreachable=true;
+
+	m_replies.push_back(reply);
+}
+
+bool CDownloadTestServer::Reply()
+{
+	if (m_pendingRequests.empty() || m_replies.empty())
+	{
+		return false;
+	}
+
+	STCPServiceDataPtr	pRequest=m_pendingRequests.front();
+	SReply							reply=m_replies.front();
+
+	m_pendingRequests.erase(m_pendingRequests.begin());
+	m_replies.erase(m_replies.begin());
+
+	if (reply.unreachable)
+	{
+		pRequest->tcpServReplyCb(eCTCPSR_Failed,pRequest->pUserArg,pRequest,NULL,0,true);
+	}
+	else
+	{
+		bool							finished=false;
+
+		for (int sent=0; sent<reply.dropAfter && !finished; sent+=reply.chunkSize)
+		{
+			finished=pRequest->tcpServReplyCb(eCTCPSR_Ok,pRequest->pUserArg,pRequest,reply.data.c_str()+sent,min(reply.chunkSize,reply.dropAfter-sent),false);
+		}
+
+		// the server closes the connection once it has sent the reply, or the connection drops part way through
+		if (!finished)
+		{
+			pRequest->tcpServReplyCb(eCTCPSR_Ok,pRequest->pUserArg,pRequest,NULL,0,true);
+		}
+	}
+
+	return true;
+}
+
+bool CDownloadTestServer::RequestReceived(
+	STCPServiceDataPtr	pInRequest)
+{
+	m_requests.push_back(string(pInRequest->pData,pInRequest->length));
+	m_pendingRequests.push_back(pInRequest);
+
+	return true;
+}
+
+// the scheduler against a stand-in server
+namespace
+{
+	const char	*k_testHost="downloadmgr.unittest";
+	const int		k_testPayloadSize=8*1024;
+	const int		k_testChunkSize=1024;
+
+	void MakeTestPayload(
+		std::vector<char>		&outPayload)
+	{
+		outPayload.resize(k_testPayloadSize);
+		for (int i=0; i<k_testPayloadSize; ++i)
+		{
+			outPayload[i]=char((i*17+i/253)&0xff);
+		}
+	}
+
+	CDownloadableResourcePtr StartTestDownload(
+		const char					*pInDescName,
+		bool								inCacheable)
+	{
+		CDownloadableResourcePtr	pResource=new CDownloadableResource;
+
+		pResource->SetDownloadInfo(pInDescName,"",k_testHost,80,k_testPayloadSize+k_httpHeaderSize,pInDescName);
+		pResource->SetCacheable(inCacheable);
+		pResource->StartDownloading();
+
+		return pResource;
+	}
+
+	bool HasTestPayload(
+		CDownloadableResourcePtr	pInResource,
+		const std::vector<char>		&inPayload)
+	{
+		char		*pData=NULL;
+		int			len=0;
+
+		pInResource->GetRawData(&pData,&len);
+
+		return (len==int(inPayload.size()) && memcmp(pData,&inPayload[0],len)==0);
+	}
+
+	void RemoveTestCache(
+		const char					*pInDescName,
+		const char					*pInExtension)
+	{
+		char		path[ICryPak::g_nMaxPath];
+		path[sizeof(path)-1]=0;
+		gEnv->pCryPak->AdjustFileName(k_downloadCacheFolder,path,ICryPak::FLAGS_PATH_REAL|ICryPak::FLAGS_FOR_WRITING);
+
+		CryFixedStringT<ICryPak::g_nMaxPath>	filePath;
+		filePath.Format("%s/%s.%s",path,pInDescName,pInExtension);
+		gEnv->pCryPak->RemoveFile(filePath.c_str());
+	}
+
+	// downloads the payload and caches it with etag "v1"
+	void CacheTestPayload(
+		CDownloadTestServer	&inServer,
+		const char					*pInDescName,
+		const std::vector<char>	&inPayload)
+	{
+		RemoveTestCache(pInDescName,"dat");
+		RemoveTestCache(pInDescName,"etag");
+
+		CDownloadableResourcePtr	pResource=StartTestDownload(pInDescName,true);
+		inServer.QueueReply(CDownloadTestServer::MakeReply("200 OK","ETag: \"v1\"\r\n",&inPayload[0],k_testPayloadSize),k_testChunkSize);
+		inServer.Reply();
+		pResource->DispatchCallbacks();
+	}
+}
+
+CRY_UNIT_TEST_SUITE(CryDownloadMgrTest)
+{
+	CRY_UNIT_TEST(NotModifiedServedFromCache)
+	{
+		CRY_UNIT_TEST_ASSERT(g_pGame && g_pGame->GetDownloadMgr());
+
+		const char						*pName="unittest_cached";
+		CDownloadTestServer		server(k_testHost,0);
+		std::vector<char>			payload;
+		MakeTestPayload(payload);
+
+		// the first download is unconditional
+		CacheTestPayload(server,pName,payload);
+		CRY_UNIT_TEST_ASSERT(strstr(server.GetRequest(0).c_str(),"If-None-Match")==NULL);
+
+		// the next asks whether it changed, and takes the payload from disk when it hasn't
+		CDownloadableResourcePtr	pResource=StartTestDownload(pName,true);
+		server.QueueReply(CDownloadTestServer::MakeReply("304 Not Modified","ETag: \"v1\"\r\n","",0),k_testChunkSize);
+		CRY_UNIT_TEST_ASSERT(server.Reply());
+		CRY_UNIT_TEST_ASSERT(strstr(server.GetRequest(1).c_str(),"If-None-Match: \"v1\"")!=NULL);
+		CRY_UNIT_TEST_ASSERT(pResource->GetState()==CDownloadableResource::k_dataAvailable);
+		CRY_UNIT_TEST_ASSERT(HasTestPayload(pResource,payload));
+
+		RemoveTestCache(pName,"dat");
+		RemoveTestCache(pName,"etag");
+	}
+
+	CRY_UNIT_TEST(NotModifiedWithoutCachedCopy)
+	{
+		CRY_UNIT_TEST_ASSERT(g_pGame && g_pGame->GetDownloadMgr());
+
+		const char						*pName="unittest_uncached";
+		CDownloadTestServer		server(k_testHost,0);
+		std::vector<char>			payload;
+		MakeTestPayload(payload);
+
+		// the cached copy went missing, but not its etag
+		CacheTestPayload(server,pName,payload);
+		RemoveTestCache(pName,"dat");
+
+		CDownloadableResourcePtr	pResource=StartTestDownload(pName,true);
+		server.QueueReply(CDownloadTestServer::MakeReply("304 Not Modified","","",0),k_testChunkSize);
+		CRY_UNIT_TEST_ASSERT(server.Reply());
+		CRY_UNIT_TEST_ASSERT(strstr(server.GetRequest(1).c_str(),"If-None-Match")!=NULL);
+		CRY_UNIT_TEST_ASSERT(pResource->GetState()==CDownloadableResource::k_failedInternalError);
+
+		// so the next request isn't conditional, and a 304 to it isn't believed
+		pResource=StartTestDownload(pName,true);
+		server.QueueReply(CDownloadTestServer::MakeReply("304 Not Modified","","",0),k_testChunkSize);
+		CRY_UNIT_TEST_ASSERT(server.Reply());
+		CRY_UNIT_TEST_ASSERT(strstr(server.GetRequest(2).c_str(),"If-None-Match")==NULL);
+		CRY_UNIT_TEST_ASSERT(pResource->GetState()==CDownloadableResource::k_failedReplyHasBadHeader);
+	}
+
+	CRY_UNIT_TEST(RetryBackoff)
+	{
+		CRY_UNIT_TEST_ASSERT(g_pGame && g_pGame->GetDownloadMgr());
+
+		CDownloadMgr					*pMgr=g_pGame->GetDownloadMgr();
+		const float						retryDelay=0.2f;
+		CDownloadTestServer		server(k_testHost,2,retryDelay);
+
+		CDownloadableResourcePtr	pResource=StartTestDownload("unittest_backoff",false);
+		CRY_UNIT_TEST_ASSERT(server.GetNumRequests()==1);
+
+		// the first retry waits the delay
+		server.QueueUnreachable();
+		server.Reply();
+		pMgr->UpdateScheduler();
+		CRY_UNIT_TEST_ASSERT(server.GetNumRequests()==1);
+		CrySleep(int(retryDelay*1000.f)+50);
+		pMgr->UpdateScheduler();
+		CRY_UNIT_TEST_ASSERT(server.GetNumRequests()==2);
+
+		// the second waits twice as long
+		server.QueueUnreachable();
+		server.Reply();
+		pMgr->UpdateScheduler();
+		CrySleep(int(retryDelay*1000.f)+50);
+		pMgr->UpdateScheduler();
+		CRY_UNIT_TEST_ASSERT(server.GetNumRequests()==2);
+		CrySleep(int(retryDelay*1000.f));
+		pMgr->UpdateScheduler();
+		CRY_UNIT_TEST_ASSERT(server.GetNumRequests()==3);
+
+		// and then it has run out of retries
+		server.QueueUnreachable();
+		server.Reply();
+		pMgr->UpdateScheduler();
+		CRY_UNIT_TEST_ASSERT(pResource->GetState()==CDownloadableResource::k_failedServerUnreachable);
+		CRY_UNIT_TEST_ASSERT(server.GetNumPendingRequests()==0);
+	}
+
+	CRY_UNIT_TEST(ResumeAfterDroppedConnection)
+	{
+		CRY_UNIT_TEST_ASSERT(g_pGame && g_pGame->GetDownloadMgr());
+
+		CDownloadMgr					*pMgr=g_pGame->GetDownloadMgr();
+		CDownloadTestServer		server(k_testHost,1);
+		std::vector<char>			payload;
+		MakeTestPayload(payload);
+
+		CDownloadableResourcePtr	pResource=StartTestDownload("unittest_resume",false);
+
+		// the connection drops part way through the payload
+		const int							resumeFrom=k_testPayloadSize/2+100;
+		const string					firstReply=CDownloadTestServer::MakeReply("200 OK","Accept-Ranges: bytes\r\n",&payload[0],k_testPayloadSize);
+		server.QueueReply(firstReply,k_testChunkSize,int(firstReply.length())-k_testPayloadSize+resumeFrom);
+		server.Reply();
+		pMgr->UpdateScheduler();
+
+		// only the rest is asked for, and spliced on to what was kept
+		CryFixedStringT<64>		range;
+		range.Format("Range: bytes=%d-",resumeFrom);
+		CRY_UNIT_TEST_ASSERT(server.GetNumRequests()==2 && strstr(server.GetRequest(1).c_str(),range.c_str())!=NULL);
+
+		CryFixedStringT<128>	headers;
+		headers.Format("Accept-Ranges: bytes\r\nContent-Range: bytes %d-%d/%d\r\n",resumeFrom,k_testPayloadSize-1,k_testPayloadSize);
+		server.QueueReply(CDownloadTestServer::MakeReply("206 Partial Content",headers.c_str(),&payload[resumeFrom],k_testPayloadSize-resumeFrom),k_testChunkSize);
+		server.Reply();
+		CRY_UNIT_TEST_ASSERT(pResource->GetState()==CDownloadableResource::k_dataAvailable);
+		CRY_UNIT_TEST_ASSERT(HasTestPayload(pResource,payload));
+	}
+
+	CRY_UNIT_TEST(RestartWhenRangeIgnored)
+	{
+		CRY_UNIT_TEST_ASSERT(g_pGame && g_pGame->GetDownloadMgr());
+
+		CDownloadMgr					*pMgr=g_pGame->GetDownloadMgr();
+		CDownloadTestServer		server(k_testHost,1);
+		std::vector<char>			payload;
+		MakeTestPayload(payload);
+
+		CDownloadableResourcePtr	pResource=StartTestDownload("unittest_restart",false);
+
+		const string					reply=CDownloadTestServer::MakeReply("200 OK","Accept-Ranges: bytes\r\n",&payload[0],k_testPayloadSize);
+		server.QueueReply(reply,k_testChunkSize,int(reply.length())-k_testPayloadSize/4);
+		server.Reply();
+		pMgr->UpdateScheduler();
+		CRY_UNIT_TEST_ASSERT(server.GetNumRequests()==2);
+
+		// the server sends all of it again instead of the range, what was kept is dropped rather than duplicated
+		server.QueueReply(reply,k_testChunkSize);
+		server.Reply();
+		CRY_UNIT_TEST_ASSERT(pResource->GetState()==CDownloadableResource::k_dataAvailable);
+		CRY_UNIT_TEST_ASSERT(HasTestPayload(pResource,payload));
+	}
+}
+#endif
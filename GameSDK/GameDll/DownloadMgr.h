@@ -16,6 +16,10 @@
 #define DOWNLOAD_MGR_DBG	1
 #endif
 
+#if defined(CRY_UNIT_TESTING)
+#define DOWNLOAD_MGR_TEST_SERVER	1
+#endif
+
 
 class CDownloadableResource;
 typedef _smart_ptr<CDownloadableResource> CDownloadableResourcePtr;
@@ -30,9 +34,24 @@ struct IDataListener
 	virtual											~IDataListener();
 };
 
+// receives the payload of a resource as it arrives, instead of the resource holding all of it in memory
+// called on the network thread, in order, only whilst the download is in progress
+struct IDataStreamSink : public CMultiThreadRefCount
+{
+	// return false to abort the download
+	virtual bool								DataReceived(
+																CDownloadableResource	*pInResource,
+																const char						*pInData,
+																int										inDataLen)=0;
+};
+typedef _smart_ptr<IDataStreamSink> IDataStreamSinkPtr;
+
 class CDownloadableResource : public CMultiThreadRefCount
 {
 	friend class CDownloadMgr;
+#if DOWNLOAD_MGR_TEST_SERVER
+	friend class CDownloadTestServer;
+#endif
 
 	public:
 		typedef uint32							TState;
@@ -56,6 +75,9 @@ class CDownloadableResource : public CMultiThreadRefCount
 		static const TState					k_callbackInProgressMask				= (k_awaitingHTTPResponse|k_awaitingPayload);
 		static const TState					k_dataPermanentFailMask					= (k_failedReplyTimedOut|k_failedServerUnreachable|k_failedInternalError|k_failedReplyHasBadHeader|k_failedReplyContentTooLong|k_failedReplyContentTruncated|k_failedUnknownResource|k_failedAborted);
 		static const TState					k_dataSoftFailMask							= (k_failedReplyTimedOut|k_failedServerUnreachable);
+		static const TState					k_dataRetryMask									= (k_dataSoftFailMask|k_failedReplyContentTruncated);
+
+		static const int						k_defaultPriority=0;
 
 	protected:
 		typedef std::vector<IDataListener*>		TListenerVector;
@@ -70,6 +92,8 @@ class CDownloadableResource : public CMultiThreadRefCount
 		CryFixedStringT<64>					m_server;
 		int													m_port;
 		int													m_maxDownloadSize;
+		int													m_priority;						// higher priority resources are requested first when the download mgr has to queue them
+		bool												m_cacheable;					// kept on disk and only fetched again when the server has changed it, by conditional GET
 
 		enum EListenerBroadcastedState
 		{
@@ -91,9 +115,25 @@ class CDownloadableResource : public CMultiThreadRefCount
 		int													m_bufferSize;
 		int													m_contentLength;			// size and offset into the buffer of where the content starts
 		int													m_contentOffset;
+		int													m_streamedLength;			// payload handed to m_pStreamSink so far
 		TState											m_state;
+		char												*m_pResumeData;				// payload received before a failed attempt, spliced back in once the range request is answered
+		int													m_resumeLength;
+		int													m_retriesLeft;
+		float												m_retryDelay;					// main thread, doubled each time the request is retried
+		CTimeValue									m_retryTime;					// main thread, a retry isn't requested before then
+		CryFixedStringT<64>					m_etag;								// of the cached copy, sent as If-None-Match
+		CryFixedStringT<64>					m_responseETag;
+		bool												m_acceptsRanges;
+		bool												m_notModified;				// the cached copy was used
+		volatile bool								m_requestInFlight;		// cleared from the callback thread once the request has finished
+		volatile bool								m_retryPending;				// set from the callback thread, the download mgr issues the request again
 		////////////////
 
+		bool												m_scheduled;					// started through the download mgr, which can retry it
+
+		IDataStreamSinkPtr					m_pStreamSink;
+
 		bool												m_abortDownload;			// set from main thread, read from callback thread
 		bool												m_doingHTTPParse;			// set when the downloadable resource is in the middle of a InitHTTPParser() / ReleaseHTTPParser() pair
 #if defined(DEDICATED_SERVER)
@@ -113,6 +153,24 @@ class CDownloadableResource : public CMultiThreadRefCount
 																	size_t								inDataLen);
 		bool												ReceiveHTTPHeader(
 																	bool								inReceivedEndOfStream);
+		bool												StreamData(
+																	const char						*pInData,
+																	int										inDataLen);
+		bool												ReceiveNotModified();
+		void												ResumePayload();
+		void												FindHeaderField(
+																	const char						*pInField,
+																	CryFixedStringT<64>		&outValue);
+		void												FinishRequest();
+		bool												PrepareRetry();
+
+		void												IssueRequest();
+		void												GetCachePath(
+																	CryFixedStringT<ICryPak::g_nMaxPath>	&outPath,
+																	const char						*pInExtension);
+		void												LoadCachedETag();
+		void												WriteCachedData();
+		int													GetPayloadReceived() const	{ return m_pStreamSink ? m_streamedLength : m_bufferUsed-m_contentOffset; }
 
 		bool												DecryptAndCheckSigning(
 																	const char						*pInData,
@@ -155,6 +213,11 @@ class CDownloadableResource : public CMultiThreadRefCount
 		// set the download information
 		void												SetDownloadInfo(const char* pUrl, const char* pUrlPrefix, const char* pServer, const int port, const int maxDownloadSize, const char* pDescName=NULL);
 
+		// streams the payload to the sink as it arrives rather than keeping it, must be set before the download starts
+		// a streamed resource has no data to return from GetRawData() or GetDecryptedData()
+		void												SetStreamSink(
+																	IDataStreamSink				*pInSink);
+
 
 		// sets the agent string for any http requests we issue
 		void												GetUserAgentString(CryFixedStringT<64> &ioAgentStr);
@@ -209,6 +272,17 @@ class CDownloadableResource : public CMultiThreadRefCount
 		// returns download Max Size
 		int													GetMaxSize()			{ return m_maxDownloadSize; }
 
+		// returns the priority the download mgr requests it with
+		int													GetPriority() const	{ return m_priority; }
+
+		// keeps the resource in the download cache, as the download mgr config does unless cache="0" is set
+		// must be set before the download starts
+		void												SetCacheable(
+																	bool									inCacheable)	{ m_cacheable=inCacheable; }
+
+		// returns the memory held for the http reply, the whole payload unless the resource is streamed
+		int													GetBufferSize() const	{ return m_bufferSize; }
+
 #if DOWNLOAD_MGR_DBG
 		// returns the transfer rate in bytes/sec
 		float												GetTransferRate();
@@ -224,8 +298,10 @@ class CDownloadableResource : public CMultiThreadRefCount
 		// if the data is already downloaded or has already permanently failed the listener will be called immediately
 		// also starts resource downloading if not already downloaded
 		// all callbacks are issued on the main thread
+		// the resource is requested with the highest priority of its listeners
 		void												AddDataListener(
-																	IDataListener					*pInListener);
+																	IDataListener					*pInListener,
+																	int										inPriority=k_defaultPriority);
 		void												RemoveDataListener(
 																	IDataListener					*pInListener);
 
@@ -251,6 +327,8 @@ class CDownloadMgr : public CGameMechanismBase, public IPatchPakManagerListener
 		typedef std::vector<CDownloadableResourcePtr>	TResourceVector;
 
 		TResourceVector							m_resources;
+		TResourceVector							m_queuedDownloads;		// waiting for one of the g_downloadMgrMaxConcurrent requests to finish
+		TResourceVector							m_activeDownloads;
 #if defined(DEDICATED_SERVER)
 		TResourceVector							m_refreshResources;
 		CTimeValue									m_lastUpdateTime;
@@ -311,6 +389,15 @@ class CDownloadMgr : public CGameMechanismBase, public IPatchPakManagerListener
 		void												PurgeLocalizedResourceByName(
 																	const char						*inResourceName);
 
+		// requests the resource now if fewer than g_downloadMgrMaxConcurrent requests are in flight, otherwise queues it
+		// called by CDownloadableResource::StartDownloading()
+		void												ScheduleDownload(
+																	CDownloadableResourcePtr	pInResource);
+
+		// issues queued and retried requests as others finish, done by Update() but needs calling
+		// whilst blocking the main thread waiting on downloads
+		void												UpdateScheduler();
+
 		// wait for downloads of specified resources to finish, warning this will stall the main thread
 		// until either the downloads finish or the timeout is reached
 		void												WaitForDownloadsToFinish(const char** resources, int numResources, float timeout);
@@ -332,5 +419,74 @@ class CDownloadMgr : public CGameMechanismBase, public IPatchPakManagerListener
 #endif
 };
 
+#if DOWNLOAD_MGR_TEST_SERVER
+// stands in for an http server in the unit tests, whilst one exists resources on its host send their requests to it rather than to
+// their tcp service. the replies the test has queued are handed back through the resource's callback from the main thread, when the
+// test calls Reply()
+class CDownloadTestServer
+{
+	protected:
+		struct SReply
+		{
+			string										data;
+			int												chunkSize;
+			int												dropAfter;
+			bool											unreachable;
+		};
+
+		std::vector<STCPServiceDataPtr>	m_pendingRequests;
+		std::vector<SReply>					m_replies;
+		std::vector<string>					m_requests;
+		string											m_host;
+		int													m_savedMaxRetries;
+		int													m_savedMaxConcurrent;
+		int													m_savedCache;
+		float												m_savedRetryDelay;
+
+		static CDownloadTestServer	*s_pRunning;
+
+	public:
+		// whilst it runs the download mgr caches resources that ask for it, retries failed requests inMaxRetries times
+		// after inRetryDelay secs, doubled each time, and doesn't hold any request back
+																CDownloadTestServer(
+																	const char						*pInHost,
+																	int										inMaxRetries,
+																	float									inRetryDelay=0.f);
+																~CDownloadTestServer();
+
+		static CDownloadTestServer	*GetRunning()			{ return s_pRunning; }
+		const char									*GetHost() const	{ return m_host.c_str(); }
+
+		// builds an http reply around the payload, the headers are each followed by \r\n
+		static string								MakeReply(
+																	const char						*pInStatus,
+																	const char						*pInHeaders,
+																	const char						*pInPayload,
+																	int										inPayloadLen);
+
+		// answers the next request with the reply, handed over inChunkSize bytes at a time
+		// if inDropAfter isn't negative the connection drops once that many bytes of the reply have been sent
+		void												QueueReply(
+																	const string					&inReply,
+																	int										inChunkSize,
+																	int										inDropAfter=-1);
+		// fails the next request as if the server couldn't be reached
+		void												QueueUnreachable();
+
+		// answers the oldest request waiting with the oldest reply queued, returns false if there is either none
+		bool												Reply();
+
+		// called by CDownloadableResource::IssueRequest() instead of uploading the request
+		bool												RequestReceived(
+																	STCPServiceDataPtr		pInRequest);
+
+		// the requests received so far, as sent
+		int													GetNumRequests() const		{ return int(m_requests.size()); }
+		const string								&GetRequest(
+																	int										inIndex) const	{ return m_requests[inIndex]; }
+		int													GetNumPendingRequests() const	{ return int(m_pendingRequests.size()); }
+};
+#endif
+
 #endif // __DOWNLOADMGR_H__
 
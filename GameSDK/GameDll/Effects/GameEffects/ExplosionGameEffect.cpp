@@ -20,6 +20,7 @@
 
 #include <IForceFeedbackSystem.h>
 #include "ActorManager.h"
+#include "Environment/WaterQueryCache.h"
 
 REGISTER_EFFECT_DEBUG_DATA(CExplosionGameEffect::DebugOnInputEvent,CExplosionGameEffect::DebugDisplay,Explosion);
 REGISTER_DATA_CALLBACKS(CExplosionGameEffect::LoadStaticData,CExplosionGameEffect::ReleaseStaticData,CExplosionGameEffect::ReloadStaticData,ExplosionData);
@@ -446,7 +447,7 @@ void CExplosionGameEffect::SpawnMaterialEffect(const SExplosionContainer &explos
 
 	// 0 for water, 1 for air
 	const Vec3 pos = params.pos;
-	const float waterLevel = gEnv->p3DEngine->GetWaterLevel(&pos); 
+	const float waterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(pos, CWaterQueryCache::eWQ_Effects); 
 	params.inWater = (buoyancy.waterPlane.origin.z > params.pos.z) && (waterLevel >= params.pos.z);
 	params.inZeroG = (gravity.len2() < 0.0001f);
 	params.trgSurfaceId = 0;
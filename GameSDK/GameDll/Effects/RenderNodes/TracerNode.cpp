@@ -0,0 +1,205 @@
+#include "StdAfx.h"
+#include "TracerNode.h"
+
+
+
+CTracerRenderNode::CTracerRenderNode()
+	:	m_aabb(AABB::RESET)
+	,	m_registered(false)
+{
+}
+
+
+
+CTracerRenderNode::~CTracerRenderNode()
+{
+	if (m_registered)
+	{
+		gEnv->p3DEngine->UnRegisterEntityDirect(this);
+	}
+}
+
+
+
+EERType CTracerRenderNode::GetRenderNodeType()
+{
+	return eERType_GameEffect;
+}
+
+
+
+const char* CTracerRenderNode::GetEntityClassName() const
+{
+	return "Tracers";
+}
+
+
+
+const char* CTracerRenderNode::GetName() const
+{
+	return "Tracers";
+}
+
+
+
+Vec3 CTracerRenderNode::GetPos(bool bWorldOnly) const
+{
+	return m_aabb.IsReset() ? Vec3(ZERO) : m_aabb.GetCenter();
+}
+
+
+
+void CTracerRenderNode::Render(const struct SRendParams& rParam, const SRenderingPassInfo& passInfo)
+{
+	const CCamera& camera = passInfo.GetCamera();
+	const Vec3 cameraPosition = camera.GetPosition();
+
+	SRendParams instanceParams(rParam);
+	instanceParams.pRenderNode = this;
+
+	const int numInstances = m_instances.size();
+	for (int i = 0; i < numInstances; ++i)
+	{
+		const SInstance& instance = m_instances[i];
+		CryPrefetch(&m_instances[min(i + 1, numInstances - 1)]);
+
+		// The node's bounds span every tracer, so each one is culled against the camera of this pass on its own
+		if (!camera.IsAABBVisible_F(instance.bounds))
+			continue;
+
+		instanceParams.pMatrix = const_cast<Matrix34*>(&instance.tm);
+		instanceParams.fAlpha = instance.opacity;
+		instanceParams.fDistance = cameraPosition.GetDistance(instance.tm.GetTranslation()) * passInfo.GetZoomFactor();
+
+		instance.pStatObj->Render(instanceParams, passInfo);
+	}
+}
+
+
+
+IPhysicalEntity* CTracerRenderNode::GetPhysics() const
+{
+	return 0;
+}
+
+
+
+void CTracerRenderNode::SetPhysics(IPhysicalEntity*)
+{
+}
+
+
+
+void CTracerRenderNode::SetMaterial(IMaterial* pMat)
+{
+}
+
+
+
+IMaterial* CTracerRenderNode::GetMaterial(Vec3* pHitPos)
+{
+	return 0;
+}
+
+
+
+IMaterial* CTracerRenderNode::GetMaterialOverride()
+{
+	return 0;
+}
+
+
+
+float CTracerRenderNode::GetMaxViewDist()
+{
+	const float maxViewDistance = 2000.0f;
+	return maxViewDistance;
+}
+
+
+
+void CTracerRenderNode::Precache()
+{
+}
+
+
+
+void CTracerRenderNode::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddObject(this, sizeof(*this));
+	pSizer->AddContainer(m_instances);
+}
+
+
+
+const AABB CTracerRenderNode::GetBBox() const
+{
+	return m_aabb;
+}
+
+
+
+void CTracerRenderNode::FillBBox(AABB &aabb)
+{
+	aabb = m_aabb;
+}
+
+
+
+void CTracerRenderNode::SetBBox(const AABB& WSBBox)
+{
+	m_aabb = WSBBox;
+}
+
+
+
+void CTracerRenderNode::OffsetPosition(const Vec3& delta)
+{
+	if (!m_aabb.IsReset())
+	{
+		m_aabb.Move(delta);
+	}
+}
+
+
+
+bool CTracerRenderNode::IsAllocatedOutsideOf3DEngineDLL()
+{
+	return true;
+}
+
+
+
+CTracerRenderNode::TInstances& CTracerRenderNode::BeginInstances()
+{
+	m_instances.clear();
+	return m_instances;
+}
+
+
+
+void CTracerRenderNode::EndInstances()
+{
+	// The node has to be re-inserted into the octree whenever its bounds change
+	if (m_registered)
+	{
+		gEnv->p3DEngine->UnRegisterEntityDirect(this);
+		m_registered = false;
+	}
+
+	if (m_instances.empty())
+		return;
+
+	AABB bounds(AABB::RESET);
+	const int numInstances = m_instances.size();
+	for (int i = 0; i < numInstances; ++i)
+	{
+		SInstance& instance = m_instances[i];
+		instance.bounds = AABB::CreateTransformedAABB(instance.tm, instance.pStatObj->GetAABB());
+		bounds.Add(instance.bounds);
+	}
+
+	m_aabb = bounds;
+	gEnv->p3DEngine->RegisterEntity(this);
+	m_registered = true;
+}
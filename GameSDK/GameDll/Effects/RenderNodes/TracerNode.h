@@ -0,0 +1,66 @@
+#ifndef _TRACER_NODE_
+#define _TRACER_NODE_
+
+
+
+#include "IGameRenderNode.h"
+
+
+
+//==================================================================================================
+// Name: CTracerRenderNode
+// Desc: Single render node that draws the geometry of every active tracer in one submission,
+//       replacing the per-tracer entity the tracer manager used to spawn
+//==================================================================================================
+class CTracerRenderNode : public IRenderNode
+{
+public:
+	struct SInstance
+	{
+		SInstance() : pStatObj(NULL), opacity(1.0f), bounds(AABB::RESET) {}
+
+		Matrix34		tm;
+		IStatObj*		pStatObj;
+		float				opacity;
+		AABB				bounds;			// world space, filled in by EndInstances()
+	};
+
+	typedef std::vector<SInstance> TInstances;
+
+	CTracerRenderNode();
+	virtual ~CTracerRenderNode();
+
+	// IRenderNode
+	virtual EERType GetRenderNodeType();
+	virtual const char* GetEntityClassName() const;
+	virtual const char* GetName() const;
+	virtual Vec3 GetPos(bool bWorldOnly = true) const;
+	virtual void Render(const struct SRendParams& rParam, const SRenderingPassInfo& passInfo);
+	virtual IPhysicalEntity* GetPhysics() const;
+	virtual void SetPhysics(IPhysicalEntity*);
+	virtual void SetMaterial(IMaterial* pMat);
+	virtual IMaterial* GetMaterial(Vec3* pHitPos = 0);
+	virtual IMaterial* GetMaterialOverride();
+	virtual float GetMaxViewDist();
+	virtual void Precache();
+	virtual void GetMemoryUsage(ICrySizer* pSizer) const;
+	virtual const AABB GetBBox() const;
+	virtual void FillBBox(AABB &aabb);
+	virtual void SetBBox(const AABB& WSBBox);
+	virtual void OffsetPosition(const Vec3& delta);
+	virtual bool IsAllocatedOutsideOf3DEngineDLL();
+
+	// Instances are rebuilt by the tracer manager every frame, before the scene is rendered
+	TInstances& BeginInstances();
+	void EndInstances();
+
+	int GetNumInstances() const { return (int)m_instances.size(); }
+
+private:
+	TInstances m_instances;
+	AABB m_aabb;
+	bool m_registered;
+};
+
+
+#endif
@@ -248,6 +248,10 @@ void CLedgeObject::GetMemoryUsage( ICrySizer *pSizer ) const
 
 void CLedgeObject::UpdateLocation()
 {
+	// In game the manager keeps the markers in the entity's frame, they follow it without updates
+	if (g_pGame->GetLedgeManager()->GetEditorManager() == NULL)
+		return;
+
 	IGameVolumes::VolumeInfo markersInfo;
 	if ( (GetLedgeMarkersInfo( GetEntityId(), markersInfo) == false) || (markersInfo.verticesCount < 2) )
 		return;
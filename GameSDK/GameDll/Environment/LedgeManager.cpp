@@ -15,10 +15,11 @@ History:
 #include "StdAfx.h"
 #include "LedgeManager.h"
 #include "IRenderAuxGeom.h"
+#include "Utility/LoadTimeline.h"
 
 #include <TypeInfo_impl.h>
 
-#define LEDGE_DATA_FILE_VERSION	3
+#define LEDGE_DATA_FILE_VERSION	5
 
 STRUCT_INFO_BEGIN(SLedgeObject)
 	STRUCT_VAR_INFO(m_entityId, TYPE_INFO(EntityId))
@@ -84,6 +85,108 @@ namespace
 		return ((fCosAngle > cosMaxAngle) && enabled);
 	}
 
+	struct SLedgeSearch
+	{
+		SLedgeSearch( const float maxDistance, const float angleRange, const float extendedAngleRange )
+			: closestDistanceSq(maxDistance * maxDistance)
+		{
+			cosMaxAngleTable[0] = cosf(angleRange);
+			cosMaxAngleTable[1] = cosf(extendedAngleRange);
+		}
+
+		float cosMaxAngleTable[2];
+		float closestDistanceSq;
+		LedgeId bestLedgeId;
+	};
+
+	// Position and direction are in the frame the object's markers are stored in
+	void TestLevelLedgeSegment( const SLevelLedges& levelLedges, const uint32 objectIdx, const uint32 markerIdx, const Vec3& referencePosition, const Vec3& testDirection, SLedgeSearch& search )
+	{
+		const float side[2] = { 1.0f, -1.0f };
+
+		const SLedgeObject& ledgeObject = levelLedges.m_pLedgeObjects[objectIdx];
+		const SLedgeMarker& startMarker = levelLedges.m_pMarkers[markerIdx];
+		const SLedgeMarker& endMarker = levelLedges.m_pMarkers[markerIdx + 1];
+		CRY_ASSERT( (markerIdx + 1) < (uint32)(ledgeObject.m_markersStartIdx + ledgeObject.m_markersCount) );
+
+		const uint32 sideCount = 1 + ((ledgeObject.m_ledgeFlags[LedgeSide_In] & kLedgeFlag_isDoubleSided) != 0);
+		const bool enabled = (ledgeObject.m_ledgeFlags[LedgeSide_In] & kLedgeFlag_enabled) != 0;
+
+		CRY_ASSERT(sideCount <= 2);
+
+		ELedgeFlagBitfield flags = kLedgeFlag_none;
+
+		if (startMarker.m_endOrCorner)
+		{
+			flags |= kledgeRunTimeOnlyFlag_p0IsEndOrCorner;
+		}
+		if (endMarker.m_endOrCorner)
+		{
+			flags |= kledgeRunTimeOnlyFlag_p1IsEndOrCorner;
+		}
+
+		for (uint32 currentSide = 0; currentSide < sideCount; ++currentSide)
+		{
+			const SLedgeInfo ledgeInfo( ledgeObject.m_entityId, startMarker.m_worldPosition, endMarker.m_worldPosition,
+				startMarker.m_facingDirection * side[currentSide], flags, ledgeObject.m_ledgeCornerEndAdjustAmount );
+
+			// Explanation: (Please do not delete this comment)
+			//	The item can be skipped if the angle is too big.
+			//	Since only the cosine of angles are compared,
+			//	bigger angles result in smaller values (hence the less_than comparison)
+			const uint32 thresholdIdx = ((ledgeObject.m_ledgeFlags[currentSide] & (kLedgeFlag_useVault|kLedgeFlag_useHighVault)) != 0);
+			CRY_ASSERT( thresholdIdx < 2 );
+
+			const float fCosMaxAngle = search.cosMaxAngleTable[thresholdIdx];
+
+			const Vec3 vPosToLedge = _FindVectorToClosestPointOnLedge( referencePosition, ledgeInfo );
+
+			float distanceSq;
+			if( IsBestLedge( vPosToLedge, testDirection, ledgeInfo, search.closestDistanceSq, fCosMaxAngle, enabled, distanceSq ) == false )
+				continue;
+
+			search.bestLedgeId = LedgeId( objectIdx, (markerIdx - ledgeObject.m_markersStartIdx), currentSide );
+			search.closestDistanceSq = distanceSq;
+		}
+	}
+
+	// Frame the markers of the ledge object are stored in, false if its entity is gone
+	bool GetLedgeObjectFrame( const SLedgeObject& ledgeObject, QuatT& frame )
+	{
+		if (ledgeObject.m_entityId == 0)
+		{
+			frame.SetIdentity();
+			return true;
+		}
+
+		IEntity* pEntity = gEnv->pEntitySystem->GetEntity( ledgeObject.m_entityId );
+		if (pEntity == NULL)
+			return false;
+
+		// Without scale, so distances in the entity's frame are the same as in the world
+		frame = QuatT( pEntity->GetWorldPos(), pEntity->GetWorldRotation() );
+		return true;
+	}
+
+	void ComputeEntityLedgeBounds( const SLevelLedges& levelLedges, SLevelLedges::SEntityLedge& entityLedge )
+	{
+		const SLedgeObject& ledgeObject = levelLedges.m_pLedgeObjects[entityLedge.objectIdx];
+		const uint32 endMarkerIdx = ledgeObject.m_markersStartIdx + ledgeObject.m_markersCount;
+
+		AABB bounds( AABB::RESET );
+		for (uint32 markerIdx = ledgeObject.m_markersStartIdx; markerIdx < endMarkerIdx; ++markerIdx)
+		{
+			bounds.Add( levelLedges.m_pMarkers[markerIdx].m_worldPosition );
+		}
+
+		entityLedge.boundsCentre = bounds.GetCenter();
+		entityLedge.boundsRadius = 0.0f;
+		for (uint32 markerIdx = ledgeObject.m_markersStartIdx; markerIdx < endMarkerIdx; ++markerIdx)
+		{
+			entityLedge.boundsRadius = max(entityLedge.boundsRadius, (levelLedges.m_pMarkers[markerIdx].m_worldPosition - entityLedge.boundsCentre).GetLength());
+		}
+	}
+
 	ILINE bool PointInShere( const Vec3& point, const Sphere& sphere )
 	{
 		return ( (sphere.center - point).GetLengthSquared() < (sphere.radius * sphere.radius) );
@@ -418,13 +521,28 @@ void CLedgeManagerEdit::Export( const char* fileName ) const
 
 				CRY_ASSERT((ledgeObject.m_markersStartIdx + ledgeObject.m_markersCount) <= totalLedgeMarkersCount);
 
+				// Ledges which are not static are stored in the frame of their entity
+				QuatT frame( IDENTITY );
+				if (GetLedgeObjectFrame( ledgeObject, frame ) == false)
+				{
+					GameWarning("!LedgeManager: Entity %d of ledge %d not found when exporting, markers stored in world space", ledgeObject.m_entityId, objectIdx);
+				}
+				const QuatT invFrame = frame.GetInverted();
+
 				for(size_t markerIdx = 0; markerIdx < ledgeObjectEdit.m_markers.size(); ++markerIdx)
 				{
-					ledgeMarkersBuffer.InsertAt( ledgeObjectEdit.m_markers[markerIdx], currentMarkerIdx + markerIdx );
+					SLedgeMarker marker = ledgeObjectEdit.m_markers[markerIdx];
+					marker.m_worldPosition = invFrame * marker.m_worldPosition;
+					marker.m_facingDirection = invFrame.q * marker.m_facingDirection;
+
+					ledgeMarkersBuffer.InsertAt( marker, currentMarkerIdx + markerIdx );
 				}
 				currentMarkerIdx += ledgeObject.m_markersCount;
 			}
 
+			SLevelLedgeGrid ledgeGrid;
+			ledgeGrid.Build( ledgeObjectBuffer, totalLedgeObjectsCount, ledgeMarkersBuffer.pMarkers, totalLedgeMarkersCount );
+
 			// Write to file...
 
 			// File version
@@ -438,6 +556,9 @@ void CLedgeManagerEdit::Export( const char* fileName ) const
 			file.Write( &ledgeObjectBuffer[0], sizeof(ledgeObjectBuffer[0]) * totalLedgeObjectsCount );
 			file.Write( &ledgeMarkersBuffer.pMarkers[0], sizeof(ledgeMarkersBuffer.pMarkers[0]) * ledgeMarkersBuffer.bufferSize );
 
+			// Grid over the static segments
+			ledgeGrid.Write( file );
+
 			file.Close();
 		}
 	}
@@ -486,6 +607,187 @@ void CLedgeManagerEdit::RegisterCVars()
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
+void SLevelLedgeGrid::Build( const SLedgeObject* pLedgeObjects, const uint32 ledgeCount, const SLedgeMarker* pMarkers, const uint32 markerCount )
+{
+	Release();
+
+	// Only static ledges go in, the others can move or be toggled at run time
+	float minX = FLT_MAX, minY = FLT_MAX;
+	float maxX = -FLT_MAX, maxY = -FLT_MAX;
+	uint32 segmentCount = 0;
+
+	for (uint32 objectIdx = 0; objectIdx < ledgeCount; ++objectIdx)
+	{
+		const SLedgeObject& ledgeObject = pLedgeObjects[objectIdx];
+		if ((ledgeObject.m_entityId != 0) || (ledgeObject.m_markersCount < 2))
+			continue;
+
+		const uint32 endMarkerIdx = ledgeObject.m_markersStartIdx + ledgeObject.m_markersCount;
+		CRY_ASSERT( endMarkerIdx <= markerCount );
+
+		for (uint32 markerIdx = ledgeObject.m_markersStartIdx; markerIdx < endMarkerIdx; ++markerIdx)
+		{
+			const Vec3& position = pMarkers[markerIdx].m_worldPosition;
+			minX = min(minX, position.x);
+			minY = min(minY, position.y);
+			maxX = max(maxX, position.x);
+			maxY = max(maxY, position.y);
+		}
+
+		segmentCount += ledgeObject.m_markersCount - 1;
+	}
+
+	if (segmentCount == 0)
+		return;
+
+	// A few meters per cell is around the distance ledges are searched at, large levels get coarser cells
+	m_cellSize = 4.0f;
+	for (;;)
+	{
+		m_width = (uint32)((maxX - minX) / m_cellSize) + 1;
+		m_height = (uint32)((maxY - minY) / m_cellSize) + 1;
+
+		if ((m_width * m_height) <= kMaxCellCount)
+			break;
+
+		m_cellSize *= 2.0f;
+	}
+
+	m_originX = minX;
+	m_originY = minY;
+
+	const uint32 cellCount = m_width * m_height;
+	m_pCellStarts = new uint32[cellCount + 1];
+	memset(m_pCellStarts, 0, sizeof(m_pCellStarts[0]) * (cellCount + 1));
+
+	// Count the segments overlapping each cell first, then fill them in
+	std::vector<uint32> cellCursors;
+
+	for (uint32 pass = 0; pass < 2; ++pass)
+	{
+		for (uint32 objectIdx = 0; objectIdx < ledgeCount; ++objectIdx)
+		{
+			const SLedgeObject& ledgeObject = pLedgeObjects[objectIdx];
+			if ((ledgeObject.m_entityId != 0) || (ledgeObject.m_markersCount < 2))
+				continue;
+
+			const uint32 endMarkerIdx = ledgeObject.m_markersStartIdx + ledgeObject.m_markersCount;
+			for (uint32 markerIdx = ledgeObject.m_markersStartIdx; markerIdx < (endMarkerIdx - 1); ++markerIdx)
+			{
+				const Vec3& start = pMarkers[markerIdx].m_worldPosition;
+				const Vec3& end = pMarkers[markerIdx + 1].m_worldPosition;
+
+				int x0, y0, x1, y1;
+				if (GetCellRange( min(start.x, end.x), min(start.y, end.y), max(start.x, end.x), max(start.y, end.y), x0, y0, x1, y1 ) == false)
+					continue;
+
+				for (int y = y0; y <= y1; ++y)
+				{
+					for (int x = x0; x <= x1; ++x)
+					{
+						const uint32 cellIdx = (y * m_width) + x;
+						if (pass == 0)
+						{
+							++m_pCellStarts[cellIdx + 1];
+						}
+						else
+						{
+							m_pEntries[cellCursors[cellIdx]++] = PackEntry( objectIdx, markerIdx );
+						}
+					}
+				}
+			}
+		}
+
+		if (pass == 0)
+		{
+			for (uint32 cellIdx = 0; cellIdx < cellCount; ++cellIdx)
+			{
+				m_pCellStarts[cellIdx + 1] += m_pCellStarts[cellIdx];
+			}
+
+			m_entryCount = m_pCellStarts[cellCount];
+			m_pEntries = new uint32[m_entryCount];
+			cellCursors.assign( m_pCellStarts, m_pCellStarts + cellCount );
+		}
+	}
+}
+
+bool SLevelLedgeGrid::GetCellRange( const float minX, const float minY, const float maxX, const float maxY, int& x0, int& y0, int& x1, int& y1 ) const
+{
+	const float invCellSize = 1.0f / m_cellSize;
+
+	x0 = max((int)floor_tpl((minX - m_originX) * invCellSize), 0);
+	y0 = max((int)floor_tpl((minY - m_originY) * invCellSize), 0);
+	x1 = min((int)floor_tpl((maxX - m_originX) * invCellSize), (int)m_width - 1);
+	y1 = min((int)floor_tpl((maxY - m_originY) * invCellSize), (int)m_height - 1);
+
+	return (x0 <= x1) && (y0 <= y1);
+}
+
+void SLevelLedgeGrid::Write( CCryFile& file ) const
+{
+	file.Write( &m_width, sizeof(m_width) );
+	file.Write( &m_height, sizeof(m_height) );
+	file.Write( &m_entryCount, sizeof(m_entryCount) );
+	file.Write( &m_originX, sizeof(m_originX) );
+	file.Write( &m_originY, sizeof(m_originY) );
+	file.Write( &m_cellSize, sizeof(m_cellSize) );
+
+	if (m_entryCount > 0)
+	{
+		file.Write( &m_pCellStarts[0], sizeof(m_pCellStarts[0]) * ((m_width * m_height) + 1) );
+		file.Write( &m_pEntries[0], sizeof(m_pEntries[0]) * m_entryCount );
+	}
+}
+
+bool SLevelLedgeGrid::Read( CCryFile& file, const uint32 ledgeCount, const uint32 markerCount )
+{
+	Release();
+
+	file.ReadType( &m_width );
+	file.ReadType( &m_height );
+	file.ReadType( &m_entryCount );
+	file.ReadType( &m_originX );
+	file.ReadType( &m_originY );
+	file.ReadType( &m_cellSize );
+
+	if (m_entryCount == 0)
+	{
+		m_width = m_height = 0;
+		return true;
+	}
+
+	const uint32 cellCount = m_width * m_height;
+	if ((m_width == 0) || (m_height == 0) || (cellCount > kMaxCellCount) || (m_cellSize <= 0.0f))
+	{
+		Release();
+		return false;
+	}
+
+	m_pCellStarts = new uint32[cellCount + 1];
+	m_pEntries = new uint32[m_entryCount];
+
+	file.ReadType( &m_pCellStarts[0], cellCount + 1 );
+	file.ReadType( &m_pEntries[0], m_entryCount );
+
+	bool valid = (m_pCellStarts[cellCount] == m_entryCount);
+	for (uint32 entryIdx = 0; valid && (entryIdx < m_entryCount); ++entryIdx)
+	{
+		valid = (GetEntryObjectIdx( m_pEntries[entryIdx] ) < ledgeCount) && ((GetEntryMarkerIdx( m_pEntries[entryIdx] ) + 1) < markerCount);
+	}
+
+	if (valid == false)
+	{
+		Release();
+	}
+
+	return valid;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+
 CLedgeManager::CLedgeManager()
 	: m_editorManager( gEnv->IsEditor() )
 {
@@ -512,6 +814,8 @@ void CLedgeManager::Reset()
 
 void CLedgeManager::Load( const char* fileName )
 {
+	LOAD_TIMELINE_SCOPE("CLedgeManager::Load");
+
 	// Clear in case there is anything left
 	Reset();
 
@@ -541,6 +845,26 @@ void CLedgeManager::Load( const char* fileName )
 
 		file.ReadType( &m_levelLedges.m_pLedgeObjects[0], totalLedgeObjectsCount );
 		file.ReadType( &m_levelLedges.m_pMarkers[0], totalLedgeMarkersCount );
+
+		if (m_levelLedges.m_grid.Read( file, m_levelLedges.m_ledgeCount, m_levelLedges.m_markerCount ) == false)
+		{
+			GameWarning("!LedgeManager: Level data could not be loaded, file %s has an invalid ledge grid. Level needs re-export", fileName);
+			m_levelLedges.Release();
+			return;
+		}
+
+		for (uint32 objectIdx = 0; objectIdx < m_levelLedges.m_ledgeCount; ++objectIdx)
+		{
+			const SLedgeObject& ledgeObject = m_levelLedges.m_pLedgeObjects[objectIdx];
+			if ((ledgeObject.m_entityId != 0) && (ledgeObject.m_markersCount >= 2))
+			{
+				SLevelLedges::SEntityLedge entityLedge;
+				entityLedge.objectIdx = (uint16)objectIdx;
+				ComputeEntityLedgeBounds( m_levelLedges, entityLedge );
+
+				m_levelLedges.m_entityLedges.push_back( entityLedge );
+			}
+		}
 	
 		file.Close();
 	}
@@ -556,14 +880,30 @@ void CLedgeManager::UpdateLedgeMarkers( const EntityId entityId, const SLedgeMar
 	{
 		SLedgeObject* pLedgeObject = m_levelLedges.FindLedgeForEntity( entityId );
 
-		if ((pLedgeObject != NULL) && (pLedgeObject->m_markersCount == markerCount))
+		QuatT frame;
+		if ((pLedgeObject != NULL) && (pLedgeObject->m_markersCount == markerCount) && GetLedgeObjectFrame( *pLedgeObject, frame ))
 		{
 			const uint32 endMarkerIdx = pLedgeObject->m_markersStartIdx + pLedgeObject->m_markersCount;
 			CRY_ASSERT( endMarkerIdx <= m_levelLedges.m_markerCount );
 
+			// Markers come in world space, they are kept in the entity's frame
+			const QuatT invFrame = frame.GetInverted();
+
 			for (uint32 markerIdx = pLedgeObject->m_markersStartIdx, idx = 0; markerIdx < endMarkerIdx; ++markerIdx, ++idx)
 			{
-				m_levelLedges.m_pMarkers[markerIdx] = pMarkersArray[idx];
+				SLedgeMarker& marker = m_levelLedges.m_pMarkers[markerIdx];
+				marker = pMarkersArray[idx];
+				marker.m_worldPosition = invFrame * marker.m_worldPosition;
+				marker.m_facingDirection = invFrame.q * marker.m_facingDirection;
+			}
+
+			const uint32 objectIdx = (uint32)(pLedgeObject - m_levelLedges.m_pLedgeObjects);
+			for (SLevelLedges::TEntityLedges::iterator it = m_levelLedges.m_entityLedges.begin(); it != m_levelLedges.m_entityLedges.end(); ++it)
+			{
+				if (it->objectIdx == objectIdx)
+				{
+					ComputeEntityLedgeBounds( m_levelLedges, *it );
+				}
 			}
 		}
 	}
@@ -605,71 +945,56 @@ LedgeId CLedgeManager::FindNearestLedge( const Vec3 &referencePosition, const Ve
 	}
 	else
 	{
-		LedgeId bestLedgeId;
-
-		float closestDistanceSq = maxDistance* maxDistance;
-		const float fCosMaxAngleTable[2] = { cosf(angleRange), cosf(extendedAngleRange) };
-		const float side[2] = { 1.0f, -1.0f };
+		SLedgeSearch search( maxDistance, angleRange, extendedAngleRange );
 
-		SLedgeInfo ledgeInfo;
+		// Static ledges, from the cells overlapping the search sphere. Cells of a row are contiguous
+		const SLevelLedgeGrid& ledgeGrid = m_levelLedges.m_grid;
 
-		const uint32 ledgeObjectCount = m_levelLedges.m_ledgeCount;
-		for(uint32 objectIdx = 0; objectIdx < ledgeObjectCount; ++objectIdx)
+		int x0, y0, x1, y1;
+		if ((ledgeGrid.m_entryCount > 0) && ledgeGrid.GetCellRange( referencePosition.x - maxDistance, referencePosition.y - maxDistance, referencePosition.x + maxDistance, referencePosition.y + maxDistance, x0, y0, x1, y1 ))
 		{
-			const SLedgeObject& ledgeObject = m_levelLedges.m_pLedgeObjects[objectIdx];
-			const uint32 startMarkerIdx = ledgeObject.m_markersStartIdx;
-			const uint32 endMarkerIdx = ledgeObject.m_markersStartIdx + ledgeObject.m_markersCount;
-			CRY_ASSERT ( endMarkerIdx <= m_levelLedges.m_markerCount );
-			
-			const uint32 sideCount = 1 + ((ledgeObject.m_ledgeFlags[LedgeSide_In] & kLedgeFlag_isDoubleSided) != 0);
-			const bool enabled = (ledgeObject.m_ledgeFlags[LedgeSide_In] & kLedgeFlag_enabled) != 0;
-
-			CRY_ASSERT(sideCount <= 2);
-
-			uint32 currentSide = 0;
-			do 
+			for (int y = y0; y <= y1; ++y)
 			{
-				for (uint32 markerIdx = startMarkerIdx; markerIdx < (endMarkerIdx - 1); ++markerIdx)
-				{
-					ELedgeFlagBitfield flags = kLedgeFlag_none;
+				const uint32* pRowStarts = &ledgeGrid.m_pCellStarts[y * ledgeGrid.m_width];
+				const uint32 endEntryIdx = pRowStarts[x1 + 1];
 
-					if (m_levelLedges.m_pMarkers[markerIdx].m_endOrCorner)
-					{
-						flags |= kledgeRunTimeOnlyFlag_p0IsEndOrCorner;
-					}
-					if (m_levelLedges.m_pMarkers[markerIdx+1].m_endOrCorner)
-					{
-						flags |= kledgeRunTimeOnlyFlag_p1IsEndOrCorner;
-					}
-
-					ledgeInfo = SLedgeInfo( ledgeObject.m_entityId, m_levelLedges.m_pMarkers[markerIdx].m_worldPosition, m_levelLedges.m_pMarkers[markerIdx+1].m_worldPosition,
-						m_levelLedges.m_pMarkers[markerIdx].m_facingDirection * side[currentSide], flags, ledgeObject.m_ledgeCornerEndAdjustAmount );
+				for (uint32 entryIdx = pRowStarts[x0]; entryIdx < endEntryIdx; ++entryIdx)
+				{
+					const uint32 entry = ledgeGrid.m_pEntries[entryIdx];
+					TestLevelLedgeSegment( m_levelLedges, SLevelLedgeGrid::GetEntryObjectIdx( entry ), SLevelLedgeGrid::GetEntryMarkerIdx( entry ), referencePosition, testDirection, search );
+				}
+			}
+		}
 
-					// Explanation: (Please do not delete this comment)
-					//	The item can be skipped if the angle is too big.
-					//	Since only the cosine of angles are compared,
-					//	bigger angles result in smaller values (hence the less_than comparison)
-					const uint32 thresholdIdx = ((ledgeObject.m_ledgeFlags[currentSide] & (kLedgeFlag_useVault|kLedgeFlag_useHighVault)) != 0);
-					CRY_ASSERT( thresholdIdx < 2 );
+		// Ledges owned by entities, in the frame of each entity whose ledge bounds are within reach
+		const size_t entityLedgeCount = m_levelLedges.m_entityLedges.size();
+		for (size_t idx = 0; idx < entityLedgeCount; ++idx)
+		{
+			const SLevelLedges::SEntityLedge& entityLedge = m_levelLedges.m_entityLedges[idx];
+			const SLedgeObject& ledgeObject = m_levelLedges.m_pLedgeObjects[entityLedge.objectIdx];
 
-					const float fCosMaxAngle = fCosMaxAngleTable[thresholdIdx];
+			QuatT frame;
+			if (GetLedgeObjectFrame( ledgeObject, frame ) == false)
+				continue;
 
-					const Vec3 vPosToLedge = _FindVectorToClosestPointOnLedge( referencePosition, ledgeInfo );
+			const float reach = entityLedge.boundsRadius + sqrt_tpl(search.closestDistanceSq);
+			if (((frame * entityLedge.boundsCentre) - referencePosition).GetLengthSquared() > (reach * reach))
+				continue;
 
-					float distanceSq;
-					if( IsBestLedge( vPosToLedge, testDirection, ledgeInfo, closestDistanceSq, fCosMaxAngle, enabled, distanceSq ) == false )
-						continue;
-					
-					bestLedgeId = LedgeId( objectIdx, (markerIdx - startMarkerIdx), currentSide );
-					closestDistanceSq = distanceSq;
-				}
+			const QuatT invFrame = frame.GetInverted();
+			const Vec3 localPosition = invFrame * referencePosition;
+			const Vec3 localDirection = invFrame.q * testDirection;
 
-				currentSide++;
+			const uint32 endMarkerIdx = ledgeObject.m_markersStartIdx + ledgeObject.m_markersCount;
+			CRY_ASSERT ( endMarkerIdx <= m_levelLedges.m_markerCount );
 
-			} while ( currentSide < sideCount );
+			for (uint32 markerIdx = ledgeObject.m_markersStartIdx; markerIdx < (endMarkerIdx - 1); ++markerIdx)
+			{
+				TestLevelLedgeSegment( m_levelLedges, entityLedge.objectIdx, markerIdx, localPosition, localDirection, search );
+			}
 		}
 
-		return bestLedgeId;
+		return search.bestLedgeId;
 	}
 }
 
@@ -690,12 +1015,13 @@ SLedgeInfo CLedgeManager::GetLedgeById( const LedgeId& ledgeId ) const
 
 			CRY_ASSERT( ledgeId.GetSubSegmentIdx() < ledgeObject.m_markersCount );
 			const uint16 segmentIdx = ledgeObject.m_markersStartIdx + ledgeId.GetSubSegmentIdx(); 
-			if ( segmentIdx < (m_levelLedges.m_markerCount - 1) )
+			QuatT frame;
+			if ( (segmentIdx < (m_levelLedges.m_markerCount - 1)) && GetLedgeObjectFrame( ledgeObject, frame ) )
 			{
 				const uint16 side = ledgeId.GetSide();
 				CRY_ASSERT( side < 2 );
 				const float sideValue[2] = { 1.0f, -1.0f };
-				const Vec3 facingDirection   = m_levelLedges.m_pMarkers[segmentIdx].m_facingDirection * sideValue[side];
+				const Vec3 facingDirection   = frame.q * (m_levelLedges.m_pMarkers[segmentIdx].m_facingDirection * sideValue[side]);
 				const EntityId entityId = (ledgeObject.m_ledgeFlags[side] & kLedgeFlag_static) ? 0 : ledgeObject.m_entityId;
 
 				ELedgeFlagBitfield flags = ledgeObject.m_ledgeFlags[side];
@@ -708,7 +1034,7 @@ SLedgeInfo CLedgeManager::GetLedgeById( const LedgeId& ledgeId ) const
 					flags |= kledgeRunTimeOnlyFlag_p1IsEndOrCorner;
 				}
 
-				return SLedgeInfo( entityId, m_levelLedges.m_pMarkers[segmentIdx].m_worldPosition, m_levelLedges.m_pMarkers[segmentIdx + 1].m_worldPosition, facingDirection, flags, ledgeObject.m_ledgeCornerEndAdjustAmount );
+				return SLedgeInfo( entityId, frame * m_levelLedges.m_pMarkers[segmentIdx].m_worldPosition, frame * m_levelLedges.m_pMarkers[segmentIdx + 1].m_worldPosition, facingDirection, flags, ledgeObject.m_ledgeCornerEndAdjustAmount );
 			}
 		}
 
@@ -779,6 +1105,11 @@ void CLedgeManager::Serialize( TSerialize ser )
 			}
 		}
 		ser.EndGroup(); // "LevelLedges"
+
+		for (SLevelLedges::TEntityLedges::iterator it = m_levelLedges.m_entityLedges.begin(); it != m_levelLedges.m_entityLedges.end(); ++it)
+		{
+			ComputeEntityLedgeBounds( m_levelLedges, *it );
+		}
 	}
 	else
 	{
@@ -858,18 +1189,22 @@ void CLedgeManager::DebugDraw() const
 				nonStaticLedges += (ledgeObject.m_entityId != 0);
 				totalLedgeCount += ((ledgeObject.m_markersCount - 1) * sideCountMultiplier[sideIdx]);
 
-				if ( PointInShere( m_levelLedges.m_pMarkers[startMarkerIdx].m_worldPosition, visibleArea) == false )
+				QuatT frame;
+				if ( (GetLedgeObjectFrame( ledgeObject, frame ) == false) || (PointInShere( frame * m_levelLedges.m_pMarkers[startMarkerIdx].m_worldPosition, visibleArea) == false) )
 					continue;
 
 				for (size_t markerIdx = startMarkerIdx; markerIdx < (endMarkerIdx - 1); ++markerIdx)
 				{
-					DrawLedge( pRenderAuxGeometry, m_levelLedges.m_pMarkers[markerIdx].m_worldPosition, m_levelLedges.m_pMarkers[markerIdx + 1].m_worldPosition, m_levelLedges.m_pMarkers[markerIdx].m_facingDirection, ledgeObject.m_ledgeFlags );
+					DrawLedge( pRenderAuxGeometry, frame * m_levelLedges.m_pMarkers[markerIdx].m_worldPosition, frame * m_levelLedges.m_pMarkers[markerIdx + 1].m_worldPosition, frame.q * m_levelLedges.m_pMarkers[markerIdx].m_facingDirection, ledgeObject.m_ledgeFlags );
 				}
 			}
 
 			if (g_LedgeGrabManager_DebugDraw > 1)
 			{
 				gEnv->pRenderer->Draw2dLabel( 50.0f, 50.f, 1.5f, Col_White, false, "Total Number of ledges %d - Non static %d", totalLedgeCount, nonStaticLedges );
+
+				const SLevelLedgeGrid& ledgeGrid = m_levelLedges.m_grid;
+				gEnv->pRenderer->Draw2dLabel( 50.0f, 65.f, 1.5f, Col_White, false, "Ledge grid %dx%d cells of %.1fm - %d entries", ledgeGrid.m_width, ledgeGrid.m_height, ledgeGrid.m_cellSize, ledgeGrid.m_entryCount );
 			}
 		}
 	}
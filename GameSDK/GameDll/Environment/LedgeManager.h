@@ -24,6 +24,8 @@ History:
 
 #define MAX_LEDGE_ENTITIES 1024
 
+class CCryFile;
+
 //////////////////////////////////////////////////////////////////////////
 /// Ledge definition structures, types and flags
 
@@ -237,6 +239,63 @@ struct SLedgeObject
 	AUTO_STRUCT_INFO
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// Uniform grid over the segments of static ledges, in the horizontal plane.
+/// Built when exporting and stored after the markers in the level data, so
+/// queries only visit the cells the search sphere overlaps
+
+struct SLevelLedgeGrid
+{
+	enum { kMaxCellCount = 32768 };
+
+	SLevelLedgeGrid()
+		: m_pCellStarts(NULL)
+		, m_pEntries(NULL)
+		, m_width(0)
+		, m_height(0)
+		, m_entryCount(0)
+		, m_originX(0.0f)
+		, m_originY(0.0f)
+		, m_cellSize(0.0f)
+	{
+
+	}
+
+	~SLevelLedgeGrid()
+	{
+		Release();
+	}
+
+	void Build( const SLedgeObject* pLedgeObjects, const uint32 ledgeCount, const SLedgeMarker* pMarkers, const uint32 markerCount );
+	void Write( CCryFile& file ) const;
+	bool Read( CCryFile& file, const uint32 ledgeCount, const uint32 markerCount );
+
+	// Clamped range of cells overlapping the horizontal bounds, false if outside of the grid
+	bool GetCellRange( const float minX, const float minY, const float maxX, const float maxY, int& x0, int& y0, int& x1, int& y1 ) const;
+
+	void Release()
+	{
+		SAFE_DELETE_ARRAY(m_pCellStarts);
+		SAFE_DELETE_ARRAY(m_pEntries);
+		m_width = m_height = m_entryCount = 0;
+	}
+
+	ILINE static uint32 PackEntry( const uint32 objectIdx, const uint32 markerIdx ) { return (objectIdx << 16) | markerIdx; }
+	ILINE static uint32 GetEntryObjectIdx( const uint32 entry ) { return (entry >> 16); }
+	ILINE static uint32 GetEntryMarkerIdx( const uint32 entry ) { return (entry & 0xFFFF); }
+
+	uint32* m_pCellStarts;    // m_width * m_height + 1 offsets into m_pEntries, row by row
+	uint32* m_pEntries;       // object and first marker index of each segment overlapping the cell
+
+	uint32  m_width;
+	uint32  m_height;
+	uint32  m_entryCount;
+
+	float   m_originX;
+	float   m_originY;
+	float   m_cellSize;
+};
+
 struct SLevelLedges
 {
 	SLevelLedges()
@@ -272,6 +331,9 @@ struct SLevelLedges
 		SAFE_DELETE_ARRAY(m_pLedgeObjects);
 		SAFE_DELETE_ARRAY(m_pMarkers);
 		m_ledgeCount = m_markerCount = 0;
+
+		m_grid.Release();
+		stl::free_container(m_entityLedges);
 	}
 
 	SLedgeObject* FindLedgeForEntity( const EntityId entityId )
@@ -298,6 +360,21 @@ struct SLevelLedges
 	
 	uint32				m_ledgeCount;
 	uint32				m_markerCount;        
+
+	// Static ledges are found through the grid
+	SLevelLedgeGrid		m_grid;
+
+	// Markers of ledges owned by an entity are stored in the entity's frame, and follow it as it moves.
+	// Queries bring the search position into the frame of each entity near enough instead
+	struct SEntityLedge
+	{
+		uint16	objectIdx;
+		Vec3		boundsCentre;		// entity frame
+		float		boundsRadius;
+	};
+	typedef std::vector<SEntityLedge> TEntityLedges;
+
+	TEntityLedges			m_entityLedges;
 };
 
 //////////////////////////////////////////////////////////////////////////
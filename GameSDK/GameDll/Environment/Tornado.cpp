@@ -3,6 +3,7 @@
 #include "../Game.h"
 #include "../Actor.h"
 #include "Environment/FlowTornado.h"
+#include "Environment/WaterQueryCache.h"
 #include <IMaterialEffects.h>
 #include <IEffectSystem.h>
 #include <IVehicleSystem.h>
@@ -205,7 +206,7 @@ void CTornado::Update(SEntityUpdateContext &ctx, int updateSlot)
 	Matrix34 tm = Matrix34(Matrix33::CreateRotationVDir(steerDir));
 	pos = pos + steerDir * gEnv->pTimer->GetFrameTime() * m_wanderSpeed;
 	pos.z = gEnv->p3DEngine->GetTerrainElevation(pos.x, pos.y);
-	float waterLevel = gEnv->p3DEngine->GetWaterLevel(&pos);
+	float waterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(pos, CWaterQueryCache::eWQ_Environment);
 
 	bool prevIsOnWater = m_isOnWater;
 	m_isOnWater = (pos.z < waterLevel);
@@ -0,0 +1,368 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Per-frame cache of ocean heights
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#include "StdAfx.h"
+#include "WaterQueryCache.h"
+#include "Game.h"
+#include "GameCVars.h"
+#include "Utility/CryWatch.h"
+#include <IActorSystem.h>
+
+namespace
+{
+	const char* s_subsystemNames[CWaterQueryCache::eWQ_Count] =
+	{
+		"Vehicle",
+		"Player",
+		"Projectile",
+		"Weapon",
+		"Boids",
+		"Effects",
+		"Environment",
+	};
+}
+
+//------------------------------------------------------------------------
+CWaterQueryCache::CWaterQueryCache()
+: m_statsTimer(0.f)
+, m_cellSize(2.f)
+, m_invCellSize(0.5f)
+, m_tolerance(0.1f)
+, m_frameStamp(1)
+, m_enabled(true)
+{
+	Reset();
+}
+
+//------------------------------------------------------------------------
+void CWaterQueryCache::Update(float frameTime)
+{
+	CryAutoCriticalSection lk(m_lock);
+
+	// A dedicated server has no camera or client actor to centre the grids on, its queries are spread over the level
+	m_enabled = (g_pGameCVars->g_waterQueryCache != 0) && !gEnv->IsDedicated();
+	m_tolerance = g_pGameCVars->g_waterQueryTolerance;
+
+	const float cellSize = max(g_pGameCVars->g_waterQueryCellSize, 0.25f);
+	if (cellSize != m_cellSize)
+	{
+		m_cellSize = cellSize;
+		m_invCellSize = 1.f / cellSize;
+	}
+
+	// Samples stamped with an older frame are treated as missing, so nothing has to be cleared
+	if (++m_frameStamp == 0)
+	{
+		Reset();
+	}
+
+	Vec3 centres[eGrid_Count];
+	centres[eGrid_Camera] = gEnv->pRenderer->GetCamera().GetPosition();
+	centres[eGrid_Actor] = centres[eGrid_Camera];
+
+	if (IActor* pClientActor = g_pGame->GetIGameFramework()->GetClientActor())
+	{
+		centres[eGrid_Actor] = pClientActor->GetEntity()->GetWorldPos();
+	}
+
+	const float halfExtent = 0.5f * kGridCells * m_cellSize;
+	for (int i = 0; i < eGrid_Count; ++i)
+	{
+		m_grids[i].origin.x = floor_tpl(centres[i].x * m_invCellSize) * m_cellSize - halfExtent;
+		m_grids[i].origin.y = floor_tpl(centres[i].y * m_invCellSize) * m_cellSize - halfExtent;
+	}
+
+	if (m_enabled)
+	{
+		GatherWaterVolumes();
+	}
+
+	UpdateStats(frameTime);
+}
+
+//------------------------------------------------------------------------
+void CWaterQueryCache::Reset()
+{
+	for (int i = 0; i < eGrid_Count; ++i)
+	{
+		memset(m_grids[i].stamps, 0, sizeof(m_grids[i].stamps));
+	}
+
+	m_waterVolumes.clear();
+
+	for (int i = 0; i < eWQ_Count; ++i)
+	{
+		m_stats[i].Reset();
+	}
+
+	m_statsTimer = 0.f;
+	m_frameStamp = 1;
+}
+
+//------------------------------------------------------------------------
+float CWaterQueryCache::GetWaterLevel(const Vec3& pos, ESubsystem subsystem)
+{
+	float height;
+	QueryHeights(&pos, &height, 1, subsystem);
+	return height;
+}
+
+//------------------------------------------------------------------------
+void CWaterQueryCache::QueryHeights(const Vec3* pPositions, float* pHeights, int count, ESubsystem subsystem)
+{
+	for (int first = 0; first < count; first += kQueryBatch)
+	{
+		QueryBatch(pPositions + first, pHeights + first, min(count - first, (int)kQueryBatch), subsystem);
+	}
+}
+
+//------------------------------------------------------------------------
+void CWaterQueryCache::QueryBatch(const Vec3* pPositions, float* pHeights, int count, ESubsystem subsystem)
+{
+	// A grid sample this batch needs and nobody has taken yet this frame
+	struct SMissingSample
+	{
+		Vec3 pos;
+		float height;
+		int grid;
+		int index;
+	};
+
+	// Missing samples are shared by the positions around them, found through a small open addressing table
+	const int kSlots = 256;
+	const int kSlotMask = kSlots - 1;
+	int16 slots[kSlots];
+	memset(slots, 0xff, sizeof(slots));
+
+	SMissingSample missing[kQueryBatch * 4];
+	int numMissing = 0;
+
+	int grids[kQueryBatch];
+	float cellT[kQueryBatch][2];
+	float corners[kQueryBatch][4];
+	int16 cornerMissing[kQueryBatch][4];							// index into missing, or -1 if the corner was cached
+
+	uint32 frameStamp;
+	float tolerance;
+
+	{
+		CryAutoCriticalSection lk(m_lock);
+
+		frameStamp = m_frameStamp;
+		tolerance = m_tolerance;
+
+		for (int i = 0; i < count; ++i)
+		{
+			int x, y;
+			grids[i] = (m_enabled && !IsInWaterVolume(pPositions[i])) ? FindCell(pPositions[i], x, y, cellT[i][0], cellT[i][1]) : -1;
+			if (grids[i] < 0)
+				continue;
+
+			const SGrid& grid = m_grids[grids[i]];
+			for (int c = 0; c < 4; ++c)
+			{
+				const int cx = x + (c & 1);
+				const int cy = y + (c >> 1);
+				const int index = cy * kGridSamples + cx;
+
+				if (grid.stamps[index] == frameStamp)
+				{
+					corners[i][c] = grid.heights[index];
+					cornerMissing[i][c] = -1;
+					continue;
+				}
+
+				const int key = grids[i] * kGridSamples * kGridSamples + index;
+				int slot = (int)(((uint32)key * 2654435761u) >> 24) & kSlotMask;
+				while (slots[slot] >= 0 && (missing[slots[slot]].grid != grids[i] || missing[slots[slot]].index != index))
+				{
+					slot = (slot + 1) & kSlotMask;
+				}
+
+				if (slots[slot] < 0)
+				{
+					// The ocean does not depend on the height of the query, unlike the water volumes
+					SMissingSample& sample = missing[numMissing];
+					sample.pos.Set(grid.origin.x + cx * m_cellSize, grid.origin.y + cy * m_cellSize, 0.f);
+					sample.grid = grids[i];
+					sample.index = index;
+					slots[slot] = (int16)numMissing++;
+				}
+
+				cornerMissing[i][c] = slots[slot];
+			}
+		}
+	}
+
+	I3DEngine* p3DEngine = gEnv->p3DEngine;
+
+	for (int m = 0; m < numMissing; ++m)
+	{
+		missing[m].height = p3DEngine->GetOceanWaterLevel(missing[m].pos);
+	}
+
+	int hits = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		if (grids[i] >= 0)
+		{
+			float h[4];
+			for (int c = 0; c < 4; ++c)
+			{
+				h[c] = (cornerMissing[i][c] < 0) ? corners[i][c] : missing[cornerMissing[i][c]].height;
+			}
+
+			// Rough waves and levels without an ocean can't be interpolated, those fall back to an exact query
+			const float minHeight = min(min(h[0], h[1]), min(h[2], h[3]));
+			const float maxHeight = max(max(h[0], h[1]), max(h[2], h[3]));
+			if (minHeight > WATER_LEVEL_UNKNOWN && (maxHeight - minHeight) <= tolerance)
+			{
+				pHeights[i] = LERP(LERP(h[0], h[1], cellT[i][0]), LERP(h[2], h[3], cellT[i][0]), cellT[i][1]);
+				++hits;
+				continue;
+			}
+		}
+
+		pHeights[i] = p3DEngine->GetWaterLevel(&pPositions[i]);
+	}
+
+	CryAutoCriticalSection lk(m_lock);
+
+	// Update may have moved the grids on while the engine was queried, the samples then belong to the old cells
+	if (m_frameStamp == frameStamp)
+	{
+		for (int m = 0; m < numMissing; ++m)
+		{
+			SGrid& grid = m_grids[missing[m].grid];
+			grid.heights[missing[m].index] = missing[m].height;
+			grid.stamps[missing[m].index] = frameStamp;
+		}
+	}
+
+	SStats& stats = m_stats[subsystem];
+	stats.queries += count;
+	stats.hits += hits;
+}
+
+//------------------------------------------------------------------------
+// Returns the grid whose cells contain pos, or -1, with the cell and the position inside it
+int CWaterQueryCache::FindCell(const Vec3& pos, int& x, int& y, float& tx, float& ty) const
+{
+	for (int i = 0; i < eGrid_Count; ++i)
+	{
+		const SGrid& grid = m_grids[i];
+
+		const float fx = (pos.x - grid.origin.x) * m_invCellSize;
+		const float fy = (pos.y - grid.origin.y) * m_invCellSize;
+		if (fx < 0.f || fy < 0.f || fx >= (float)kGridCells || fy >= (float)kGridCells)
+			continue;
+
+		x = (int)fx;
+		y = (int)fy;
+		tx = fx - x;
+		ty = fy - y;
+		return i;
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------
+void CWaterQueryCache::GatherWaterVolumes()
+{
+	m_waterVolumes.clear();
+
+	const float extent = kGridCells * m_cellSize;
+	const float maxHeight = 10000.f;
+
+	for (int i = 0; i < eGrid_Count; ++i)
+	{
+		const Vec3 boxMin(m_grids[i].origin.x, m_grids[i].origin.y, -maxHeight);
+		const Vec3 boxMax(m_grids[i].origin.x + extent, m_grids[i].origin.y + extent, maxHeight);
+
+		IPhysicalEntity** pAreas = NULL;
+		const int numAreas = gEnv->pPhysicalWorld->GetEntitiesInBox(boxMin, boxMax, pAreas, ent_areas);
+		for (int j = 0; j < numAreas; ++j)
+		{
+			// 0 is water
+			pe_params_buoyancy buoyancy;
+			if (!pAreas[j]->GetParams(&buoyancy) || buoyancy.iMedium != 0)
+				continue;
+
+			pe_status_pos status;
+			if (pAreas[j]->GetStatus(&status))
+			{
+				m_waterVolumes.push_back(AABB(status.pos + status.BBox[0], status.pos + status.BBox[1]));
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+bool CWaterQueryCache::IsInWaterVolume(const Vec3& pos) const
+{
+	for (std::vector<AABB>::const_iterator it = m_waterVolumes.begin(), end = m_waterVolumes.end(); it != end; ++it)
+	{
+		// the whole column, a volume changes the answer both inside and above it
+		if (pos.x >= it->min.x && pos.x <= it->max.x && pos.y >= it->min.y && pos.y <= it->max.y)
+			return true;
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------
+void CWaterQueryCache::UpdateStats(float frameTime)
+{
+	m_statsTimer += frameTime;
+	if (m_statsTimer >= 1.f)
+	{
+		const float invTime = 1.f / m_statsTimer;
+		for (int i = 0; i < eWQ_Count; ++i)
+		{
+			SStats& stats = m_stats[i];
+			stats.queriesPerSecond = stats.queries * invTime;
+			stats.hitRate = stats.queries > 0 ? (float)stats.hits / (float)stats.queries : 0.f;
+			stats.queries = 0;
+			stats.hits = 0;
+		}
+
+		m_statsTimer = 0.f;
+	}
+
+	if (g_pGameCVars->g_waterQueryDebug)
+	{
+		float totalQueries = 0.f, totalHits = 0.f;
+		for (int i = 0; i < eWQ_Count; ++i)
+		{
+			const SStats& stats = m_stats[i];
+			totalQueries += stats.queriesPerSecond;
+			totalHits += stats.queriesPerSecond * stats.hitRate;
+
+			if (stats.queriesPerSecond > 0.f)
+			{
+				CryWatch("WaterQuery %s: %.0f/s, hit rate %.0f%%", s_subsystemNames[i], stats.queriesPerSecond, 100.f * stats.hitRate);
+			}
+		}
+
+		CryWatch("WaterQuery total: %.0f/s, hit rate %.0f%%, cell %.2fm%s", totalQueries,
+			totalQueries > 0.f ? 100.f * totalHits / totalQueries : 0.f, m_cellSize, m_enabled ? "" : " (cache disabled)");
+	}
+}
+
+//------------------------------------------------------------------------
+void CWaterQueryCache::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->Add(*this);
+	pSizer->AddContainer(m_waterVolumes);
+}
@@ -0,0 +1,112 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Per-frame cache of water heights. Ocean heights are sampled
+	lazily on two grids, one around the camera and one around the client
+	actor, and queries inside them are interpolated from the cell corners.
+	The level of a water volume depends on the height of the query, so
+	queries inside the bounds of one are always exact.
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#ifndef __WATERQUERYCACHE_H__
+#define __WATERQUERYCACHE_H__
+
+#if _MSC_VER > 1000
+# pragma once
+#endif
+
+class CWaterQueryCache
+{
+public:
+	// Callers tag their queries so the debug output can show who is asking
+	enum ESubsystem
+	{
+		eWQ_Vehicle = 0,
+		eWQ_Player,
+		eWQ_Projectile,
+		eWQ_Weapon,
+		eWQ_Boids,
+		eWQ_Effects,
+		eWQ_Environment,
+		eWQ_Count
+	};
+
+	CWaterQueryCache();
+
+	// Main thread, once per frame: re-centres the grids and invalidates last frame's samples
+	void Update(float frameTime);
+	void Reset();
+
+	// Thread safe, the boats query from the physics thread. The engine is only queried outside of the lock,
+	// so the threads only wait for each other on the grid bookkeeping
+	float GetWaterLevel(const Vec3& pos, ESubsystem subsystem);
+	void QueryHeights(const Vec3* pPositions, float* pHeights, int count, ESubsystem subsystem);
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+private:
+	enum
+	{
+		kGridCells = 64,
+		kGridSamples = kGridCells + 1,
+		kQueryBatch = 32,									// positions resolved per lock, see QueryBatch
+	};
+
+	enum EGrid
+	{
+		eGrid_Camera = 0,
+		eGrid_Actor,
+		eGrid_Count
+	};
+
+	struct SGrid
+	{
+		SGrid() : origin(ZERO) {}
+
+		Vec2 origin;
+		float heights[kGridSamples * kGridSamples];
+		uint32 stamps[kGridSamples * kGridSamples];
+	};
+
+	struct SStats
+	{
+		SStats() { Reset(); }
+		void Reset() { queries = hits = 0; queriesPerSecond = hitRate = 0.f; }
+
+		// current measuring window
+		int queries;
+		int hits;
+
+		// last complete window
+		float queriesPerSecond;
+		float hitRate;
+	};
+
+	void QueryBatch(const Vec3* pPositions, float* pHeights, int count, ESubsystem subsystem);
+	int FindCell(const Vec3& pos, int& x, int& y, float& tx, float& ty) const;
+	void GatherWaterVolumes();
+	bool IsInWaterVolume(const Vec3& pos) const;
+	void UpdateStats(float frameTime);
+
+	SGrid m_grids[eGrid_Count];
+	std::vector<AABB> m_waterVolumes;				// bounds of the water volumes overlapping the grids
+	SStats m_stats[eWQ_Count];
+	float m_statsTimer;
+
+	float m_cellSize;
+	float m_invCellSize;
+	float m_tolerance;
+	uint32 m_frameStamp;
+	bool m_enabled;
+
+	CryCriticalSection m_lock;
+};
+
+#endif // __WATERQUERYCACHE_H__
@@ -1,5 +1,6 @@
 #include "StdAfx.h"
 #include "WaterRipplesGenerator.h"
+#include "Environment/WaterQueryCache.h"
 
 #include <IRenderAuxGeom.h>
 
@@ -11,7 +12,7 @@ namespace
 	bool TestLocation( const Vec3& testPosition )
 	{
 		const float threshold = 0.4f;
-		const float waterLevel = gEnv->p3DEngine->GetWaterLevel( &testPosition );
+		const float waterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(testPosition, CWaterQueryCache::eWQ_Environment);
 
 		return (fabs_tpl(waterLevel - testPosition.z) < threshold);
 	}
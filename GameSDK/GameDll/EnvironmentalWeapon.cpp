@@ -17,6 +17,7 @@
 
 #ifndef _RELEASE
 #include "Utility/CryWatch.h"
+#include "Environment/WaterQueryCache.h"
 #endif //#ifndef _RELEASE
 
 
@@ -728,7 +729,7 @@ void CEnvironmentalWeapon::PerformGroundClearanceAdjust( const CActor* pOwner, c
 
 			// WATER PENETRATION (at least the 'global' water level - still may need work for individual water volumes) 
 			const Vec3& entWPos = pEntity->GetPos(); 
-			const float entWaterLevel = gEnv->p3DEngine->GetWaterLevel(&entWPos);
+			const float entWaterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(entWPos, CWaterQueryCache::eWQ_Weapon);
 			if (entWaterLevel != WATER_LEVEL_UNKNOWN)
 			{
 				const float depth = entWaterLevel - entLowestZVal;
@@ -249,6 +249,8 @@ CEquipmentLoadout::CEquipmentLoadout()
 
 	m_bShowCellModel = false;
 
+	m_prefetchRequest = CGameCachePrefetch::INVALID_REQUEST;
+
 	memset(&m_currentCustomizePackage,0,sizeof(m_currentCustomizePackage));
 
 	m_allItems.reserve(64);
@@ -958,6 +960,40 @@ void CEquipmentLoadout::SvSetClientLoadout(int channelId, const CGameRules::Equi
 	package.m_weaponAttachmentFlags = params.m_weaponAttachmentFlags; 
 	package.m_modelIndex = params.m_modelIndex;
 	package.m_loadoutIdx = params.m_loadoutIndex;
+
+	// The items are handed out at the next spawn of the client, warm them up until then
+	CGameRules* pGameRules = g_pGame->GetGameRules();
+	IActor* pActor = pGameRules ? pGameRules->GetActorByChannelId(channelId) : NULL;
+	if (pActor)
+	{
+		const EntityId actorId = pActor->GetEntityId();
+
+		g_pGame->GetGameCache().GetPrefetch().CancelRequester(actorId);
+		PrefetchContents(package.m_contents, CGameCachePrefetch::GetPriorityForActor(actorId), actorId);
+	}
+}
+
+//------------------------------------------------------------------------
+CGameCachePrefetch::TRequestId CEquipmentLoadout::PrefetchContents(const TEquipmentPackageContents& contents, CGameCachePrefetch::EPriority priority, EntityId requesterId) const
+{
+	CGameCachePrefetch& prefetch = g_pGame->GetGameCache().GetPrefetch();
+
+	const CGameCachePrefetch::TRequestId requestId = prefetch.AddRequest(priority, requesterId);
+	if (requestId != CGameCachePrefetch::INVALID_REQUEST)
+	{
+		const int numItems = m_allItems.size();
+		for (int i = 0; i < EQUIPMENT_LOADOUT_NUM_SLOTS; ++i)
+		{
+			// Item 0 is the empty slot
+			const int itemId = contents[i];
+			if ((itemId > 0) && (itemId < numItems))
+			{
+				prefetch.AddResource(requestId, CGameCachePrefetch::eResource_ItemClass, m_allItems[itemId].m_name.c_str());
+			}
+		}
+	}
+
+	return requestId;
 }
 //------------------------------------------------------------------------
 void CEquipmentLoadout::ApplyAttachmentOverrides(uint8 * contents) const
@@ -2074,6 +2110,10 @@ void CEquipmentLoadout::SetSelectedPackage(int index)
 		TEquipmentPackageContents &contents = group.m_packages[group.m_selectedPackage].m_contents;
 		memcpy( (void*)m_currentCustomizePackage, (void*)contents, sizeof(contents));
 		m_currentCustomizeNameChanged = false;
+
+		// Warm the items before the next spawn, a newer pick replaces the previous one
+		g_pGame->GetGameCache().GetPrefetch().Cancel(m_prefetchRequest);
+		m_prefetchRequest = PrefetchContents(contents, CGameCachePrefetch::ePriority_LocalPlayer, g_pGame->GetIGameFramework()->GetClientActorId());
 	}
 }
 
@@ -25,6 +25,7 @@ History:
 #include "IPlayerProfiles.h"
 #include "VectorMap.h"
 #include "UI/UITypes.h"
+#include "GameCache.h"
 
 #ifndef _RELEASE
 	#define LIST_LOADOUT_CONTENTS_ON_SCREEN 0 // Feel free to turn this on locally, but please don't commit it as anything but 0 [TF]
@@ -468,6 +469,8 @@ private:
 
 	void ResetOverrides();
 
+	CGameCachePrefetch::TRequestId PrefetchContents(const TEquipmentPackageContents& contents, CGameCachePrefetch::EPriority priority, EntityId requesterId) const;
+
 	typedef std::map<int, SClientEquipmentPackage> TClientEquipmentPackages;
 	typedef CryFixedArray<TFixedString64, MP_MODEL_INDEX_DEFAULT> TModelNamesArray;
 	typedef CryFixedStringT<128> TStreamedGeometry[ePGE_Total];
@@ -509,6 +512,8 @@ private:
 
 	TClientEquipmentPackages m_clientLoadouts;
 
+	CGameCachePrefetch::TRequestId m_prefetchRequest;
+
 	typedef VectorMap<uint32, uint32>	TWeaponAttachmentFlagMap;	//weapon class name crc to attach flags
 	TWeaponAttachmentFlagMap	m_unlockedAttachments;
 	TWeaponAttachmentFlagMap	m_currentAvailableAttachments;
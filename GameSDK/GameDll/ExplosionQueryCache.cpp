@@ -0,0 +1,121 @@
+/*************************************************************************
+	Crytek Source File.
+	Copyright (C), Crytek Studios, 2001-2012.
+	-------------------------------------------------------------------------
+	$Id$
+	$DateTime$
+	Description: Per-frame cache of the entities around all queued explosions
+
+	-------------------------------------------------------------------------
+	History:
+
+*************************************************************************/
+#include "StdAfx.h"
+#include "ExplosionQueryCache.h"
+#include "Game.h"
+#include <IVehicleSystem.h>
+
+//------------------------------------------------------------------------
+CExplosionQueryCache::CExplosionQueryCache()
+: m_bounds(AABB::RESET)
+, m_valid(false)
+{
+}
+
+//------------------------------------------------------------------------
+void CExplosionQueryCache::Build(const AABB& queryBounds)
+{
+	Reset();
+
+	if (queryBounds.IsReset())
+		return;
+
+	m_bounds = queryBounds;
+	m_valid = true;
+
+	IPhysicalEntity **pents = NULL;
+	const int numRigids = gEnv->pPhysicalWorld->GetEntitiesInBox(queryBounds.min, queryBounds.max, pents, ent_rigid|ent_sleeping_rigid);
+
+	m_rigids.reserve(numRigids);
+	for (int i = 0; i < numRigids; ++i)
+	{
+		pe_status_pos statusPos;
+		if (!pents[i]->GetStatus(&statusPos))
+			continue;
+
+		SEntry entry;
+		entry.pPhysics = pents[i];
+		entry.pEntity = (IEntity*) pents[i]->GetForeignData(PHYS_FOREIGN_ID_ENTITY);
+		entry.bounds = AABB(statusPos.pos + statusPos.BBox[0], statusPos.pos + statusPos.BBox[1]);
+		m_rigids.push_back(entry);
+	}
+
+	IVehicleSystem *pVehicleSystem = g_pGame->GetIGameFramework()->GetIVehicleSystem();
+	if (pVehicleSystem->GetVehicleCount() > 0)
+	{
+		IVehicleIteratorPtr iter = pVehicleSystem->CreateVehicleIterator();
+		while (IVehicle* pVehicle = iter->Next())
+		{
+			IEntity *pEntity = pVehicle->GetEntity();
+			if (!pEntity || pEntity->IsHidden())
+				continue;
+
+			IPhysicalEntity* pPhysics = pEntity->GetPhysics();
+			if (!pPhysics)
+				continue;
+
+			SEntry entry;
+			entry.pEntity = pEntity;
+			entry.pPhysics = pPhysics;
+			pEntity->GetWorldBounds(entry.bounds);
+
+			if (entry.bounds.IsIntersectBox(queryBounds))
+			{
+				m_vehicles.push_back(entry);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+void CExplosionQueryCache::Reset()
+{
+	m_rigids.clear();
+	m_vehicles.clear();
+	m_bounds.Reset();
+	m_valid = false;
+}
+
+//------------------------------------------------------------------------
+void CExplosionQueryCache::GetRigidEntitiesInBox(const AABB& box, TEntries& results) const
+{
+	const int numRigids = m_rigids.size();
+	for (int i = 0; i < numRigids; ++i)
+	{
+		const SEntry& entry = m_rigids[i];
+		if (entry.pPhysics && entry.bounds.IsIntersectBox(box))
+		{
+			results.push_back(entry);
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+void CExplosionQueryCache::OnEntityRemoved(IEntity* pEntity)
+{
+	for (TEntries::iterator it = m_rigids.begin(); it != m_rigids.end(); ++it)
+	{
+		if (it->pEntity == pEntity)
+		{
+			it->pEntity = NULL;
+			it->pPhysics = NULL;
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+void CExplosionQueryCache::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddContainer(m_rigids);
+	pSizer->AddContainer(m_vehicles);
+}
@@ -0,0 +1,61 @@
+/*************************************************************************
+	Crytek Source File.
+	Copyright (C), Crytek Studios, 2001-2012.
+	-------------------------------------------------------------------------
+	$Id$
+	$DateTime$
+	Description: Per-frame cache of the entities around all queued explosions.
+		Clustered impacts (e.g. a volley hitting one deck) share a single
+		physical world query instead of each explosion issuing its own.
+
+	-------------------------------------------------------------------------
+	History:
+
+*************************************************************************/
+#ifndef __EXPLOSIONQUERYCACHE_H__
+#define __EXPLOSIONQUERYCACHE_H__
+
+#if _MSC_VER > 1000
+# pragma once
+#endif
+
+class CExplosionQueryCache
+{
+public:
+	struct SEntry
+	{
+		SEntry() : pEntity(NULL), pPhysics(NULL) {}
+
+		IEntity*					pEntity;
+		IPhysicalEntity*	pPhysics;
+		AABB							bounds;
+	};
+
+	typedef std::vector<SEntry> TEntries;
+
+	CExplosionQueryCache();
+
+	// Gathers rigid bodies and vehicles overlapping queryBounds into flat arrays
+	void Build(const AABB& queryBounds);
+	void Reset();
+
+	// The cache can only answer queries that lie completely inside the gathered volume
+	bool Covers(const AABB& box) const { return m_valid && m_bounds.ContainsBox(box); }
+
+	// Appends the cached rigid bodies overlapping box, in physical world order
+	void GetRigidEntitiesInBox(const AABB& box, TEntries& results) const;
+	const TEntries& GetVehicles() const { return m_vehicles; }
+
+	// Drop an entity that has been hidden or removed while the cache is alive
+	void OnEntityRemoved(IEntity* pEntity);
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+private:
+	TEntries	m_rigids;
+	TEntries	m_vehicles;
+	AABB			m_bounds;
+	bool			m_valid;
+};
+
+#endif // __EXPLOSIONQUERYCACHE_H__
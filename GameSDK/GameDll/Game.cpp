@@ -36,6 +36,7 @@ Crytek Source File.
 #include "GameCache.h"
 #include "ItemScheduler.h"
 #include "Utility/CryWatch.h"
+#include "Utility/LoadTimeline.h"
 
 #include <ICryPak.h>
 #include <CryPath.h>
@@ -106,6 +107,10 @@ Crytek Source File.
 
 #include "Environment/LedgeManager.h"
 #include "Environment/WaterPuddle.h"
+#include "Environment/WaterQueryCache.h"
+#include "Vehicle/BoatEffectsManager.h"
+#include "Vehicle/VehicleThreadExchange.h"
+#include "Vehicle/VehicleServerLod.h"
 
 #include "Graphics/ColorGradientManager.h"
 #include "VehicleClient.h"
@@ -562,6 +567,8 @@ CGame::CGame()
 #endif
 	m_pLedgeManager(0),
 	m_pWaterPuddleManager(0),
+	m_pWaterQueryCache(0),
+	m_pBoatEffectsManager(0),
 	m_colorGradientManager(0),
 	m_pRecordingSystem(0),
 	m_pEquipmentLoadout(0),
@@ -760,6 +767,8 @@ CGame::~CGame()
 	SAFE_DELETE(m_pUIManager);
 	SAFE_DELETE(m_pLedgeManager);
 	SAFE_DELETE(m_pWaterPuddleManager);
+	SAFE_DELETE(m_pWaterQueryCache);
+	SAFE_DELETE(m_pBoatEffectsManager);
 	SAFE_DELETE(m_pRecordingSystem);
 	SAFE_DELETE(m_statsRecorder);
 	SAFE_DELETE(m_patchPakManager);
@@ -887,6 +896,7 @@ static inline void InlineInitializationProcessing(const char *sDescription)
 bool CGame::Init(IGameFramework *pFramework)
 {
   LOADING_TIME_PROFILE_SECTION(GetISystem());
+	LOAD_TIMELINE_SCOPE("CGame::Init");
 
 	InlineInitializationProcessing("CGame::Init");
 #ifdef GAME_DEBUG_MEM
@@ -1271,6 +1281,16 @@ bool CGame::Init(IGameFramework *pFramework)
 		m_pWaterPuddleManager = new CWaterPuddleManager();
 	}
 
+	if (!m_pWaterQueryCache)
+	{
+		m_pWaterQueryCache = new CWaterQueryCache();
+	}
+
+	if (!m_pBoatEffectsManager)
+	{
+		m_pBoatEffectsManager = new CBoatEffectsManager();
+	}
+
 	InlineInitializationProcessing("CGame::Init LedgeManager");
 
 	m_colorGradientManager = new Graphics::CColorGradientManager();
@@ -2668,6 +2688,11 @@ int CGame::Update(bool haveFocus, unsigned int updateFlags) PREFAST_SUPPRESS_WAR
 	if (m_pMovingPlatformMgr)
 		m_pMovingPlatformMgr->Update(frameTime);
 
+	m_pWaterQueryCache->Update(frameTime);
+	m_pBoatEffectsManager->Update(frameTime);
+	SVehicleSyncStats::Update(frameTime);
+	SVehicleServerLod::Update(frameTime);
+
 	m_colorGradientManager->UpdateForThisFrame(frameTime);
 
 	{
@@ -2868,6 +2893,7 @@ int CGame::Update(bool haveFocus, unsigned int updateFlags) PREFAST_SUPPRESS_WAR
 
 		itemPfManager.Update(fCurrTime);
 
+		m_pGameCache->UpdatePrefetch();
 		m_pGameCache->Debug();
 
 		//m_pGameAchievements->Update(frameTime);
@@ -3886,6 +3912,10 @@ void CGame::OnActionEvent(const SActionEvent& event)
 
 			m_pWaterPuddleManager->Reset();
 
+			m_pWaterQueryCache->Reset();
+
+			m_pBoatEffectsManager->Reset();
+
 			m_clientActorId = 0;
 
 			if (m_pMovingPlatformMgr)
@@ -4369,6 +4399,11 @@ void CGame::GetMemoryStatistics(ICrySizer * s)
 	if (m_pMovementTransitionsSystem)
 		m_pMovementTransitionsSystem->GetMemoryUsage(s);
 
+	if (m_pWaterQueryCache)
+		m_pWaterQueryCache->GetMemoryUsage(s);
+	if (m_pBoatEffectsManager)
+		m_pBoatEffectsManager->GetMemoryUsage(s);
+
 	m_pGameCache->GetMemoryUsage(s);
 }
 
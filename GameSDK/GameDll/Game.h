@@ -113,6 +113,8 @@ class CLaptopUtil;
 class CScreenEffects;
 class CLedgeManager;
 class CWaterPuddleManager;
+class CWaterQueryCache;
+class CBoatEffectsManager;
 class CRecordingSystem;
 class CHUDMissionObjectiveSystem; // TODO : Remove me?
 class CGameBrowser;
@@ -535,6 +537,8 @@ public:
 
 	CLedgeManager*	GetLedgeManager() const { return m_pLedgeManager; };
 	CWaterPuddleManager* GetWaterPuddleManager() const {return m_pWaterPuddleManager;}
+	CWaterQueryCache* GetWaterQueryCache() const { return m_pWaterQueryCache; }
+	CBoatEffectsManager* GetBoatEffectsManager() const { return m_pBoatEffectsManager; }
 
 	CGameActions&	Actions() const {	return *m_pGameActions;	};
 
@@ -763,6 +767,12 @@ protected:
 	static void CmdTakeDamage(IConsoleCmdArgs *pArgs);
 	static void CmdRevive(IConsoleCmdArgs *pArgs);
   static void CmdVehicleKill(IConsoleCmdArgs *pArgs);
+	static void CmdBoatHullBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdBoatNetReport(IConsoleCmdArgs *pArgs);
+	static void CmdShipFloodingBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdWheeledSolverBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdShipSteeringBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdCookItemParams(IConsoleCmdArgs *pArgs);
 	static void CmdRestart(IConsoleCmdArgs *pArgs);
 	static void CmdSay(IConsoleCmdArgs *pArgs);
 	static void CmdEcho(IConsoleCmdArgs *pArgs);
@@ -966,6 +976,8 @@ private:
 	// Manager the ledges in the level (markup) that the player can grab onto
 	CLedgeManager*	m_pLedgeManager;
 	CWaterPuddleManager* m_pWaterPuddleManager;
+	CWaterQueryCache* m_pWaterQueryCache;
+	CBoatEffectsManager* m_pBoatEffectsManager;
 
 	Graphics::CColorGradientManager* m_colorGradientManager;
 
@@ -38,6 +38,7 @@ History:
 #include "UI/HUD/HUDEventWrapper.h"
 #include "UI/Utils/ScreenLayoutManager.h"
 #include "UI/Utils/ILoadingMessageProvider.h"
+#include "UI/Utils/LocalizedStringManager.h"
 #include "INetworkService.h"
 
 #include "LagOMeter.h"
@@ -53,6 +54,11 @@ History:
 #include "PlaylistManager.h"
 #include "Utility/DesignerWarning.h"
 #include "AI/GameAISystem.h"
+#include "Vehicle/VehicleHullBuoyancy.h"
+#include "Vehicle/VehicleWheelSolver.h"
+#include "VehicleMovementStdBoat.h"
+#include "ShipFlooding.h"
+#include "AI/ShipSteeringManager.h"
 #include "PersistantStats.h"
 #include "Battlechatter.h"
 
@@ -735,6 +741,11 @@ void SCVars::InitCVars(IConsole *pConsole)
 	REGISTER_CVAR(g_gameRayCastQuota, 16, VF_CHEAT, "Amount of deferred rays allowed to be cast per frame by Game");
 	REGISTER_CVAR(g_gameIntersectionTestQuota, 6, VF_CHEAT, "Amount of deferred intersection tests allowed to be cast per frame by Game");
 
+	REGISTER_CVAR(g_waterQueryCache, 1, VF_CHEAT, "Answers water height queries from a per-frame grid of ocean heights around the camera and the client actor. Queries inside water volumes, and all queries on dedicated servers, stay exact");
+	REGISTER_CVAR(g_waterQueryCellSize, 2.f, VF_CHEAT, "Cell size (in meters) of the water height query grids");
+	REGISTER_CVAR(g_waterQueryTolerance, 0.1f, VF_CHEAT, "Largest height difference between the corners of a cell that is still interpolated, above it the query is exact");
+	REGISTER_CVAR(g_waterQueryDebug, 0, VF_CHEAT, "Shows water height queries per second and the cache hit rate per subsystem");
+
 	REGISTER_CVAR(g_STAPCameraAnimation, 1, VF_CHEAT, "Enable STAP camera animation");
 	
 	REGISTER_CVAR(g_mpAllSeeingRadar, 0, VF_READONLY,	"Player has radar that permanently shows all friends and enemies (for Attackers in Assault mode).");
@@ -800,6 +811,8 @@ void SCVars::InitCVars(IConsole *pConsole)
 	REGISTER_CVAR(g_ec_volume, 0.75f, VF_CHEAT, "Explosion culling volume which needs to be exceed for objects to not be culled.");
 	REGISTER_CVAR(g_ec_extent, 2.0f, VF_CHEAT, "Explosion culling length of an AABB side which needs to be exceed for objects to not be culled.");
 	REGISTER_CVAR(g_ec_removeThreshold, 20, VF_CHEAT, "At how many items in exploding area will it start removing items.");
+	REGISTER_CVAR(g_explosionsMaxPerFrame, 1, VF_CHEAT, "Maximum number of queued explosions processed per frame.");
+	REGISTER_CVAR(g_explosionQueryCache, 1, VF_CHEAT, "Enable/Disable sharing one entity query between all explosions processed in a frame.");
 	REGISTER_CVAR(g_radialBlur, 1.0f, VF_CHEAT, "Radial blur on explosions. Default = 1, 0 to disable");
 
 	REGISTER_CVAR(g_aiCorpses_DebugDraw, 0, VF_CHEAT, "Enable AI corpse debugging");
@@ -1354,6 +1367,10 @@ void SCVars::InitCVars(IConsole *pConsole)
 
 	REGISTER_CVAR(hud_faderDebug, 0, 0, "Show Debug Information for FullScreen Faders. 2 = Disable screen fading");
 
+#ifndef _RELEASE
+	REGISTER_CVAR2("hud_localizedStringCacheDebug", &CLocalizedStringManager::s_debug, 0, 0, "Shows the size and hit rate of the localized string cache.");
+#endif
+
 	REGISTER_CVAR(hud_objectiveIcons_flashTime, 1.6f, 0, "Time between icon changes for flashing objective icons");
 
 	{
@@ -1455,6 +1472,29 @@ void SCVars::InitCVars(IConsole *pConsole)
 	REGISTER_CVAR(v_invertPitchControl, 0, VF_DUMPTODISK, "Invert the pitch control for driving some vehicles, including the helicopter and the vtol");
 	REGISTER_CVAR(v_sprintSpeed, 0.f, 0, "Set speed for acceleration measuring");
 	REGISTER_CVAR(v_rockBoats, 1, 0, "Enable/disable boats idle rocking");  
+	REGISTER_CVAR(v_boatNetMode, 1, 0, "Boat network mode, read when a boat is spawned. 0: legacy (float controls every update plus physics sync), 1: ship mode (quantised controls sent on change, snapshots and dead reckoning)");
+	REGISTER_CVAR(v_boatNetSnapshotRate, 4.f, VF_CHEAT, "Ship network mode: snapshots per second sent by the side simulating the ship");
+	REGISTER_CVAR(v_boatNetSnapDistance, 8.f, VF_CHEAT, "Ship network mode: position error (in meters) above which a remote ship snaps instead of being smoothed");
+	REGISTER_CVAR(v_boatNetCorrectionRate, 1.5f, VF_CHEAT, "Ship network mode: rate (1/s) at which remote ships converge on the dead reckoned snapshot");
+	REGISTER_CVAR(v_boatNetMaxClientError, 3.f, VF_CHEAT, "Ship network mode: largest position error (in meters) by which a client driving a ship can pull the server's simulation of it");
+	REGISTER_CVAR(v_boatNetMaxClientSpeedScale, 1.5f, VF_CHEAT, "Ship network mode: client snapshots faster than the boat's top speed times this are clamped on the server");
+	REGISTER_CVAR(v_boatNetStats, 0, 0, "Shows per boat network sends and snapshot stats of the ship and legacy network modes. The bytes sent are in the network profiler, under NetMovementStdBoat");
+	REGISTER_CVAR(v_boatHullBuoyancy, 1, 0, "Use the hull points of boats that define them for buoyancy and wave response, read when a boat is spawned");
+	REGISTER_CVAR(v_boatHullLod, -1, VF_CHEAT, "Forces the hull buoyancy sample level of all boats. -1: by distance and visibility, 0: low, 1: medium, 2: high");
+	REGISTER_CVAR(v_boatEffectsMaxDistance, 300.f, 0, "Distance from the camera beyond which boats don't update their wake and spray effects");
+	REGISTER_CVAR(v_boatEffectsMinScreenSize, 0.01f, 0, "Fraction of the screen height below which boats don't update their wake and spray effects. Boats up to four times this size spawn proportionally less");
+	REGISTER_CVAR(v_boatEffectsBudget, 32.f, 0, "Sum of the spawn count scales of all boat wake and spray emitters. Over budget the spawn rate of every boat is scaled down evenly, 0 disables the budget");
+	REGISTER_CVAR(v_boatEffectsDebug, 0, 0, "Shows the number of boats updating wake effects, culled boats, and the spawn budget");
+	REGISTER_CVAR(v_wheeledSolverStep, 0.02f, 0, "Longest step the wheeled vehicle friction solver takes, longer physics steps are split into up to 4 substeps. 0 solves once per physics step");
+	REGISTER_CVAR(v_vehicleSyncStats, 0, 0, "Shows how often the vehicle movement locks are taken and waited for, per thread, and the traffic of the lock-free input exchange");
+	REGISTER_CVAR(v_serverLod, 1, 0, "Dedicated servers update vehicles no player is close to at a lower rate, and hold back helicopter network updates that didn't change");
+	REGISTER_CVAR(v_serverLodRelevance, 200.f, 0, "Distance (in meters) from the closest player within which vehicles update every frame on dedicated servers");
+	REGISTER_CVAR(v_serverLodInterval, 4, 0, "Vehicles outside v_serverLodRelevance of every player update once every this many frames on dedicated servers");
+	REGISTER_CVAR(v_serverLodNetKeepAlive, 1.f, 0, "Seconds after which unchanged vehicle network state is sent anyway with v_serverLod");
+	REGISTER_CVAR(v_serverLodStats, 0, 0, "Vehicle movement updates run and skipped, and network sends made and held back. 1: per frame on screen, 2: logged every second");
+	REGISTER_CVAR(g_shipTexturePrefetchPerFrame, 2, 0, "Number of ship textures each ship requests per frame while it streams its texture list in");
+	REGISTER_CVAR(g_shipFloodingRate, 4.f, 0, "Steps per second of the ship compartment flooding solver, the load in between is interpolated");
+	REGISTER_CVAR(g_shipBreachAreaPerDamage, 0.002f, 0, "Hull breach area in m2 a ship opens per point of damage it takes");
 	REGISTER_CVAR(v_debugSounds, 0, 0, "Enable/disable vehicle sound debug drawing");
 
 	pAltitudeLimitCVar = REGISTER_CVAR(v_altitudeLimit, v_altitudeLimitDefault(), VF_CHEAT, "Used to restrict the helicopter and VTOL movement from going higher than a set altitude. If set to zero, the altitude limit is disabled.");
@@ -1496,6 +1536,11 @@ void SCVars::InitCVars(IConsole *pConsole)
 
 	REGISTER_CVAR(i_debug_itemparams_memusage, 0, VF_CHEAT, "Displays info about the item params memory usage");
 	REGISTER_CVAR(i_debug_weaponparams_memusage, 0, VF_CHEAT, "Displays info about the weapon params memory usage");
+	REGISTER_CVAR(i_ammoPoolPrewarmMax, 64, 0, "Maximum number of projectiles prewarmed per ammo class from the level's ammo pool manifest");
+	REGISTER_CVAR(i_ammoPoolTopUpPerFrame, 2, 0, "Maximum number of pooled projectiles spawned per frame to top ammo pools back up to their prewarm size");
+	REGISTER_CVAR(i_ammoPoolRecordManifest, 0, 0, "Writes the peak ammo pool usage of the level to its ammo pool manifest on unload");
+	REGISTER_CVAR(i_itemParamsCache, 1, 0, "Reads item, weapon and ammo parameter files that didn't change from the cooked cache instead of parsing them, and cooks the cache again after files changed");
+	REGISTER_CVAR(i_itemParamsLoadThreads, 3, 0, "Worker threads that read and parse item and weapon parameter files at startup alongside the main thread. 0 loads them on the main thread only");
 	REGISTER_CVAR(i_debug_zoom_mods, 0, VF_CHEAT, "Use zoom mode spread/recoil mods");
 	REGISTER_CVAR(i_debug_sounds, 0, VF_CHEAT, "Enable item sound debugging");
 	REGISTER_CVAR(i_debug_turrets, 0, VF_CHEAT, 
@@ -1704,6 +1749,13 @@ void SCVars::InitCVars(IConsole *pConsole)
 	REGISTER_CVAR2("ai_SquadManager_UpdateTick", &ai_SquadManager_UpdateTick,
 		5.0f, 0, "Tick time to request a new update or the squads calculation.\n");
 
+	REGISTER_CVAR(ai_shipSteering, 1, 0, "AI ships steer along the shared flow fields of the level and give way to each other. 0 sails straight for the AI move target");
+	REGISTER_CVAR(ai_shipSteeringCellSize, 16.f, 0, "Size of the cells of the navigable water grid AI ships route over, used from the next level load");
+	REGISTER_CVAR(ai_shipSteeringDraft, 2.f, 0, "Depth of water a cell needs for AI ships to route through it, used from the next level load");
+	REGISTER_CVAR(ai_shipSteeringBudget, 4096, 0, "Grid cells the AI ship flow fields may expand per frame while being built");
+	REGISTER_CVAR(ai_shipSteeringAvoidTime, 8.f, 0, "Seconds ahead AI ships look for ships and obstacles they would pass too close to");
+	REGISTER_CVAR(ai_shipSteeringDebug, 0, VF_CHEAT, "Shows the state and cost of the AI ship steering");
+
 	REGISTER_CVAR2("ai_SOMDebugName", &ai_threatModifiers.DebugAgentName, "none", 0, "Debug the threat modifier for the given AI");
 	REGISTER_CVAR2("ai_SOMIgnoreVisualRatio", &ai_threatModifiers.SOMIgnoreVisualRatio, 0.35f, 0,
 		"Ratio from [0,1] where the AI will ignore seeing an enemy (keep the threat at none).\n"
@@ -1808,6 +1860,7 @@ void SCVars::InitCVars(IConsole *pConsole)
 	REGISTER_CVAR(g_hitDeathReactions_logReactionAnimsOnLoading, eHDRLRAT_DontLog, 0, "Non-Release only CVar: Enables logging of animations used by non-animation graph-based reactions. 0: don't log, 1: log anim names, 2: log filepaths");
 	REGISTER_CVAR(g_hitDeathReactions_streaming, gEnv->bMultiplayer ? eHDRSP_EntityLifespanBased : eHDRSP_ActorsAliveAndNotInPool, 0, "Enables/Disables reactionAnims streaming. 0: Disabled, 1: DBA Registering-based, 2: Entity lifespan-based");
 	REGISTER_CVAR(g_hitDeathReactions_usePrecaching, 1, 0, "Enables/Disables precaching of of hitreactions: Requires game restart.");
+	REGISTER_CVAR(g_hitDeathReactions_foldFrameHits, 1, 0, "Only the first (or a stronger) hit an actor receives in a frame chooses a hit reaction, the other hits of that frame (e.g. grapeshot pellets) are folded into it");
 
 	REGISTER_CVAR(g_spectacularKill.maxDistanceError, 2.0f, 0, "Maximum error allowed from the optimal distance to the target");
 	REGISTER_CVAR(g_spectacularKill.minTimeBetweenKills, 1.0f, 0, "Minimum time allowed between spectacular kills");
@@ -1877,10 +1930,15 @@ void SCVars::InitCVars(IConsole *pConsole)
 	REGISTER_CVAR(g_telemetrySampleRateBandwidth, -1.0f, 0, "How often to gather bandwidth telemetry statistics (negative to disable)");
 	REGISTER_CVAR(g_telemetrySampleRateMemory, -1.0f, 0, "How often to gather memory telemetry statistics (negative to disable)");
 	REGISTER_CVAR(g_telemetrySampleRateSound, -1.0f, 0, "How often to gather sound telemetry statistics (negative to disable)");
+	REGISTER_CVAR(g_loadTimeline, 0, 0, "Writes the timeline of the game startup and of each level load to %USER%/LoadTimelines as a Chrome trace, the summary is sent with telemetry in any case");
 
 	REGISTER_CVAR(g_telemetry_xp_event_send_interval, 1.0f, 0, "How often in seconds the client should send its XP events to the server for logging in the telemetry files");
 	REGISTER_CVAR(g_telemetry_mp_upload_delay, 5.0f, 0, "How long to wait in seconds before uploading the statslog after the game ends in multiplayer");
 	REGISTER_CVAR(g_dataRefreshFrequency, 1.0f, 0, "How many hours to wait before refreshing data from web server");
+	REGISTER_CVAR(g_downloadMgrMaxConcurrent, 4, 0, "Number of downloads the download mgr requests at once, the rest are queued by priority");
+	REGISTER_CVAR(g_downloadMgrMaxRetries, 2, 0, "Number of times a download is requested again after a timeout or dropped connection, resuming where it stopped if the server allows");
+	REGISTER_CVAR(g_downloadMgrCache, 1, 0, "Keep downloaded resources in the user folder and only download them again if the server has changed them");
+	REGISTER_CVAR(g_downloadMgrRetryDelay, 1.f, 0, "Seconds before a failed download is requested again, doubled for each further retry");
 #if defined(DEDICATED_SERVER)
 	REGISTER_CVAR(g_quitOnNewDataFound, 1, 0, "Close the server down if a new data patch is found on the web server");
 	REGISTER_CVAR(g_quitNumRoundsWarning, 3, 0, "Number of rounds to wait before closing the server down when a new data patch is available (only applicable if g_quitOnNewDataFound = 1)");
@@ -1919,6 +1977,10 @@ void SCVars::InitCVars(IConsole *pConsole)
 	REGISTER_CVAR(g_setActorModelFromLua, 0, 0, "Toggle if the actor model should be set from Lua or internally");
 	REGISTER_CVAR(g_loadPlayerModelOnLoad, 1, 0, "Sets if the client player's model should be loaded on level load");
 	REGISTER_CVAR(g_enableActorLuaCache, 1, 0, "Enable the caching of actor properties from Lua to avoid Lua access at run-time");
+	REGISTER_CVAR(g_gameCachePrefetch, 1, 0, "Load the resources of picked loadouts and of the next map ahead, over several frames");
+	REGISTER_CVAR(g_gameCachePrefetchBudget, 1.0f, 0, "Milliseconds per frame spent on prefetched resources and their completion callbacks");
+	REGISTER_CVAR(g_gameCachePrefetchNearDistance, 40.0f, 0, "Actors closer to the local player than this have their resources prefetched before those further away");
+	REGISTER_CVAR(g_gameCachePrefetchDebug, 0, 0, "Show the pending resource prefetches");
 
 	REGISTER_CVAR(g_enableSlimCheckpoints, 0, 0, "Enable the use of console style checkpoints instead of full save.");
 
@@ -2187,6 +2249,10 @@ void SCVars::ReleaseCVars()
 	pConsole->UnregisterVariable("g_holdObjectiveDebug", true);
 	
 	pConsole->UnregisterVariable("g_STAPCameraAnimation", true);
+	pConsole->UnregisterVariable("g_waterQueryCache", true);
+	pConsole->UnregisterVariable("g_waterQueryCellSize", true);
+	pConsole->UnregisterVariable("g_waterQueryTolerance", true);
+	pConsole->UnregisterVariable("g_waterQueryDebug", true);
 	
 	pConsole->UnregisterVariable("g_mpAllSeeingRadar", true);
 	pConsole->UnregisterVariable("g_mpAllSeeingRadarSv", true);
@@ -2496,6 +2562,29 @@ void SCVars::ReleaseCVars()
 	pConsole->UnregisterVariable("v_invertPitchControl", true);
 	pConsole->UnregisterVariable("v_sprintSpeed", true);
 	pConsole->UnregisterVariable("v_rockBoats", true);  
+	pConsole->UnregisterVariable("v_boatNetMode", true);
+	pConsole->UnregisterVariable("v_boatNetSnapshotRate", true);
+	pConsole->UnregisterVariable("v_boatNetSnapDistance", true);
+	pConsole->UnregisterVariable("v_boatNetCorrectionRate", true);
+	pConsole->UnregisterVariable("v_boatNetMaxClientError", true);
+	pConsole->UnregisterVariable("v_boatNetMaxClientSpeedScale", true);
+	pConsole->UnregisterVariable("v_boatNetStats", true);
+	pConsole->UnregisterVariable("v_boatHullBuoyancy", true);
+	pConsole->UnregisterVariable("v_boatHullLod", true);
+	pConsole->UnregisterVariable("v_boatEffectsMaxDistance", true);
+	pConsole->UnregisterVariable("v_boatEffectsMinScreenSize", true);
+	pConsole->UnregisterVariable("v_boatEffectsBudget", true);
+	pConsole->UnregisterVariable("v_boatEffectsDebug", true);
+	pConsole->UnregisterVariable("v_vehicleSyncStats", true);
+	pConsole->UnregisterVariable("v_wheeledSolverStep", true);
+	pConsole->UnregisterVariable("v_serverLod", true);
+	pConsole->UnregisterVariable("v_serverLodRelevance", true);
+	pConsole->UnregisterVariable("v_serverLodInterval", true);
+	pConsole->UnregisterVariable("v_serverLodNetKeepAlive", true);
+	pConsole->UnregisterVariable("v_serverLodStats", true);
+	pConsole->UnregisterVariable("g_shipTexturePrefetchPerFrame", true);
+	pConsole->UnregisterVariable("g_shipFloodingRate", true);
+	pConsole->UnregisterVariable("g_shipBreachAreaPerDamage", true);
 	pConsole->UnregisterVariable("v_debugSounds", true);
 	pConsole->UnregisterVariable("v_altitudeLimit", true);
 	pConsole->UnregisterVariable("v_altitudeLimitLowerOffset", true);
@@ -2581,6 +2670,9 @@ void SCVars::ReleaseCVars()
 	pConsole->UnregisterVariable("menu3D_enabled", true);
 
 	pConsole->UnregisterVariable("hud_ContextualHealthIndicator", true);
+#ifndef _RELEASE
+	pConsole->UnregisterVariable("hud_localizedStringCacheDebug", true);
+#endif
 
 	pConsole->UnregisterVariable("hud_aspectCorrection", true);
 	pConsole->UnregisterVariable("controller_power_curve_z", true);
@@ -2605,6 +2697,11 @@ void SCVars::ReleaseCVars()
 
 	pConsole->UnregisterVariable("i_debug_itemparams_memusage", true);
 	pConsole->UnregisterVariable("i_debug_weaponparams_memusage", true);
+	pConsole->UnregisterVariable("i_ammoPoolPrewarmMax", true);
+	pConsole->UnregisterVariable("i_ammoPoolTopUpPerFrame", true);
+	pConsole->UnregisterVariable("i_ammoPoolRecordManifest", true);
+	pConsole->UnregisterVariable("i_itemParamsCache", true);
+	pConsole->UnregisterVariable("i_itemParamsLoadThreads", true);
 	pConsole->UnregisterVariable("i_debug_zoom_mods", true);
 	pConsole->UnregisterVariable("i_debug_mp_flowgraph", true);
 
@@ -2735,6 +2832,12 @@ void SCVars::ReleaseCVars()
 	pConsole->UnregisterVariable("ai_DebugPressureSystem");
 	pConsole->UnregisterVariable("ai_DebugAggressionSystem");
 	pConsole->UnregisterVariable("ai_DebugBattleFront");
+	pConsole->UnregisterVariable("ai_shipSteering", true);
+	pConsole->UnregisterVariable("ai_shipSteeringCellSize", true);
+	pConsole->UnregisterVariable("ai_shipSteeringDraft", true);
+	pConsole->UnregisterVariable("ai_shipSteeringBudget", true);
+	pConsole->UnregisterVariable("ai_shipSteeringAvoidTime", true);
+	pConsole->UnregisterVariable("ai_shipSteeringDebug", true);
 
 	pConsole->UnregisterVariable("g_actorViewDistRatio");
 	pConsole->UnregisterVariable("g_playerLodRatio");
@@ -2745,6 +2848,7 @@ void SCVars::ReleaseCVars()
 	pConsole->UnregisterVariable("g_hitDeathReactions_disable_ai", true);
 	pConsole->UnregisterVariable("g_hitDeathReactions_debug", true);
 	pConsole->UnregisterVariable("g_hitDeathReactions_disableRagdoll", true);
+	pConsole->UnregisterVariable("g_hitDeathReactions_foldFrameHits", true);
 	pConsole->UnregisterVariable("g_hitDeathReactions_disableHitAnimatedCollisions", true);
 
 	pConsole->UnregisterVariable("g_movementTransitions_enable", true);
@@ -3135,6 +3239,12 @@ void CGame::RegisterConsoleCommands()
 	REGISTER_COMMAND("takeDamage", CmdTakeDamage, VF_RESTRICTEDMODE, "Forces the player to take damage");
 	REGISTER_COMMAND("revive", CmdRevive, VF_RESTRICTEDMODE, "Revives the player.");
 	REGISTER_COMMAND("v_kill", CmdVehicleKill, VF_CHEAT, "Kills the players vehicle.");
+	REGISTER_COMMAND("v_boatHullBench", CmdBoatHullBenchmark, VF_CHEAT, "Runs the hull buoyancy solver on synthetic ships without physics and logs the cost per sample level.\nUsage: v_boatHullBench [ships] [steps]. Without a ship count 1, 16 and 64 ships are run.");
+	REGISTER_COMMAND("v_boatNetReport", CmdBoatNetReport, VF_CHEAT, "Logs the network sends and snapshots per ship per second of the boats in the level, for the legacy and the ship network mode (v_boatNetMode). The bytes sent are in the network profiler, under NetMovementStdBoat.\nUsage: v_boatNetReport [reset]. With reset the totals start over after the report.");
+	REGISTER_COMMAND("v_wheeledSolverBench", CmdWheeledSolverBenchmark, VF_CHEAT, "Drives synthetic wheeled vehicles without physics through the wheel friction solver and logs the cost per vehicle.\nUsage: v_wheeledSolverBench [vehicles] [steps]. Defaults to 64 vehicles for 600 steps.");
+	REGISTER_COMMAND("ai_shipSteeringBench", CmdShipSteeringBenchmark, VF_CHEAT, "Sails four synthetic fleets across a synthetic archipelago without physics with the AI ship steering, and logs the steering cost per frame.\nUsage: ai_shipSteeringBench [ships] [frames]. Defaults to 50 ships for 12000 frames at 30 Hz.");
+	REGISTER_COMMAND("i_itemParamsCook", CmdCookItemParams, VF_CHEAT, "Parses every item, weapon and ammo parameter file and writes the cooked cache read with i_itemParamsCache to %USER%/Cache/ItemParams.cooked. A build step can ship it as scripts/entities/items/ItemParams.cooked, which is read when there is no user copy.");
+	REGISTER_COMMAND("g_shipFloodingBench", CmdShipFloodingBenchmark, VF_CHEAT, "Floods synthetic damaged ships without physics and logs the solver cost per frame against its budget.\nUsage: g_shipFloodingBench [ships] [frames]. Defaults to 30 ships for 900 frames.");
 	REGISTER_COMMAND("sv_restart", CmdRestart, 0, "Restarts the round.");
 	REGISTER_COMMAND("sv_say", CmdSay, 0, "Broadcasts a message to all clients.");
 
@@ -3248,6 +3358,11 @@ void CGame::UnregisterConsoleCommands()
 	m_pConsole->RemoveCommand("takeDamage"); 
 	m_pConsole->RemoveCommand("revive");
 	m_pConsole->RemoveCommand("v_kill");
+	m_pConsole->RemoveCommand("v_boatHullBench");
+	m_pConsole->RemoveCommand("g_shipFloodingBench");
+	m_pConsole->RemoveCommand("v_wheeledSolverBench");
+	m_pConsole->RemoveCommand("ai_shipSteeringBench");
+	m_pConsole->RemoveCommand("i_itemParamsCook");
 	m_pConsole->RemoveCommand("sv_restart");
 	m_pConsole->RemoveCommand("sv_say");
 	m_pConsole->RemoveCommand("echo");
@@ -3672,6 +3787,64 @@ void CGame::CmdVehicleKill(IConsoleCmdArgs *pArgs)
 	}
 }
 
+//------------------------------------------------------------------------
+void CGame::CmdBoatHullBenchmark(IConsoleCmdArgs *pArgs)
+{
+	const int numSteps = (pArgs->GetArgCount() > 2) ? atoi(pArgs->GetArg(2)) : 300;
+
+	if (pArgs->GetArgCount() > 1)
+	{
+		CVehicleHullBuoyancy::RunBenchmark(atoi(pArgs->GetArg(1)), numSteps);
+	}
+	else
+	{
+		CVehicleHullBuoyancy::RunBenchmark(1, numSteps);
+		CVehicleHullBuoyancy::RunBenchmark(16, numSteps);
+		CVehicleHullBuoyancy::RunBenchmark(64, numSteps);
+	}
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdBoatNetReport(IConsoleCmdArgs *pArgs)
+{
+	const bool reset = (pArgs->GetArgCount() > 1) && !stricmp(pArgs->GetArg(1), "reset");
+	CVehicleMovementStdBoat::ReportNetStats(reset);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdShipFloodingBenchmark(IConsoleCmdArgs *pArgs)
+{
+	const int numShips = (pArgs->GetArgCount() > 1) ? atoi(pArgs->GetArg(1)) : 30;
+	const int numFrames = (pArgs->GetArgCount() > 2) ? atoi(pArgs->GetArg(2)) : 900;
+
+	CShipFlooding::RunBenchmark(numShips, numFrames);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdWheeledSolverBenchmark(IConsoleCmdArgs *pArgs)
+{
+	const int numVehicles = (pArgs->GetArgCount() > 1) ? atoi(pArgs->GetArg(1)) : 64;
+	const int numSteps = (pArgs->GetArgCount() > 2) ? atoi(pArgs->GetArg(2)) : 600;
+
+	CVehicleWheelSolver::RunBenchmark(numVehicles, numSteps);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdShipSteeringBenchmark(IConsoleCmdArgs *pArgs)
+{
+	const int numShips = (pArgs->GetArgCount() > 1) ? atoi(pArgs->GetArg(1)) : 50;
+	const int numFrames = (pArgs->GetArgCount() > 2) ? atoi(pArgs->GetArg(2)) : 12000;
+
+	CShipSteeringManager::RunBenchmark(numShips, numFrames);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdCookItemParams(IConsoleCmdArgs *pArgs)
+{
+	if (CWeaponSystem* pWeaponSystem = g_pGame->GetWeaponSystem())
+		pWeaponSystem->CookItemParams();
+}
+
 //------------------------------------------------------------------------
 void CGame::CmdRestart(IConsoleCmdArgs *pArgs)
 {
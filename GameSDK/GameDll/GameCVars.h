@@ -642,6 +642,11 @@ struct SCVars
 	int		g_gameRayCastQuota;
 	int		g_gameIntersectionTestQuota;
 
+	int		g_waterQueryCache;
+	float	g_waterQueryCellSize;
+	float	g_waterQueryTolerance;
+	int		g_waterQueryDebug;
+
 	int		g_STAPCameraAnimation;
 
 	int   g_debugaimlook;
@@ -703,6 +708,8 @@ struct SCVars
 	float g_ec_volume;
 	float g_ec_extent;
 	int		g_ec_removeThreshold;
+	int		g_explosionsMaxPerFrame;
+	int		g_explosionQueryCache;
 
 	float g_radialBlur;
 
@@ -829,6 +836,10 @@ struct SCVars
 
 	int g_enableInitialLoginSilent;
 	float g_dataRefreshFrequency;
+	int g_downloadMgrMaxConcurrent;
+	int g_downloadMgrMaxRetries;
+	int g_downloadMgrCache;
+	float g_downloadMgrRetryDelay;
 	int		g_maxGameBrowserResults;
 
 
@@ -988,6 +999,29 @@ struct SCVars
 	float v_wind_minspeed; 
 	float v_sprintSpeed;
 	int   v_rockBoats;
+	int   v_boatNetMode;
+	float v_boatNetSnapshotRate;
+	float v_boatNetSnapDistance;
+	float v_boatNetCorrectionRate;
+	float v_boatNetMaxClientError;
+	float v_boatNetMaxClientSpeedScale;
+	int   v_boatNetStats;
+	int   v_boatHullBuoyancy;
+	int   v_boatHullLod;
+	float v_boatEffectsMaxDistance;
+	float v_boatEffectsMinScreenSize;
+	float v_boatEffectsBudget;
+	int   v_boatEffectsDebug;
+	int   v_vehicleSyncStats;
+	float v_wheeledSolverStep;
+	int   v_serverLod;
+	float v_serverLodRelevance;
+	int   v_serverLodInterval;
+	float v_serverLodNetKeepAlive;
+	int   v_serverLodStats;
+	int   g_shipTexturePrefetchPerFrame;
+	float g_shipFloodingRate;
+	float g_shipBreachAreaPerDamage;
 	int   v_debugSounds;
 	float v_altitudeLimit;
 	ICVar* pAltitudeLimitCVar;
@@ -1098,6 +1132,12 @@ struct SCVars
 	int		i_debug_itemparams_memusage;
 	int		i_debug_weaponparams_memusage;
 
+	int		i_ammoPoolPrewarmMax;
+	int		i_ammoPoolTopUpPerFrame;
+	int		i_ammoPoolRecordManifest;
+	int		i_itemParamsCache;
+	int		i_itemParamsLoadThreads;
+
 	float i_failedDetonation_speedMultiplier;
 	float i_failedDetonation_lifetime;
 
@@ -1265,6 +1305,13 @@ struct SCVars
 	float ai_SquadManager_MaxDistanceFromSquadCenter;
 	float ai_SquadManager_UpdateTick;
 
+	int ai_shipSteering;
+	float ai_shipSteeringCellSize;
+	float ai_shipSteeringDraft;
+	int ai_shipSteeringBudget;
+	float ai_shipSteeringAvoidTime;
+	int ai_shipSteeringDebug;
+
 	float ai_ProximityToHostileAlertnessIncrementThresholdDistance;
 
 	int g_actorViewDistRatio;
@@ -1279,6 +1326,7 @@ struct SCVars
 	int			g_hitDeathReactions_debug;
 	int			g_hitDeathReactions_disableRagdoll;
 	int			g_hitDeathReactions_usePrecaching;
+	int			g_hitDeathReactions_foldFrameHits;
 
 	enum EHitDeathReactionsLogReactionAnimsType
 	{
@@ -1350,6 +1398,7 @@ struct SCVars
 	float g_telemetrySampleRateBandwidth;
 	float g_telemetrySampleRateMemory;
 	float g_telemetrySampleRateSound;
+	int g_loadTimeline;
 	float g_telemetry_xp_event_send_interval;
 	float g_telemetry_mp_upload_delay;
 	const char* g_telemetryTags;
@@ -1390,6 +1439,10 @@ struct SCVars
 	int g_setActorModelFromLua;
 	int g_loadPlayerModelOnLoad;
 	int g_enableActorLuaCache;
+	int g_gameCachePrefetch;
+	float g_gameCachePrefetchBudget;
+	float g_gameCachePrefetchNearDistance;
+	int g_gameCachePrefetchDebug;
 
 	int g_enableSlimCheckpoints;
 
@@ -22,6 +22,13 @@
 #include "ICryMannequin.h"
 #include "HitDeathReactionsSystem.h"
 #include "BehaviorTree/IBehaviorTree.h"
+#include "GameParameters.h"
+#include "ItemSharedParams.h"
+#include "ItemResourceCache.h"
+#include "WeaponSystem.h"
+#include "AmmoParams.h"
+#include "Utility/CryWatch.h"
+#include "Utility/LoadTimeline.h"
 
 //////////////////////////////////////////////////////////////////////////
 CGameCache::CGameCache()
@@ -97,6 +104,7 @@ void CGameCache::Init()
 void CGameCache::PrecacheLevel()
 {
 	LOADING_TIME_PROFILE_SECTION;
+	LOAD_TIMELINE_SCOPE("CGameCache::PrecacheLevel");
 
 	// Cache player model
 	if (g_pGameCVars->g_loadPlayerModelOnLoad != 0)
@@ -155,6 +163,7 @@ void CGameCache::Reset()
 	m_materialCache.clear();
 	m_statiObjectCache.clear();
 	m_characterDBAs.Reset();
+	m_prefetch.Reset();
 
 }
 
@@ -176,6 +185,7 @@ void CGameCache::GetMemoryUsage(ICrySizer *s) const
 	s->AddContainer(m_statiObjectCache);
 
 	m_characterDBAs.GetMemoryUsage(s);
+	m_prefetch.GetMemoryUsage(s);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -791,6 +801,7 @@ ILINE bool CGameCache::IsCharacterFileModelCached( const char* szFileName, uint3
 void CGameCache::Debug()
 {
 	m_characterDBAs.Debug();
+	m_prefetch.Debug();
 }
 #endif
 
@@ -1057,3 +1068,479 @@ void CGameCharacterDBAs::Debug()
 	}
 }
 #endif
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+namespace
+{
+	// The lists CGameRules::PrecacheLevel loads from at level start
+	const char* s_precacheListsFile = "Scripts/GameRules/PrecacheLists.xml";
+
+	struct SPrecacheListType
+	{
+		const char* tag;
+		CGameCachePrefetch::EResourceType type;
+	};
+
+	// Only the precache types which end up in the game side caches, the others stay with the level load
+	const SPrecacheListType s_precacheListTypes[] =
+	{
+		{ "Items", CGameCachePrefetch::eResource_ItemClass },
+		{ "Ammos", CGameCachePrefetch::eResource_AmmoClass },
+		{ "CGFs", CGameCachePrefetch::eResource_Geometry },
+		{ "CGAs", CGameCachePrefetch::eResource_Geometry },
+		{ "CHRs", CGameCachePrefetch::eResource_Character },
+		{ "Particles", CGameCachePrefetch::eResource_Particle },
+	};
+
+	bool IsPrecacheEntryForThisPlatform(const XmlNodeRef& precacheItemNode)
+	{
+		const char* precachePlatform = precacheItemNode->getAttr("platform");
+		if (!precachePlatform[0])
+			return true;
+
+#if defined(XENON)
+		return (strcmpi(precachePlatform, "360") == 0);
+#elif defined(PS3)
+		return (strcmpi(precachePlatform, "ps3") == 0);
+#else
+		return (strcmpi(precachePlatform, "pc") == 0);
+#endif
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+CGameCachePrefetch::CGameCachePrefetch()
+: m_nextRequestId(INVALID_REQUEST + 1)
+, m_nextMapRequestId(INVALID_REQUEST)
+, m_numIssued(0)
+, m_numCancelled(0)
+, m_lastUpdateMs(0.0f)
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////////
+CGameCachePrefetch::TRequestId CGameCachePrefetch::AddRequest(EPriority priority, EntityId requesterId, IListener* pListener)
+{
+	CRY_ASSERT((priority >= 0) && (priority < ePriority_Count));
+
+	if (!g_pGameCVars->g_gameCachePrefetch)
+		return INVALID_REQUEST;
+
+	SRequest request;
+	request.id = m_nextRequestId++;
+	request.requesterId = requesterId;
+	request.pListener = pListener;
+
+	if (m_nextRequestId == INVALID_REQUEST)
+		++m_nextRequestId;
+
+	m_queues[priority].push_back(request);
+
+	return request.id;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CGameCachePrefetch::AddResource(TRequestId requestId, EResourceType type, const char* resourceName, int flags)
+{
+	SRequest* pRequest = FindRequest(requestId);
+	if (pRequest && resourceName && resourceName[0])
+	{
+		pRequest->resources.push_back(SResource());
+
+		SResource& resource = pRequest->resources.back();
+		resource.name = resourceName;
+		resource.flags = flags;
+		resource.type = type;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+CGameCachePrefetch::SRequest* CGameCachePrefetch::FindRequest(TRequestId requestId)
+{
+	if (requestId != INVALID_REQUEST)
+	{
+		for (int priority = 0; priority < ePriority_Count; ++priority)
+		{
+			TRequestQueue& queue = m_queues[priority];
+			for (TRequestQueue::iterator it = queue.begin(); it != queue.end(); ++it)
+			{
+				if (it->id == requestId)
+					return &(*it);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CGameCachePrefetch::Cancel(TRequestId requestId)
+{
+	if (requestId == INVALID_REQUEST)
+		return;
+
+	for (int priority = 0; priority < ePriority_Count; ++priority)
+	{
+		TRequestQueue& queue = m_queues[priority];
+		for (TRequestQueue::iterator it = queue.begin(); it != queue.end(); ++it)
+		{
+			if (it->id == requestId)
+			{
+				queue.erase(it);
+				++m_numCancelled;
+				return;
+			}
+		}
+	}
+
+	// Done already, the callback is not wanted anymore
+	for (TCompletedRequests::iterator it = m_completed.begin(); it != m_completed.end(); ++it)
+	{
+		if (it->first == requestId)
+		{
+			m_completed.erase(it);
+			return;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CGameCachePrefetch::CancelRequester(EntityId requesterId)
+{
+	if (requesterId == 0)
+		return;
+
+	for (int priority = 0; priority < ePriority_Count; ++priority)
+	{
+		TRequestQueue& queue = m_queues[priority];
+		for (TRequestQueue::iterator it = queue.begin(); it != queue.end(); )
+		{
+			if (it->requesterId == requesterId)
+			{
+				it = queue.erase(it);
+				++m_numCancelled;
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CGameCachePrefetch::RemoveListener(IListener* pListener)
+{
+	for (int priority = 0; priority < ePriority_Count; ++priority)
+	{
+		TRequestQueue& queue = m_queues[priority];
+		for (TRequestQueue::iterator it = queue.begin(); it != queue.end(); ++it)
+		{
+			if (it->pListener == pListener)
+				it->pListener = NULL;
+		}
+	}
+
+	for (TCompletedRequests::iterator it = m_completed.begin(); it != m_completed.end(); )
+	{
+		if (it->second == pListener)
+			it = m_completed.erase(it);
+		else
+			++it;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+CGameCachePrefetch::TRequestId CGameCachePrefetch::PrefetchNextMap(const char* gameRules, const char* levelName)
+{
+	// A new vote or rotation step replaces the previous guess
+	Cancel(m_nextMapRequestId);
+	m_nextMapRequestId = INVALID_REQUEST;
+
+	if (!gameRules || !gameRules[0] || !levelName || !levelName[0])
+		return INVALID_REQUEST;
+
+	XmlNodeRef root = gEnv->pSystem->LoadXmlFromFile(s_precacheListsFile);
+	if (!root)
+		return INVALID_REQUEST;
+
+	m_nextMapRequestId = AddRequest(ePriority_Predictive);
+	if (m_nextMapRequestId == INVALID_REQUEST)
+		return INVALID_REQUEST;
+
+	// The rotation may name the rules by an alias, the lists use the class name
+	const char* gameRulesName = g_pGame->GetIGameFramework()->GetIGameRulesSystem()->GetGameRulesName(gameRules);
+	if (!gameRulesName)
+		gameRulesName = gameRules;
+
+	const char* levelFileName = PathUtil::GetFile(levelName);
+
+	const int numPrecacheSets = root->getChildCount();
+	for (int i = 0; i < numPrecacheSets; ++i)
+	{
+		XmlNodeRef precacheNode = root->getChild(i);
+		const char* precacheName = precacheNode->getAttr("name");
+		const char* precacheTag = precacheNode->getTag();
+
+		bool precacheIt = false;
+		if (strcmpi(precacheTag, "GameMode") == 0)
+		{
+			precacheIt = (strcmpi(precacheName, gameRulesName) == 0) || ((strcmpi(precacheName, "Multiplayer") == 0) && gEnv->bMultiplayer);
+		}
+		else if (strcmpi(precacheTag, "Level") == 0)
+		{
+			precacheIt = (strcmpi(precacheName, levelName) == 0) || (strcmpi(precacheName, levelFileName) == 0);
+		}
+		else if (strcmpi(precacheTag, "MultiplayerOption") == 0)
+		{
+			precacheIt = gEnv->bMultiplayer;
+		}
+		else if (strcmpi(precacheTag, "Always") == 0)
+		{
+			precacheIt = true;
+		}
+
+		if (precacheIt)
+		{
+			AddPrecacheList(m_nextMapRequestId, precacheNode);
+		}
+	}
+
+	const SRequest* pRequest = FindRequest(m_nextMapRequestId);
+	CryLog("[GameCachePrefetch] Predicted %d resources for '%s' on '%s'", pRequest ? (int)pRequest->resources.size() : 0, gameRulesName, levelName);
+
+	return m_nextMapRequestId;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CGameCachePrefetch::AddPrecacheList(TRequestId requestId, const XmlNodeRef& precacheListNode)
+{
+	const int numPrecacheTypes = precacheListNode->getChildCount();
+	for (int p = 0; p < numPrecacheTypes; ++p)
+	{
+		XmlNodeRef precacheNode = precacheListNode->getChild(p);
+		const char* precacheType = precacheNode->getTag();
+
+		for (int t = 0; t < ARRAY_COUNT(s_precacheListTypes); ++t)
+		{
+			if (strcmpi(precacheType, s_precacheListTypes[t].tag) != 0)
+				continue;
+
+			const int numPrecacheItems = precacheNode->getChildCount();
+			for (int k = 0; k < numPrecacheItems; ++k)
+			{
+				XmlNodeRef precacheItemNode = precacheNode->getChild(k);
+				if (IsPrecacheEntryForThisPlatform(precacheItemNode))
+				{
+					AddResource(requestId, s_precacheListTypes[t].type, precacheItemNode->getAttr("name"));
+				}
+			}
+			break;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CGameCachePrefetch::Update(CGameCache& gameCache)
+{
+	const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+	const float budgetMs = g_pGameCVars->g_gameCachePrefetchBudget;
+
+	// Nothing is spent on requests whose requester went away
+	for (int priority = 0; priority < ePriority_Count; ++priority)
+	{
+		TRequestQueue& queue = m_queues[priority];
+		for (TRequestQueue::iterator it = queue.begin(); it != queue.end(); )
+		{
+			if ((it->requesterId != 0) && (gEnv->pEntitySystem->GetEntity(it->requesterId) == NULL))
+			{
+				it = queue.erase(it);
+				++m_numCancelled;
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	// Callbacks and issuing share the budget, at least one of each runs per frame so nothing starves
+	bool firstCallback = true;
+	while (!m_completed.empty() && (firstCallback || ((gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds() < budgetMs)))
+	{
+		const std::pair<TRequestId, IListener*> completed = m_completed.front();
+		m_completed.erase(m_completed.begin());
+
+		completed.second->OnPrefetchComplete(completed.first);
+		firstCallback = false;
+	}
+
+	bool firstIssue = true;
+	for (int priority = 0; priority < ePriority_Count; ++priority)
+	{
+		TRequestQueue& queue = m_queues[priority];
+		while (!queue.empty())
+		{
+			if (!firstIssue && ((gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds() >= budgetMs))
+			{
+				priority = ePriority_Count;
+				break;
+			}
+
+			// Loading may end up queueing or cancelling requests, so nothing is held across it
+			const TRequestId requestId = queue.front().id;
+			const int resourceIndex = queue.front().nextResource++;
+			if (resourceIndex < (int)queue.front().resources.size())
+			{
+				const SResource resource = queue.front().resources[resourceIndex];
+				IssueResource(gameCache, resource);
+				++m_numIssued;
+				firstIssue = false;
+			}
+
+			if (!queue.empty() && (queue.front().id == requestId) && (queue.front().nextResource >= (int)queue.front().resources.size()))
+			{
+				if (queue.front().pListener)
+					m_completed.push_back(std::make_pair(requestId, queue.front().pListener));
+
+				if (requestId == m_nextMapRequestId)
+					m_nextMapRequestId = INVALID_REQUEST;
+
+				queue.erase(queue.begin());
+			}
+		}
+	}
+
+	m_lastUpdateMs = (gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CGameCachePrefetch::IssueResource(CGameCache& gameCache, const SResource& resource)
+{
+	CGameSharedParametersStorage* pGameParamsStorage = g_pGame->GetGameSharedParametersStorage();
+	CItemResourceCache& itemResourceCache = pGameParamsStorage->GetItemResourceCache();
+	const char* resourceName = resource.name.c_str();
+
+	switch (resource.type)
+	{
+	case eResource_ItemClass:
+		{
+			IEntityClass* pItemClass = gEnv->pEntitySystem->GetClassRegistry()->FindClass(resourceName);
+			CItemSharedParams* pSharedParams = pItemClass ? pGameParamsStorage->GetItemSharedParameters(pItemClass->GetName(), false) : NULL;
+			if (pSharedParams)
+			{
+				pSharedParams->CacheResources(itemResourceCache, pItemClass);
+			}
+		}
+		break;
+
+	case eResource_AmmoClass:
+		{
+			IEntityClass* pAmmoClass = gEnv->pEntitySystem->GetClassRegistry()->FindClass(resourceName);
+			const SAmmoParams* pAmmoParams = pAmmoClass ? g_pGame->GetWeaponSystem()->GetAmmoParams(pAmmoClass) : NULL;
+			if (pAmmoParams)
+			{
+				pAmmoParams->CacheResources();
+			}
+		}
+		break;
+
+	case eResource_Geometry:
+		itemResourceCache.GetItemGeometryCache().CacheGeometry(resourceName, true);
+		break;
+
+	case eResource_Character:
+		itemResourceCache.GetPrefetchCHRManager().Prefetch(ItemString(resourceName));
+		break;
+
+	case eResource_Material:
+		gameCache.CacheMaterial(resourceName);
+		break;
+
+	case eResource_Texture:
+		gameCache.CacheTexture(resourceName, resource.flags);
+		break;
+
+	case eResource_Particle:
+		itemResourceCache.GetParticleEffectCache().CacheParticle(resourceName);
+		break;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CGameCachePrefetch::Reset()
+{
+	for (int priority = 0; priority < ePriority_Count; ++priority)
+	{
+		stl::free_container(m_queues[priority]);
+	}
+
+	stl::free_container(m_completed);
+	m_nextMapRequestId = INVALID_REQUEST;
+	m_numIssued = 0;
+	m_numCancelled = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CGameCachePrefetch::GetMemoryUsage(ICrySizer *s) const
+{
+	for (int priority = 0; priority < ePriority_Count; ++priority)
+	{
+		s->AddContainer(m_queues[priority]);
+	}
+
+	s->AddContainer(m_completed);
+}
+
+//////////////////////////////////////////////////////////////////////////
+CGameCachePrefetch::EPriority CGameCachePrefetch::GetPriorityForActor(EntityId actorId)
+{
+	IGameFramework* pGameFramework = g_pGame->GetIGameFramework();
+	if (actorId == pGameFramework->GetClientActorId())
+		return ePriority_LocalPlayer;
+
+	IActor* pClientActor = pGameFramework->GetClientActor();
+	IEntity* pActorEntity = gEnv->pEntitySystem->GetEntity(actorId);
+	if (pClientActor && pActorEntity)
+	{
+		const float nearDistance = g_pGameCVars->g_gameCachePrefetchNearDistance;
+		if (pActorEntity->GetWorldPos().GetSquaredDistance(pClientActor->GetEntity()->GetWorldPos()) < sqr(nearDistance))
+			return ePriority_Nearby;
+	}
+
+	return ePriority_Distant;
+}
+
+#if GAME_CACHE_DEBUG
+//////////////////////////////////////////////////////////////////////////
+void CGameCachePrefetch::Debug() const
+{
+	if (!g_pGameCVars->g_gameCachePrefetchDebug)
+		return;
+
+	static const char* s_priorityNames[ePriority_Count] =
+	{
+		"local player",
+		"nearby",
+		"distant",
+		"predictive",
+	};
+
+	for (int priority = 0; priority < ePriority_Count; ++priority)
+	{
+		const TRequestQueue& queue = m_queues[priority];
+
+		int numPending = 0;
+		for (TRequestQueue::const_iterator it = queue.begin(); it != queue.end(); ++it)
+		{
+			numPending += it->resources.size() - it->nextResource;
+		}
+
+		CryWatch("Prefetch %s: %d requests, %d resources pending", s_priorityNames[priority], (int)queue.size(), numPending);
+	}
+
+	CryWatch("Prefetch: %d issued, %d cancelled, %d callbacks pending, %.2f ms last frame", m_numIssued, m_numCancelled, (int)m_completed.size(), m_lastUpdateMs);
+}
+#endif
@@ -92,6 +92,115 @@ private:
 	TCharacterDBAGroups	m_dbaGroups; 
 };
 
+class CGameCache;
+
+// Resources an actor or item is about to need, loaded ahead over the next frames instead of when first used.
+// Requests are served by priority within a time budget per frame; geometry and characters are requested
+// streamed, so the reads happen in the background. Requests of an entity which goes away are dropped
+class CGameCachePrefetch
+{
+public:
+	enum EPriority
+	{
+		ePriority_LocalPlayer = 0,
+		ePriority_Nearby,
+		ePriority_Distant,
+		ePriority_Predictive,		// only served once nothing else is pending
+
+		ePriority_Count
+	};
+
+	enum EResourceType
+	{
+		eResource_ItemClass = 0,	// item and weapon resources, through the item resource cache
+		eResource_AmmoClass,
+		eResource_Geometry,
+		eResource_Character,			// kept resident for a while by the item CHR prefetch
+		eResource_Material,
+		eResource_Texture,
+		eResource_Particle,
+	};
+
+	typedef uint32 TRequestId;
+	static const TRequestId INVALID_REQUEST = 0;
+
+	struct IListener
+	{
+		virtual ~IListener() {}
+		// Every resource of the request has been issued, cancelled requests are not reported
+		virtual void OnPrefetchComplete(TRequestId requestId) = 0;
+	};
+
+	CGameCachePrefetch();
+
+	TRequestId AddRequest(EPriority priority, EntityId requesterId = 0, IListener* pListener = NULL);
+	void AddResource(TRequestId requestId, EResourceType type, const char* resourceName, int flags = 0);
+
+	void Cancel(TRequestId requestId);
+	void CancelRequester(EntityId requesterId);
+	void RemoveListener(IListener* pListener);
+
+	// Queues what the precache lists name for the given game rules and level, ahead of loading it
+	TRequestId PrefetchNextMap(const char* gameRules, const char* levelName);
+
+	void Update(CGameCache& gameCache);
+	void Reset();
+	void GetMemoryUsage(ICrySizer *s) const;
+
+	// The local player first, then by distance to it
+	static EPriority GetPriorityForActor(EntityId actorId);
+
+#if GAME_CACHE_DEBUG
+	void Debug() const;
+#else
+	ILINE void Debug() const {};
+#endif
+
+private:
+	struct SResource
+	{
+		SResource() : flags(0), type(eResource_ItemClass) {}
+
+		void GetMemoryUsage(ICrySizer *s) const { s->AddObject(name); }
+
+		string name;
+		int flags;
+		EResourceType type;
+	};
+
+	typedef std::vector<SResource> TResources;
+
+	struct SRequest
+	{
+		SRequest() : id(INVALID_REQUEST), requesterId(0), pListener(NULL), nextResource(0) {}
+
+		void GetMemoryUsage(ICrySizer *s) const { s->AddContainer(resources); }
+
+		TRequestId id;
+		EntityId requesterId;
+		IListener* pListener;
+		TResources resources;
+		int nextResource;
+	};
+
+	typedef std::vector<SRequest> TRequestQueue;
+	typedef std::vector<std::pair<TRequestId, IListener*> > TCompletedRequests;
+
+	SRequest* FindRequest(TRequestId requestId);
+	void AddPrecacheList(TRequestId requestId, const XmlNodeRef& precacheListNode);
+	static void IssueResource(CGameCache& gameCache, const SResource& resource);
+
+	TRequestQueue m_queues[ePriority_Count];
+	TCompletedRequests m_completed;
+	TRequestId m_nextRequestId;
+	TRequestId m_nextMapRequestId;
+
+	// stats, shown by g_gameCachePrefetchDebug
+	int m_numIssued;
+	int m_numCancelled;
+	float m_lastUpdateMs;
+};
+
 class CGameCache : public IEntityPoolListener
 {
 public:
@@ -133,6 +242,9 @@ public:
 	bool PrepareDBAsFor(const EntityId userId, const std::vector<string>& dbaGroups);
 	void RemoveDBAUser(const EntityId userId);
 
+	CGameCachePrefetch& GetPrefetch() { return m_prefetch; }
+	void UpdatePrefetch() { m_prefetch.Update(*this); }
+
 #if GAME_CACHE_DEBUG
 	void Debug();
 #else
@@ -241,6 +353,8 @@ private:
 	//DBA management for characters
 	CGameCharacterDBAs m_characterDBAs;
 
+	CGameCachePrefetch m_prefetch;
+
 	IActorSystem *m_pActorSystem;
 };
 
@@ -1630,8 +1630,7 @@ void CGameRules::ProcessEvent( SEntityEvent& event)
 			m_explosionValidities[i]	= false;
 		}
     
-		while (!m_queuedExplosions.empty())
-			m_queuedExplosions.pop();
+		m_queuedExplosions.clear();
 
 		while (!m_queuedExplosionsAwaitingRaycasts.empty())
 			m_queuedExplosionsAwaitingRaycasts.pop();
@@ -8885,8 +8884,7 @@ void CGameRules::ResetQueuedExplosionsAndHits()
 		m_explosionValidities[i]	= false;
 	}
 
-	while (!m_queuedExplosions.empty())
-		m_queuedExplosions.pop();
+	m_queuedExplosions.clear();
 
 	while (!m_queuedExplosionsAwaitingRaycasts.empty())
 		m_queuedExplosionsAwaitingRaycasts.pop();
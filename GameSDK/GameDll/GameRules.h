@@ -33,6 +33,8 @@
 
 #include "IAntiCheatManager.h"
 
+#include "ExplosionQueryCache.h"
+
 #if defined(SERVER_CHECKS)
 #include "PlayerPositionChecker.h"
 #endif
@@ -888,6 +890,7 @@ public:
 	void UpdateEntitySchedules(float frameTime);
 	void FlushEntitySchedules();
 	void ProcessQueuedExplosions();
+	void PrepareExplosionQueryCache(int numExplosions);
 	ILINE void ClearExplosion(SExplosionContainer *pExplosionInfo);
 	void ProcessServerExplosion(SExplosionContainer &explosionInfo);
 	
@@ -2366,10 +2369,13 @@ protected:
 	SmartScriptTable		m_scriptClientHitInfo;
 
 	typedef std::queue<SExplosionContainer*>	TExplosionPtrQueue;
-	TExplosionPtrQueue		m_queuedExplosions;
+	typedef std::deque<SExplosionContainer*>	TExplosionPtrDeque;
+	TExplosionPtrDeque		m_queuedExplosions;				// a deque so the explosions due this frame can be looked ahead at
 	TExplosionPtrQueue		m_queuedExplosionsAwaitingRaycasts;
 	SExplosionContainer		m_explosions[MAX_CONCURRENT_EXPLOSIONS];
 	bool					m_explosionValidities[MAX_CONCURRENT_EXPLOSIONS];
+	CExplosionQueryCache	m_explosionQueryCache;
+	CExplosionQueryCache::TEntries	m_explosionCachedEntities;	// scratch for the entities of one explosion
 
 	typedef std::queue<HitInfo> THitQueue;
 	THitQueue						m_queuedHits;
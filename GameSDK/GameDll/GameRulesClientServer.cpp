@@ -91,6 +91,7 @@ History:
 static const int sSimulateExplosionMaxEntitiesToSkip = 20;
 #include "SkillKill.h"
 #include "EnvironmentalWeapon.h"
+#include "Ship.h"
 
 //------------------------------------------------------------------------
 // Our local client has hit something locally
@@ -451,6 +452,15 @@ void CGameRules::ProcessServerHit(const HitInfo& hitInfo)
 				(*iter)->OnHit(hitInfo);
 		}
 
+		// ships open a breach in their hull where they are hit
+		if (!pTarget)
+		{
+			if (CShip* pShip = static_cast<CShip*>(g_pGame->GetIGameFramework()->QueryGameObjectExtension(hitInfo.targetId, "Ship")))
+			{
+				pShip->OnHit(&hitInfo);
+			}
+		}
+
 		if(bActorKilled && pTarget)
 		{
 			PostHitKillCleanup(pTarget);
@@ -585,7 +595,7 @@ void CGameRules::QueueExplosion(const ExplosionInfo &explosionInfo)
 		m_explosionValidities[index] = true;
 		m_explosions[index].m_mfxInfo.Reset();
 
-		m_queuedExplosions.push(&m_explosions[index]);
+		m_queuedExplosions.push_back(&m_explosions[index]);
 	}
 	else
 	{
@@ -613,11 +623,16 @@ void CGameRules::ProcessServerExplosion(SExplosionContainer &explosionInfo)
 //------------------------------------------------------------------------
 void CGameRules::ProcessQueuedExplosions()
 {
-  const static uint8 nMaxExp = 1;
+	const int nMaxExp = max(g_pGameCVars->g_explosionsMaxPerFrame, 1);
+
+	if (!m_queuedExplosions.empty())
+	{
+		PrepareExplosionQueryCache(min((int)m_queuedExplosions.size(), nMaxExp));
+	}
 
 	if(gEnv->bServer)
 	{
-		for (uint8 exp=0; !m_queuedExplosions.empty() && exp<nMaxExp; ++exp)
+		for (int exp=0; !m_queuedExplosions.empty() && exp<nMaxExp; ++exp)
 		{ 
 			SExplosionContainer& info = *m_queuedExplosions.front();
 			ProcessServerExplosion(info);
@@ -631,12 +646,12 @@ void CGameRules::ProcessQueuedExplosions()
 				ClearExplosion(&info);
 			}
 
-			m_queuedExplosions.pop();
+			m_queuedExplosions.pop_front();
 		}
 	}
 	else
 	{
-		for (uint8 exp=0; !m_queuedExplosions.empty() && exp<nMaxExp; ++exp)
+		for (int exp=0; !m_queuedExplosions.empty() && exp<nMaxExp; ++exp)
 		{ 
 			SExplosionContainer& info = *m_queuedExplosions.front();
 			ClientExplosion(info);
@@ -650,13 +665,40 @@ void CGameRules::ProcessQueuedExplosions()
 				ClearExplosion(&info);
 			}
 
-			m_queuedExplosions.pop();
+			m_queuedExplosions.pop_front();
 		}
 	}
 
+	m_explosionQueryCache.Reset();
+
 	ProcessDeferredMaterialEffects();
 }
 
+//------------------------------------------------------------------------
+// Gathers the entities for the union of the explosions processed this frame,
+// the first numExplosions in the queue, so that they share one physics query
+void CGameRules::PrepareExplosionQueryCache(int numExplosions)
+{
+	// A lone explosion gains nothing from the shared query
+	if (numExplosions <= 1 || !g_pGameCVars->g_explosionQueryCache)
+	{
+		m_explosionQueryCache.Reset();
+		return;
+	}
+
+	const float cullRadiusScale = g_pGameCVars->g_ec_radiusScale;
+
+	AABB queryBounds(AABB::RESET);
+	for (int i = 0; i < numExplosions; ++i)
+	{
+		const ExplosionInfo& explosionInfo = m_queuedExplosions[i]->m_explosionInfo;
+		const float radius = max(explosionInfo.radius, cullRadiusScale * explosionInfo.physRadius);
+		queryBounds.Add(explosionInfo.pos, radius);
+	}
+
+	m_explosionQueryCache.Build(queryBounds);
+}
+
 //------------------------------------------------------------------------
 void CGameRules::ProcessDeferredMaterialEffects()
 {
@@ -701,7 +743,20 @@ void CGameRules::CullEntitiesInExplosion(const ExplosionInfo &explosionInfo)
 	IActor *pClientActor = g_pGame->GetIGameFramework()->GetClientActor();
 
 	Vec3 radiusVec(radiusScale * explosionInfo.physRadius);
-	int i = gEnv->pPhysicalWorld->GetEntitiesInBox(explosionInfo.pos-radiusVec,explosionInfo.pos+radiusVec,pents, ent_rigid|ent_sleeping_rigid);
+	const AABB cullBox(explosionInfo.pos-radiusVec, explosionInfo.pos+radiusVec);
+
+	const bool fromCache = m_explosionQueryCache.Covers(cullBox);
+	int i = 0;
+	if (fromCache)
+	{
+		m_explosionCachedEntities.clear();
+		m_explosionQueryCache.GetRigidEntitiesInBox(cullBox, m_explosionCachedEntities);
+		i = m_explosionCachedEntities.size();
+	}
+	else
+	{
+		i = gEnv->pPhysicalWorld->GetEntitiesInBox(cullBox.min,cullBox.max,pents, ent_rigid|ent_sleeping_rigid);
+	}
 	int removedCount = 0;
 
 	static IEntityClass* s_pInteractiveEntityClass = gEnv->pEntitySystem->GetClassRegistry()->FindClass("InteractiveEntity");
@@ -716,7 +771,7 @@ void CGameRules::CullEntitiesInExplosion(const ExplosionInfo &explosionInfo)
 			if(removedCount>=entitiesToRemove)
 				break;
 
-			IEntity * pEntity = (IEntity*) pents[i]->GetForeignData(PHYS_FOREIGN_ID_ENTITY);
+			IEntity * pEntity = fromCache ? m_explosionCachedEntities[i].pEntity : (IEntity*) pents[i]->GetForeignData(PHYS_FOREIGN_ID_ENTITY);
 			if (pEntity)
 			{
 				// don't remove items/pickups
@@ -767,6 +822,8 @@ void CGameRules::CullEntitiesInExplosion(const ExplosionInfo &explosionInfo)
 				// but craig says, hiding is not synchronized for DX10 breakable MP, so we remove entities only when playing pure game
 				// alexl: in SinglePlayer, we also currently only hide the object because it could be part of flowgraph logic
 				//        which would break if Entity was removed and could not propagate events anymore
+				m_explosionQueryCache.OnEntityRemoved(pEntity);
+
 				if (gEnv->bMultiplayer == false || gEnv->IsEditor())
 				{
 					pEntity->Hide(true);
@@ -1038,9 +1095,24 @@ void CGameRules::CalculateExplosionAffectedEntities(const ExplosionInfo &explosi
 		UpdateAffectedEntitiesSet(affectedEntities, explosion);
 
 		// check vehicles
+		const float radiusSqr = explosionInfo.radius*explosionInfo.radius;
 		IVehicleSystem *pVehicleSystem = g_pGame->GetIGameFramework()->GetIVehicleSystem();
 		uint32 vcount = pVehicleSystem->GetVehicleCount();
-		if (vcount > 0)
+		if (vcount > 0 && m_explosionQueryCache.Covers(AABB(explosionInfo.pos, explosionInfo.radius)))
+		{
+			const CExplosionQueryCache::TEntries& vehicles = m_explosionQueryCache.GetVehicles();
+			const int numVehicles = vehicles.size();
+			for (int i = 0; i < numVehicles; ++i)
+			{
+				const CExplosionQueryCache::SEntry& vehicle = vehicles[i];
+				if (vehicle.bounds.GetDistanceSqr(explosionInfo.pos) <= radiusSqr)
+				{
+					float affected = gEnv->pPhysicalWorld->CalculateExplosionExposure(&explosion, vehicle.pPhysics);
+					AddOrUpdateAffectedEntity(affectedEntities, vehicle.pEntity, affected);
+				}
+			}
+		}
+		else if (vcount > 0)
 		{
 			IVehicleIteratorPtr iter = g_pGame->GetIGameFramework()->GetIVehicleSystem()->CreateVehicleIterator();
 			while (IVehicle* pVehicle = iter->Next())
@@ -30,6 +30,7 @@ History:
 #include "IBasicEventListener.h"
 #include "Editor/GameRealtimeRemoteUpdate.h"
 #include "Utility/StringUtils.h"
+#include "Utility/LoadTimeline.h"
 
 #include "Testing/AutoTester.h"
 #include "ModInfoManager.h"
@@ -533,6 +534,8 @@ IGameRef CGameStartup::Init(SSystemInitParams &startupParams)
 
   LOADING_TIME_PROFILE_SECTION(m_pFramework->GetISystem());
 
+	CLoadTimeline::BeginCapture("startup");
+
 	ISystem* pSystem = m_pFramework->GetISystem();
 	startupParams.pSystem = pSystem;
 
@@ -651,6 +654,9 @@ IGameRef CGameStartup::Init(SSystemInitParams &startupParams)
 #endif // CRY_UNIT_TESTING
 
 	GetISystem()->GetISystemEventDispatcher()->OnSystemEvent(ESYSTEM_EVENT_RANDOM_SEED, (UINT_PTR)gEnv->pTimer->GetAsyncTime().GetMicroSecondsAsInt64(), 0);
+
+	CLoadTimeline::EndCapture();
+
 	return pOut;
 }
 
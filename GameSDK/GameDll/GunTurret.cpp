@@ -29,6 +29,7 @@ History:
 #include "Player.h"
 #include "ItemSharedParams.h"
 #include "TacticalManager.h"
+#include "Environment/WaterQueryCache.h"
 
 
 namespace 
@@ -489,7 +490,7 @@ Vec3 CGunTurret::GetTargetPos(IEntity* pEntity) const
 				return dyn.centerOfMass;
 
 			Vec3 pos=dyn.centerOfMass;
-			float waterLevel=gEnv->p3DEngine->GetWaterLevel(&pos);
+			float waterLevel=g_pGame->GetWaterQueryCache()->GetWaterLevel(pos, CWaterQueryCache::eWQ_Weapon);
 			if (waterLevel>=pos.z)
 				pos.z=waterLevel;
 
@@ -390,7 +390,7 @@ m_fReactionCounter(-1.0f), m_iGoalPipeId(0), m_AIPausedState(eAIP_NotPaused), m_
 m_pHitInfo(NULL), m_reactionOnCollision(NO_COLLISION_REACTION), m_currentExecutionType(eET_None),
 m_reactionFlags(0), m_effectorChannel(INVALID_FACIAL_CHANNEL_ID), m_pCurrentReactionParams(NULL), m_pseudoRandom(g_pGame->GetHitDeathReactionsSystem().GetRandomGenerator()),
 m_profileId(INVALID_PROFILE_ID), m_postDeathTagRagdoll(TAG_STATE_EMPTY),
-m_bInSmartObject(false)
+m_bInSmartObject(false), m_fFrameHitsMaxDamage(0.0f), m_bFrameHitsReactionStarted(false)
 {
 	m_pSelfTable.Create(m_pScriptSystem);
 
@@ -714,6 +714,30 @@ bool CHitDeathReactions::OnHit(const HitInfo& hitInfo, float fCausedDamage/* = 0
 		}
 	}
 
+	// Multi projectile shots (grapeshot, pellets) deliver all their hits in the same frame. Once a reaction
+	// has been chosen for this frame, weaker or equal hits are folded into it instead of evaluating the
+	// reactions again
+	if (g_pGameCVars->g_hitDeathReactions_foldFrameHits)
+	{
+		// Keyed on the timer's frame start time rather than gEnv->pRenderer->GetFrameID(): dedicated servers
+		// run without a renderer frame id, so it would never change there and every hit would be folded
+		const CTimeValue frameTime = gEnv->pTimer->GetFrameStartTime();
+		if (frameTime != m_frameHitsTime)
+		{
+			m_frameHitsTime = frameTime;
+			m_fFrameHitsMaxDamage = hitInfo.damage;
+			m_bFrameHitsReactionStarted = false;
+		}
+		else if (m_bFrameHitsReactionStarted || (hitInfo.damage <= m_fFrameHitsMaxDamage))
+		{
+			return m_bFrameHitsReactionStarted;
+		}
+		else
+		{
+			m_fFrameHitsMaxDamage = hitInfo.damage;
+		}
+	}
+
 	m_bInSmartObject = static_cast<CPlayer&>(m_actor).IsPlayingSmartObjectAction();
 
 	if (CanPlayHitReaction())
@@ -732,6 +756,8 @@ bool CHitDeathReactions::OnHit(const HitInfo& hitInfo, float fCausedDamage/* = 0
 		}	
 	}
 
+	m_bFrameHitsReactionStarted = bSuccess;
+
 	return bSuccess;
 }
 
@@ -287,6 +287,11 @@ private:
 
 	bool														m_bInSmartObject;
 
+	// Hits received during the same frame share the reaction chosen for the strongest of them
+	CTimeValue											m_frameHitsTime;				// game frame start, the renderer frame id does not advance on a dedicated server
+	float														m_fFrameHitsMaxDamage;
+	bool														m_bFrameHitsReactionStarted;
+
 	unsigned char										m_reactionOnCollision;
 	uint8														m_reactionFlags;
 };
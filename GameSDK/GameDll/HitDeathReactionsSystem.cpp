@@ -10,6 +10,7 @@
 #include "GameCVars.h"
 #include "GameRules.h"
 #include "Player.h"
+#include "Utility/LoadTimeline.h"
 
 // Unnamed namespace for constants
 namespace
@@ -886,6 +887,8 @@ void CHitDeathReactionsSystem::Reload()
 //////////////////////////////////////////////////////////////////////////
 void CHitDeathReactionsSystem::PreloadData()
 {
+	LOAD_TIMELINE_SCOPE("CHitDeathReactionsSystem::PreloadData");
+
 	// Clear the existing cache ready for reload
 	stl::free_container(m_reactionsScriptTableCache);
 
@@ -0,0 +1,351 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+Description: Cooked copy of the item, weapon and ammo parameter files
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#include "StdAfx.h"
+#include "ItemParamsCache.h"
+#include "GameCVars.h"
+
+namespace
+{
+	// Bump when the layout of the blob changes
+	const int k_cookedVersion = 2;
+
+	// Written on the first run, a build step can ship the same file with the data
+	const char* k_cookedUserFile = "%USER%/Cache/ItemParams.cooked";
+	const char* k_cookedDataFile = "scripts/entities/items/ItemParams.cooked";
+
+	void MakeKey(const char* fileName, string& key)
+	{
+		key = fileName;
+		key.replace('\\', '/');
+		key.MakeLower();
+	}
+}
+
+//------------------------------------------------------------------------
+CItemParamsCache::CItemParamsCache()
+: m_cookedOpened(false)
+, m_invalidated(false)
+, m_numCooked(0)
+, m_numParsed(0)
+{
+}
+
+//------------------------------------------------------------------------
+XmlNodeRef CItemParamsCache::LoadXml(const char* fileName)
+{
+	string key;
+	MakeKey(fileName, key);
+
+	TEntries::iterator it = m_entries.find(key);
+	if (it != m_entries.end())
+		return it->second.root;
+
+	if (!g_pGameCVars->i_itemParamsCache)
+	{
+		SEntry& entry = m_entries[key];
+		entry.root = gEnv->pSystem->LoadXmlFromFile(fileName);
+		++m_numParsed;
+		return entry.root;
+	}
+
+	const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+
+	OpenCooked();
+
+	SLoadJob job;
+	PrepareJob(fileName, key, job);
+	LoadFile(job);
+	XmlNodeRef root = FinishJob(job);
+
+	m_loadTime += gEnv->pTimer->GetAsyncTime() - startTime;
+
+	return root;
+}
+
+//------------------------------------------------------------------------
+class CItemParamsCache::CLoadThread : public CryThread<>
+{
+public:
+	CLoadThread(SLoadBatch& batch) : m_batch(batch) {}
+
+	virtual void Run()
+	{
+		SetName("ItemParamsLoader");
+		ScopedSwitchToGlobalHeap globalHeap;
+
+		ProcessJobs(m_batch);
+	}
+
+private:
+	SLoadBatch& m_batch;
+};
+
+//------------------------------------------------------------------------
+void CItemParamsCache::Prefetch(const std::vector<string>& fileNames, int numThreads)
+{
+	LOAD_TIMELINE_SCOPE("CItemParamsCache::Prefetch");
+
+	const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+
+	if (g_pGameCVars->i_itemParamsCache)
+		OpenCooked();
+
+	SLoadBatch batch;
+	batch.jobs.reserve(fileNames.size());
+	batch.timelineScope = CLoadTimeline::GetCurrentScope();
+
+	std::set<string> keys;
+	string key;
+	for (size_t i = 0, count = fileNames.size(); i < count; ++i)
+	{
+		MakeKey(fileNames[i].c_str(), key);
+		if (m_entries.find(key) == m_entries.end() && keys.insert(key).second)
+		{
+			batch.jobs.push_back(SLoadJob());
+			PrepareJob(fileNames[i].c_str(), key, batch.jobs.back());
+		}
+	}
+
+	numThreads = min(numThreads, (int)batch.jobs.size() - 1);
+
+	std::vector<CLoadThread*> threads;
+	for (int i = 0; i < numThreads; ++i)
+	{
+		threads.push_back(new CLoadThread(batch));
+		threads.back()->Start();
+	}
+
+	ProcessJobs(batch);
+
+	for (size_t i = 0; i < threads.size(); ++i)
+	{
+		threads[i]->WaitForThread();
+		delete threads[i];
+	}
+
+	// Entries are added in the order of the list, whichever thread loaded them
+	for (size_t i = 0, count = batch.jobs.size(); i < count; ++i)
+		FinishJob(batch.jobs[i]);
+
+	m_loadTime += gEnv->pTimer->GetAsyncTime() - startTime;
+}
+
+//------------------------------------------------------------------------
+void CItemParamsCache::PrepareJob(const char* fileName, const string& key, SLoadJob& job) const
+{
+	job.fileName = fileName;
+	job.key = key;
+
+	// The cooked blob is only touched on the main thread
+	TCookedIndex::const_iterator cookedIt = m_cookedIndex.find(key);
+	if (cookedIt != m_cookedIndex.end())
+	{
+		XmlNodeRef fileNode = m_cookedRoot->getChild(cookedIt->second);
+		if (fileNode->getChildCount() == 1 && fileNode->getAttr("time", job.cookedModTime) && fileNode->getAttr("size", job.cookedSize))
+			job.cookedIndex = cookedIt->second;
+	}
+}
+
+//------------------------------------------------------------------------
+void CItemParamsCache::LoadFile(SLoadJob& job)
+{
+	// Only opened to check the size and time against the cooked copy, the text is read if they changed
+	ICryPak* pCryPak = gEnv->pCryPak;
+	FILE* pFile = pCryPak->FOpen(job.fileName.c_str(), "rb");
+	if (!pFile)
+	{
+		job.cookedIndex = -1;
+		job.parse = false;
+		return;
+	}
+
+	SEntry& entry = job.entry;
+	entry.size = (uint32)pCryPak->FGetSize(pFile);
+	entry.modTime = pCryPak->GetModificationTime(pFile);
+
+	if (job.cookedIndex >= 0 && job.cookedModTime == entry.modTime && job.cookedSize == entry.size)
+	{
+		pCryPak->FClose(pFile);
+		job.parse = false;
+		return;
+	}
+
+	std::vector<char> buffer(entry.size);
+	const size_t size = buffer.empty() ? 0 : pCryPak->FReadRaw(&buffer[0], 1, buffer.size(), pFile);
+	pCryPak->FClose(pFile);
+
+	if (size)
+	{
+		IXmlParser* pParser = gEnv->pSystem->GetXmlUtils()->CreateXmlParser();
+		entry.root = pParser->ParseBuffer(&buffer[0], (int)size, false);
+		pParser->Release();
+	}
+}
+
+//------------------------------------------------------------------------
+void CItemParamsCache::ProcessJobs(SLoadBatch& batch)
+{
+	LOAD_TIMELINE_SCOPE_CHILD("CItemParamsCache::ProcessJobs", batch.timelineScope);
+
+	const LONG numJobs = (LONG)batch.jobs.size();
+	for (LONG job = CryInterlockedIncrement(&batch.nextJob) - 1; job < numJobs; job = CryInterlockedIncrement(&batch.nextJob) - 1)
+	{
+		LoadFile(batch.jobs[job]);
+	}
+}
+
+//------------------------------------------------------------------------
+XmlNodeRef CItemParamsCache::FinishJob(SLoadJob& job)
+{
+	SEntry& entry = m_entries[job.key];
+	entry = job.entry;
+
+	if (job.parse)
+	{
+		if (!entry.root)
+			GameWarning("Failed to parse item parameters '%s'", job.fileName.c_str());
+
+		++m_numParsed;
+	}
+	else if (job.cookedIndex >= 0)
+	{
+		entry.root = m_cookedRoot->getChild(job.cookedIndex)->getChild(0);
+		++m_numCooked;
+	}
+
+	return entry.root;
+}
+
+//------------------------------------------------------------------------
+void CItemParamsCache::OpenCooked()
+{
+	if (m_cookedOpened)
+		return;
+
+	m_cookedOpened = true;
+
+	if (m_invalidated)
+		return;
+
+	const char* cookedFiles[] = { k_cookedUserFile, k_cookedDataFile };
+	for (int i = 0; i < (int)ARRAY_COUNT(cookedFiles) && !m_cookedRoot; ++i)
+	{
+		if (!gEnv->pCryPak->IsFileExist(cookedFiles[i]))
+			continue;
+
+		XmlNodeRef root = gEnv->pSystem->LoadXmlFromFile(cookedFiles[i]);
+
+		int version = 0;
+		if (root && !strcmp(root->getTag(), "ItemParamsCache") && root->getAttr("version", version) && version == k_cookedVersion)
+			m_cookedRoot = root;
+	}
+
+	if (!m_cookedRoot)
+		return;
+
+	string key;
+	const int numFiles = m_cookedRoot->getChildCount();
+	for (int i = 0; i < numFiles; ++i)
+	{
+		MakeKey(m_cookedRoot->getChild(i)->getAttr("path"), key);
+		m_cookedIndex[key] = i;
+	}
+}
+
+//------------------------------------------------------------------------
+void CItemParamsCache::Invalidate()
+{
+	m_invalidated = true;
+}
+
+//------------------------------------------------------------------------
+void CItemParamsCache::Flush()
+{
+	if (m_numCooked || m_numParsed)
+	{
+		CryLog("Item parameters: %d files read from the cooked cache, %d parsed, %.1f ms", m_numCooked, m_numParsed, m_loadTime.GetMilliSeconds());
+	}
+
+	// Files parsed because they changed, or because the blob is missing or outdated, are cooked together with the
+	// cooked files not asked for this time
+	if (g_pGameCVars->i_itemParamsCache && m_numParsed)
+	{
+		XmlNodeRef root = gEnv->pSystem->CreateXmlNode("ItemParamsCache");
+		root->setAttr("version", k_cookedVersion);
+
+		for (TEntries::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+		{
+			const SEntry& entry = it->second;
+			if (!entry.root)
+				continue;
+
+			XmlNodeRef fileNode = root->newChild("File");
+			fileNode->setAttr("path", it->first.c_str());
+			fileNode->setAttr("time", entry.modTime);
+			fileNode->setAttr("size", entry.size);
+			fileNode->addChild(CopyNode(entry.root));
+		}
+
+		for (TCookedIndex::const_iterator it = m_cookedIndex.begin(); it != m_cookedIndex.end(); ++it)
+		{
+			if (m_entries.find(it->first) == m_entries.end())
+				root->addChild(CopyNode(m_cookedRoot->getChild(it->second)));
+		}
+
+		gEnv->pCryPak->MakeDir("%USER%/Cache");
+		if (!gEnv->pSystem->GetXmlUtils()->SaveBinaryXmlFile(k_cookedUserFile, root))
+			GameWarning("Failed to write the cooked item parameters to '%s'", k_cookedUserFile);
+
+		m_invalidated = false;
+	}
+
+	stl::free_container(m_entries);
+	stl::free_container(m_cookedIndex);
+	m_cookedRoot = NULL;
+	m_cookedOpened = false;
+
+	m_numCooked = 0;
+	m_numParsed = 0;
+	m_loadTime = CTimeValue();
+}
+
+//------------------------------------------------------------------------
+XmlNodeRef CItemParamsCache::CopyNode(const XmlNodeRef& source)
+{
+	// Nodes of the cooked blob are read only and can't be moved to another document
+	XmlNodeRef node = gEnv->pSystem->CreateXmlNode(source->getTag());
+
+	const int numAttributes = source->getNumAttributes();
+	for (int i = 0; i < numAttributes; ++i)
+	{
+		const char* key = NULL;
+		const char* value = NULL;
+		if (source->getAttributeByIndex(i, &key, &value))
+			node->setAttr(key, value);
+	}
+
+	node->setContent(source->getContent());
+
+	const int numChildren = source->getChildCount();
+	for (int i = 0; i < numChildren; ++i)
+		node->addChild(CopyNode(source->getChild(i)));
+
+	return node;
+}
+
+//------------------------------------------------------------------------
+void CItemParamsCache::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddObject(this, sizeof(*this));
+	pSizer->AddContainer(m_entries);
+	pSizer->AddContainer(m_cookedIndex);
+}
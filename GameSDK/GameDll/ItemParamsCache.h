@@ -0,0 +1,105 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+Description: Cooked copy of the item, weapon and ammo parameter files.
+	The files are kept in one binary XML blob along with their size and
+	modification time. A file that still has both is taken from the blob
+	without its text being read or parsed, any other file is parsed and the
+	blob is cooked again once loading is done. The nodes of the blob are
+	still walked by the item system like parsed ones.
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#ifndef __ITEMPARAMSCACHE_H__
+#define __ITEMPARAMSCACHE_H__
+
+#if _MSC_VER > 1000
+# pragma once
+#endif
+
+#include "Utility/LoadTimeline.h"
+
+class CItemParamsCache
+{
+public:
+	CItemParamsCache();
+
+	// Root node of the file, from the cooked blob if its size and time match. Each file is only read once
+	// until Flush, the base files of inherited items in particular
+	XmlNodeRef LoadXml(const char* fileName);
+
+	// Reads and parses the files not read yet on worker threads and the calling one, LoadXml then
+	// returns them right away. Works with the cooked blob turned off too
+	void Prefetch(const std::vector<string>& fileNames, int numThreads);
+
+	// Cooks the blob again if a file had to be parsed, and releases all nodes
+	void Flush();
+
+	// Ignores the cooked blob until the next flush, which then cooks every file read
+	void Invalidate();
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+private:
+	struct SEntry
+	{
+		SEntry() : modTime(0), size(0) {}
+
+		XmlNodeRef root;
+		uint64 modTime;
+		uint32 size;
+	};
+
+	typedef std::map<string, SEntry> TEntries;
+	typedef std::map<string, int> TCookedIndex;
+
+	// One file to read, filled in on the main thread and completed by whichever thread takes it
+	struct SLoadJob
+	{
+		SLoadJob() : cookedIndex(-1), cookedModTime(0), cookedSize(0), parse(true) {}
+
+		string fileName;
+		string key;
+		int cookedIndex;
+		uint64 cookedModTime;
+		uint32 cookedSize;
+		SEntry entry;
+		bool parse;					// set to false by the thread if the cooked copy can be used
+	};
+
+	struct SLoadBatch
+	{
+		SLoadBatch() : nextJob(0), timelineScope(CLoadTimeline::kNoScope) {}
+
+		std::vector<SLoadJob> jobs;
+		volatile LONG nextJob;
+		int timelineScope;		// the load timeline scopes of the threads nest in the prefetch
+	};
+
+	class CLoadThread;
+
+	void OpenCooked();
+	void PrepareJob(const char* fileName, const string& key, SLoadJob& job) const;
+	XmlNodeRef FinishJob(SLoadJob& job);
+	static void LoadFile(SLoadJob& job);
+	static void ProcessJobs(SLoadBatch& batch);
+	static XmlNodeRef CopyNode(const XmlNodeRef& source);
+
+	TEntries m_entries;
+
+	XmlNodeRef m_cookedRoot;
+	TCookedIndex m_cookedIndex;				// file name to child of m_cookedRoot
+	bool m_cookedOpened;
+	bool m_invalidated;
+
+	// since the last flush
+	int m_numCooked;
+	int m_numParsed;
+	CTimeValue m_loadTime;
+};
+
+#endif // __ITEMPARAMSCACHE_H__
@@ -21,6 +21,7 @@ History:
 #include "GameXmlParamReader.h"
 #include "ItemParamsRegistrationOperators.h"
 #include "ICryMannequin.h"
+#include "Utility/LoadTimeline.h"
 
 #undef ReadOptionalParams
 #define ReadOptionalParams(paramString, param) {									\
@@ -992,6 +993,8 @@ void CItemSharedParams::CacheResources( CItemResourceCache& itemResourceCache, c
 	if (itemResourceCache.AreClassResourcesCached(pItemClass))
 		return;
 
+	LOAD_TIMELINE_SCOPE("CItemSharedParams::CacheResources");
+
 	if (g_pGameCVars->designer_warning_level_resources)
 	{
 		if (g_pGame->IsLevelLoaded())
@@ -25,6 +25,7 @@
 #include "GameCodeCoverage/GameCodeCoverageTracker.h"
 #include "PlayerProgression.h"
 #include "GameRules.h"
+#include "GameCache.h"
 #include "GameRulesModules/GameRulesModulesManager.h"
 #include "GameRulesModules/IGameRulesStateModule.h"
 #include "GameRulesModules/IGameRulesRoundsModule.h"
@@ -9734,6 +9735,9 @@ void CGameLobby::UpdateRulesAndLevel(const char *pGameRules, const char *pLevelN
 	SetCurrentLevelName(pLevelName);
 
 	PrecachePaks(pLevelName);
+
+	// The caches are flushed on unload only, so what is warmed while waiting here carries into the level load
+	g_pGame->GetGameCache().GetPrefetch().PrefetchNextMap(pGameRules, pLevelName);
 }
 
 //-------------------------------------------------------------------------
@@ -13,6 +13,7 @@
 *************************************************************************/
 
 #include "StdAfx.h"
+#include "CryUnitTest.h"
 #include "PatchPakManager.h"
 #include "Utility/CryWatch.h"
 #include "Network/Lobby/GameLobbyData.h"
@@ -32,6 +33,9 @@
 #define k_defaultPatchPakPollTime						300 // 5 mins default is overideable within permissions xml to get a new poll update time
 #define k_defaultPatchPakDebug							0
 #define k_defaultPatchPakDediServerMustPatch	0
+#define k_defaultPatchPakStreaming					0
+
+static const char *k_streamedPatchPakFolder="%USER%/PatchPaks";
 
 void CPatchPakMemoryBlock::CopyMemoryRegion( void *pOutputBuffer,size_t nOffset,size_t nSize )
 {
@@ -45,6 +49,57 @@ void CPatchPakMemoryBlock::CopyMemoryRegion( void *pOutputBuffer,size_t nOffset,
 	}
 }
 
+CPatchPakStreamWriter::CPatchPakStreamWriter( const char *inPath, FILE *inFile ) :
+	m_path(inPath),
+	m_pFile(inFile),
+	m_bytesWritten(0),
+	m_writeFailed(false)
+{
+	GetISystem()->GetIZLibCompressor()->MD5Init(&m_md5Context);
+}
+
+CPatchPakStreamWriter::~CPatchPakStreamWriter()
+{
+	if (m_pFile)
+	{
+		gEnv->pCryPak->FClose(m_pFile);
+	}
+}
+
+bool CPatchPakStreamWriter::DataReceived( CDownloadableResource *pInResource, const char *pInData, int inDataLen )
+{
+	if (m_pFile && !m_writeFailed)
+	{
+		GetISystem()->GetIZLibCompressor()->MD5Update(&m_md5Context, pInData, inDataLen);
+
+		if (gEnv->pCryPak->FWrite(pInData, 1, inDataLen, m_pFile) == (size_t)inDataLen)
+		{
+			m_bytesWritten += inDataLen;
+		}
+		else
+		{
+			m_writeFailed = true;
+		}
+	}
+
+	return m_pFile && !m_writeFailed;
+}
+
+bool CPatchPakStreamWriter::Finish( char outMD5[16] )
+{
+	bool succeeded = (m_pFile != NULL) && !m_writeFailed;
+
+	if (m_pFile)
+	{
+		succeeded = (gEnv->pCryPak->FClose(m_pFile) == 0) && succeeded;
+		m_pFile = NULL;
+	}
+
+	GetISystem()->GetIZLibCompressor()->MD5Final(&m_md5Context, outMD5);
+
+	return succeeded;
+}
+
 CPatchPakManager::SPatchPakData::SPatchPakData()
 {
 	m_pPatchPakMemBlock=NULL;
@@ -85,6 +140,7 @@ CPatchPakManager::CPatchPakManager() :
 		"Usage: g_patchpak_poll_time <time in seconds between permissions polling\n");
 	m_patchPakDebug=REGISTER_INT("g_patchpak_debug", k_defaultPatchPakDebug, 0, "turn on watch debugging of patch paks");
 	m_patchPakDediServerMustPatch=REGISTER_INT("g_patchPakDediServerMustPatch", k_defaultPatchPakDediServerMustPatch, 0, "if set, dedi servers MUST be able to access the patch download server, or they will fatal error and exit");
+	m_patchPakStreaming=REGISTER_INT("g_patchpak_streaming", k_defaultPatchPakStreaming, 0, "if set, patch paks are verified and written to the user folder as they download and opened from there, instead of being held in memory");
 
 	m_enabled=m_patchPakEnabled->GetIVal() ? true : false;	// don't allow enabled changes whilst running
 
@@ -123,6 +179,13 @@ CPatchPakManager::~CPatchPakManager()
 				CRY_ASSERT(closeResult == IPlatformOS::eCDPC_Success);
 				patchPakData.m_state = SPatchPakData::es_Cached;
 			}
+			else if (patchPakData.m_state == SPatchPakData::es_PakLoaded && !patchPakData.m_streamedPakPath.empty())
+			{
+				uint32 nFlags = ICryPak::FLAGS_NEVER_IN_PAK|ICryPak::FLAGS_PATH_REAL|ICryArchive::FLAGS_OVERRIDE_PAK;
+
+				bool bSuccess=gEnv->pCryPak->ClosePack(patchPakData.m_streamedPakPath.c_str(), nFlags);
+				CRY_ASSERT_MESSAGE(bSuccess, "we failed to close our streamed patch pak, pack file. Not good!");
+			}
 			else if (patchPakData.m_state == SPatchPakData::es_PakLoaded)
 			{
 				// close the pak file
@@ -178,6 +241,7 @@ CPatchPakManager::~CPatchPakManager()
 		ic->UnregisterVariable(m_patchPakDownloadTimeOut->GetName());
 		ic->UnregisterVariable(m_patchPakPollTime->GetName());
 		ic->UnregisterVariable(m_patchPakDebug->GetName());
+		ic->UnregisterVariable(m_patchPakStreaming->GetName());
 	}
 
 	GetISystem()->GetPlatformOS()->RemoveListener(this);
@@ -261,6 +325,14 @@ void CPatchPakManager::Update(float frameTime)
 		if (m_patchPakDebug->GetIVal())
 		{
 			CryWatch("patch[%d] %s state=%d; bindRoot=%s", i, patchPakData.m_url.c_str(), patchPakData.m_state, patchPakData.m_pakBindRoot.c_str());
+
+			if (patchPakData.m_state == SPatchPakData::eS_Downloading && patchPakData.m_downloadableResource)
+			{
+				int downloaded=0, total=0;
+				patchPakData.m_downloadableResource->GetProgress(&downloaded, &total);
+				const float timeTaken = (gEnv->pTimer->GetAsyncTime() - patchPakData.m_downloadStartTime).GetSeconds();
+				CryWatch("patch[%d] %s %d/%d bytes (%.1f KB/sec); %d bytes in memory", i, patchPakData.m_pStreamWriter ? "streaming" : "downloading", downloaded, total, (timeTaken > 0.f) ? (downloaded / 1024.f) / timeTaken : 0.f, patchPakData.m_downloadableResource->GetBufferSize());
+			}
 		}
 #endif
 
@@ -455,6 +527,10 @@ void CPatchPakManager::BlockingUpdateTillDone()
 			const float sleepTimeS=sleepTimeMs/1000.f;
 
 			CrySleep(sleepTimeMs);
+			if (CDownloadMgr *pDL=g_pGame->GetDownloadMgr())
+			{
+				pDL->UpdateScheduler();	// paks beyond the concurrent download limit are queued
+			}
 			Update(sleepTimeS);
 
 			// we need to leave the save message on for an amount of time to ensure that the RT has picked it up and is displaying it
@@ -515,7 +591,7 @@ void CPatchPakManager::BlockingUpdateTillDone()
 		{
 			SPatchPakData &patchPakData=m_patchPaks[i];
 	
-			if ( (patchPakData.m_state == SPatchPakData::es_Downloaded && patchPakData.m_downloadableResource) ||
+			if ( (patchPakData.m_state == SPatchPakData::es_Downloaded && (patchPakData.m_downloadableResource || !patchPakData.m_streamedPakPath.empty())) ||
 				   (patchPakData.m_state == SPatchPakData::es_Cached) )
 			{
 				OpenPatchPakDataAsPak(&patchPakData);
@@ -666,6 +742,13 @@ void CPatchPakManager::DataFailedToDownload(CDownloadableResourcePtr inResource)
 		CryLog("failed to download patch pak url=%s", patchPakIndex >= 0 ? m_patchPaks[patchPakIndex].m_url.c_str() : "N/A");
 		if (patchPakIndex >= 0)
 		{
+			if (CPatchPakStreamWriter *pStreamWriter = m_patchPaks[patchPakIndex].m_pStreamWriter.get())
+			{
+				char pMD5[16];
+				pStreamWriter->Finish(pMD5);
+				gEnv->pCryPak->RemoveFile(pStreamWriter->GetPath());
+			}
+
 			m_patchPaks.removeAt(patchPakIndex); // will deconstruct and clear the smart ptr
 			m_patchPakRemoved=true;
 			m_numPatchPaksFailedToDownload++;
@@ -731,6 +814,14 @@ void CPatchPakManager::UnloadPatchPakFiles()
 			CRY_ASSERT(closeResult == IPlatformOS::eCDPC_Success);
 			patchPakData.m_state = SPatchPakData::es_Cached;
 		}
+		else if (patchPakData.m_state == SPatchPakData::es_PakLoaded && !patchPakData.m_streamedPakPath.empty())
+		{
+			uint32 nFlags = ICryPak::FLAGS_NEVER_IN_PAK|ICryPak::FLAGS_PATH_REAL|ICryArchive::FLAGS_OVERRIDE_PAK;
+
+			bool bSuccess=gEnv->pCryPak->ClosePack(patchPakData.m_streamedPakPath.c_str(), nFlags);
+			CRY_ASSERT_MESSAGE(bSuccess, "we failed to close our streamed patch pak, pack file. Not good!");
+			patchPakData.m_state = SPatchPakData::es_Downloaded;
+		}
 		else if (patchPakData.m_state == SPatchPakData::es_PakLoaded)
 		{
 			// close the pak file
@@ -1037,27 +1128,7 @@ void CPatchPakManager::StartNewDownload(const char *inServerName, const int inPo
 				case IPlatformOS::eCDPO_FileNotFound:
 				{
 					CryLog("CPatchPakManager::StartNewDownload() has found we need to actually download this patch pak %s", inURL);
-					int maxSize=inDownloadSize+k_maxHttpHeaderSize;
-
-					newPatchPakData.m_state = SPatchPakData::eS_Downloading;
-
-					newPatchPakData.m_downloadableResource = new CDownloadableResource;
-
-					CryFixedStringT<50> md5FileName;
-					const char *remoteFileName = inURL;
-
-					if (inMD5FileName)
-					{
-						md5FileName.Format("%s.pak", inMD5);
-						remoteFileName = md5FileName.c_str();
-						CryLog("CPatchPakManager::StartNewDownload() has MD5FileName set, so using %s as the remoteFileName instead of inURL=%s", remoteFileName, inURL);
-					}
-
-					newPatchPakData.m_downloadableResource->SetDownloadInfo(remoteFileName, inURLPrefix, inServerName, inPort, maxSize, inDescName);
-					newPatchPakData.m_downloadableResource->AddDataListener( this );
-
-					m_numPatchPaksDownloading++;
-
+					StartPakDownload(newPatchPakData, inServerName, inPort, inURLPrefix, inURL, inDownloadSize, inMD5, inMD5FileName, inDescName);
 					break;
 				}
 
@@ -1069,30 +1140,118 @@ void CPatchPakManager::StartNewDownload(const char *inServerName, const int inPo
 		else
 		{
 			CryLog("CPatchPakManager::StartNewDownload() we're either not okToCachePaks (%d) or not usingCachePaks (%d). We need to just download our patches as required", m_okToCachePaks, m_isUsingCachePaks);
+			StartPakDownload(newPatchPakData, inServerName, inPort, inURLPrefix, inURL, inDownloadSize, inMD5, inMD5FileName, inDescName);
+		}
 
-			int maxSize=inDownloadSize+k_maxHttpHeaderSize;
+		m_patchPaks.push_back(newPatchPakData);
+	}
+}
 
-			newPatchPakData.m_state = SPatchPakData::eS_Downloading;
-			newPatchPakData.m_downloadableResource = new CDownloadableResource;
+// all paks in the permissions are downloaded at once, each through its own resource
+void CPatchPakManager::StartPakDownload(SPatchPakData &ioPakData, const char *inServerName, const int inPort, const char *inURLPrefix, const char *inURL, const int inDownloadSize, const char *inMD5, const bool inMD5FileName, const char *inDescName)
+{
+	CPatchPakStreamWriterPtr pStreamWriter;
 
-			CryFixedStringT<50> md5FileName;
-			const char *remoteFileName = inURL;
+	if (m_patchPakStreaming->GetIVal())
+	{
+		CryFixedStringT<ICryPak::g_nMaxPath> streamedPakPath;
+		GenerateStreamedPakPath(streamedPakPath, inURL);
 
-			if (inMD5FileName)
-			{
-				md5FileName.Format("%s.pak", inMD5);
-				remoteFileName = md5FileName.c_str();
-				CryLog("CPatchPakManager::StartNewDownload() has MD5FileName set, so using %s as the remoteFileName instead of inURL=%s", remoteFileName, inURL);
-			}
+		if (VerifyStreamedPak(streamedPakPath.c_str(), inDownloadSize, ioPakData.m_pMD5))
+		{
+			CryLog("CPatchPakManager::StartPakDownload() has found this patch pak %s was already streamed to %s, no need to download it", inURL, streamedPakPath.c_str());
+			ioPakData.m_streamedPakPath = streamedPakPath;
+			ioPakData.m_state = SPatchPakData::es_Downloaded;
+			return;
+		}
+
+		FILE *pFile = gEnv->pCryPak->FOpen(streamedPakPath.c_str(), "wb", ICryPak::FLAGS_PATH_REAL);
+		if (pFile)
+		{
+			CryLog("CPatchPakManager::StartPakDownload() streaming patch pak %s to %s", inURL, streamedPakPath.c_str());
+			pStreamWriter = new CPatchPakStreamWriter(streamedPakPath.c_str(), pFile);
+		}
+		else
+		{
+			CryLog("CPatchPakManager::StartPakDownload() failed to open %s for writing, downloading patch pak %s into memory instead", streamedPakPath.c_str(), inURL);
+		}
+	}
+
+	int maxSize=inDownloadSize+k_maxHttpHeaderSize;
 
-			newPatchPakData.m_downloadableResource->SetDownloadInfo(remoteFileName, inURLPrefix, inServerName, inPort, maxSize, inDescName);
-			newPatchPakData.m_downloadableResource->AddDataListener( this );
+	ioPakData.m_state = SPatchPakData::eS_Downloading;
+	ioPakData.m_downloadableResource = new CDownloadableResource;
+	ioPakData.m_pStreamWriter = pStreamWriter;
+	ioPakData.m_downloadStartTime = gEnv->pTimer->GetAsyncTime();
 
-			m_numPatchPaksDownloading++;
+	CryFixedStringT<50> md5FileName;
+	const char *remoteFileName = inURL;
+
+	if (inMD5FileName)
+	{
+		md5FileName.Format("%s.pak", inMD5);
+		remoteFileName = md5FileName.c_str();
+		CryLog("CPatchPakManager::StartPakDownload() has MD5FileName set, so using %s as the remoteFileName instead of inURL=%s", remoteFileName, inURL);
+	}
+
+	ioPakData.m_downloadableResource->SetDownloadInfo(remoteFileName, inURLPrefix, inServerName, inPort, maxSize, inDescName);
+	ioPakData.m_downloadableResource->SetStreamSink(pStreamWriter);
+	ioPakData.m_downloadableResource->AddDataListener( this );
+
+	m_numPatchPaksDownloading++;
+}
+
+void CPatchPakManager::GenerateStreamedPakPath(CryFixedStringT<ICryPak::g_nMaxPath> &outPath, const char *inUrlName)
+{
+	char path[ICryPak::g_nMaxPath];
+	path[sizeof(path) - 1] = 0;
+	gEnv->pCryPak->AdjustFileName(k_streamedPatchPakFolder, path, ICryPak::FLAGS_PATH_REAL | ICryPak::FLAGS_FOR_WRITING);
+	gEnv->pCryPak->MakeDir(path);
+
+	outPath.Format("%s/%s", path, inUrlName);
+}
+
+// checks a pak streamed by a previous session is complete and unaltered
+bool CPatchPakManager::VerifyStreamedPak(const char *inPath, const int inDownloadSize, const unsigned char inMD5[16])
+{
+	ICryPak *pPak = gEnv->pCryPak;
+	FILE *pFile = pPak->FOpen(inPath, "rb", ICryPak::FLAGS_PATH_REAL);
+	if (!pFile)
+	{
+		return false;
+	}
+
+	bool valid = false;
+
+	if (pPak->FGetSize(pFile) == (size_t)inDownloadSize)
+	{
+		IZLibCompressor *pZLib = GetISystem()->GetIZLibCompressor();
+		SMD5Context context;
+		char buffer[16*1024];
+		char pMD5[16];
+
+		pZLib->MD5Init(&context);
+
+		size_t bytesRead;
+		while ((bytesRead = pPak->FReadRaw(buffer, 1, sizeof(buffer), pFile)) > 0)
+		{
+			pZLib->MD5Update(&context, buffer, (uint32)bytesRead);
 		}
 
-		m_patchPaks.push_back(newPatchPakData);
+		pZLib->MD5Final(&context, pMD5);
+
+		valid = (memcmp(pMD5, inMD5, 16) == 0);
+	}
+
+	pPak->FClose(pFile);
+
+	if (!valid)
+	{
+		CryLog("CPatchPakManager::VerifyStreamedPak() found %s but it doesn't match the patch pak, removing it", inPath);
+		pPak->RemoveFile(inPath);
 	}
+
+	return valid;
 }
 
 bool CPatchPakManager::CheckForNewDownload(const char *inServerName, const int inPort, const char *inURLPrefix, const char *inURL, const int inDownloadSize, const char *inMD5, const char *inDescName)
@@ -1283,23 +1442,49 @@ void CPatchPakManager::PatchPakDataDownloaded(CDownloadableResourcePtr inResourc
 		CRY_ASSERT(m_numPatchPaksDownloading >= 0);
 
 		// verify the MD5
-		IZLibCompressor			*pZLib=GetISystem()->GetIZLibCompressor();
-		SMD5Context context;
-
 		char	pMD5[16];
+		bool	streamedToDisk=false;
 
-		pZLib->MD5Init(&context);
-		pZLib->MD5Update(&context,(const char*)buffer, bufferSize);
-		pZLib->MD5Final(&context, pMD5);
+		if (pakData->m_pStreamWriter)
+		{
+			// hashed as it arrived, only the file is left to close
+			streamedToDisk = pakData->m_pStreamWriter->Finish(pMD5);
+			bufferSize = pakData->m_pStreamWriter->GetBytesWritten();
+			if (!streamedToDisk)
+			{
+				CryLog("CPatchPakManager::PatchPakDataDownloaded() failed to write patch %s to %s", pakData->m_url.c_str(), pakData->m_pStreamWriter->GetPath());
+			}
+		}
+		else
+		{
+			IZLibCompressor			*pZLib=GetISystem()->GetIZLibCompressor();
+			SMD5Context context;
+
+			pZLib->MD5Init(&context);
+			pZLib->MD5Update(&context,(const char*)buffer, bufferSize);
+			pZLib->MD5Final(&context, pMD5);
+		}
+
+		const float timeTaken = (gEnv->pTimer->GetAsyncTime() - pakData->m_downloadStartTime).GetSeconds();
+		CryLog("CPatchPakManager::PatchPakDataDownloaded() patch %s downloaded %d bytes in %.2f secs (%.1f KB/sec), holding %d bytes in memory at most", pakData->m_url.c_str(), bufferSize, timeTaken, (timeTaken > 0.f) ? (bufferSize / 1024.f) / timeTaken : 0.f, inResource->GetBufferSize());
 
 		CryLog("CPatchPakManager::PatchPakDataDownloaded() found patch %s downloaded MD5 of %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x", pakData->m_url.c_str(), pMD5[0], pMD5[1], pMD5[2], pMD5[3], pMD5[4], pMD5[5], pMD5[6], pMD5[7], pMD5[8], pMD5[9], pMD5[10], pMD5[11], pMD5[12], pMD5[13], pMD5[14], pMD5[15]);
 
-		if (memcmp(pMD5, pakData->m_pMD5, 16) == 0)
+		if (pakData->m_pStreamWriter && !streamedToDisk)
+		{
+			pakData->m_state = SPatchPakData::es_DownloadedButCorrupt;
+		}
+		else if (memcmp(pMD5, pakData->m_pMD5, 16) == 0)
 		{
 			CryLog("CPatchPakManager::PatchPakDataDownloaded() found matching CRCs with expected value.. download is valid. Caching newly downloaded file");
 			pakData->m_state = SPatchPakData::es_Downloaded;
 
-			if (m_okToCachePaks && m_isUsingCachePaks)
+			if (pakData->m_pStreamWriter)
+			{
+				// already on disk, opened from there rather than going through the platform cache which needs the whole pak in memory
+				pakData->m_streamedPakPath = pakData->m_pStreamWriter->GetPath();
+			}
+			else if (m_okToCachePaks && m_isUsingCachePaks)
 			{
 				CryLog("CPatchPakManager::PatchPakDataDownloaded() we're ok to cache paks, so doing so");
 				bool succeeeded = CachePakDataToDisk(pakData);
@@ -1332,6 +1517,15 @@ void CPatchPakManager::PatchPakDataDownloaded(CDownloadableResourcePtr inResourc
 			pakData->m_state = SPatchPakData::es_DownloadedButCorrupt;
 		}
 
+		if (pakData->m_pStreamWriter)
+		{
+			if (pakData->m_state == SPatchPakData::es_DownloadedButCorrupt)
+			{
+				gEnv->pCryPak->RemoveFile(pakData->m_pStreamWriter->GetPath());
+			}
+			pakData->m_pStreamWriter = NULL;
+		}
+
 		// TODO - now we're cache pak dependent we should really be freeing up our downloadable resource NOW to save memory
 		// although this would remove any possibility of coping (and patching) in a scenario where caching ALWAYS fails
 		// if we can take the memory hit in SP then we can keep the old patching implementation as a fallback to failed caching
@@ -1383,6 +1577,17 @@ void CPatchPakManager::OpenPatchPakDataAsPak(SPatchPakData *inPakData)
 			inPakData->m_state = SPatchPakData::es_FailedToOpenFromCache;
 		}
 	}
+	else if (inPakData->m_state == SPatchPakData::es_Downloaded && !inPakData->m_streamedPakPath.empty())
+	{
+		CryLog("CPatchPakManager::OpenPatchPakDataAsPak() opening streamed pakdata for pak file %s from %s", inPakData->m_url.c_str(), inPakData->m_streamedPakPath.c_str());
+
+		bool success=gEnv->pCryPak->OpenPack(bindRootPath.c_str(), inPakData->m_streamedPakPath.c_str(), nFlags);
+		CRY_ASSERT_MESSAGE(success, string().Format("failed to open pak file for streamed patch pak %s", inPakData->m_streamedPakPath.c_str()));
+		if (success)
+		{
+			inPakData->m_state = SPatchPakData::es_PakLoaded;
+		}
+	}
 	else if (inPakData->m_state == SPatchPakData::es_Downloaded)
 	{
 		int bufferSize = -1;
@@ -1504,3 +1709,161 @@ void CPatchPakManager::EventUpdatedPermissionsAvailable()
 		m_eventListeners[i]->UpdatedPermissionsNowAvailable();
 	}
 }
+
+#if DOWNLOAD_MGR_TEST_SERVER
+// patch paks streamed to disk against a stand-in http server, as they would be with g_patchpak_streaming set
+namespace
+{
+	const char	*k_testPakHost="patchpak.unittest";
+	const char	*k_testPakName="unittest_streamed.pak";
+	const int		k_testPakSize=32*1024;
+	const int		k_testChunkSize=1024;
+
+	void MakeTestPak(std::vector<char> &outPak, char outMD5[16])
+	{
+		outPak.resize(k_testPakSize);
+		for (int i=0; i<k_testPakSize; ++i)
+		{
+			outPak[i]=char((i*31+i/251)&0xff);
+		}
+
+		IZLibCompressor *pZLib=GetISystem()->GetIZLibCompressor();
+		SMD5Context context;
+		pZLib->MD5Init(&context);
+		pZLib->MD5Update(&context, &outPak[0], k_testPakSize);
+		pZLib->MD5Final(&context, outMD5);
+	}
+
+	bool IsTestPakOnDisk(const char *inPath)
+	{
+		FILE *pFile = gEnv->pCryPak->FOpen(inPath, "rb", ICryPak::FLAGS_PATH_REAL);
+		if (pFile)
+		{
+			gEnv->pCryPak->FClose(pFile);
+		}
+		return pFile != NULL;
+	}
+
+	// started the way CPatchPakManager::StartPakDownload() does, through the download mgr so it can be retried
+	CDownloadableResourcePtr StartStreamedDownload(_smart_ptr<CPatchPakStreamWriter> &outWriter, CryFixedStringT<ICryPak::g_nMaxPath> &outPath)
+	{
+		CPatchPakManager::GenerateStreamedPakPath(outPath, k_testPakName);
+
+		FILE *pFile = gEnv->pCryPak->FOpen(outPath.c_str(), "wb", ICryPak::FLAGS_PATH_REAL);
+		outWriter = pFile ? new CPatchPakStreamWriter(outPath.c_str(), pFile) : NULL;
+
+		CDownloadableResourcePtr pResource = new CDownloadableResource;
+		pResource->SetDownloadInfo(k_testPakName, "", k_testPakHost, 80, k_testPakSize+k_maxHttpHeaderSize, "unittest_streamed_pak");
+		pResource->SetStreamSink(outWriter);
+		pResource->StartDownloading();
+
+		return pResource;
+	}
+}
+
+CRY_UNIT_TEST_SUITE(CryPatchPakStreamingTest)
+{
+	CRY_UNIT_TEST(ResumeAfterDroppedConnection)
+	{
+		CRY_UNIT_TEST_ASSERT(g_pGame && g_pGame->GetDownloadMgr());
+
+		CDownloadTestServer server(k_testPakHost, 1);
+		std::vector<char> pak;
+		char md5[16];
+		MakeTestPak(pak, md5);
+
+		_smart_ptr<CPatchPakStreamWriter> pWriter;
+		CryFixedStringT<ICryPak::g_nMaxPath> path;
+		CDownloadableResourcePtr pResource = StartStreamedDownload(pWriter, path);
+		CRY_UNIT_TEST_ASSERT(pWriter && server.GetNumPendingRequests() == 1);
+
+		// the connection drops a third of the way into the payload
+		const int resumeFrom = k_testPakSize / 3;
+		const string firstReply = CDownloadTestServer::MakeReply("200 OK", "Accept-Ranges: bytes\r\n", &pak[0], k_testPakSize);
+		server.QueueReply(firstReply, k_testChunkSize, int(firstReply.length()) - k_testPakSize + resumeFrom);
+		server.Reply();
+		CRY_UNIT_TEST_ASSERT(pWriter->GetBytesWritten() == resumeFrom);
+		CRY_UNIT_TEST_ASSERT(pResource->GetState() == CDownloadableResource::k_awaitingHTTPResponse);
+
+		// and the download mgr asks for the rest only
+		g_pGame->GetDownloadMgr()->UpdateScheduler();
+		CryFixedStringT<64> range;
+		range.Format("Range: bytes=%d-", resumeFrom);
+		CRY_UNIT_TEST_ASSERT(server.GetNumRequests() == 2 && strstr(server.GetRequest(1).c_str(), range.c_str()) != NULL);
+
+		CryFixedStringT<128> headers;
+		headers.Format("Accept-Ranges: bytes\r\nContent-Range: bytes %d-%d/%d\r\n", resumeFrom, k_testPakSize - 1, k_testPakSize);
+		server.QueueReply(CDownloadTestServer::MakeReply("206 Partial Content", headers.c_str(), &pak[resumeFrom], k_testPakSize - resumeFrom), k_testChunkSize);
+		server.Reply();
+		CRY_UNIT_TEST_ASSERT(pResource->GetState() == CDownloadableResource::k_dataAvailable);
+
+		// only ever the http header was held in memory
+		CRY_UNIT_TEST_ASSERT(pResource->GetBufferSize() < k_testPakSize / 4);
+
+		char streamedMD5[16];
+		CRY_UNIT_TEST_ASSERT(pWriter->Finish(streamedMD5));
+		CRY_UNIT_TEST_ASSERT(pWriter->GetBytesWritten() == k_testPakSize);
+		CRY_UNIT_TEST_ASSERT(memcmp(streamedMD5, md5, 16) == 0);
+		CRY_UNIT_TEST_ASSERT(CPatchPakManager::VerifyStreamedPak(path.c_str(), k_testPakSize, (const unsigned char*)md5));
+
+		gEnv->pCryPak->RemoveFile(path.c_str());
+	}
+
+	CRY_UNIT_TEST(TruncatedDownloadIsRemoved)
+	{
+		CRY_UNIT_TEST_ASSERT(g_pGame && g_pGame->GetDownloadMgr());
+
+		CDownloadTestServer server(k_testPakHost, 1);
+		std::vector<char> pak;
+		char md5[16];
+		MakeTestPak(pak, md5);
+
+		_smart_ptr<CPatchPakStreamWriter> pWriter;
+		CryFixedStringT<ICryPak::g_nMaxPath> path;
+		CDownloadableResourcePtr pResource = StartStreamedDownload(pWriter, path);
+		CRY_UNIT_TEST_ASSERT(pWriter && server.GetNumPendingRequests() == 1);
+
+		// without range requests what the sink already has can't be taken back, so it isn't retried
+		const string reply = CDownloadTestServer::MakeReply("200 OK", "", &pak[0], k_testPakSize);
+		server.QueueReply(reply, k_testChunkSize, int(reply.length()) - k_testPakSize / 2);
+		server.Reply();
+		g_pGame->GetDownloadMgr()->UpdateScheduler();
+		CRY_UNIT_TEST_ASSERT(pResource->GetState() == CDownloadableResource::k_failedReplyContentTruncated);
+		CRY_UNIT_TEST_ASSERT(server.GetNumRequests() == 1);
+
+		char streamedMD5[16];
+		pWriter->Finish(streamedMD5);
+		CRY_UNIT_TEST_ASSERT(pWriter->GetBytesWritten() == k_testPakSize / 2);
+		CRY_UNIT_TEST_ASSERT(!CPatchPakManager::VerifyStreamedPak(path.c_str(), k_testPakSize, (const unsigned char*)md5));
+		CRY_UNIT_TEST_ASSERT(!IsTestPakOnDisk(path.c_str()));
+	}
+
+	CRY_UNIT_TEST(CorruptDownloadIsRemoved)
+	{
+		CRY_UNIT_TEST_ASSERT(g_pGame && g_pGame->GetDownloadMgr());
+
+		CDownloadTestServer server(k_testPakHost, 1);
+		std::vector<char> pak;
+		char md5[16];
+		MakeTestPak(pak, md5);
+
+		_smart_ptr<CPatchPakStreamWriter> pWriter;
+		CryFixedStringT<ICryPak::g_nMaxPath> path;
+		CDownloadableResourcePtr pResource = StartStreamedDownload(pWriter, path);
+		CRY_UNIT_TEST_ASSERT(pWriter && server.GetNumPendingRequests() == 1);
+
+		// complete, but a byte was changed on the way
+		pak[k_testPakSize / 2] ^= 0x20;
+		server.QueueReply(CDownloadTestServer::MakeReply("200 OK", "", &pak[0], k_testPakSize), k_testChunkSize);
+		server.Reply();
+		CRY_UNIT_TEST_ASSERT(pResource->GetState() == CDownloadableResource::k_dataAvailable);
+
+		char streamedMD5[16];
+		CRY_UNIT_TEST_ASSERT(pWriter->Finish(streamedMD5));
+		CRY_UNIT_TEST_ASSERT(pWriter->GetBytesWritten() == k_testPakSize);
+		CRY_UNIT_TEST_ASSERT(memcmp(streamedMD5, md5, 16) != 0);
+		CRY_UNIT_TEST_ASSERT(!CPatchPakManager::VerifyStreamedPak(path.c_str(), k_testPakSize, (const unsigned char*)md5));
+		CRY_UNIT_TEST_ASSERT(!IsTestPakOnDisk(path.c_str()));
+	}
+}
+#endif // DOWNLOAD_MGR_TEST_SERVER
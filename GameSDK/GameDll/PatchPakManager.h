@@ -23,6 +23,7 @@
 #include "DownloadMgr.h"
 #include <CryFixedArray.h>
 #include <IPlatformOS.h>
+#include <IZLibCompressor.h>
 #include "IPatchPakManagerListener.h"
 
 #if defined(_RELEASE) 
@@ -55,6 +56,32 @@ private:
 	size_t m_nSize;
 };
 
+// hashes a patch pak and writes it out to disk as it is downloaded, so the pak is never held in memory as a whole
+// DataReceived() runs on the network thread, everything else on the main thread
+class CPatchPakStreamWriter : public IDataStreamSink
+{
+public:
+	CPatchPakStreamWriter(const char *inPath, FILE *inFile);
+	virtual ~CPatchPakStreamWriter();
+
+	// IDataStreamSink
+	virtual bool DataReceived(CDownloadableResource *pInResource, const char *pInData, int inDataLen);
+	// ~IDataStreamSink
+
+	// closes the file once the download has completed, returns whether all the data made it to disk
+	bool Finish(char outMD5[16]);
+
+	const char *GetPath() const { return m_path.c_str(); }
+	int GetBytesWritten() const { return m_bytesWritten; }
+
+private:
+	CryFixedStringT<ICryPak::g_nMaxPath> m_path;
+	SMD5Context m_md5Context;
+	FILE *m_pFile;
+	int m_bytesWritten;
+	bool m_writeFailed;
+};
+
 class CPatchPakManager : public IDataListener, public IPlatformOS::IPlatformListener
 {
 public:
@@ -89,6 +116,10 @@ public:
 
 	void VersionMismatchErrorOccurred();
 
+	// where a patch pak is streamed to, and whether the pak there is complete and unaltered, removing it if not
+	static void GenerateStreamedPakPath(CryFixedStringT<ICryPak::g_nMaxPath> &outPath, const char *inUrlName);
+	static bool VerifyStreamedPak(const char *inPath, const int inDownloadSize, const unsigned char inMD5[16]);
+
 protected:
 
 	typedef std::vector<IPatchPakManagerListener*> TPatchPakManagerEventListenersVec;
@@ -117,6 +148,7 @@ protected:
 	};
 
 	typedef _smart_ptr<CPatchPakMemoryBlock> CPatchPakMemoryBlockPtr;
+	typedef _smart_ptr<CPatchPakStreamWriter> CPatchPakStreamWriterPtr;
 	struct SPatchPakData
 	{
 		enum EState
@@ -135,6 +167,9 @@ protected:
 		float m_showingSaveMessageTimer;
 		CDownloadableResourcePtr m_downloadableResource;
 		CPatchPakMemoryBlockPtr m_pPatchPakMemBlock;
+		CPatchPakStreamWriterPtr m_pStreamWriter;
+		CryFixedStringT<ICryPak::g_nMaxPath> m_streamedPakPath;		// set once the pak is downloaded to disk rather than memory
+		CTimeValue m_downloadStartTime;
 		uint32 m_actualCRC32;
 		CryFixedStringT<32> m_pMD5Str; 
 		unsigned char				m_pMD5[16];
@@ -179,6 +214,16 @@ protected:
 		const char *inMD5, 
 		const char *inDescName);
 	
+	void StartPakDownload(
+		SPatchPakData &ioPakData,
+		const char *inServerName, 
+		const int inPort, 
+		const char *inURLPrefix, 
+		const char *inURL, 
+		const int inDownloadSize,
+		const char *inMD5, 
+		const bool inMD5FileName,
+		const char *inDescName);
 	void GeneratePakFileNameFromURLName(CryFixedStringT<64> &outPakFileName, const char *inUrlName);
 	void ProcessPermissionsXML(CDownloadableResourcePtr inResource);
 	bool CachePakDataToDisk(SPatchPakData *pInPakData);
@@ -199,6 +244,7 @@ protected:
 	ICVar						*m_patchPakPollTime;
 	ICVar						*m_patchPakDebug;
 	ICVar						*m_patchPakDediServerMustPatch;
+	ICVar						*m_patchPakStreaming;
 	EMgrState				m_state;
 	float						m_pollPermissionsXMLTimer;
 	int							m_timeThatUpdatedPermissionsAvailable;
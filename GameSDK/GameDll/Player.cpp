@@ -51,6 +51,7 @@ History:
 #include "ICooperativeAnimationManager.h"
 
 #include "Binocular.h"
+#include "Environment/WaterQueryCache.h"
 
 #include "ScreenEffects.h"
 #include "Utility/CryWatch.h"
@@ -5888,7 +5889,7 @@ void CPlayer::ExecuteFootStep(ICharacterInstance* pCharacter, const float frameT
 		CryFixedStringT<16> sEffectWater = "water_shallow";
 
 		bool usingWaterEffectId = false;
-		const float feetWaterLevel = gEnv->p3DEngine->GetWaterLevel(&params.pos);
+		const float feetWaterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(params.pos, CWaterQueryCache::eWQ_Player);
 
 		if (feetWaterLevel != WATER_LEVEL_UNKNOWN)
 		{
@@ -6154,7 +6155,7 @@ void CPlayer::ExecuteGroundEffectAnimEvent(ICharacterInstance* pCharacter, const
 	CryFixedStringT<16> sEffectWater = "water_shallow";
 
 	bool usingWaterEffectId = false;
-	const float feetWaterLevel = gEnv->p3DEngine->GetWaterLevel(&params.pos);
+	const float feetWaterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(params.pos, CWaterQueryCache::eWQ_Player);
 
 	if (feetWaterLevel != WATER_LEVEL_UNKNOWN)
 	{
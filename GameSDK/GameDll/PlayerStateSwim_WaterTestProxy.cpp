@@ -19,6 +19,7 @@ History:
 #include "PlayerRotation.h"
 
 #include "GameCVars.h"
+#include "Environment/WaterQueryCache.h"
 
 float CPlayerStateSwim_WaterTestProxy::s_rayLength = 10.f;
 
@@ -77,7 +78,7 @@ void CPlayerStateSwim_WaterTestProxy::OnEnterWater(const CPlayer& player)
 	const Vec3 localReferencePos = GetLocalReferencePosition(player);
 	const Vec3 worldReferencePos = playerWorldPos + (Quat(playerWorldTM) * localReferencePos);
 
-	m_waterLevel = gEnv->p3DEngine->GetWaterLevel(&worldReferencePos);
+	m_waterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(worldReferencePos, CWaterQueryCache::eWQ_Player);
 
 	m_internalState = eProxyInternalState_Swimming;
 	m_swimmingTimer = 0.0f;
@@ -44,6 +44,7 @@ History:
 #include "VTOLVehicleManager/VTOLVehicleManager.h"
 
 #include "Environment/WaterPuddle.h"
+#include "Environment/WaterQueryCache.h"
 
 namespace Proj
 {
@@ -2276,7 +2277,7 @@ void CProjectile::ProcessElectricHit(const SElectricHitTarget& target)
 			if ((actorData.position - referencePosition).len2() > distanceThresholdSqr)
 				continue;
 
-			const float waterLevel = gEnv->p3DEngine->GetWaterLevel( &actorData.position );
+			const float waterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(actorData.position, CWaterQueryCache::eWQ_Projectile);
 
 			const bool applyHit = (waterLevel > actorData.position.z) && (fabs_tpl(waterLevel - referencePosition.z) < 0.5f);
 
@@ -2,6 +2,8 @@
 #define _Ship_
 
 #include <IGameObject.h>
+#include "CannonBattery.h"
+#include "ShipFlooding.h"
 
 
 struct SShipParams {};
@@ -9,6 +11,16 @@ struct SShipParams {};
 class CShip : public CGameObjectExtensionHelper<CShip, IGameObjectExtension>
 {
 public:
+	// Ships take entity updates only while one of their subsystems has work registered
+	enum EUpdateWork
+	{
+		eUW_CannonBattery	= BIT(0),
+		eUW_TextureStream	= BIT(1),
+		eUW_Flooding			= BIT(2),
+	};
+
+	static const NetworkAspectType ASPECT_FLOOD_LOAD = eEA_GameServerStatic;
+
 	CShip();
 	virtual ~CShip();
 
@@ -21,7 +33,7 @@ public:
 	virtual void PostReloadExtension( IGameObject * pGameObject, const SEntitySpawnParams &params ) {}
 	virtual bool GetEntityPoolSignature( TSerialize signature );
 	virtual void Release();
-	virtual bool NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int pflags) { return true; }
+	virtual bool NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int pflags);
 	virtual void FullSerialize(TSerialize ser);
 	virtual void PostSerialize() {}
 	virtual void SerializeSpawnInfo( TSerialize ser ) {}
@@ -33,16 +45,43 @@ public:
 	virtual void ProcessEvent(SEntityEvent &);
 	virtual void SetChannelId(uint16 id) {}
 	virtual void SetAuthority(bool auth);
-	virtual void GetMemoryUsage(ICrySizer *pSizer) const { pSizer->Add(*this); }
+	virtual void GetMemoryUsage(ICrySizer *pSizer) const { pSizer->Add(*this); m_cannonBattery.GetMemoryUsage(pSizer); m_flooding.GetMemoryUsage(pSizer); pSizer->AddContainer(m_textureRequests); pSizer->AddContainer(m_Textures); }
 	virtual void OnHit(const HitInfo* hitInfo);
 
 	//~IGameObjectExtension
 
 	bool Reset();
 
+	void RegisterWork(uint32 work);
+	void CompleteWork(uint32 work);
+
+	CCannonBattery& GetCannonBattery() { return m_cannonBattery; }
+	bool FireCannon(EntityId cannonId, const Vec3& recoilDir, const Vec3& firingPos, const Vec3& firingDir);
+
+	const CShipFlooding& GetFlooding() const { return m_flooding; }
+
 	protected:
 
+	// Textures are streamed in over several frames, closest ships first, and dropped if the ship goes away before they arrive
 	void PreloadTextures();
+	void UpdateTextureStream();
+	void CancelTextureStream();
+
+	// Flooding is simulated where the hits are decided, the boat movement carries the water as extra load.
+	// Clients get the load through ASPECT_FLOOD_LOAD, a driving client simulates the hull in the ship network mode
+	void InitCompartments();
+	void UpdateFlooding(float frameTime);
+	void ApplyFloodLoad(float mass, const Vec3& centre);
+
+	struct STextureRequest
+	{
+		STextureRequest() : flags(0), priority(0) {}
+		bool operator<(const STextureRequest& other) const { return priority < other.priority; }
+
+		string	name;
+		uint32	flags;
+		int			priority;
+	};
 
 	SShipParams	m_params;
 	bool				m_bEnabled;
@@ -50,9 +89,20 @@ public:
 	typedef std::vector<ITexture*> TTextureList;
 	TTextureList m_Textures;
 
+	typedef std::vector<STextureRequest> TTextureRequests;
+	TTextureRequests m_textureRequests;		// not loaded yet, the next one to load is at the back
+	int					m_numTexturesReady;
+	CTimeValue	m_textureStreamStart;
+
+	CCannonBattery m_cannonBattery;
+	CShipFlooding	m_flooding;
+	uint32				m_updateWork;
+	float					m_appliedFloodMass;			// last load handed to the boat movement
+	Vec3					m_appliedFloodCentre;
+
 private:
 	CShip(const CShip&);
 	//CRain& operator = (const CRain&);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,482 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id:$
+$DateTime$
+Description:  Flooding of a ship's compartments
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#include "StdAfx.h"
+#include "CryUnitTest.h"
+#include "ShipFlooding.h"
+#include "Game.h"
+#include "GameCVars.h"
+#include "Environment/WaterQueryCache.h"
+#include "Utility/BenchmarkTimer.h"
+
+namespace
+{
+	const float kGravity = 9.81f;
+	const float kWaterDensity = 1025.f;
+	const float kDischarge = 0.6f;				// orifice discharge coefficient
+	const float kMaxBreachArea = 8.f;
+	const float kQuietVolume = 0.01f;			// m3 per step below which the water counts as settled
+	const int kQuietSteps = 4;
+	const float kSettledStepTime = 1.f;		// s between the steps of settled water
+	const float kSettledTiltCos = 0.99939f;	// cos 2 degrees, trim or heel that wakes settled water
+	const int kMaxStepsPerFrame = 4;
+
+	inline float GetWorldZ(const Matrix34& tm, float x, float y, float z)
+	{
+		return tm.m20 * x + tm.m21 * y + tm.m22 * z + tm.m23;
+	}
+
+	void GetBenchWaterHeights(const Vec3* pPositions, float* pHeights, int count, void* pUserData)
+	{
+		for (int i = 0; i < count; ++i)
+			pHeights[i] = 0.f;
+	}
+
+	// Synthetic 40 m hull with one or two holes below the waterline, shared by the benchmark and the unit tests
+	void InitBenchShip(CShipFlooding& ship, int index)
+	{
+		const AABB hullBounds(Vec3(-5.f, -20.f, -3.f), Vec3(5.f, 20.f, 3.f));
+		ship.InitFromBounds(hullBounds, 4);
+
+		const float y = -18.f + (float)((index * 7) % 37);
+		ship.AddBreach(Vec3(5.f, y, -1.5f), 0.2f + 0.05f * (index % 4));
+		if (index & 1)
+			ship.AddBreach(Vec3(-5.f, -y, -2.5f), 0.1f);
+	}
+}
+
+//------------------------------------------------------------------------
+CShipFlooding::CShipFlooding()
+: m_bulkheadLeak(0.05f)
+, m_stepTimer(0.f)
+, m_quietSteps(0)
+, m_settledUp(0.f, 0.f, 1.f)
+, m_floodMass(0.f)
+, m_floodCentre(ZERO)
+{
+}
+
+//------------------------------------------------------------------------
+void CShipFlooding::AddCompartment(const AABB& localBounds, float permeability)
+{
+	const Vec3 size = localBounds.GetSize();
+	const float capacity = size.x * size.y * size.z * clamp(permeability, 0.01f, 1.f);
+	if (capacity <= 0.f)
+		return;
+
+	m_bounds.push_back(localBounds);
+	m_centreX.push_back(0.5f * (localBounds.min.x + localBounds.max.x));
+	m_centreY.push_back(0.5f * (localBounds.min.y + localBounds.max.y));
+	m_floorZ.push_back(localBounds.min.z);
+	m_capacity.push_back(capacity);
+	m_invPlanArea.push_back(size.z / capacity);
+	m_breachArea.push_back(0.f);
+	m_breachZ.push_back(localBounds.max.z);
+	m_water.push_back(0.f);
+	m_prevWater.push_back(0.f);
+	m_breachPos.push_back(Vec3(ZERO));
+	m_waterLevel.push_back(0.f);
+}
+
+//------------------------------------------------------------------------
+void CShipFlooding::InitFromBounds(const AABB& localBounds, int numCompartments)
+{
+	Clear();
+
+	numCompartments = max(numCompartments, 1);
+	const float length = (localBounds.max.y - localBounds.min.y) / numCompartments;
+
+	for (int i = 0; i < numCompartments; ++i)
+	{
+		AABB section = localBounds;
+		section.min.y = localBounds.min.y + i * length;
+		section.max.y = section.min.y + length;
+		AddCompartment(section, 0.85f);
+	}
+}
+
+//------------------------------------------------------------------------
+bool CShipFlooding::InitFromXml(const char* filename)
+{
+	XmlNodeRef root = (filename && filename[0]) ? GetISystem()->LoadXmlFromFile(filename) : XmlNodeRef();
+	if (!root || !root->isTag("Compartments"))
+		return false;
+
+	Clear();
+
+	root->getAttr("bulkheadLeak", m_bulkheadLeak);
+
+	const int numChildren = root->getChildCount();
+	for (int i = 0; i < numChildren; ++i)
+	{
+		XmlNodeRef compartment = root->getChild(i);
+		if (!compartment->isTag("Compartment"))
+			continue;
+
+		AABB bounds(AABB::RESET);
+		float permeability = 0.85f;
+		if (compartment->getAttr("min", bounds.min) && compartment->getAttr("max", bounds.max))
+		{
+			compartment->getAttr("permeability", permeability);
+			AddCompartment(bounds, permeability);
+		}
+		else
+		{
+			GameWarning("[Ship] compartment %d in %s has no bounds", i, filename);
+		}
+	}
+
+	return HasCompartments();
+}
+
+//------------------------------------------------------------------------
+void CShipFlooding::Clear()
+{
+	m_bounds.clear();
+	m_centreX.clear();
+	m_centreY.clear();
+	m_floorZ.clear();
+	m_capacity.clear();
+	m_invPlanArea.clear();
+	m_breachArea.clear();
+	m_breachZ.clear();
+	m_water.clear();
+	m_prevWater.clear();
+	m_breachPos.clear();
+	m_waterLevel.clear();
+
+	m_stepTimer = 0.f;
+	m_quietSteps = 0;
+	m_settledUp.Set(0.f, 0.f, 1.f);
+	m_floodMass = 0.f;
+	m_floodCentre.zero();
+}
+
+//------------------------------------------------------------------------
+bool CShipFlooding::AddBreach(const Vec3& localPos, float area)
+{
+	// Hits land on the hull surface, which can be just outside the compartment boxes
+	int best = -1;
+	float bestDistSq = sqr(2.f);
+
+	for (int i = 0, count = (int)m_bounds.size(); i < count; ++i)
+	{
+		const float distSq = m_bounds[i].GetDistanceSqr(localPos);
+		if (distSq < bestDistSq)
+		{
+			best = i;
+			bestDistSq = distSq;
+		}
+	}
+
+	if (best < 0 || area <= 0.f)
+		return false;
+
+	m_breachArea[best] = min(m_breachArea[best] + area, kMaxBreachArea);
+	m_breachZ[best] = clamp(min(m_breachZ[best], localPos.z), m_bounds[best].min.z, m_bounds[best].max.z);
+	m_quietSteps = 0;
+
+	return true;
+}
+
+//------------------------------------------------------------------------
+bool CShipFlooding::Update(float frameTime, const Matrix34& worldTM, TWaterHeightFunc pWaterHeightFunc, void* pUserData)
+{
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
+	const float stepTime = 1.f / max(g_pGameCVars->g_shipFloodingRate, 0.5f);
+
+	m_stepTimer += frameTime;
+
+	if (IsSettled())
+	{
+		// Settled water moves again when the ship trims or heels, and slowly with the sea
+		if (worldTM.GetColumn2().Dot(m_settledUp) < kSettledTiltCos)
+			m_quietSteps = 0;
+		else if (m_stepTimer < kSettledStepTime)
+			return IsFlooded();
+
+		m_stepTimer = stepTime;
+	}
+
+	int numSteps = 0;
+	while (m_stepTimer >= stepTime && numSteps < kMaxStepsPerFrame)
+	{
+		Step(stepTime, worldTM, pWaterHeightFunc, pUserData);
+		m_stepTimer -= stepTime;
+		++numSteps;
+	}
+
+	// don't try to catch up after a hitch
+	m_stepTimer = min(m_stepTimer, stepTime);
+
+	UpdateLoad(m_stepTimer / stepTime);
+
+	if (IsSettled() && numSteps > 0)
+	{
+		m_settledUp = worldTM.GetColumn2();
+		m_stepTimer = 0.f;
+	}
+
+	return !IsSettled() || IsFlooded();
+}
+
+//------------------------------------------------------------------------
+bool CShipFlooding::IsSettled() const
+{
+	return m_quietSteps >= kQuietSteps;
+}
+
+//------------------------------------------------------------------------
+bool CShipFlooding::IsFlooded() const
+{
+	for (int i = 0, count = (int)m_water.size(); i < count; ++i)
+	{
+		if (m_water[i] > 0.f || m_breachArea[i] > 0.f)
+			return true;
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------
+void CShipFlooding::Step(float dt, const Matrix34& worldTM, TWaterHeightFunc pWaterHeightFunc, void* pUserData)
+{
+	const int count = (int)m_water.size();
+	if (count == 0)
+	{
+		m_quietSteps = kQuietSteps;
+		return;
+	}
+
+	m_prevWater = m_water;
+
+	for (int i = 0; i < count; ++i)
+	{
+		m_breachPos[i] = worldTM * Vec3(m_centreX[i], m_centreY[i], m_breachZ[i]);
+	}
+
+	pWaterHeightFunc(&m_breachPos[0], &m_waterLevel[0], count, pUserData);
+
+	// Sea water through the breaches: flow through an orifice under the head between the sea and the higher of
+	// the breach and the water already inside, capped so a step never overshoots the level it is heading for
+	for (int i = 0; i < count; ++i)
+	{
+		const float area = m_breachArea[i];
+		const float outside = m_waterLevel[i];
+		if (area <= 0.f || outside <= WATER_LEVEL_UNKNOWN)
+			continue;
+
+		const float breachZ = m_breachPos[i].z;
+		const float insideZ = GetWorldZ(worldTM, m_centreX[i], m_centreY[i], GetSurfaceZ(i, &m_prevWater[0]));
+
+		float flow = 0.f;
+		if (outside > breachZ && outside > insideZ)
+		{
+			const float head = outside - max(breachZ, insideZ);
+			flow = min(kDischarge * area * sqrt_tpl(2.f * kGravity * head) * dt, (outside - insideZ) / m_invPlanArea[i]);
+		}
+		else if (insideZ > breachZ && insideZ > outside)
+		{
+			const float head = insideZ - max(breachZ, outside);
+			flow = -min(kDischarge * area * sqrt_tpl(2.f * kGravity * head) * dt, head / m_invPlanArea[i]);
+		}
+
+		m_water[i] = clamp(m_water[i] + flow, 0.f, m_capacity[i]);
+	}
+
+	// Leaks through the bulkheads between neighbouring compartments
+	if (m_bulkheadLeak > 0.f)
+	{
+		for (int i = 0; i < count - 1; ++i)
+		{
+			const int j = i + 1;
+			const float zi = GetWorldZ(worldTM, m_centreX[i], m_centreY[i], GetSurfaceZ(i, &m_water[0]));
+			const float zj = GetWorldZ(worldTM, m_centreX[j], m_centreY[j], GetSurfaceZ(j, &m_water[0]));
+
+			const int from = (zi > zj) ? i : j;
+			const int to = (zi > zj) ? j : i;
+			const float diff = fabs_tpl(zi - zj);
+			if (diff < 0.001f || m_water[from] <= 0.f)
+				continue;
+
+			float flow = kDischarge * m_bulkheadLeak * sqrt_tpl(2.f * kGravity * diff) * dt;
+			flow = min(flow, diff / (m_invPlanArea[i] + m_invPlanArea[j]));
+			flow = min(flow, m_water[from]);
+			flow = min(flow, m_capacity[to] - m_water[to]);
+
+			m_water[from] -= flow;
+			m_water[to] += flow;
+		}
+	}
+
+	float moved = 0.f;
+	for (int i = 0; i < count; ++i)
+	{
+		moved += fabs_tpl(m_water[i] - m_prevWater[i]);
+	}
+
+	m_quietSteps = (moved < kQuietVolume) ? m_quietSteps + 1 : 0;
+}
+
+//------------------------------------------------------------------------
+void CShipFlooding::UpdateLoad(float alpha)
+{
+	float mass = 0.f;
+	Vec3 moment(ZERO);
+
+	for (int i = 0, count = (int)m_water.size(); i < count; ++i)
+	{
+		const float water = LERP(m_prevWater[i], m_water[i], alpha);
+		if (water <= 0.f)
+			continue;
+
+		const float waterMass = water * kWaterDensity;
+		mass += waterMass;
+		moment += Vec3(m_centreX[i], m_centreY[i], m_floorZ[i] + 0.5f * water * m_invPlanArea[i]) * waterMass;
+	}
+
+	m_floodMass = mass;
+	m_floodCentre = (mass > 0.f) ? moment / mass : Vec3(ZERO);
+}
+
+//------------------------------------------------------------------------
+float CShipFlooding::GetFloodedFraction() const
+{
+	float water = 0.f, capacity = 0.f;
+	for (int i = 0, count = (int)m_water.size(); i < count; ++i)
+	{
+		water += m_water[i];
+		capacity += m_capacity[i];
+	}
+
+	return (capacity > 0.f) ? water / capacity : 0.f;
+}
+
+//------------------------------------------------------------------------
+void CShipFlooding::GetWaterHeights(const Vec3* pPositions, float* pHeights, int count, void* pUserData)
+{
+	g_pGame->GetWaterQueryCache()->QueryHeights(pPositions, pHeights, count, CWaterQueryCache::eWQ_Vehicle);
+}
+
+//------------------------------------------------------------------------
+void CShipFlooding::RunBenchmark(int numShips, int numFrames)
+{
+	numShips = max(numShips, 1);
+	numFrames = max(numFrames, 1);
+
+	const float frameTime = 1.f / 30.f;
+	const float waterPlaneArea = 10.f * 40.f;
+
+	std::vector<CShipFlooding> ships(numShips);
+	std::vector<Matrix34> transforms(numShips);
+
+	for (int s = 0; s < numShips; ++s)
+	{
+		InitBenchShip(ships[s], s);
+
+		transforms[s] = Matrix34::CreateRotationY(0.05f);
+		transforms[s].SetTranslation(Vec3(60.f * (s % 8), 60.f * (s / 8), 0.f));
+	}
+
+	CBenchmarkTimer timer;
+
+	for (int frame = 0; frame < numFrames; ++frame)
+	{
+		timer.Start();
+
+		for (int s = 0; s < numShips; ++s)
+			ships[s].Update(frameTime, transforms[s], &GetBenchWaterHeights, NULL);
+
+		timer.Stop();
+
+		// Settle each hull by the weight of its water, standing in for the buoyancy the physics would give
+		for (int s = 0; s < numShips; ++s)
+		{
+			Vec3 pos = transforms[s].GetTranslation();
+			pos.z = -ships[s].GetFloodMass() / (kWaterDensity * waterPlaneArea);
+			transforms[s].SetTranslation(pos);
+		}
+	}
+
+	const float budgetMs = 0.2f * numShips / 30.f;
+
+	CryLog("[g_shipFloodingBench] %d ships, %d frames at %.0f Hz: %.4f ms per frame, worst %.4f ms, budget %.3f ms",
+		numShips, numFrames, g_pGameCVars->g_shipFloodingRate, timer.GetAverageMs(), timer.GetWorstMs(), budgetMs);
+}
+
+//------------------------------------------------------------------------
+void CShipFlooding::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddContainer(m_bounds);
+	pSizer->AddContainer(m_centreX);
+	pSizer->AddContainer(m_centreY);
+	pSizer->AddContainer(m_floorZ);
+	pSizer->AddContainer(m_capacity);
+	pSizer->AddContainer(m_invPlanArea);
+	pSizer->AddContainer(m_breachArea);
+	pSizer->AddContainer(m_breachZ);
+	pSizer->AddContainer(m_water);
+	pSizer->AddContainer(m_prevWater);
+	pSizer->AddContainer(m_breachPos);
+	pSizer->AddContainer(m_waterLevel);
+}
+
+//------------------------------------------------------------------------
+namespace
+{
+	// Runs a held ship until its water settles, or gives up after an hour
+	bool RunUntilSettled(CShipFlooding& ship, const Matrix34& worldTM)
+	{
+		const float frameTime = 1.f / 30.f;
+		for (int frame = 0; frame < 30 * 3600; ++frame)
+		{
+			ship.Update(frameTime, worldTM, &GetBenchWaterHeights, NULL);
+			if (ship.IsSettled())
+				return true;
+		}
+
+		return false;
+	}
+}
+
+CRY_UNIT_TEST_SUITE(CryShipFloodingTest)
+{
+	CRY_UNIT_TEST(SettlesBelowTheWaterline)
+	{
+		CShipFlooding ship;
+		InitBenchShip(ship, 0);
+
+		CRY_UNIT_TEST_ASSERT(RunUntilSettled(ship, Matrix34(IDENTITY)));
+		CRY_UNIT_TEST_ASSERT(ship.GetFloodMass() > 0.f);
+		CRY_UNIT_TEST_ASSERT(ship.GetFloodCentre().z < 0.f);
+		CRY_UNIT_TEST_ASSERT(ship.GetFloodedFraction() < 1.f);
+	}
+
+	// Settled water runs to the low end as soon as the ship trims by more than the wake angle
+	CRY_UNIT_TEST(TrimWakesSettledWater)
+	{
+		CShipFlooding ship;
+		InitBenchShip(ship, 0);
+
+		CRY_UNIT_TEST_ASSERT(RunUntilSettled(ship, Matrix34(IDENTITY)));
+		const Vec3 levelCentre = ship.GetFloodCentre();
+
+		// bow up by 5 degrees
+		const Matrix34 trimmedTM = Matrix34::CreateRotationX(DEG2RAD(5.f));
+		ship.Update(1.f / 30.f, trimmedTM, &GetBenchWaterHeights, NULL);
+		CRY_UNIT_TEST_ASSERT(!ship.IsSettled());
+
+		CRY_UNIT_TEST_ASSERT(RunUntilSettled(ship, trimmedTM));
+		CRY_UNIT_TEST_ASSERT(ship.GetFloodCentre().y < levelCentre.y - 0.1f);
+	}
+}
@@ -0,0 +1,93 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id:$
+$DateTime$
+Description:  Flooding of a ship's compartments. Hits open breaches in
+the hull, water flows in through them and across the bulkheads in fixed
+steps of a few Hz, and the resulting load is interpolated between steps
+for the boat movement to carry.
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#pragma once
+
+#ifndef _SHIP_FLOODING_H_
+#define _SHIP_FLOODING_H_
+
+class CShipFlooding
+{
+public:
+	typedef void (*TWaterHeightFunc)(const Vec3* pPositions, float* pHeights, int count, void* pUserData);
+
+	CShipFlooding();
+
+	// Compartments are boxes in the ship's local space, ordered along the keel so neighbours share a bulkhead
+	void AddCompartment(const AABB& localBounds, float permeability);
+	// Splits the hull bounds into numCompartments equal sections along the local y axis
+	void InitFromBounds(const AABB& localBounds, int numCompartments);
+	// <Compartments bulkheadLeak=""><Compartment min="x,y,z" max="x,y,z" permeability=""/>...</Compartments>
+	bool InitFromXml(const char* filename);
+	void Clear();
+
+	bool HasCompartments() const { return !m_capacity.empty(); }
+
+	// Opens (or widens) a breach in the compartment containing localPos. Returns false if the position misses every compartment
+	bool AddBreach(const Vec3& localPos, float area);
+
+	// Accumulates frameTime and runs as many fixed steps as are due. Once the water has settled it is only stepped
+	// again at a low rate, or as soon as the ship trims or heels. Returns false once there is no breach and no water
+	bool Update(float frameTime, const Matrix34& worldTM, TWaterHeightFunc pWaterHeightFunc = &GetWaterHeights, void* pUserData = NULL);
+	bool IsSettled() const;
+
+	// Flood load interpolated between the last two steps, the centre is in the ship's local space
+	float GetFloodMass() const { return m_floodMass; }
+	const Vec3& GetFloodCentre() const { return m_floodCentre; }
+	float GetFloodedFraction() const;
+
+	static void GetWaterHeights(const Vec3* pPositions, float* pHeights, int count, void* pUserData);
+
+	// Floods numShips synthetic ships for numFrames frames at 30 fps without physics, and logs the cost per frame.
+	// How the water settles and follows the trim is checked by CryShipFloodingTest
+	static void RunBenchmark(int numShips, int numFrames);
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+private:
+	void Step(float dt, const Matrix34& worldTM, TWaterHeightFunc pWaterHeightFunc, void* pUserData);
+	void UpdateLoad(float alpha);
+	bool IsFlooded() const;
+
+	float GetSurfaceZ(int i, const float* water) const { return m_floorZ[i] + water[i] * m_invPlanArea[i]; }
+
+	// compartments
+	std::vector<AABB>		m_bounds;
+	std::vector<float>	m_centreX;
+	std::vector<float>	m_centreY;
+	std::vector<float>	m_floorZ;
+	std::vector<float>	m_capacity;				// m3 of water the compartment holds when full
+	std::vector<float>	m_invPlanArea;		// surface rise per m3 of water
+	std::vector<float>	m_breachArea;			// m2, zero while the compartment is intact
+	std::vector<float>	m_breachZ;				// lowest breach, local space
+
+	// water volume at the last two steps
+	std::vector<float>	m_water;
+	std::vector<float>	m_prevWater;
+
+	// scratch for the water query
+	std::vector<Vec3>		m_breachPos;
+	std::vector<float>	m_waterLevel;
+
+	float		m_bulkheadLeak;						// effective m2 of opening through each bulkhead
+	float		m_stepTimer;
+	int			m_quietSteps;
+	Vec3		m_settledUp;							// world up axis of the hull when the water last settled
+
+	float		m_floodMass;
+	Vec3		m_floodCentre;
+};
+
+#endif
@@ -27,6 +27,7 @@
 #include "Utility/CryDebugLog.h"
 #include "PlaylistManager.h"
 #include "Utility/StringUtils.h"
+#include "Utility/LoadTimeline.h"
 #include "IZLibCompressor.h"
 #include "GameCVars.h"
 #include "IStatoscope.h"
@@ -2765,12 +2766,19 @@ void CTelemetryCollector::OnLoadingStart(ILevelInfo *pLevel)
 {
 //	CryLog("CTelemetryCollector::OnLoadingStart()");
 //	OutputMemoryUsage("OnLoadingStart", pLevel->GetDisplayName());
+	CLoadTimeline::BeginCapture(pLevel->GetName());
 }
 
 void CTelemetryCollector::OnLoadingComplete(ILevel *pLevel)
 {
 //	CryLog("CTelemetryCollector::OnLoadingComplete()");
 //	OutputMemoryUsage("OnLoadingComplete", pLevel->GetLevelInfo()->GetDisplayName());
+	CLoadTimeline::EndCapture();
+}
+
+void CTelemetryCollector::OnLoadingError(ILevelInfo *pLevel, const char *error)
+{
+	CLoadTimeline::AbortCapture();
 }
 
 bool CTelemetryCollector::AreTransfersInProgress()
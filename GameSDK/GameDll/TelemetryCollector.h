@@ -312,7 +312,7 @@ class CTelemetryCollector : public ITelemetryCollector, public ILevelSystemListe
 		virtual void OnLevelNotFound(const char *levelName) {}
 		virtual void OnLoadingStart(ILevelInfo *pLevel);
 		virtual void OnLoadingComplete(ILevel *pLevel);
-		virtual void OnLoadingError(ILevelInfo *pLevel, const char *error) {}
+		virtual void OnLoadingError(ILevelInfo *pLevel, const char *error);
 		virtual void OnLoadingProgress(ILevelInfo *pLevel, int progressAmount) {}
 		virtual void OnUnloadComplete(ILevel* pLevel) {}
 		//~ILevelSystemListener
@@ -19,527 +19,473 @@ History:
 #include "RecordingSystem.h"
 #include "WeaponSystem.h"
 #include "Projectile.h"
+#include "Effects/RenderNodes/TracerNode.h"
 
 
-#define TRACER_GEOM_SLOT  0
-#define TRACER_FX_SLOT    1
-//------------------------------------------------------------------------
-CTracer::CTracer(const Vec3 &pos)
-: m_pos(0,0,0),
-	m_dest(0,0,0),
-	m_startingPos(pos),
-	m_age(0.0f),
-	m_lifeTime(1.5f),
-	m_entityId(0),
-	m_geometrySlot(0),
-	m_startFadeOutTime(0.0f),
-	m_scale(1.0f),
-	m_geometryOpacity(0.99f),
-	m_slideFrac(0.f),
-	m_tracerFlags(0)
-{
-	CreateEntity();
-}
+#define TRACER_INITIAL_CAPACITY 96
 
 //------------------------------------------------------------------------
-CTracer::CTracer()
-: m_pos(0,0,0),
-	m_dest(0,0,0),
-	m_startingPos(0,0,0),
-	m_age(0.0f),
-	m_lifeTime(1.5f),
-	m_entityId(0),
-	m_geometrySlot(0),
-	m_startFadeOutTime(0.0f),
-	m_scale(1.0f),
-	m_geometryOpacity(0.99f),
-	m_slideFrac(0.f),
-	m_tracerFlags(0)
+void CTracerManager::STracerStore::Resize(int size)
 {
+	pos.resize(size, Vec3(ZERO));
+	renderPos.resize(size, Vec3(ZERO));
+	dest.resize(size, Vec3(ZERO));
+	startingPos.resize(size, Vec3(ZERO));
+	age.resize(size, 0.0f);
+	lifeTime.resize(size, 1.5f);
+	speed.resize(size, 0.0f);
+	fadeOutTime.resize(size, 0.0f);
+	startFadeOutTime.resize(size, 0.0f);
+	slideFrac.resize(size, 0.0f);
+	halfLength.resize(size, 0.0f);
+	flags.resize(size, 0);
+	boundToBulletId.resize(size, 0);
+	scale.resize(size, 1.0f);
+	geometryOpacity.resize(size, 0.99f);
+	opacity.resize(size, 0.99f);
+	geometry.resize(size);
+	emitter.resize(size, NULL);
 }
 
 //------------------------------------------------------------------------
-CTracer::~CTracer()
+void CTracerManager::STracerStore::Swap(int a, int b)
 {
-	//DeleteEntity();
+	std::swap(pos[a], pos[b]);
+	std::swap(renderPos[a], renderPos[b]);
+	std::swap(dest[a], dest[b]);
+	std::swap(startingPos[a], startingPos[b]);
+	std::swap(age[a], age[b]);
+	std::swap(lifeTime[a], lifeTime[b]);
+	std::swap(speed[a], speed[b]);
+	std::swap(fadeOutTime[a], fadeOutTime[b]);
+	std::swap(startFadeOutTime[a], startFadeOutTime[b]);
+	std::swap(slideFrac[a], slideFrac[b]);
+	std::swap(halfLength[a], halfLength[b]);
+	std::swap(flags[a], flags[b]);
+	std::swap(boundToBulletId[a], boundToBulletId[b]);
+	std::swap(scale[a], scale[b]);
+	std::swap(geometryOpacity[a], geometryOpacity[b]);
+	std::swap(opacity[a], opacity[b]);
+	std::swap(geometry[a], geometry[b]);
+	std::swap(emitter[a], emitter[b]);
 }
 
 //------------------------------------------------------------------------
-void CTracer::Reset(const Vec3 &pos, const Vec3 &dest)
+void CTracerManager::STracerStore::Clear()
 {
-	m_pos.zero();
-	m_dest.zero();
-	m_startingPos=pos;
-	m_age=0.0f;
-	m_lifeTime=1.5f;
-	m_tracerFlags &= ~kTracerFlag_scaleToDistance;
-	m_startFadeOutTime = 0.0f;
-	m_slideFrac = 0.f;
-
-	if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(m_entityId))
-	{
-		pEntity->FreeSlot(TRACER_GEOM_SLOT);
-		pEntity->FreeSlot(TRACER_FX_SLOT);
-
-		Vec3 dir = dest - pos;
-		dir.Normalize();
-
-		Matrix34 tm;
-		
-		tm.SetIdentity();
-
-		if(!dir.IsZero())
-		{
-			tm = Matrix33::CreateRotationVDir(dir);
-		}
-		
-		tm.AddTranslation(pos);
-		pEntity->SetWorldTM(tm);
-	}
+	stl::free_container(pos);
+	stl::free_container(renderPos);
+	stl::free_container(dest);
+	stl::free_container(startingPos);
+	stl::free_container(age);
+	stl::free_container(lifeTime);
+	stl::free_container(speed);
+	stl::free_container(fadeOutTime);
+	stl::free_container(startFadeOutTime);
+	stl::free_container(slideFrac);
+	stl::free_container(halfLength);
+	stl::free_container(flags);
+	stl::free_container(boundToBulletId);
+	stl::free_container(scale);
+	stl::free_container(geometryOpacity);
+	stl::free_container(opacity);
+	stl::free_container(geometry);
+	stl::free_container(emitter);
 }
 
 //------------------------------------------------------------------------
-void CTracer::CreateEntity()
+void CTracerManager::STracerStore::GetMemoryStatistics(ICrySizer *s) const
 {
-	if (!m_entityId)
-	{
-		SEntitySpawnParams spawnParams;
-		spawnParams.pClass = gEnv->pEntitySystem->GetClassRegistry()->GetDefaultClass();
-		spawnParams.sName = "_tracer";
-		spawnParams.nFlags = ENTITY_FLAG_NO_PROXIMITY | ENTITY_FLAG_CLIENT_ONLY | ENTITY_FLAG_NO_SAVE;
-
-		if (IEntity *pEntity=gEnv->pEntitySystem->SpawnEntity(spawnParams))
-			m_entityId=pEntity->GetId();
-	}
+	s->AddContainer(pos);
+	s->AddContainer(renderPos);
+	s->AddContainer(dest);
+	s->AddContainer(startingPos);
+	s->AddContainer(age);
+	s->AddContainer(lifeTime);
+	s->AddContainer(speed);
+	s->AddContainer(fadeOutTime);
+	s->AddContainer(startFadeOutTime);
+	s->AddContainer(slideFrac);
+	s->AddContainer(halfLength);
+	s->AddContainer(flags);
+	s->AddContainer(boundToBulletId);
+	s->AddContainer(scale);
+	s->AddContainer(geometryOpacity);
+	s->AddContainer(opacity);
+	s->AddContainer(geometry);
+	s->AddContainer(emitter);
 }
 
-void CTracer::DeleteEntity()
-{
-	if (m_entityId)
-	{
-		gEnv->pEntitySystem->RemoveEntity(m_entityId);
-	}
-
-	m_entityId=0;
-}
+//////////////////////////////////////////////////////////////////////////
 
 //------------------------------------------------------------------------
-void CTracer::GetMemoryStatistics(ICrySizer * s) const
+CTracerManager::CTracerManager()
+: m_pRenderNode(NULL)
+, m_numActiveTracers(0)
 {
-	s->Add(*this);
 }
 
 //------------------------------------------------------------------------
-void CTracer::SetGeometry(const char *name, float scale)
+CTracerManager::~CTracerManager()
 {
-	if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(m_entityId))
-	{
-		m_geometrySlot =pEntity->LoadGeometry(TRACER_GEOM_SLOT, name);
-
-		if (scale!=1.0f)
-		{
-			Matrix34 tm=Matrix34::CreateIdentity();
-			tm.ScaleColumn(Vec3(scale, scale, scale));
-			pEntity->SetSlotLocalTM(m_geometrySlot, tm);
-		}
-
-		// Set opacity
-		IEntityRenderProxy *pRenderProxy = (IEntityRenderProxy*)pEntity->GetProxy(ENTITY_PROXY_RENDER);
-		pRenderProxy->SetOpacity(m_geometryOpacity);
-	}
+	Reset();
 }
 
 //------------------------------------------------------------------------
-void CTracer::SetEffect(const char *name, float scale)
+int CTracerManager::EmitTracer(const STracerParams &params, const EntityId bulletId)
 {
-	IParticleEffect *pEffect = gEnv->pParticleManager->FindEffect(name);
-	if (!pEffect)
-		return;
+	if(!gEnv->IsClient())
+		return -1;
 
-	if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(m_entityId))
+	CRecordingSystem* pRecordingSystem = g_pGame->GetRecordingSystem();
+	if (pRecordingSystem)
 	{
-		m_effectSlot = pEntity->LoadParticleEmitter(TRACER_FX_SLOT, pEffect);
-		if (scale!=1.0f)
+		if (!pRecordingSystem->OnEmitTracer(params))
 		{
-			Matrix34 tm=Matrix34::CreateIdentity();
-			tm.ScaleColumn(Vec3(scale, scale, scale));
-			pEntity->SetSlotLocalTM(m_effectSlot, tm);
+			return -1;
 		}
 	}
-}
 
-//------------------------------------------------------------------------
-bool CTracer::Update(float frameTime, const Vec3 &camera, const float fovScale)
-{
-	frameTime							= (float)__fsel(-m_age, 0.002f, frameTime);
-	const float tracerAge	= (float)__fsel(-m_age, 0.002f, m_age+frameTime);
-
-	m_age = tracerAge;
+	if (m_numActiveTracers >= m_tracers.Capacity())
+	{
+		const int capacity = m_tracers.Capacity();
+		m_tracers.Resize(capacity ? capacity * 2 : TRACER_INITIAL_CAPACITY);
+	}
 
-	if (tracerAge >= m_lifeTime)
-		return false;
+	const int idx = m_numActiveTracers++;
+
+	m_tracers.pos[idx] = params.position;
+	m_tracers.renderPos[idx] = params.position;
+	m_tracers.startingPos[idx] = params.position;
+	m_tracers.dest[idx] = params.destination;
+	m_tracers.age[idx] = 0.0f;
+	m_tracers.lifeTime[idx] = params.lifetime;
+	m_tracers.speed[idx] = params.speed;
+	m_tracers.fadeOutTime[idx] = params.delayBeforeDestroy;
+	m_tracers.startFadeOutTime[idx] = params.startFadeOutTime;
+	m_tracers.slideFrac[idx] = params.slideFraction;
+	m_tracers.halfLength[idx] = 0.0f;
+	m_tracers.boundToBulletId[idx] = bulletId;
+	m_tracers.scale[idx] = params.scale;
+	m_tracers.geometryOpacity[idx] = params.geometryOpacity;
+	m_tracers.opacity[idx] = params.geometryOpacity;
+	m_tracers.geometry[idx] = NULL;
+	m_tracers.emitter[idx] = NULL;
+
+	uint16 flags = kTracerFlag_active;
 
-	Vec3 currentLimitDestination;
-	if (gEnv->bMultiplayer)
+	if (params.geometry && params.geometry[0])
 	{
-		if(m_tracerFlags & kTracerFlag_updateDestFromBullet)
+		if (IStatObj* pStatObj = gEnv->p3DEngine->LoadStatObj(params.geometry))
 		{
-			IEntity* pBulletEntity = gEnv->pEntitySystem->GetEntity(m_boundToBulletId);
-			if(pBulletEntity)
-			{
-				m_dest = pBulletEntity->GetPos();
-			}
+			m_tracers.geometry[idx] = pStatObj;
+			m_tracers.halfLength[idx] = pStatObj->GetAABB().GetRadius() * params.scale;
+			flags |= kTracerFlag_useGeometry;
 		}
-		currentLimitDestination = m_dest;
 	}
-	else
+
+	if(params.scaleToDistance)
 	{
-		IEntity* pBulletEntity = gEnv->pEntitySystem->GetEntity(m_boundToBulletId);
-		currentLimitDestination = pBulletEntity ? pBulletEntity->GetPos() : m_dest;
+		flags |= kTracerFlag_scaleToDistance;
 	}
 
-	const Vec3 maxTravelledDistance = m_dest - m_startingPos;
-	const float maxTravelledDistanceSqr = maxTravelledDistance.len2();
-	
-	float dist = sqrt_tpl(maxTravelledDistanceSqr);
-	if (dist <= 0.001f)
-		return false;
-		
-	const Vec3 dir = maxTravelledDistance * (float)__fres(dist);
-	Vec3 pos = m_pos;
-	float lengthScale = 1.f;
-	Vec3 newPos = m_pos;
-	
-	if (!(m_tracerFlags & kTracerFlag_dontTranslate))
+  if(params.dontTranslate)
   {
-    const float sqrRadius = GetGameConstCVar(g_tracers_slowDownAtCameraDistance) * GetGameConstCVar(g_tracers_slowDownAtCameraDistance);
-		const float cameraDistance = (m_pos-camera).len2();
-    const float speed = m_speed * (float)__fsel(sqrRadius - cameraDistance, 0.35f + (cameraDistance/(sqrRadius*2)), 1.0f); //Slow down tracer when near the player
-    newPos += dir * min(speed*frameTime, dist);
-	  pos = newPos;
-
-		if(m_slideFrac > 0.f)
-		{
-			pos += (((2.f * cry_frand()) - 0.5f) * m_slideFrac * speed * frameTime * dir);
-		}
+    flags |= kTracerFlag_dontTranslate;
   }
 
-	// Now update visuals...
-	if (IEntity *pEntity = gEnv->pEntitySystem->GetEntity(m_entityId))
+	if(params.updateDestPosFromBullet)
 	{
-		AABB tracerBbox;
-		pEntity->GetWorldBounds(tracerBbox);
-
-		float tracerHalfLength = !tracerBbox.IsEmpty() ? tracerBbox.GetRadius() : 0.0f;
-		const Vec3 frontOfTracerPos = pos + (dir * tracerHalfLength);
-
-		if((frontOfTracerPos-m_startingPos).len2() > maxTravelledDistanceSqr)
-		{
-			return false;
-		}
-	
-		if (!(m_tracerFlags & kTracerFlag_dontTranslate) && tracerHalfLength > 0.f)
-		{
-			//Ensure that never goes in front of the bullet
-			const Vec3 dirFromFrontOfTracerToDestination = currentLimitDestination - frontOfTracerPos;
-			if (dir.dot(dirFromFrontOfTracerToDestination) < 0)
-			{
-				pos += dirFromFrontOfTracerToDestination;
-			}
-
-			// ... and check if back of tracer is behind starting point, so adjust length.
-			const Vec3 backOfTracerPos = pos - (dir * tracerHalfLength);
-			const Vec3 dirFromBackOfTracerToStart = m_startingPos - backOfTracerPos;
-
-			if (dir.dot(dirFromBackOfTracerToStart) > 0)
-			{
-				if(dir.dot((m_startingPos - pos)) > 0)
-				{
-					pos = m_startingPos + (dir * cry_frand() * tracerHalfLength);
-				}
-
-				lengthScale = ((pos - m_startingPos).GetLength() / tracerHalfLength);
-			}
-		}
-		
-		m_pos = newPos;
-		
-		Matrix34 tm(Matrix33::CreateRotationVDir(dir));
-		tm.AddTranslation(pos);
+		flags |= kTracerFlag_updateDestFromBullet;
+	}
 
-		pEntity->SetWorldTM(tm);
+	m_tracers.flags[idx] = flags;
 
-		//Do not scale effects
-		if((m_tracerFlags & kTracerFlag_useGeometry))
+	if (params.effect && params.effect[0])
+	{
+		if (IParticleEffect *pEffect = gEnv->pParticleManager->FindEffect(params.effect))
 		{
-			float finalFovScale = fovScale;
-			if((m_tracerFlags & kTracerFlag_scaleToDistance) != 0)
-			{
-				lengthScale = dist * 0.5f;
-			}
-			else
-			{
-				const float cameraDistanceSqr = (m_pos-camera).len2();
-				const float minScale = GetGameConstCVar(g_tracers_minScale);
-				const float maxScale = GetGameConstCVar(g_tracers_maxScale);
-				const float minDistanceRange = GetGameConstCVar(g_tracers_minScaleAtDistance) * GetGameConstCVar(g_tracers_minScaleAtDistance);
-				const float maxDistanceRange = max(GetGameConstCVar(g_tracers_maxScaleAtDistance) * GetGameConstCVar(g_tracers_maxScaleAtDistance), minDistanceRange + 1.0f);
-				const float currentRefDistance = clamp(cameraDistanceSqr, minDistanceRange, maxDistanceRange);
-
-				const float distanceToCameraFactor = ((currentRefDistance - minDistanceRange) / (maxDistanceRange - minDistanceRange));
-				const float distanceToCameraScale = LERP(minScale, maxScale, distanceToCameraFactor);
-				
-				lengthScale = m_scale * distanceToCameraScale;
-				finalFovScale *= distanceToCameraScale;
-			}
-			
-			const float widthScale = fovScale;
-
-			tm.SetIdentity();
-			tm.SetScale(Vec3(m_scale * finalFovScale, lengthScale, m_scale * finalFovScale));
-			pEntity->SetSlotLocalTM(m_geometrySlot,tm);
+			const Vec3 dir = (params.destination - params.position).GetNormalizedSafe(Vec3Constants<float>::fVec3_OneY);
+			m_tracers.emitter[idx] = pEffect->Spawn(false, IParticleEffect::ParticleLoc(params.position, dir, params.scale));
 		}
 	}
 
-	return true;
+	return idx;
 }
 
 //------------------------------------------------------------------------
-void CTracer::SetLifeTime(float lifeTime)
+// Tracer destinations are only ever moved here, when the bound projectile goes away;
+// the per-frame update never looks up the projectile entity
+void CTracerManager::OnBoundProjectileDestroyed( const int tracerIdx, const EntityId projectileId, const Vec3& newEndTracerPosition )
 {
-	m_lifeTime = lifeTime;
-}
+	bool validTracerIdx = (tracerIdx >= 0) && (tracerIdx < m_numActiveTracers);
 
-//////////////////////////////////////////////////////////////////////////
-
-//------------------------------------------------------------------------
-CTracerManager::CTracerManager()
-: m_numActiveTracers(0)
-{
+	if (validTracerIdx)
+	{
+		bool tracerMatchesProjectile = (m_tracers.flags[tracerIdx] & kTracerFlag_active) && (m_tracers.boundToBulletId[tracerIdx] == projectileId);
+		if (tracerMatchesProjectile)
+		{
+			m_tracers.dest[tracerIdx] = newEndTracerPosition;
+			m_tracers.boundToBulletId[tracerIdx] = 0; 
+		}
+	}
 }
 
 //------------------------------------------------------------------------
-CTracerManager::~CTracerManager()
+void CTracerManager::Update(float frameTime)
 {
+	const CCamera& viewCamera = gEnv->pSystem->GetViewCamera();
+	const Vec3 cameraPosition = viewCamera.GetPosition();
+	const float viewCameraFovScale = viewCamera.GetFov() / DEG2RAD(g_pGame->GetFOV());
+
+	if (m_numActiveTracers > 0)
+	{
+		IntegrateTracers(frameTime, cameraPosition);
+		UpdateVisuals(frameTime, cameraPosition, viewCameraFovScale);
+		RemoveInactiveTracers();
+	}
+	else if (m_pRenderNode && m_pRenderNode->GetNumInstances())
+	{
+		m_pRenderNode->BeginInstances();
+		m_pRenderNode->EndInstances();
+	}
 }
 
 //------------------------------------------------------------------------
-int CTracerManager::EmitTracer(const STracerParams &params, const EntityId bulletId)
+// Advances age and position of every active tracer in one pass over the
+// store's arrays. Sets kTracerFlag_moving on the tracers that are still travelling
+void CTracerManager::IntegrateTracers(float frameTime, const Vec3 &cameraPosition)
 {
-	if(!gEnv->IsClient())
-		return -1;
+	const float slowDownDistance = GetGameConstCVar(g_tracers_slowDownAtCameraDistance);
+	const float sqrRadius = slowDownDistance * slowDownDistance;
+	const int kNumActiveTracers = m_numActiveTracers;
 
-	CRecordingSystem* pRecordingSystem = g_pGame->GetRecordingSystem();
-	if (pRecordingSystem)
+	Vec3* __restrict pPos = &m_tracers.pos[0];
+	Vec3* __restrict pRenderPos = &m_tracers.renderPos[0];
+	const Vec3* __restrict pDest = &m_tracers.dest[0];
+	const Vec3* __restrict pStartingPos = &m_tracers.startingPos[0];
+	float* __restrict pAge = &m_tracers.age[0];
+	const float* __restrict pLifeTime = &m_tracers.lifeTime[0];
+	const float* __restrict pSpeed = &m_tracers.speed[0];
+	const float* __restrict pSlideFrac = &m_tracers.slideFrac[0];
+	const float* __restrict pHalfLength = &m_tracers.halfLength[0];
+	uint16* __restrict pFlags = &m_tracers.flags[0];
+
+	for (int i = 0; i < kNumActiveTracers; ++i)
 	{
-		if (!pRecordingSystem->OnEmitTracer(params))
-		{
-			return -1;
-		}
-	}
+		const float tracerFrameTime	= (float)__fsel(-pAge[i], 0.002f, frameTime);
+		const float tracerAge				= (float)__fsel(-pAge[i], 0.002f, pAge[i]+frameTime);
+		pAge[i] = tracerAge;
 
-	int idx = 0;
+		const Vec3 maxTravelledDistance = pDest[i] - pStartingPos[i];
+		const float maxTravelledDistanceSqr = maxTravelledDistance.len2();
+		const float dist = sqrt_tpl(maxTravelledDistanceSqr);
 
-	if(m_numActiveTracers < kMaxNumTracers)
-	{
-		//Add to end of array
-		idx = m_numActiveTracers;
-		m_tracerPool[idx].CreateEntity();
-		m_tracerPool[idx].Reset(params.position, params.destination);
-		m_numActiveTracers++;
-	}
-	else
-	{
-		//Find the oldest existing tracer and remove
-		assert(!"Too many tracers in existence! Removing oldest");
-
-		float oldest = 0.0f;
+		bool moving = (tracerAge < pLifeTime[i]) && (dist > 0.001f);
 
-		for(int i = 0; i < kMaxNumTracers; i++)
+		if (moving)
 		{
-			CryPrefetchUnsafe(&m_tracerPool[i+4]);
-			if(m_tracerPool[i].m_age > oldest)
-			{
-				oldest = m_tracerPool[i].m_age;
-				idx = i;
-			}
-		}
-
-		m_tracerPool[idx].Reset(params.position, params.destination);
-	}
+			const Vec3 dir = maxTravelledDistance * (float)__fres(dist);
+			Vec3 newPos = pPos[i];
+			Vec3 pos = newPos;
 
-	CTracer& tracer = m_tracerPool[idx];
+			const bool translate = !(pFlags[i] & kTracerFlag_dontTranslate);
+			if (translate)
+			{
+				const float cameraDistance = (pPos[i]-cameraPosition).len2();
+				const float speed = pSpeed[i] * (float)__fsel(sqrRadius - cameraDistance, 0.35f + (cameraDistance/(sqrRadius*2)), 1.0f); //Slow down tracer when near the player
+				newPos += dir * min(speed*tracerFrameTime, dist);
+				pos = newPos;
 
-	tracer.m_boundToBulletId = bulletId;
-	tracer.m_tracerFlags = kTracerFlag_active;
-	tracer.m_effectSlot = -1;
-	tracer.m_geometryOpacity = params.geometryOpacity;
-	if (params.geometry && params.geometry[0])
-	{
-		tracer.SetGeometry(params.geometry, params.scale);
-		tracer.m_tracerFlags |= kTracerFlag_useGeometry;
-	}
+				if(pSlideFrac[i] > 0.f)
+				{
+					pos += (((2.f * cry_frand()) - 0.5f) * pSlideFrac[i] * speed * tracerFrameTime * dir);
+				}
+			}
 
-	tracer.SetLifeTime(params.lifetime);
+			const float tracerHalfLength = pHalfLength[i];
+			const Vec3 frontOfTracerPos = pos + (dir * tracerHalfLength);
 
-	tracer.m_speed = params.speed;
-	tracer.m_pos = params.position;
-	tracer.m_startingPos = params.position;
-	tracer.m_dest = params.destination;
-	tracer.m_fadeOutTime = params.delayBeforeDestroy;
-	
-	if(params.scaleToDistance)
-	{
-		tracer.m_tracerFlags |= kTracerFlag_scaleToDistance;
-	}
+			if ((frontOfTracerPos-pStartingPos[i]).len2() > maxTravelledDistanceSqr)
+			{
+				moving = false;
+			}
+			else
+			{
+				if (translate && tracerHalfLength > 0.f)
+				{
+					//Ensure that never goes in front of the bullet
+					const Vec3 dirFromFrontOfTracerToDestination = pDest[i] - frontOfTracerPos;
+					if (dir.dot(dirFromFrontOfTracerToDestination) < 0)
+					{
+						pos += dirFromFrontOfTracerToDestination;
+					}
 
-  if(params.dontTranslate)
-  {
-    tracer.m_tracerFlags |= kTracerFlag_dontTranslate;
-  }
+					// ... and check if back of tracer is behind starting point
+					if ((dir.dot(pStartingPos[i] - (pos - (dir * tracerHalfLength))) > 0) && (dir.dot(pStartingPos[i] - pos) > 0))
+					{
+						pos = pStartingPos[i] + (dir * cry_frand() * tracerHalfLength);
+					}
+				}
 
-	if(params.updateDestPosFromBullet)
-	{
-		tracer.m_tracerFlags |= kTracerFlag_updateDestFromBullet;
-	}
-	
-	tracer.m_startFadeOutTime = params.startFadeOutTime;
-	tracer.m_scale = params.scale;
-	tracer.m_slideFrac = params.slideFraction;
+				pPos[i] = newPos;
+				pRenderPos[i] = pos;
+			}
+		}
 
-	if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(tracer.m_entityId))
-	{
-		pEntity->Hide(0);
+		pFlags[i] = moving ? (pFlags[i] | kTracerFlag_moving) : (pFlags[i] & ~kTracerFlag_moving);
 	}
-
-	// set effect after unhiding the entity, or else the particle emitter is created hidden
-	if (params.effect && params.effect[0])
-		tracer.SetEffect(params.effect, params.scale);
-
-	return idx;
 }
 
 //------------------------------------------------------------------------
-void CTracerManager::OnBoundProjectileDestroyed( const int tracerIdx, const EntityId projectileId, const Vec3& newEndTracerPosition )
+Matrix34 CTracerManager::GetTracerTM(int idx) const
 {
-	bool validTracerIdx = (tracerIdx >= 0) && (tracerIdx < kMaxNumTracers);
+	const Vec3 dir = (m_tracers.dest[idx] - m_tracers.startingPos[idx]).GetNormalizedSafe(Vec3Constants<float>::fVec3_OneY);
 
-	if (validTracerIdx)
-	{
-		CTracer& tracer = m_tracerPool[tracerIdx];
+	Matrix34 tm(Matrix33::CreateRotationVDir(dir));
+	tm.AddTranslation(m_tracers.renderPos[idx]);
 
-		bool tracerMatchesProjectile = (tracer.m_tracerFlags & kTracerFlag_active) && (tracer.m_boundToBulletId == projectileId);
-		if (tracerMatchesProjectile)
-		{
-			tracer.m_dest = newEndTracerPosition;
-			tracer.m_boundToBulletId = 0; 
-		}
-	}
+	return tm;
 }
 
 //------------------------------------------------------------------------
-void CTracerManager::Update(float frameTime)
+// Handles fade out and builds this frame's render node instances and emitter locations
+void CTracerManager::UpdateVisuals(float frameTime, const Vec3 &cameraPosition, const float fovScale)
 {
-	CryPrefetch(m_tracerPool);
+	const int kNumActiveTracers = m_numActiveTracers;
 
-	const CCamera& viewCamera = gEnv->pSystem->GetViewCamera();
-	const Vec3 cameraPosition = viewCamera.GetPosition();
-	const float viewCameraFovScale = viewCamera.GetFov() / DEG2RAD(g_pGame->GetFOV());
+	if (!m_pRenderNode)
+	{
+		m_pRenderNode = new CTracerRenderNode();
+	}
 
-	const int kNumActiveTracers = m_numActiveTracers;
+	CTracerRenderNode::TInstances& instances = m_pRenderNode->BeginInstances();
+
+	const float minScale = GetGameConstCVar(g_tracers_minScale);
+	const float maxScale = GetGameConstCVar(g_tracers_maxScale);
+	const float minDistanceRange = GetGameConstCVar(g_tracers_minScaleAtDistance) * GetGameConstCVar(g_tracers_minScaleAtDistance);
+	const float maxDistanceRange = max(GetGameConstCVar(g_tracers_maxScaleAtDistance) * GetGameConstCVar(g_tracers_maxScaleAtDistance), minDistanceRange + 1.0f);
 
-	for(int i = 0; i < kNumActiveTracers;)
+	for(int i = 0; i < kNumActiveTracers; ++i)
 	{
-		int nextTracerIndex = i + 1;
-		CTracer& tracer = m_tracerPool[i];
-		CryPrefetch(&m_tracerPool[nextTracerIndex]);
-		
-		//Update
-		const bool stillMoving = tracer.Update(frameTime, cameraPosition, viewCameraFovScale);
-
-		//Is it worth putting this in another loop for instruction cache coherency? Profile when PS3 is up and running - Rich S
-		if(stillMoving || (tracer.m_fadeOutTime > 0.f))
+		uint16 flags = m_tracers.flags[i];
+		const bool stillMoving = (flags & kTracerFlag_moving) != 0;
+
+		if(stillMoving || (m_tracers.fadeOutTime[i] > 0.f))
 		{
-			tracer.m_tracerFlags |= kTracerFlag_active;
-			
+			flags |= kTracerFlag_active;
+
 			if (!stillMoving)
 			{
-				tracer.m_fadeOutTime -= frameTime;
+				m_tracers.fadeOutTime[i] -= frameTime;
 
-				if (tracer.m_effectSlot > -1)
+				if (m_tracers.emitter[i] && !(flags & kTracerFlag_effectStopped))
 				{
-					if (IEntity *pEntity = gEnv->pEntitySystem->GetEntity(tracer.m_entityId))
+					m_tracers.emitter[i]->Activate(false);
+
+					if (flags & kTracerFlag_useGeometry)
 					{
-						IParticleEmitter * emitter = pEntity->GetParticleEmitter(tracer.m_effectSlot);
-						if (emitter)
-						{
-							emitter->Activate(false);
-						}
-
-						if (tracer.m_tracerFlags & kTracerFlag_useGeometry)
-						{
-							pEntity->SetSlotFlags(tracer.m_geometrySlot, pEntity->GetSlotFlags(tracer.m_geometrySlot) &~ (ENTITY_SLOT_RENDER|ENTITY_SLOT_RENDER_NEAREST));
-						}
-
-						tracer.m_effectSlot = -1;
+						flags |= kTracerFlag_hideGeometry;
 					}
+
+					flags |= kTracerFlag_effectStopped;
 				}
 
-				if(tracer.m_tracerFlags & kTracerFlag_useGeometry)
+				if(flags & kTracerFlag_useGeometry)
 				{
 					// Fade out geometry
-					if((tracer.m_fadeOutTime < tracer.m_startFadeOutTime) && (tracer.m_startFadeOutTime > 0.0f))
+					const float startFadeOutTime = m_tracers.startFadeOutTime[i];
+					if((m_tracers.fadeOutTime[i] < startFadeOutTime) && (startFadeOutTime > 0.0f))
 					{
-						if (IEntity *pEntity = gEnv->pEntitySystem->GetEntity(tracer.m_entityId))
-						{
-							IEntityRenderProxy *pRenderProxy = (IEntityRenderProxy*)pEntity->GetProxy(ENTITY_PROXY_RENDER);
-							pRenderProxy->SetOpacity(max((tracer.m_fadeOutTime / tracer.m_startFadeOutTime) * tracer.m_geometryOpacity, 0.0f));
-						}
+						m_tracers.opacity[i] = max((m_tracers.fadeOutTime[i] / startFadeOutTime) * m_tracers.geometryOpacity[i], 0.0f);
 					}
 				}
 			}
+
+			const Matrix34 tm = GetTracerTM(i);
+			const float scale = m_tracers.scale[i];
+
+			if (stillMoving && m_tracers.emitter[i] && !(flags & kTracerFlag_effectStopped))
+			{
+				m_tracers.emitter[i]->SetMatrix(tm * Matrix34::CreateScale(Vec3(scale, scale, scale)));
+			}
+
+			//Do not scale effects
+			if((flags & (kTracerFlag_useGeometry|kTracerFlag_hideGeometry)) == kTracerFlag_useGeometry)
+			{
+				float finalFovScale = fovScale;
+				float lengthScale = 1.f;
+				if((flags & kTracerFlag_scaleToDistance) != 0)
+				{
+					lengthScale = (m_tracers.dest[i] - m_tracers.startingPos[i]).GetLength() * 0.5f;
+				}
+				else
+				{
+					const float cameraDistanceSqr = (m_tracers.pos[i]-cameraPosition).len2();
+					const float currentRefDistance = clamp(cameraDistanceSqr, minDistanceRange, maxDistanceRange);
+
+					const float distanceToCameraFactor = ((currentRefDistance - minDistanceRange) / (maxDistanceRange - minDistanceRange));
+					const float distanceToCameraScale = LERP(minScale, maxScale, distanceToCameraFactor);
+
+					lengthScale = scale * distanceToCameraScale;
+					finalFovScale *= distanceToCameraScale;
+				}
+
+				CTracerRenderNode::SInstance instance;
+				instance.tm = tm * Matrix34::CreateScale(Vec3(scale * finalFovScale, lengthScale, scale * finalFovScale));
+				instance.pStatObj = m_tracers.geometry[i];
+				instance.opacity = m_tracers.opacity[i];
+				instances.push_back(instance);
+			}
 		}
 		else
 		{
-			tracer.m_tracerFlags &= ~kTracerFlag_active;
-			tracer.m_boundToBulletId = 0;
+			flags &= ~kTracerFlag_active;
+			m_tracers.boundToBulletId[i] = 0;
 		}
 
-		i = nextTracerIndex;
+		m_tracers.flags[i] = flags;
+	}
+
+	m_pRenderNode->EndInstances();
+}
+
+//------------------------------------------------------------------------
+void CTracerManager::ReleaseVisuals(int idx)
+{
+	if (m_tracers.emitter[idx])
+	{
+		gEnv->pParticleManager->DeleteEmitter(m_tracers.emitter[idx]);
+		m_tracers.emitter[idx] = NULL;
 	}
 
+	m_tracers.geometry[idx] = NULL;
+}
+
+//------------------------------------------------------------------------
+void CTracerManager::RemoveInactiveTracers()
+{
 	//This is where we clear out the inactive tracers, so the counter isn't const
-	int numActiveTracers = kNumActiveTracers;
+	int numActiveTracers = m_numActiveTracers;
 	
 	CWeaponSystem* pWeaponSystem = g_pGame->GetWeaponSystem();
 
-	for(int i = kNumActiveTracers - 1; i >= 0;)
+	for(int i = m_numActiveTracers - 1; i >= 0; --i)
 	{
-		int nextIndex = i - 1;
-		CTracer& tracer = m_tracerPool[i];
-		CryPrefetch(&m_tracerPool[nextIndex]);
-		
-		if(!(tracer.m_tracerFlags & kTracerFlag_active))
+		if(!(m_tracers.flags[i] & kTracerFlag_active))
 		{
-			if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(tracer.m_entityId))
-			{
-				pEntity->Hide(true);
-				pEntity->FreeSlot(TRACER_GEOM_SLOT);
-				pEntity->FreeSlot(TRACER_FX_SLOT); 
-			}
+			ReleaseVisuals(i);
 
 			//Switch the inactive tracer so it's at the end of the array;
 			const int lastTracer = numActiveTracers - 1;
-			static CTracer temp;
-			temp = tracer;			
 			numActiveTracers = lastTracer;
-			tracer = m_tracerPool[lastTracer];
-			m_tracerPool[lastTracer] = temp;
+			m_tracers.Swap(i, lastTracer);
 
 			//Re-bind index to the corresponding bullet
-			if (tracer.m_boundToBulletId)
+			const EntityId boundToBulletId = m_tracers.boundToBulletId[i];
+			if (boundToBulletId && (i != lastTracer))
 			{
-				CProjectile* pProjectile = pWeaponSystem->GetProjectile(tracer.m_boundToBulletId);
+				CProjectile* pProjectile = pWeaponSystem->GetProjectile(boundToBulletId);
 				if (pProjectile && pProjectile->IsAlive())
 				{
 					if(lastTracer == pProjectile->GetTracerIdx())
@@ -552,10 +498,7 @@ void CTracerManager::Update(float frameTime)
 					}
 				}
 			}
-
 		}
-
-		i = nextIndex;
 	}
 
 	m_numActiveTracers = numActiveTracers;
@@ -564,12 +507,11 @@ void CTracerManager::Update(float frameTime)
 //------------------------------------------------------------------------
 void CTracerManager::Reset()
 {
-	for(int i = 0; i < kMaxNumTracers; i++)
-	{
-		m_tracerPool[i].DeleteEntity();
-	}
+	ClearCurrentActiveTracers();
+
+	m_tracers.Clear();
 
-	m_numActiveTracers = 0;	
+	SAFE_DELETE(m_pRenderNode);
 }
 
 //------------------------------------------------------------------------
@@ -578,30 +520,26 @@ void CTracerManager::ClearCurrentActiveTracers()
 	const int kNumActiveTracers = m_numActiveTracers;
 	for(int i = 0; i < kNumActiveTracers; i++)
 	{
-		CTracer& tracer = m_tracerPool[i];
-		CryPrefetchUnsafe(&m_tracerPool[i+4]);
-
-		tracer.m_tracerFlags &= ~kTracerFlag_active;
-
-		if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(tracer.m_entityId))
-		{
-			pEntity->Hide(true);
-			pEntity->FreeSlot(TRACER_GEOM_SLOT);
-			pEntity->FreeSlot(TRACER_FX_SLOT); 
-		}
+		m_tracers.flags[i] &= ~kTracerFlag_active;
+		ReleaseVisuals(i);
 	}
 
 	m_numActiveTracers = 0;
+
+	if (m_pRenderNode)
+	{
+		m_pRenderNode->BeginInstances();
+		m_pRenderNode->EndInstances();
+	}
 }
 
 void CTracerManager::GetMemoryStatistics(ICrySizer * s)
 {
 	SIZER_SUBCOMPONENT_NAME(s, "TracerManager");
-	//s->Add(*this);
-	//s->AddObject(m_tracerPool);
+	m_tracers.GetMemoryStatistics(s);
 
-	for (int16 i=0; i<m_numActiveTracers; i++)
-		m_tracerPool[i].GetMemoryStatistics(s);
+	if (m_pRenderNode)
+	{
+		m_pRenderNode->GetMemoryUsage(s);
+	}
 }
-
-
@@ -18,58 +18,56 @@ History:
 # pragma once
 #endif
 
+class CTracerRenderNode;
+
 enum
 {
 	kTracerFlag_scaleToDistance				= BIT(0),
 	kTracerFlag_useGeometry						=	BIT(1),
 	kTracerFlag_active								= BIT(2),
 	kTracerFlag_updateDestFromBullet	= BIT(3),
-  kTracerFlag_dontTranslate         = BIT(4)
-};
-
-
-class CTracer
-{
-	friend class CTracerManager;
-public:
-	CTracer();
-	CTracer(const Vec3 &pos);
-	virtual ~CTracer();
-
-	void Reset(const Vec3 &pos, const Vec3 &dest);
-	void CreateEntity();
-	void DeleteEntity();
-	void SetGeometry(const char *name, float scale);
-	void SetEffect(const char *name, float scale);
-	void SetLifeTime(float lifeTime);
-	bool Update(float frameTime, const Vec3 &campos, const float fovScale);
-	float GetAge() const;
-	void GetMemoryStatistics(ICrySizer * s) const;
-
-private:
-	float				m_speed;
-	Vec3				m_pos;
-	Vec3				m_dest;
-	Vec3				m_startingPos;
-	float				m_age;
-	float				m_lifeTime;
-	float				m_fadeOutTime;
-	float				m_startFadeOutTime;	
-	float				m_scale;
-	float				m_geometryOpacity;
-	float				m_slideFrac;
-	EntityId		m_entityId;
-	EntityId		m_boundToBulletId;
-	uint16			m_tracerFlags;
-	int8				m_effectSlot;
-	int8        m_geometrySlot;
+  kTracerFlag_dontTranslate         = BIT(4),
+	kTracerFlag_hideGeometry					= BIT(5),
+	kTracerFlag_moving								= BIT(6),
+	kTracerFlag_effectStopped					= BIT(7)
 };
 
 
 class CTracerManager
 {
-	const static int kMaxNumTracers = 96;
-	
+	// Tracers are stored as parallel arrays so the per-frame integration walks
+	// contiguous memory; the store grows on demand instead of dropping tracers
+	struct STracerStore
+	{
+		void Resize(int size);
+		void Swap(int a, int b);
+		void Clear();
+		int Capacity() const { return (int)age.size(); }
+		void GetMemoryStatistics(ICrySizer *s) const;
+
+		// Integration data
+		std::vector<Vec3>			pos;
+		std::vector<Vec3>			renderPos;
+		std::vector<Vec3>			dest;
+		std::vector<Vec3>			startingPos;
+		std::vector<float>		age;
+		std::vector<float>		lifeTime;
+		std::vector<float>		speed;
+		std::vector<float>		fadeOutTime;
+		std::vector<float>		startFadeOutTime;
+		std::vector<float>		slideFrac;
+		std::vector<float>		halfLength;
+		std::vector<uint16>		flags;
+		std::vector<EntityId>	boundToBulletId;
+
+		// Presentation data
+		std::vector<float>							scale;
+		std::vector<float>							geometryOpacity;
+		std::vector<float>							opacity;
+		std::vector<_smart_ptr<IStatObj> >	geometry;
+		std::vector<IParticleEmitter*>	emitter;
+	};
+
 public:
 	CTracerManager();
 	virtual ~CTracerManager();
@@ -119,10 +117,16 @@ public:
 
 private:
 
-	CTracer					m_tracerPool[kMaxNumTracers + 4];
+	void IntegrateTracers(float frameTime, const Vec3 &cameraPosition);
+	void UpdateVisuals(float frameTime, const Vec3 &cameraPosition, const float fovScale);
+	void RemoveInactiveTracers();
+	void ReleaseVisuals(int idx);
+	Matrix34 GetTracerTM(int idx) const;
 
-	int16						m_numActiveTracers;
-};
+	STracerStore				m_tracers;
+	CTracerRenderNode*	m_pRenderNode;
 
+	int									m_numActiveTracers;
+};
 
 #endif //__TRACERMANAGER_H__
\ No newline at end of file
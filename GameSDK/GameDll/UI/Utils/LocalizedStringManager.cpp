@@ -19,16 +19,35 @@ History:
 #include "LocalizedStringManager.h"
 #include "ILocalizationManager.h"
 #include "crc32.h"
+#include "Utility/CryWatch.h"
 
 //-----------------------------------------------------------------------------------------------------
 
 int CLocalizedStringManager::s_maxAge = -1;
+int CLocalizedStringManager::s_debug = 0;
 
 //-----------------------------------------------------------------------------------------------------
 CLocalizedStringManager::CLocalizedStringManager()
 {
 	m_curTick = 0;
 	m_language = NULL;
+	m_generation = 1;
+
+	m_arena.resize(kArenaInitialSize);
+	m_arenaUsed = 0;
+	m_arenaOverflowSize = 0;
+
+	m_frameLookups = 0;
+	m_frameHits = 0;
+	m_totalLookups = 0;
+	m_totalHits = 0;
+
+	rehash(kMinSlots);
+}
+
+//-----------------------------------------------------------------------------------------------------
+CLocalizedStringManager::~CLocalizedStringManager()
+{
 }
 
 //-----------------------------------------------------------------------------------------------------
@@ -36,26 +55,43 @@ CLocalizedStringManager::CLocalizedStringManager()
 const wchar_t* CLocalizedStringManager::add(const wchar_t* finalStr, const char* label, 
 																						bool bAdjustActions, bool bPreferXI, 
 																						const char* param1, const char* param2, 
-																						const char* param3, const char* param4)
+																						const char* param3, const char* param4,
+																						Handle* pHandle)
 {
+	if (pHandle)
+		*pHandle = kInvalidHandle;
+
 	if (gEnv->bMultiplayer)
 		return finalStr;
 
-	SLocalizedString entry;
+	Key key = generateKey(label, bAdjustActions, bPreferXI, param1, param2, param3, param4);
+
+	// Will overwrite old instance of key, in case of key overlap.
+	int entryIndex = findEntry(key);
+	if (entryIndex < 0)
+	{
+		if (m_cache.size() >= kHandleIndexMask)
+			return finalStr;
+
+		if ((m_cache.size() + 1) * 2 > m_slots.size())
+		{
+			rehash((unsigned int)m_slots.size() * 2);
+		}
+
+		entryIndex = (int)m_cache.size();
+		m_cache.push_back(SLocalizedString());
+		insertSlot(key, entryIndex);
+	}
+
+	SLocalizedString& entry = m_cache[entryIndex];
+	entry.m_key = key;
 	entry.m_refTick = m_curTick;
 	entry.m_finalStr = finalStr;
-	entry.m_label = label;
-	entry.m_bPreferXI = bPreferXI;
-	entry.m_bAdjustActions = bAdjustActions;
-	entry.m_param1 = param1;
-	entry.m_param2 = param2;
-	entry.m_param3 = param3;
-	entry.m_param4 = param4;
 
-	Key key = generateKey(label, bAdjustActions, bPreferXI, param1, param2, param3, param4);
-	m_cache[key] = entry; // Will overwrite old instance of key (insert would fail if the key already exists), in case of key overlap.
+	if (pHandle)
+		*pHandle = makeHandle(entryIndex);
 
-	return entry.m_finalStr;
+	return entry.m_finalStr.c_str();
 }
 
 //-----------------------------------------------------------------------------------------------------
@@ -71,13 +107,88 @@ const wchar_t* CLocalizedStringManager::find(const char* label,
 
 	Key key = generateKey(label, bAdjustActions, bPreferXI, param1, param2, param3, param4);
 
-	Map::iterator found = m_cache.find(key);
-	if (found == m_cache.end())
+	const int entryIndex = findEntry(key);
+	recordLookup(entryIndex >= 0);
+	if (entryIndex < 0)
 		return NULL;
 
-	SLocalizedString& entry = (*found).second;
+	SLocalizedString& entry = m_cache[entryIndex];
 	entry.m_refTick = m_curTick;
-	return entry.m_finalStr;
+	return entry.m_finalStr.c_str();
+}
+
+//-----------------------------------------------------------------------------------------------------
+// Finds an already generated localized string and returns a handle to it.
+CLocalizedStringManager::Handle CLocalizedStringManager::resolve(const char* label, 
+																																 bool bAdjustActions, bool bPreferXI,
+																																 const char* param1, const char* param2, 
+																																 const char* param3, const char* param4)
+{
+	if (gEnv->bMultiplayer)
+		return kInvalidHandle;
+
+	Key key = generateKey(label, bAdjustActions, bPreferXI, param1, param2, param3, param4);
+
+	const int entryIndex = findEntry(key);
+	recordLookup(entryIndex >= 0);
+	if (entryIndex < 0)
+		return kInvalidHandle;
+
+	m_cache[entryIndex].m_refTick = m_curTick;
+	return makeHandle(entryIndex);
+}
+
+//-----------------------------------------------------------------------------------------------------
+// Returns the string a handle refers to, NULL if it was cleared since.
+const wchar_t* CLocalizedStringManager::get(Handle handle)
+{
+	if (handle == kInvalidHandle)
+		return NULL;
+
+	const unsigned int entryIndex = (handle & kHandleIndexMask) - 1;
+	if (((handle >> kHandleIndexBits) != m_generation) || (entryIndex >= m_cache.size()))
+	{
+		recordLookup(false);
+		return NULL;
+	}
+
+	recordLookup(true);
+
+	SLocalizedString& entry = m_cache[entryIndex];
+	entry.m_refTick = m_curTick;
+	return entry.m_finalStr.c_str();
+}
+
+//-----------------------------------------------------------------------------------------------------
+// Formats a parameter into the arena of the current frame.
+const char* CLocalizedStringManager::formatParam(const char* format, ...)
+{
+	char buffer[kMaxParamLength];
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	buffer[sizeof(buffer) - 1] = 0;
+
+	const unsigned int size = (unsigned int)strlen(buffer) + 1;
+
+	char* pResult = NULL;
+	if (m_arenaUsed + size <= m_arena.size())
+	{
+		pResult = &m_arena[m_arenaUsed];
+		m_arenaUsed += size;
+	}
+	else
+	{
+		// Out of space for this frame, the arena grows on the next tick
+		m_arenaOverflow.push_back(std::vector<char>(size));
+		pResult = &m_arenaOverflow.back()[0];
+		m_arenaOverflowSize += size;
+	}
+
+	memcpy(pResult, buffer, size);
+	return pResult;
 }
 
 //-----------------------------------------------------------------------------------------------------
@@ -99,23 +210,102 @@ CLocalizedStringManager::Key CLocalizedStringManager::generateKey(const char* la
 	return key;
 }
 
+//-----------------------------------------------------------------------------------------------------
+// Returns the index of the entry with the given key, -1 if there is none.
+int CLocalizedStringManager::findEntry(Key key) const
+{
+	const unsigned int mask = (unsigned int)m_slots.size() - 1;
+
+	for (unsigned int slot = key & mask; ; slot = (slot + 1) & mask)
+	{
+		const unsigned int value = m_slots[slot];
+		if (value == 0)
+			return -1;
+
+		if (m_cache[value - 1].m_key == key)
+			return (int)(value - 1);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------
+void CLocalizedStringManager::insertSlot(Key key, int entryIndex)
+{
+	const unsigned int mask = (unsigned int)m_slots.size() - 1;
+
+	unsigned int slot = key & mask;
+	while (m_slots[slot] != 0)
+	{
+		slot = (slot + 1) & mask;
+	}
+
+	m_slots[slot] = (unsigned int)(entryIndex + 1);
+}
+
+//-----------------------------------------------------------------------------------------------------
+// Rebuilds the slots for the entries, numSlots must be a power of two.
+void CLocalizedStringManager::rehash(unsigned int numSlots)
+{
+	m_slots.assign(numSlots, 0);
+
+	for (int entryIndex = 0, numEntries = (int)m_cache.size(); entryIndex < numEntries; ++entryIndex)
+	{
+		insertSlot(m_cache[entryIndex].m_key, entryIndex);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------
+void CLocalizedStringManager::recordLookup(bool hit)
+{
+	++m_frameLookups;
+	m_frameHits += hit ? 1 : 0;
+}
+
+//-----------------------------------------------------------------------------------------------------
+// Releases the formatted parameters of the last frame, grows the arena if it didn't fit them.
+void CLocalizedStringManager::resetArena()
+{
+	if (m_arenaOverflowSize > 0)
+	{
+		m_arena.resize(max(m_arena.size() * 2, (size_t)(m_arenaUsed + m_arenaOverflowSize)));
+		m_arenaOverflow.clear();
+		m_arenaOverflowSize = 0;
+	}
+
+	m_arenaUsed = 0;
+}
+
 //-----------------------------------------------------------------------------------------------------
 // Increases the age of cached strings and removes strings older than maxAge (not referenced for that many ticks).
 // Should be called once per frame.
 void CLocalizedStringManager::tick()
 {
+	m_totalLookups += m_frameLookups;
+	m_totalHits += m_frameHits;
+
+	if (s_debug)
+	{
+		CryWatch("Localized strings: %d cached in %d slots, %d/%d lookups hit this frame, %.1f%% since clear",
+			(int)m_cache.size(), (int)m_slots.size(), m_frameHits, m_frameLookups, m_totalLookups ? (100.f * m_totalHits / m_totalLookups) : 0.f);
+		CryWatch("Localized string params: %d/%d bytes, %d bytes over", m_arenaUsed, (int)m_arena.size(), m_arenaOverflowSize);
+	}
+
+	m_frameLookups = 0;
+	m_frameHits = 0;
+
+	resetArena();
+
 	m_curTick++;
 
 	if (m_curTick > 60*60*1)
 	{
 		m_curTick = 0;
-		m_cache.clear();
+		clear();
 	}
 
 	const char* language = gEnv->pSystem->GetLocalizationManager()->GetLanguage();
 	if ((m_language == NULL) || stricmp(m_language, language) != 0)
 	{
-		m_cache.clear();
+		clear();
 		m_language = language;
 		return;
 	}
@@ -141,6 +331,11 @@ void CLocalizedStringManager::tick()
 void CLocalizedStringManager::clear()
 {
 	m_cache.clear();
+	m_slots.assign(kMinSlots, 0);
+	m_generation = (m_generation + 1) & kHandleGenerationMask;
+
+	m_totalLookups = 0;
+	m_totalHits = 0;
 }
 
 //-----------------------------------------------------------------------------------------------------
\ No newline at end of file
@@ -19,7 +19,6 @@ History:
 
 //-----------------------------------------------------------------------------------------------------
 
-#include <map>
 #include "crc32.h"
 
 //-----------------------------------------------------------------------------------------------------
@@ -30,19 +29,35 @@ class CLocalizedStringManager
 public:
 
 	static int s_maxAge;
+	static int s_debug;
+
+	// Refers to a cached string, stays valid until the cache is cleared
+	typedef unsigned int Handle;
+	enum { kInvalidHandle = 0 };
 
 	CLocalizedStringManager();
+	~CLocalizedStringManager();
 
 	// Adds a generated localized string and it's generation parameters to the cache managed by this class.
-	// Only pointers are copied, not whole string content.
-	// Returns a pointer to the internally allocated string.
-	const wchar_t* add(const wchar_t* finalStr, const char* label, bool bAdjustActions, bool bPreferXI, const char* param1, const char* param2, const char* param3, const char* param4);
+	// Only a key generated from the label and parameters is kept, the parameters themselves are not referenced afterwards.
+	// Returns a pointer to the internally allocated string, and optionally a handle to it.
+	const wchar_t* add(const wchar_t* finalStr, const char* label, bool bAdjustActions, bool bPreferXI, const char* param1, const char* param2, const char* param3, const char* param4, Handle* pHandle = NULL);
 	
 	// Finds and returns an already generated localized string given it's generation parameters.
 	// Returns NULL if no match was found.
-	// Uses strcmp for internal comparison (which does initial pointer comparison, afaik).
 	const wchar_t* find(const char* label, bool bAdjustActions, bool bPreferXI, const char* param1, const char* param2, const char* param3, const char* param4);
 
+	// Same lookup as find, but returns a handle to keep instead, kInvalidHandle if no match was found.
+	// Call sites showing the same text every frame resolve it once and use get() afterwards.
+	Handle resolve(const char* label, bool bAdjustActions, bool bPreferXI, const char* param1, const char* param2, const char* param3, const char* param4);
+
+	// Returns the string a handle refers to without generating a key, NULL once the cache was cleared.
+	const wchar_t* get(Handle handle);
+
+	// Formats a parameter (name, score, ...) into memory owned by this class.
+	// The result stays valid until the next tick, which avoids allocating strings on the heap every frame.
+	const char* formatParam(const char* format, ...) PRINTF_PARAMS(2, 3);
+
 	// Increases the age of cached strings and remove/delete strings older than s_maxAge.
 	// Should be called once per frame.
 	// NOTE: Current implementation does NOT remove old/unreferenced strings (due to problem with wstring refcount).
@@ -54,33 +69,62 @@ public:
 
 private:
 
+	typedef unsigned int Key;
+
 	struct SLocalizedString
 	{
+		Key m_key;
 		int m_refTick;
-		bool m_bAdjustActions;
-		bool m_bPreferXI;
 		wstring m_finalStr;
-		const char* m_label;
-		const char* m_param1;
-		const char* m_param2;
-		const char* m_param3;
-		const char* m_param4;
 	};
 
-	typedef unsigned int Key;
-	typedef std::map<Key, SLocalizedString> Map;
-	typedef std::pair<Key, SLocalizedString> Pair;
+	typedef std::vector<SLocalizedString> Entries;
+	typedef std::vector<unsigned int> Slots;
+	typedef std::list< std::vector<char> > ArenaOverflow;
 
-	Map m_cache;
+	enum
+	{
+		kHandleIndexBits = 20,
+		kHandleIndexMask = (1 << kHandleIndexBits) - 1,
+		kHandleGenerationMask = (1 << (32 - kHandleIndexBits)) - 1,
+		kMinSlots = 64,
+		kArenaInitialSize = 4096,
+		kMaxParamLength = 256,
+	};
+
+	// Strings are kept in insertion order, the slots are an open addressing table over them with linear probing.
+	// A slot holds the entry index + 1, 0 when empty. The table is at most half full.
+	Entries m_cache;
+	Slots m_slots;
+	unsigned int m_generation;	// bumped when the cache is cleared, so older handles no longer resolve
 
 	int m_curTick;
 
 	const char* m_language;
 
+	// Formatted parameters of the current frame
+	std::vector<char> m_arena;
+	unsigned int m_arenaUsed;
+	ArenaOverflow m_arenaOverflow;
+	unsigned int m_arenaOverflowSize;
+
+	// Lookups of the current frame and since the last clear, shown with hud_localizedStringCacheDebug
+	int m_frameLookups;
+	int m_frameHits;
+	int m_totalLookups;
+	int m_totalHits;
+
 	Key generateKey(const char* label, bool bAdjustActions, bool bPreferXI,
 									const char* param1, const char* param2, 
 									const char* param3, const char* param4);
 
+	int findEntry(Key key) const;
+	void insertSlot(Key key, int entryIndex);
+	void rehash(unsigned int numSlots);
+	Handle makeHandle(int entryIndex) const { return (m_generation << kHandleIndexBits) | (unsigned int)(entryIndex + 1); }
+	void recordLookup(bool hit);
+	void resetArena();
+
 };
 
 //-----------------------------------------------------------------------------------------------------
@@ -0,0 +1,61 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Frame timing for the console benchmarks. The benchmarks only
+	measure cost, what they simulate is checked by the unit test suites
+	next to the code.
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#ifndef __BENCHMARK_TIMER_H__
+#define __BENCHMARK_TIMER_H__
+
+#if _MSC_VER > 1000
+# pragma once
+#endif
+
+//------------------------------------------------------------------------
+class CBenchmarkTimer
+{
+public:
+	CBenchmarkTimer()
+		: m_totalMs(0.f)
+		, m_worstMs(0.f)
+		, m_numSamples(0)
+	{
+	}
+
+	void Start()
+	{
+		m_start = gEnv->pTimer->GetAsyncTime();
+	}
+
+	// Returns the time since Start, and adds it to the totals
+	float Stop()
+	{
+		const float ms = (gEnv->pTimer->GetAsyncTime() - m_start).GetMilliSeconds();
+		m_totalMs += ms;
+		m_worstMs = max(m_worstMs, ms);
+		++m_numSamples;
+		return ms;
+	}
+
+	float GetTotalMs() const { return m_totalMs; }
+	float GetWorstMs() const { return m_worstMs; }
+	float GetAverageMs() const { return (m_numSamples > 0) ? m_totalMs / m_numSamples : 0.f; }
+	int GetNumSamples() const { return m_numSamples; }
+
+private:
+	CTimeValue m_start;
+	float m_totalMs;
+	float m_worstMs;
+	int m_numSamples;
+};
+
+#endif // __BENCHMARK_TIMER_H__
@@ -0,0 +1,334 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+LoadTimeline.cpp
+
+Description:
+- hierarchical timers for the game side load phases, see LoadTimeline.h
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#include "StdAfx.h"
+#include "LoadTimeline.h"
+
+#if LOAD_TIMELINE_ENABLED
+
+#include "GameCVars.h"
+#include "TelemetryCollector.h"
+
+namespace
+{
+	struct SEvent
+	{
+		string name;
+		int64 begin;							// microseconds since the capture started
+		int64 end;								// negative while the scope is open
+		threadID threadId;
+		int parent;
+		int depth;
+	};
+
+	struct SThreadScope
+	{
+		threadID threadId;
+		int current;
+	};
+
+	typedef std::vector<SEvent> TEvents;
+
+	CryCriticalSection s_lock;
+	TEvents s_events;
+	std::vector<SThreadScope> s_threads;
+	string s_captureName;
+	CTimeValue s_captureStart;
+	uint32 s_capture = 0;				// bumped by every capture, scopes opened in an earlier one are dropped
+	volatile bool s_capturing = false;
+
+	const char* k_traceFolder = "%USER%/LoadTimelines";
+	const char* k_telemetryFile = "USER/MiscTelemetry/load_times.txt";
+
+	int64 GetCaptureTime()
+	{
+		return (gEnv->pTimer->GetAsyncTime() - s_captureStart).GetMicroSecondsAsInt64();
+	}
+
+	SThreadScope& GetThreadScope(threadID threadId)
+	{
+		for (size_t i = 0, n = s_threads.size(); i < n; ++i)
+		{
+			if (s_threads[i].threadId == threadId)
+				return s_threads[i];
+		}
+
+		SThreadScope thread;
+		thread.threadId = threadId;
+		thread.current = CLoadTimeline::kNoScope;
+		s_threads.push_back(thread);
+		return s_threads.back();
+	}
+
+	void WriteEscaped(ICryPak* pPak, FILE* pFile, const char* str)
+	{
+		for (; *str; ++str)
+		{
+			if (*str == '"' || *str == '\\')
+				pPak->FPrintf(pFile, "\\%c", *str);
+			else if ((unsigned char)*str >= ' ')
+				pPak->FPrintf(pFile, "%c", *str);
+		}
+	}
+
+	void WriteTrace(const string& captureName, const TEvents& events)
+	{
+		ICryPak* pPak = gEnv->pCryPak;
+
+		char path[ICryPak::g_nMaxPath];
+		path[sizeof(path) - 1] = 0;
+		pPak->AdjustFileName(k_traceFolder, path, ICryPak::FLAGS_PATH_REAL | ICryPak::FLAGS_FOR_WRITING);
+		pPak->MakeDir(path);
+
+		CryFixedStringT<32> timeStr;
+		time_t ltime;
+		time(&ltime);
+		strftime(timeStr.m_str, timeStr.MAX_SIZE, "%Y%m%d_%H%M%S", localtime(&ltime));
+
+		// level names can carry folders
+		string fileName = captureName;
+		fileName.replace('/', '_');
+		fileName.replace('\\', '_');
+
+		CryFixedStringT<ICryPak::g_nMaxPath> filePath;
+		filePath.Format("%s/%s_%s.json", path, fileName.c_str(), timeStr.c_str());
+
+		CDebugAllowFileAccess allowFileAccess;
+		FILE* pFile = pPak->FOpen(filePath.c_str(), "wt", ICryPak::FLAGS_PATH_REAL);
+		if (!pFile)
+		{
+			GameWarning("[LoadTimeline] Failed to open '%s' for writing", filePath.c_str());
+			return;
+		}
+
+		pPak->FPrintf(pFile, "{\"traceEvents\":[\n");
+		pPak->FPrintf(pFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"");
+		WriteEscaped(pPak, pFile, captureName.c_str());
+		pPak->FPrintf(pFile, "\"}},\n");
+		pPak->FPrintf(pFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Main\"}}", (uint32)gEnv->mMainThreadId);
+
+		for (size_t i = 0, n = events.size(); i < n; ++i)
+		{
+			const SEvent& event = events[i];
+			const SEvent* pParent = (event.parent != CLoadTimeline::kNoScope) ? &events[event.parent] : NULL;
+
+			pPak->FPrintf(pFile, ",\n{\"name\":\"");
+			WriteEscaped(pPak, pFile, event.name.c_str());
+			pPak->FPrintf(pFile, "\",\"cat\":\"load\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%u,\"args\":{\"depth\":%d",
+				event.begin, event.end - event.begin, (uint32)event.threadId, event.depth);
+			if (pParent)
+			{
+				pPak->FPrintf(pFile, ",\"parent\":\"");
+				WriteEscaped(pPak, pFile, pParent->name.c_str());
+				pPak->FPrintf(pFile, "\"");
+			}
+			pPak->FPrintf(pFile, "}}");
+
+			// work handed to another thread is linked to the scope that started it by a flow arrow
+			if (pParent && pParent->threadId != event.threadId)
+			{
+				pPak->FPrintf(pFile, ",\n{\"name\":\"spawn\",\"cat\":\"load\",\"ph\":\"s\",\"id\":%d,\"ts\":%lld,\"pid\":1,\"tid\":%u}",
+					(int)i, event.begin, (uint32)pParent->threadId);
+				pPak->FPrintf(pFile, ",\n{\"name\":\"spawn\",\"cat\":\"load\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%d,\"ts\":%lld,\"pid\":1,\"tid\":%u}",
+					(int)i, event.begin, (uint32)event.threadId);
+			}
+		}
+
+		pPak->FPrintf(pFile, "\n]}\n");
+		pPak->FClose(pFile);
+
+		CryLog("[LoadTimeline] Wrote %d scopes to '%s'", (int)events.size(), filePath.c_str());
+	}
+
+	// One line per capture: the name, the build, the total and the time of each top level phase, in ms
+	void SubmitSummary(const string& captureName, const TEvents& events)
+	{
+		CTelemetryCollector* pTelemetry = CTelemetryCollector::GetTelemetryCollector();
+		if (!pTelemetry || events.empty())
+			return;
+
+		std::vector<std::pair<string, int64> > phases;
+		for (size_t i = 1, n = events.size(); i < n; ++i)
+		{
+			const SEvent& event = events[i];
+			if (event.parent != 0)
+				continue;
+
+			size_t phase = 0;
+			while (phase < phases.size() && phases[phase].first != event.name)
+				++phase;
+			if (phase == phases.size())
+				phases.push_back(std::make_pair(event.name, (int64)0));
+			phases[phase].second += event.end - event.begin;
+		}
+
+		const SFileVersion& version = gEnv->pSystem->GetFileVersion();
+
+		string line;
+		line.Format("capture=%s build=%d total=%d", captureName.c_str(), version.v[0], (int)(events[0].end / 1000));
+		for (size_t i = 0, n = phases.size(); i < n; ++i)
+		{
+			string phaseName = phases[i].first;
+			phaseName.replace(' ', '_');
+			line += string().Format(" %s=%d", phaseName.c_str(), (int)(phases[i].second / 1000));
+		}
+		line += "\n";
+
+		pTelemetry->AppendStringToFile(k_telemetryFile, line.c_str());
+	}
+}
+
+//------------------------------------------------------------------------
+CLoadTimeline::CScope::CScope(const char* name, int parent)
+	: m_index(kNoScope)
+	, m_previous(kNoScope)
+	, m_capture(0)
+{
+	if (!s_capturing)
+		return;
+
+	CryAutoCriticalSection lock(s_lock);
+	if (!s_capturing)
+		return;
+
+	SThreadScope& thread = GetThreadScope(CryGetCurrentThreadId());
+	if (parent == kNoScope || parent >= (int)s_events.size())
+		parent = thread.current;
+
+	SEvent event;
+	event.name = name;
+	event.begin = GetCaptureTime();
+	event.end = -1;
+	event.threadId = thread.threadId;
+	event.parent = parent;
+	event.depth = (parent != kNoScope) ? s_events[parent].depth + 1 : 0;
+
+	m_index = (int)s_events.size();
+	m_previous = thread.current;
+	m_capture = s_capture;
+
+	s_events.push_back(event);
+	thread.current = m_index;
+}
+
+//------------------------------------------------------------------------
+CLoadTimeline::CScope::~CScope()
+{
+	if (m_index == kNoScope)
+		return;
+
+	CryAutoCriticalSection lock(s_lock);
+	if (!s_capturing || m_capture != s_capture)
+		return;
+
+	s_events[m_index].end = GetCaptureTime();
+	GetThreadScope(CryGetCurrentThreadId()).current = m_previous;
+}
+
+//------------------------------------------------------------------------
+void CLoadTimeline::BeginCapture(const char* name)
+{
+	CryAutoCriticalSection lock(s_lock);
+
+	if (s_capturing)
+	{
+		CryLog("[LoadTimeline] Dropping unfinished capture '%s'", s_captureName.c_str());
+	}
+
+	s_events.clear();
+	s_threads.clear();
+	s_captureName = name;
+	s_captureStart = gEnv->pTimer->GetAsyncTime();
+	++s_capture;
+
+	// the capture itself is the root every scope of the main thread nests in
+	SEvent root;
+	root.name = name;
+	root.begin = 0;
+	root.end = -1;
+	root.threadId = CryGetCurrentThreadId();
+	root.parent = kNoScope;
+	root.depth = 0;
+	s_events.push_back(root);
+
+	GetThreadScope(root.threadId).current = 0;
+	s_capturing = true;
+}
+
+//------------------------------------------------------------------------
+void CLoadTimeline::EndCapture()
+{
+	TEvents events;
+	string captureName;
+
+	{
+		CryAutoCriticalSection lock(s_lock);
+		if (!s_capturing)
+			return;
+
+		// scopes still open, on threads that outlived the load, end with it
+		const int64 now = GetCaptureTime();
+		for (TEvents::iterator it = s_events.begin(), end = s_events.end(); it != end; ++it)
+		{
+			if (it->end < 0)
+				it->end = now;
+		}
+
+		events.swap(s_events);
+		captureName.swap(s_captureName);
+		s_threads.clear();
+		s_capturing = false;
+	}
+
+	CryLog("[LoadTimeline] '%s' took %.3f s over %d scopes", captureName.c_str(), events[0].end / 1000000.f, (int)events.size());
+
+	if (g_pGameCVars && g_pGameCVars->g_loadTimeline)
+	{
+		WriteTrace(captureName, events);
+	}
+
+	SubmitSummary(captureName, events);
+}
+
+//------------------------------------------------------------------------
+void CLoadTimeline::AbortCapture()
+{
+	CryAutoCriticalSection lock(s_lock);
+
+	stl::free_container(s_events);
+	s_threads.clear();
+	s_captureName.clear();
+	s_capturing = false;
+}
+
+//------------------------------------------------------------------------
+int CLoadTimeline::GetCurrentScope()
+{
+	if (!s_capturing)
+		return kNoScope;
+
+	CryAutoCriticalSection lock(s_lock);
+	return s_capturing ? GetThreadScope(CryGetCurrentThreadId()).current : kNoScope;
+}
+
+#else
+
+CLoadTimeline::CScope::CScope(const char* name, int parent) {}
+CLoadTimeline::CScope::~CScope() {}
+void CLoadTimeline::BeginCapture(const char* name) {}
+void CLoadTimeline::EndCapture() {}
+void CLoadTimeline::AbortCapture() {}
+int CLoadTimeline::GetCurrentScope() { return kNoScope; }
+
+#endif // LOAD_TIMELINE_ENABLED
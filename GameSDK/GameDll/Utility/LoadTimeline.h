@@ -0,0 +1,65 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+LoadTimeline.h
+
+Description:
+- hierarchical timers for the game side phases of the startup and of
+	each level load
+- a scope nests inside the one open on its thread, or inside an explicit
+	parent for work handed to other threads
+- each capture can be written as a Chrome trace (chrome://tracing or
+	Perfetto) to %USER%/LoadTimelines, and its top level phases are sent
+	as one line through the telemetry collector
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#ifndef __LOADTIMELINE_H__
+#define __LOADTIMELINE_H__
+
+#if !defined(_RELEASE) || defined(DEDICATED_SERVER)
+#define LOAD_TIMELINE_ENABLED		(1)
+#else
+#define LOAD_TIMELINE_ENABLED		(0)
+#endif
+
+class CLoadTimeline
+{
+public:
+	enum { kNoScope = -1 };
+
+	// Outside of a capture a scope costs a flag test
+	class CScope
+	{
+	public:
+		explicit CScope(const char* name, int parent = kNoScope);
+		~CScope();
+
+	private:
+		int m_index;
+		int m_previous;
+		uint32 m_capture;
+	};
+
+	// Starting a capture drops one left unfinished, by a load that failed
+	static void BeginCapture(const char* name);
+	static void EndCapture();
+	static void AbortCapture();
+
+	// The scope open on the calling thread, to pass to the jobs it starts on other threads
+	static int GetCurrentScope();
+};
+
+#if LOAD_TIMELINE_ENABLED
+#define LOAD_TIMELINE_SCOPE(name) CLoadTimeline::CScope loadTimelineScope(name)
+#define LOAD_TIMELINE_SCOPE_CHILD(name, parent) CLoadTimeline::CScope loadTimelineScope(name, parent)
+#else
+#define LOAD_TIMELINE_SCOPE(name)
+#define LOAD_TIMELINE_SCOPE_CHILD(name, parent)
+#endif
+
+#endif // __LOADTIMELINE_H__
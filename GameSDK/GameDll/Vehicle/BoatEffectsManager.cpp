@@ -0,0 +1,167 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Wake and spray effects of all boats
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#include "StdAfx.h"
+#include "BoatEffectsManager.h"
+#include "Game.h"
+#include "GameCVars.h"
+#include "VehicleMovementStdBoat.h"
+#include "Environment/WaterQueryCache.h"
+#include "Utility/CryWatch.h"
+
+namespace
+{
+	// boats the camera can't see only keep their effects up close
+	const float kInvisibleCullDistance = 50.f;
+}
+
+//------------------------------------------------------------------------
+CBoatEffectsManager::CBoatEffectsManager()
+: m_numRequested(0)
+, m_numCulled(0)
+, m_requestedSpawn(0.f)
+, m_throttle(1.f)
+{
+}
+
+//------------------------------------------------------------------------
+void CBoatEffectsManager::RegisterBoat(CVehicleMovementStdBoat* pBoat)
+{
+	if (std::find(m_boats.begin(), m_boats.end(), pBoat) == m_boats.end())
+	{
+		m_boats.push_back(pBoat);
+	}
+}
+
+//------------------------------------------------------------------------
+void CBoatEffectsManager::UnregisterBoat(CVehicleMovementStdBoat* pBoat)
+{
+	TBoats::iterator it = std::find(m_boats.begin(), m_boats.end(), pBoat);
+	if (it != m_boats.end())
+	{
+		*it = m_boats.back();
+		m_boats.pop_back();
+	}
+}
+
+//------------------------------------------------------------------------
+void CBoatEffectsManager::Update(float frameTime)
+{
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
+	m_params.clear();
+	m_samplePositions.clear();
+	m_numRequested = 0;
+	m_numCulled = 0;
+	m_requestedSpawn = 0.f;
+	m_throttle = 1.f;
+
+	const CCamera& camera = gEnv->pRenderer->GetCamera();
+	const Vec3 cameraPos = camera.GetPosition();
+	const float invTanHalfFov = 1.f / max(tan_tpl(0.5f * camera.GetFov()), 0.01f);
+	const float maxDistanceSq = sqr(g_pGameCVars->v_boatEffectsMaxDistance);
+	const float minScreenSize = g_pGameCVars->v_boatEffectsMinScreenSize;
+
+	// Gather the boats that updated this frame and cull them
+	for (TBoats::const_iterator it = m_boats.begin(), itEnd = m_boats.end(); it != itEnd; ++it)
+	{
+		SWakeParams params;
+		if (!(*it)->BeginWakeUpdate(params))
+			continue;
+
+		++m_numRequested;
+
+		params.pBoat = *it;
+		params.distanceSq = params.worldTM.GetTranslation().GetSquaredDistance(cameraPos);
+
+		// fraction of the screen height the boat covers
+		const float screenSize = params.radius * invTanHalfFov / max(sqrt_tpl(params.distanceSq), 1.f);
+
+		if (params.distanceSq > maxDistanceSq || (!params.visible && params.distanceSq > sqr(kInvisibleCullDistance)) || screenSize < minScreenSize)
+		{
+			++m_numCulled;
+			continue;
+		}
+
+		params.detail = (minScreenSize > 0.f) ? min(1.f, screenSize / (4.f * minScreenSize)) : 1.f;
+		params.firstSample = (int)m_samplePositions.size();
+		params.pBoat->GatherWakeSamples(m_samplePositions);
+		params.numSamples = (int)m_samplePositions.size() - params.firstSample;
+
+		m_params.push_back(params);
+	}
+
+	const int numSamples = (int)m_samplePositions.size();
+	if (numSamples > 0)
+	{
+		// One water query for every emitter of the fleet
+		m_waterLevels.resize(numSamples);
+		m_emissions.assign(numSamples, SWakeEmission());
+		g_pGame->GetWaterQueryCache()->QueryHeights(&m_samplePositions[0], &m_waterLevels[0], numSamples, CWaterQueryCache::eWQ_Vehicle);
+
+		for (std::vector<SWakeParams>::const_iterator it = m_params.begin(), itEnd = m_params.end(); it != itEnd; ++it)
+		{
+			m_requestedSpawn += it->pBoat->ComputeWakeEmission(*it, &m_waterLevels[it->firstSample], &m_emissions[it->firstSample]);
+		}
+
+		// Over budget every boat spawns proportionally less, so nothing pops in or out
+		const float budget = g_pGameCVars->v_boatEffectsBudget;
+		if (budget > 0.f && m_requestedSpawn > budget)
+		{
+			m_throttle = budget / m_requestedSpawn;
+		}
+
+		for (std::vector<SWakeParams>::const_iterator it = m_params.begin(), itEnd = m_params.end(); it != itEnd; ++it)
+		{
+			it->pBoat->ApplyWakeEffects(*it, &m_waterLevels[it->firstSample], &m_emissions[it->firstSample], m_throttle);
+		}
+	}
+
+	if (g_pGameCVars->v_boatEffectsDebug)
+	{
+		UpdateDebug();
+	}
+}
+
+//------------------------------------------------------------------------
+void CBoatEffectsManager::Reset()
+{
+	m_params.clear();
+	m_samplePositions.clear();
+	m_waterLevels.clear();
+	m_emissions.clear();
+
+	m_numRequested = 0;
+	m_numCulled = 0;
+	m_requestedSpawn = 0.f;
+	m_throttle = 1.f;
+}
+
+//------------------------------------------------------------------------
+void CBoatEffectsManager::UpdateDebug()
+{
+	CryWatch("BoatEffects: %d boats, %d updated, %d culled, %d emitters", (int)m_boats.size(), m_numRequested, m_numCulled,
+		(int)m_samplePositions.size() - (int)m_params.size());
+	CryWatch("BoatEffects: spawn %.1f of %.1f budget, throttle %.2f", m_requestedSpawn, g_pGameCVars->v_boatEffectsBudget, m_throttle);
+}
+
+//------------------------------------------------------------------------
+void CBoatEffectsManager::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->Add(*this);
+	pSizer->AddContainer(m_boats);
+	pSizer->AddContainer(m_params);
+	pSizer->AddContainer(m_samplePositions);
+	pSizer->AddContainer(m_waterLevels);
+	pSizer->AddContainer(m_emissions);
+}
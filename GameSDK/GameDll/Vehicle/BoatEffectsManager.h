@@ -0,0 +1,87 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Wake and spray effects of all boats, updated as one batch.
+	Boats ask for an update from their own update, once a frame the
+	manager culls them by distance and screen size, queries the water
+	under all their emitters at once and scales the spawn rate of the
+	whole fleet down to a global particle budget.
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#ifndef __BOATEFFECTSMANAGER_H__
+#define __BOATEFFECTSMANAGER_H__
+
+#if _MSC_VER > 1000
+# pragma once
+#endif
+
+class CVehicleMovementStdBoat;
+
+class CBoatEffectsManager
+{
+public:
+	// Per boat data for one frame
+	struct SWakeParams
+	{
+		SWakeParams() : pBoat(NULL), radius(0.f), distanceSq(0.f), detail(1.f), firstSample(0), numSamples(0), visible(false) {}
+
+		CVehicleMovementStdBoat* pBoat;
+		Matrix34 worldTM;
+		float radius;
+		float distanceSq;
+		float detail;					// spawn scale from screen size, 0..1
+		int firstSample;
+		int numSamples;
+		bool visible;
+	};
+
+	// Per emitter result, filled by the boat before the budget is applied
+	struct SWakeEmission
+	{
+		SWakeEmission() : countScale(0.f), sizeScale(1.f), speedScale(1.f), speed(0.f), inWater(false) {}
+
+		float countScale;
+		float sizeScale;
+		float speedScale;
+		float speed;
+		bool inWater;
+	};
+
+	CBoatEffectsManager();
+
+	void RegisterBoat(CVehicleMovementStdBoat* pBoat);
+	void UnregisterBoat(CVehicleMovementStdBoat* pBoat);
+
+	// Main thread, once per frame after the entities have been updated
+	void Update(float frameTime);
+	void Reset();
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+private:
+	void UpdateDebug();
+
+	typedef std::vector<CVehicleMovementStdBoat*> TBoats;
+	TBoats m_boats;
+
+	// rebuilt every frame
+	std::vector<SWakeParams> m_params;
+	std::vector<Vec3> m_samplePositions;
+	std::vector<float> m_waterLevels;
+	std::vector<SWakeEmission> m_emissions;
+
+	// last frame, for the debug output
+	int m_numRequested;
+	int m_numCulled;
+	float m_requestedSpawn;
+	float m_throttle;
+};
+
+#endif // __BOATEFFECTSMANAGER_H__
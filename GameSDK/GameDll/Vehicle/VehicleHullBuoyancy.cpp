@@ -0,0 +1,470 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Multi-point hull buoyancy for boats
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+#include "StdAfx.h"
+#include "CryUnitTest.h"
+#include "Game.h"
+#include "IVehicleSystem.h"
+#include "Vehicle/VehicleHullBuoyancy.h"
+#include "Environment/WaterQueryCache.h"
+#include "Utility/BenchmarkTimer.h"
+
+namespace
+{
+	const float kGravity = 9.81f;
+
+	struct SLodSortEntry
+	{
+		bool operator<(const SLodSortEntry& other) const { return lod < other.lod; }
+
+		Vec3 pos;
+		float volume;
+		float invHeight;
+		uint8 lod;
+	};
+}
+
+//------------------------------------------------------------------------
+CVehicleHullBuoyancy::CVehicleHullBuoyancy()
+: m_lod(eLod_High)
+, m_totalVolume(0.f)
+, m_waterDensity(1000.f)
+, m_linearDamping(0.5f)
+, m_angularDamping(1.f)
+, m_lodMediumDistance(250.f)
+, m_lodHighDistance(80.f)
+, m_replacePhysicsBuoyancy(true)
+{
+	for (int i = 0; i < eLod_Count; ++i)
+	{
+		m_lodCounts[i] = 0;
+		m_lodVolumeScale[i] = 1.f;
+	}
+}
+
+//------------------------------------------------------------------------
+bool CVehicleHullBuoyancy::Init(const CVehicleParams& table)
+{
+	CVehicleParams pointsTable = table.findChild("HullPoints");
+	if (!pointsTable)
+		return false;
+
+	pointsTable.getAttr("waterDensity", m_waterDensity);
+	pointsTable.getAttr("linearDamping", m_linearDamping);
+	pointsTable.getAttr("angularDamping", m_angularDamping);
+	pointsTable.getAttr("lodMediumDistance", m_lodMediumDistance);
+	pointsTable.getAttr("lodHighDistance", m_lodHighDistance);
+	pointsTable.getAttr("replacePhysicsBuoyancy", m_replacePhysicsBuoyancy);
+
+	const int numPoints = pointsTable.getChildCount();
+	for (int i = 0; i < numPoints; ++i)
+	{
+		CVehicleParams pointTable = pointsTable.getChild(i);
+
+		Vec3 pos(ZERO);
+		float volume = 0.f;
+		float height = 1.f;
+		int lod = eLod_Low;
+
+		if (!pointTable.getAttr("pos", pos) || !pointTable.getAttr("volume", volume))
+		{
+			GameWarning("[CVehicleHullBuoyancy]: hull point %d needs a pos and a volume", i);
+			continue;
+		}
+
+		pointTable.getAttr("height", height);
+		pointTable.getAttr("lod", lod);
+
+		AddPoint(pos, volume, height, (ELod)clamp(lod, (int)eLod_Low, (int)eLod_High));
+	}
+
+	SortByLod();
+
+	return IsEnabled();
+}
+
+//------------------------------------------------------------------------
+void CVehicleHullBuoyancy::InitBox(const AABB& bounds, int pointsPerSide)
+{
+	pointsPerSide = max(pointsPerSide, 2);
+
+	const Vec3 size = bounds.GetSize();
+	const float volume = size.x * size.y * size.z / (float)sqr(pointsPerSide);
+	const float z = bounds.min.z + 0.5f * size.z;
+
+	for (int i = 0; i < pointsPerSide; ++i)
+	{
+		for (int j = 0; j < pointsPerSide; ++j)
+		{
+			const bool corner = (i == 0 || i == pointsPerSide - 1) && (j == 0 || j == pointsPerSide - 1);
+			const bool even = ((i & 1) == 0) && ((j & 1) == 0);
+			const ELod lod = corner ? eLod_Low : (even ? eLod_Medium : eLod_High);
+
+			const Vec3 pos(
+				bounds.min.x + size.x * (i + 0.5f) / pointsPerSide,
+				bounds.min.y + size.y * (j + 0.5f) / pointsPerSide,
+				z);
+
+			AddPoint(pos, volume, size.z, lod);
+		}
+	}
+
+	SortByLod();
+}
+
+//------------------------------------------------------------------------
+void CVehicleHullBuoyancy::AddPoint(const Vec3& localPos, float volume, float height, ELod lod)
+{
+	m_px.push_back(localPos.x);
+	m_py.push_back(localPos.y);
+	m_pz.push_back(localPos.z);
+	m_volume.push_back(max(volume, 0.f));
+	m_invHeight.push_back(1.f / max(height, 0.01f));
+	m_pointLod.push_back((uint8)lod);
+}
+
+//------------------------------------------------------------------------
+void CVehicleHullBuoyancy::SortByLod()
+{
+	// Points are ordered by lod so every level is a prefix of the streams
+	const int numPoints = m_px.size();
+
+	std::vector<SLodSortEntry> entries(numPoints);
+	for (int i = 0; i < numPoints; ++i)
+	{
+		entries[i].pos.Set(m_px[i], m_py[i], m_pz[i]);
+		entries[i].volume = m_volume[i];
+		entries[i].invHeight = m_invHeight[i];
+		entries[i].lod = m_pointLod[i];
+	}
+
+	std::stable_sort(entries.begin(), entries.end());
+
+	m_totalVolume = 0.f;
+	float lodVolume[eLod_Count] = { 0.f };
+
+	for (int i = 0; i < numPoints; ++i)
+	{
+		const SLodSortEntry& entry = entries[i];
+		m_px[i] = entry.pos.x;
+		m_py[i] = entry.pos.y;
+		m_pz[i] = entry.pos.z;
+		m_volume[i] = entry.volume;
+		m_invHeight[i] = entry.invHeight;
+		m_pointLod[i] = entry.lod;
+
+		m_totalVolume += entry.volume;
+		for (int lod = entry.lod; lod < eLod_Count; ++lod)
+			lodVolume[lod] += entry.volume;
+	}
+
+	// Coarser levels carry the volume of the points they skip
+	for (int lod = 0; lod < eLod_Count; ++lod)
+	{
+		m_lodCounts[lod] = 0;
+		for (int i = 0; i < numPoints && m_pointLod[i] <= lod; ++i)
+			++m_lodCounts[lod];
+
+		m_lodVolumeScale[lod] = lodVolume[lod] > 0.f ? m_totalVolume / lodVolume[lod] : 1.f;
+	}
+
+	m_worldPos.resize(numPoints);
+	m_waterHeight.resize(numPoints);
+}
+
+//------------------------------------------------------------------------
+CVehicleHullBuoyancy::ELod CVehicleHullBuoyancy::SelectLod(float distanceSq, bool visible) const
+{
+	if (!visible || distanceSq > sqr(m_lodMediumDistance))
+		return eLod_Low;
+
+	if (distanceSq > sqr(m_lodHighDistance))
+		return eLod_Medium;
+
+	return eLod_High;
+}
+
+//------------------------------------------------------------------------
+void CVehicleHullBuoyancy::Integrate(const SHullState& state, float frameTime, SHullImpulse& result, TWaterHeightFunc pWaterHeightFunc, void* pUserData)
+{
+	result = SHullImpulse();
+
+	int lod = m_lod;
+	while (lod < eLod_High && m_lodCounts[lod] < 3)
+		++lod;
+
+	const int numPoints = m_lodCounts[lod];
+	if (numPoints <= 0 || m_totalVolume <= 0.f || state.mass <= 0.f)
+		return;
+
+	const Matrix33 rot(state.q);
+
+	// Transform the points into world space in one pass, then fetch all water heights in one call
+	Vec3* pWorldPos = &m_worldPos[0];
+	float* pWaterHeight = &m_waterHeight[0];
+	const float* px = &m_px[0];
+	const float* py = &m_py[0];
+	const float* pz = &m_pz[0];
+
+	for (int i = 0; i < numPoints; ++i)
+	{
+		pWorldPos[i] = state.pos + rot * Vec3(px[i], py[i], pz[i]);
+	}
+
+	pWaterHeightFunc(pWorldPos, pWaterHeight, numPoints, pUserData);
+
+	const float* pVolume = &m_volume[0];
+	const float* pInvHeight = &m_invHeight[0];
+	const float volumeScale = m_lodVolumeScale[lod];
+	const float buoyancyPerVolume = m_waterDensity * kGravity * volumeScale;
+	const float dampingPerVolume = m_linearDamping * state.mass * volumeScale / m_totalVolume;
+
+	Vec3 force(ZERO);
+	Vec3 torque(ZERO);
+	float buoyancy = 0.f;
+	float submergedVolume = 0.f;
+
+	for (int i = 0; i < numPoints; ++i)
+	{
+		const float ratio = clamp((pWaterHeight[i] - pWorldPos[i].z) * pInvHeight[i] + 0.5f, 0.f, 1.f);
+		if (ratio <= 0.f)
+			continue;
+
+		const float volume = pVolume[i] * ratio;
+		const Vec3 arm = pWorldPos[i] - state.centerOfMass;
+		const Vec3 pointVel = state.v + state.w.Cross(arm);
+
+		const Vec3 pointForce(
+			-pointVel.x * dampingPerVolume * volume,
+			-pointVel.y * dampingPerVolume * volume,
+			-pointVel.z * dampingPerVolume * volume + buoyancyPerVolume * volume);
+
+		force += pointForce;
+		torque += arm.Cross(pointForce);
+		buoyancy += buoyancyPerVolume * volume;
+		submergedVolume += volume;
+	}
+
+	result.numSamples = numPoints;
+	result.submergedFraction = min(1.f, submergedVolume * volumeScale / m_totalVolume);
+
+	if (submergedVolume <= 0.f)
+		return;
+
+	// When the physics buoyancy stays active only the wave response torque is added on top of it
+	if (!m_replacePhysicsBuoyancy)
+		force.z -= buoyancy;
+
+	// Roll and pitch damping, in vehicle space
+	const Vec3 localW = state.w * rot;
+	const Vec3 localDamp(
+		-localW.x * state.inertia.x * m_angularDamping * result.submergedFraction,
+		-localW.y * state.inertia.y * m_angularDamping * result.submergedFraction,
+		0.f);
+
+	torque += rot * localDamp;
+
+	result.impulse = force * frameTime;
+	result.angImpulse = torque * frameTime;
+}
+
+//------------------------------------------------------------------------
+void CVehicleHullBuoyancy::GetWaterHeights(const Vec3* pPositions, float* pHeights, int count, void* pUserData)
+{
+	g_pGame->GetWaterQueryCache()->QueryHeights(pPositions, pHeights, count, CWaterQueryCache::eWQ_Vehicle);
+}
+
+//------------------------------------------------------------------------
+namespace
+{
+	struct SBenchSwell
+	{
+		float time;
+	};
+
+	void GetBenchSwellHeights(const Vec3* pPositions, float* pHeights, int count, void* pUserData)
+	{
+		const float t = static_cast<SBenchSwell*>(pUserData)->time;
+		for (int i = 0; i < count; ++i)
+		{
+			const Vec3& p = pPositions[i];
+			pHeights[i] = 0.8f * sinf(0.08f * p.x + 0.05f * p.y + 0.9f * t) + 0.3f * sinf(0.21f * p.y - 1.7f * t);
+		}
+	}
+
+	// Synthetic 40 m hulls on the swell, shared by the benchmark and the unit tests
+	struct SBenchHulls
+	{
+		static const float kStepTime;
+
+		SBenchHulls(int numShips, CVehicleHullBuoyancy::ELod lod)
+			: hulls(numShips)
+			, states(numShips)
+		{
+			const float mass = 1000000.f;
+			const AABB hullBounds(Vec3(-5.f, -20.f, -3.f), Vec3(5.f, 20.f, 3.f));
+			const Vec3 size = hullBounds.GetSize();
+
+			swell.time = 0.f;
+
+			for (int s = 0; s < numShips; ++s)
+			{
+				hulls[s].InitBox(hullBounds, 8);
+				hulls[s].SetLod(lod);
+
+				CVehicleHullBuoyancy::SHullState& state = states[s];
+				state.pos.Set(60.f * (s % 8), 60.f * (s / 8), 0.f);
+				state.q = Quat::CreateRotationY(0.1f);
+				state.v.zero();
+				state.w.zero();
+				state.mass = mass;
+				state.inertia.Set(
+					mass * (sqr(size.y) + sqr(size.z)) / 12.f,
+					mass * (sqr(size.x) + sqr(size.z)) / 12.f,
+					mass * (sqr(size.x) + sqr(size.y)) / 12.f);
+			}
+		}
+
+		// One step of every hull, with a plain rigid body step standing in for the physics
+		void Step()
+		{
+			swell.time += kStepTime;
+
+			for (int s = 0, numShips = (int)hulls.size(); s < numShips; ++s)
+			{
+				CVehicleHullBuoyancy::SHullState& state = states[s];
+				state.centerOfMass = state.pos;
+
+				CVehicleHullBuoyancy::SHullImpulse impulse;
+				hulls[s].Integrate(state, kStepTime, impulse, &GetBenchSwellHeights, &swell);
+
+				state.v += impulse.impulse / state.mass;
+				state.v.z -= kGravity * kStepTime;
+				state.pos += state.v * kStepTime;
+
+				const Matrix33 rot(state.q);
+				Vec3 localW = state.w * rot;
+				const Vec3 localAngImp = impulse.angImpulse * rot;
+				localW.x += localAngImp.x / state.inertia.x;
+				localW.y += localAngImp.y / state.inertia.y;
+				localW.z += localAngImp.z / state.inertia.z;
+				state.w = rot * localW;
+
+				const float angle = state.w.GetLength() * kStepTime;
+				if (angle > 0.0001f)
+				{
+					state.q = Quat::CreateRotationAA(angle, state.w.GetNormalized()) * state.q;
+					state.q.Normalize();
+				}
+			}
+		}
+
+		std::vector<CVehicleHullBuoyancy> hulls;
+		std::vector<CVehicleHullBuoyancy::SHullState> states;
+		SBenchSwell swell;
+	};
+
+	const float SBenchHulls::kStepTime = 1.f / 30.f;
+}
+
+void CVehicleHullBuoyancy::RunBenchmark(int numShips, int numSteps)
+{
+	numShips = max(numShips, 1);
+	numSteps = max(numSteps, 1);
+
+	for (int lod = eLod_Low; lod < eLod_Count; ++lod)
+	{
+		SBenchHulls bench(numShips, (ELod)lod);
+
+		if (lod == eLod_Low)
+		{
+			const CVehicleHullBuoyancy& hull = bench.hulls[0];
+			CryLog("[v_boatHullBench] %d ships, %d steps, %d/%d/%d points per lod", numShips, numSteps,
+				hull.GetNumSamples(eLod_Low), hull.GetNumSamples(eLod_Medium), hull.GetNumSamples(eLod_High));
+		}
+
+		CBenchmarkTimer timer;
+		for (int step = 0; step < numSteps; ++step)
+		{
+			timer.Start();
+			bench.Step();
+			timer.Stop();
+		}
+
+		static const char* lodNames[eLod_Count] = { "low", "medium", "high" };
+		CryLog("[v_boatHullBench]   lod %-6s: %.2f ms total, %.2f us per ship step, worst step %.3f ms",
+			lodNames[lod], timer.GetTotalMs(), 1000.f * timer.GetAverageMs() / numShips, timer.GetWorstMs());
+	}
+}
+
+//------------------------------------------------------------------------
+void CVehicleHullBuoyancy::GetMemoryUsage(ICrySizer* pSizer) const
+{
+	pSizer->AddContainer(m_px);
+	pSizer->AddContainer(m_py);
+	pSizer->AddContainer(m_pz);
+	pSizer->AddContainer(m_volume);
+	pSizer->AddContainer(m_invHeight);
+	pSizer->AddContainer(m_pointLod);
+	pSizer->AddContainer(m_worldPos);
+	pSizer->AddContainer(m_waterHeight);
+}
+
+//------------------------------------------------------------------------
+CRY_UNIT_TEST_SUITE(CryVehicleHullBuoyancyTest)
+{
+	// Every lod keeps a hull afloat on the swell, and the cheaper ones move it about like the full point set does
+	CRY_UNIT_TEST(LodsFloatLikeTheFullHull)
+	{
+		const int numSteps = 600;
+		float heave[CVehicleHullBuoyancy::eLod_Count];
+		float roll[CVehicleHullBuoyancy::eLod_Count];
+
+		for (int lod = CVehicleHullBuoyancy::eLod_Low; lod < CVehicleHullBuoyancy::eLod_Count; ++lod)
+		{
+			SBenchHulls bench(1, (CVehicleHullBuoyancy::ELod)lod);
+			const CVehicleHullBuoyancy::SHullState& state = bench.states[0];
+
+			float minZ = FLT_MAX, maxZ = -FLT_MAX, maxRoll = 0.f;
+			bool stable = true;
+
+			for (int step = 0; step < numSteps; ++step)
+			{
+				bench.Step();
+
+				stable = stable && state.pos.IsValid() && state.q.IsValid() && (fabs_tpl(state.pos.z) < 10.f);
+
+				// measured once the hull had half the run to settle
+				if (step >= numSteps / 2)
+				{
+					minZ = min(minZ, state.pos.z);
+					maxZ = max(maxZ, state.pos.z);
+					maxRoll = max(maxRoll, fabs_tpl(Ang3(state.q).y));
+				}
+			}
+
+			CRY_UNIT_TEST_ASSERT(stable);
+			heave[lod] = maxZ - minZ;
+			roll[lod] = maxRoll;
+		}
+
+		const float fullHeave = heave[CVehicleHullBuoyancy::eLod_High];
+		const float fullRoll = roll[CVehicleHullBuoyancy::eLod_High];
+		CRY_UNIT_TEST_ASSERT(fullHeave > 0.f);
+
+		for (int lod = CVehicleHullBuoyancy::eLod_Low; lod < CVehicleHullBuoyancy::eLod_High; ++lod)
+		{
+			CRY_UNIT_TEST_ASSERT(fabs_tpl(heave[lod] - fullHeave) <= 0.5f * fullHeave + 0.1f);
+			CRY_UNIT_TEST_ASSERT(fabs_tpl(roll[lod] - fullRoll) <= 0.5f * fullRoll + DEG2RAD(2.f));
+		}
+	}
+}
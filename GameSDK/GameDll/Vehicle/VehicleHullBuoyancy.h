@@ -0,0 +1,117 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Multi-point hull buoyancy for boats. A set of hull sample
+	points, read from the vehicle xml, is evaluated as one batch against
+	the water height and integrated into a single impulse per step.
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+#ifndef __VEHICLEHULLBUOYANCY_H__
+#define __VEHICLEHULLBUOYANCY_H__
+
+#if _MSC_VER > 1000
+# pragma once
+#endif
+
+class CVehicleParams;
+
+class CVehicleHullBuoyancy
+{
+public:
+	// Sample density, points are tagged with the lowest level they are used at
+	enum ELod
+	{
+		eLod_Low = 0,
+		eLod_Medium,
+		eLod_High,
+		eLod_Count
+	};
+
+	struct SHullState
+	{
+		Vec3 pos;
+		Quat q;
+		Vec3 v;
+		Vec3 w;
+		Vec3 centerOfMass;   // world space
+		Vec3 inertia;        // local space diagonal
+		float mass;
+	};
+
+	struct SHullImpulse
+	{
+		SHullImpulse() : impulse(ZERO), angImpulse(ZERO), submergedFraction(0.f), numSamples(0) {}
+
+		Vec3 impulse;
+		Vec3 angImpulse;
+		float submergedFraction;
+		int numSamples;
+	};
+
+	// Fills pHeights with the water height at each of the given world positions
+	typedef void (*TWaterHeightFunc)(const Vec3* pPositions, float* pHeights, int count, void* pUserData);
+
+	CVehicleHullBuoyancy();
+
+	// Reads the <HullPoints> child of the movement params. Returns false if the vehicle has none
+	bool Init(const CVehicleParams& table);
+	// Builds a box shaped point set, used by the benchmark
+	void InitBox(const AABB& bounds, int pointsPerSide);
+
+	bool IsEnabled() const { return !m_px.empty(); }
+	bool ReplacesPhysicsBuoyancy() const { return m_replacePhysicsBuoyancy; }
+
+	void SetLod(ELod lod) { m_lod = lod; }
+	ELod GetLod() const { return m_lod; }
+	ELod SelectLod(float distanceSq, bool visible) const;
+	int GetNumSamples(ELod lod) const { return m_lodCounts[lod]; }
+
+	// NOTE: called from the physics thread, the owner is responsible for the locking
+	void Integrate(const SHullState& state, float frameTime, SHullImpulse& result, TWaterHeightFunc pWaterHeightFunc = &GetWaterHeights, void* pUserData = NULL);
+
+	static void GetWaterHeights(const Vec3* pPositions, float* pHeights, int count, void* pUserData);
+
+	// Runs the solver for numShips ships against an analytic swell without any physics or rendering,
+	// and logs the cost per ship. CryVehicleHullBuoyancyTest checks how the hulls float
+	static void RunBenchmark(int numShips, int numSteps);
+
+	void GetMemoryUsage(ICrySizer* pSizer) const;
+
+private:
+	typedef std::vector<float> TFloats;
+
+	void AddPoint(const Vec3& localPos, float volume, float height, ELod lod);
+	void SortByLod();
+
+	// Hull points in vehicle space, stored as separate streams so the transform and force loops run over contiguous data
+	TFloats m_px;
+	TFloats m_py;
+	TFloats m_pz;
+	TFloats m_volume;
+	TFloats m_invHeight;
+	std::vector<uint8> m_pointLod;
+
+	// Per step scratch
+	std::vector<Vec3> m_worldPos;
+	TFloats m_waterHeight;
+
+	int m_lodCounts[eLod_Count];
+	float m_lodVolumeScale[eLod_Count];
+	ELod m_lod;
+
+	float m_totalVolume;
+	float m_waterDensity;
+	float m_linearDamping;
+	float m_angularDamping;
+	float m_lodMediumDistance;
+	float m_lodHighDistance;
+	bool m_replacePhysicsBuoyancy;
+};
+
+#endif // __VEHICLEHULLBUOYANCY_H__
@@ -0,0 +1,124 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Update rate of vehicle movements on dedicated servers
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#include "StdAfx.h"
+#include "VehicleServerLod.h"
+#include "GameCVars.h"
+#include "Utility/CryWatch.h"
+#include "IActorSystem.h"
+
+namespace
+{
+	enum { kMaxPlayers = 64 };
+
+	Vec3 s_playerPositions[kMaxPlayers];
+	int s_numPlayers = 0;
+	uint32 s_frameId = 0;
+
+	// counts of the frame being updated, and of the last complete one
+	struct SCounters
+	{
+		int updates;
+		int skippedUpdates;
+		int netSends;
+		int skippedNetSends;
+	};
+
+	SCounters s_counters;
+	SCounters s_lastFrame;
+
+	// totals over the last complete second, logged on servers with v_serverLodStats 2
+	SCounters s_window;
+	float s_windowTimer = 0.f;
+}
+
+//------------------------------------------------------------------------
+void SVehicleServerLod::Update(float frameTime)
+{
+	++s_frameId;
+
+	s_lastFrame = s_counters;
+	memset(&s_counters, 0, sizeof(s_counters));
+
+	s_window.updates += s_lastFrame.updates;
+	s_window.skippedUpdates += s_lastFrame.skippedUpdates;
+	s_window.netSends += s_lastFrame.netSends;
+	s_window.skippedNetSends += s_lastFrame.skippedNetSends;
+
+	s_numPlayers = 0;
+	if (g_pGameCVars->v_serverLod && gEnv->bServer)
+	{
+		IActorSystem* pActorSystem = g_pGame->GetIGameFramework()->GetIActorSystem();
+		IActorIteratorPtr pIter = pActorSystem->CreateActorIterator();
+		while (IActor* pActor = pIter->Next())
+		{
+			if (pActor->IsPlayer() && s_numPlayers < kMaxPlayers)
+				s_playerPositions[s_numPlayers++] = pActor->GetEntity()->GetWorldPos();
+		}
+	}
+
+	const int stats = g_pGameCVars->v_serverLodStats;
+	if (stats == 1)
+	{
+		CryWatch("Vehicle server lod: %d updates, %d skipped, %d network sends, %d batched, %d players", s_lastFrame.updates, s_lastFrame.skippedUpdates, s_lastFrame.netSends, s_lastFrame.skippedNetSends, s_numPlayers);
+	}
+
+	s_windowTimer += frameTime;
+	if (s_windowTimer >= 1.f)
+	{
+		if (stats == 2)
+		{
+			CryLog("Vehicle server lod: %d updates, %d skipped, %d network sends, %d batched in %.2f s", s_window.updates, s_window.skippedUpdates, s_window.netSends, s_window.skippedNetSends, s_windowTimer);
+		}
+
+		memset(&s_window, 0, sizeof(s_window));
+		s_windowTimer = 0.f;
+	}
+}
+
+//------------------------------------------------------------------------
+uint32 SVehicleServerLod::GetFrameId()
+{
+	return s_frameId;
+}
+
+//------------------------------------------------------------------------
+bool SVehicleServerLod::IsRelevant(const Vec3& pos)
+{
+	const float radiusSq = sqr(g_pGameCVars->v_serverLodRelevance);
+	for (int i = 0; i < s_numPlayers; ++i)
+	{
+		if (s_playerPositions[i].GetSquaredDistance(pos) < radiusSq)
+			return true;
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------
+void SVehicleServerLod::RecordUpdate(bool skipped)
+{
+	if (skipped)
+		++s_counters.skippedUpdates;
+	else
+		++s_counters.updates;
+}
+
+//------------------------------------------------------------------------
+void SVehicleServerLod::RecordNetSend(bool skipped)
+{
+	if (skipped)
+		++s_counters.skippedNetSends;
+	else
+		++s_counters.netSends;
+}
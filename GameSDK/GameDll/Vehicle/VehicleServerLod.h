@@ -0,0 +1,37 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Update rate of vehicle movements on dedicated servers.
+	Nothing is presented there, and vehicles no player is close to
+	update only every few frames with the time of the skipped ones.
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#ifndef __VEHICLESERVERLOD_H__
+#define __VEHICLESERVERLOD_H__
+
+#if _MSC_VER > 1000
+# pragma once
+#endif
+
+struct SVehicleServerLod
+{
+	// Main thread, once per frame before the vehicles update, caches the player positions
+	static void Update(float frameTime);
+
+	static uint32 GetFrameId();
+
+	// Whether any player is within v_serverLodRelevance of pos
+	static bool IsRelevant(const Vec3& pos);
+
+	static void RecordUpdate(bool skipped);
+	static void RecordNetSend(bool skipped);
+};
+
+#endif // __VEHICLESERVERLOD_H__
@@ -0,0 +1,132 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Hand-over of vehicle movement state between the main thread
+	and the physics step
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#include "StdAfx.h"
+#include "VehicleThreadExchange.h"
+#include "GameCVars.h"
+#include "Utility/CryWatch.h"
+
+namespace
+{
+	struct SLockCounters
+	{
+		volatile LONG locks;
+		volatile LONG contended;
+		volatile LONG waitMicroseconds;
+	};
+
+	SLockCounters s_lockCounters[SVehicleSyncStats::eThread_Count];
+	volatile LONG s_publishes = 0;
+	volatile LONG s_acquires = 0;
+
+	// last complete window, per second
+	struct SLockRates
+	{
+		float locks;
+		float contended;
+		float waitMs;
+	};
+
+	SLockRates s_lockRates[SVehicleSyncStats::eThread_Count];
+	float s_publishRate = 0.f;
+	float s_acquireRate = 0.f;
+	float s_statsTimer = 0.f;
+
+	const char* s_threadNames[SVehicleSyncStats::eThread_Count] =
+	{
+		"main",
+		"physics",
+	};
+}
+
+volatile bool SVehicleSyncStats::s_enabled = false;
+
+//------------------------------------------------------------------------
+void SVehicleSyncStats::RecordLock(EThread thread, bool contended, float waitMs)
+{
+	SLockCounters& counters = s_lockCounters[thread];
+
+	CryInterlockedIncrement(&counters.locks);
+	if (contended)
+	{
+		CryInterlockedIncrement(&counters.contended);
+		CryInterlockedExchangeAdd(&counters.waitMicroseconds, (LONG)(waitMs * 1000.f));
+	}
+}
+
+//------------------------------------------------------------------------
+void SVehicleSyncStats::RecordPublish()
+{
+	CryInterlockedIncrement(&s_publishes);
+}
+
+//------------------------------------------------------------------------
+void SVehicleSyncStats::RecordAcquire()
+{
+	CryInterlockedIncrement(&s_acquires);
+}
+
+//------------------------------------------------------------------------
+void SVehicleSyncStats::Update(float frameTime)
+{
+	const bool enabled = (g_pGameCVars->v_vehicleSyncStats != 0);
+	if (enabled != s_enabled)
+	{
+		// Counts from before the cvar was last switched off would end up in the first window
+		for (int i = 0; i < eThread_Count; ++i)
+		{
+			SLockCounters& counters = s_lockCounters[i];
+			CryInterlockedExchange(&counters.locks, 0);
+			CryInterlockedExchange(&counters.contended, 0);
+			CryInterlockedExchange(&counters.waitMicroseconds, 0);
+			s_lockRates[i].locks = s_lockRates[i].contended = s_lockRates[i].waitMs = 0.f;
+		}
+
+		CryInterlockedExchange(&s_publishes, 0);
+		CryInterlockedExchange(&s_acquires, 0);
+		s_publishRate = s_acquireRate = 0.f;
+		s_statsTimer = 0.f;
+
+		s_enabled = enabled;
+	}
+
+	if (!enabled)
+		return;
+
+	s_statsTimer += frameTime;
+	if (s_statsTimer >= 1.f)
+	{
+		const float invTime = 1.f / s_statsTimer;
+
+		for (int i = 0; i < eThread_Count; ++i)
+		{
+			SLockCounters& counters = s_lockCounters[i];
+			s_lockRates[i].locks = CryInterlockedExchange(&counters.locks, 0) * invTime;
+			s_lockRates[i].contended = CryInterlockedExchange(&counters.contended, 0) * invTime;
+			s_lockRates[i].waitMs = CryInterlockedExchange(&counters.waitMicroseconds, 0) * 0.001f * invTime;
+		}
+
+		s_publishRate = CryInterlockedExchange(&s_publishes, 0) * invTime;
+		s_acquireRate = CryInterlockedExchange(&s_acquires, 0) * invTime;
+		s_statsTimer = 0.f;
+	}
+
+	for (int i = 0; i < eThread_Count; ++i)
+	{
+		const SLockRates& rates = s_lockRates[i];
+		CryWatch("Vehicle locks %s: %.0f/s, %.0f contended/s, %.3f ms/s waiting", s_threadNames[i], rates.locks, rates.contended, rates.waitMs);
+	}
+
+	CryWatch("Vehicle input exchange: %.0f published/s, %.0f picked up/s", s_publishRate, s_acquireRate);
+}
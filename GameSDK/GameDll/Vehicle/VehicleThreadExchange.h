@@ -0,0 +1,140 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Hand-over of vehicle movement state between the main thread
+	and the physics step. CVehicleStateExchange is a triple buffer: the
+	producer always has a buffer to write, the consumer always has the
+	latest complete one to read, and neither ever waits for the other.
+	The locks that remain are taken through CVehicleScopedLock, which
+	counts how often and how long they are waited for.
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#ifndef __VEHICLETHREADEXCHANGE_H__
+#define __VEHICLETHREADEXCHANGE_H__
+
+#if _MSC_VER > 1000
+# pragma once
+#endif
+
+//------------------------------------------------------------------------
+// Process wide counters, shown with v_vehicleSyncStats. Nothing is counted while the cvar is off
+struct SVehicleSyncStats
+{
+	enum EThread
+	{
+		eThread_Main = 0,
+		eThread_Physics,
+		eThread_Count
+	};
+
+	static bool IsEnabled() { return s_enabled; }
+
+	static void RecordLock(EThread thread, bool contended, float waitMs);
+	static void RecordPublish();
+	static void RecordAcquire();
+
+	// Main thread, once per frame
+	static void Update(float frameTime);
+
+private:
+	static volatile bool s_enabled;
+};
+
+//------------------------------------------------------------------------
+// Single producer, single consumer
+template <typename T>
+class CVehicleStateExchange
+{
+public:
+	CVehicleStateExchange()
+	: m_middle(1)
+	, m_back(0)
+	, m_front(2)
+	{
+	}
+
+	// Producer: the value becomes the latest state, replacing one the consumer hasn't picked up yet
+	void Publish(const T& value)
+	{
+		m_buffers[m_back] = value;
+		m_back = CryInterlockedExchange(&m_middle, m_back | kFresh) & kIndexMask;
+
+		if (SVehicleSyncStats::IsEnabled())
+			SVehicleSyncStats::RecordPublish();
+	}
+
+	// Consumer: returns false if nothing was published since the last call
+	bool Acquire()
+	{
+		if ((m_middle & kFresh) == 0)
+			return false;
+
+		m_front = CryInterlockedExchange(&m_middle, m_front) & kIndexMask;
+
+		if (SVehicleSyncStats::IsEnabled())
+			SVehicleSyncStats::RecordAcquire();
+		return true;
+	}
+
+	// Consumer: the state picked up by the last Acquire, stays valid until the next one
+	const T& Get() const { return m_buffers[m_front]; }
+
+private:
+	enum
+	{
+		kIndexMask = 3,
+		kFresh = 4,
+	};
+
+	T m_buffers[3];
+	volatile LONG m_middle;		// index of the buffer in between, and whether it is newer than the consumer's
+	LONG m_back;							// producer only
+	LONG m_front;							// consumer only
+};
+
+//------------------------------------------------------------------------
+class CVehicleScopedLock
+{
+public:
+	explicit CVehicleScopedLock(CryCriticalSection& lock)
+	: m_lock(lock)
+	{
+		if (!SVehicleSyncStats::IsEnabled())
+		{
+			m_lock.Lock();
+			return;
+		}
+
+		const SVehicleSyncStats::EThread thread = (CryGetCurrentThreadId() == gEnv->mMainThreadId) ? SVehicleSyncStats::eThread_Main : SVehicleSyncStats::eThread_Physics;
+
+		if (m_lock.TryLock())
+		{
+			SVehicleSyncStats::RecordLock(thread, false, 0.f);
+			return;
+		}
+
+		const CTimeValue start = gEnv->pTimer->GetAsyncTime();
+		m_lock.Lock();
+		SVehicleSyncStats::RecordLock(thread, true, (gEnv->pTimer->GetAsyncTime() - start).GetMilliSeconds());
+	}
+
+	~CVehicleScopedLock()
+	{
+		m_lock.Unlock();
+	}
+
+private:
+	CVehicleScopedLock(const CVehicleScopedLock&);
+	CVehicleScopedLock& operator=(const CVehicleScopedLock&);
+
+	CryCriticalSection& m_lock;
+};
+
+#endif // __VEHICLETHREADEXCHANGE_H__
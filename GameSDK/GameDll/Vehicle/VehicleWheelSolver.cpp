@@ -0,0 +1,549 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Wheel friction solver of the arcade wheeled movement
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#include "StdAfx.h"
+#include "CryUnitTest.h"
+#include "VehicleWheelSolver.h"
+#include "Utility/BenchmarkTimer.h"
+
+namespace
+{
+	// Lower bound of the velocity response at a contact. The padding lanes of a chassis without mass
+	// have none at all, and their gains must stay finite so the masked lanes still add exactly nothing
+	const float kMinResponse = 1e-6f;
+}
+
+//------------------------------------------------------------------------
+CVehicleWheelSolver::CVehicleWheelSolver()
+: m_numWheels(0)
+, m_numBlocks(0)
+, m_invMass(0.f)
+, m_invInertia(0.f)
+{
+}
+
+//------------------------------------------------------------------------
+void CVehicleWheelSolver::Begin(int numWheels, float chassisInvMass, float chassisInvInertia)
+{
+	assert(numWheels <= kMaxWheels);
+
+	m_numWheels = min(numWheels, (int)kMaxWheels);
+	m_numBlocks = (m_numWheels + kLanes - 1) / kLanes;
+	m_invMass = chassisInvMass;
+	m_invInertia = chassisInvInertia;
+
+	// The unused lanes of the last block get no friction, so they add nothing to the chassis
+	SWheel padding;
+	padding.worldOffset.zero();
+	padding.frictionDir[0].zero();
+	padding.frictionDir[1].zero();
+	padding.w = padding.radius = padding.invMass = padding.invInertia = padding.invWheelK = 0.f;
+	padding.tractionMin = padding.tractionMax = padding.lateralMin = padding.lateralMax = 0.f;
+	padding.locked = true;
+	for (int i = m_numWheels, end = m_numBlocks * kLanes; i < end; ++i)
+	{
+		SetWheel(i, padding);
+	}
+}
+
+//------------------------------------------------------------------------
+void CVehicleWheelSolver::SetWheel(int i, const SWheel& wheel)
+{
+	m_offX[i] = wheel.worldOffset.x;
+	m_offY[i] = wheel.worldOffset.y;
+	m_offZ[i] = wheel.worldOffset.z;
+	m_d0X[i] = wheel.frictionDir[0].x;
+	m_d0Y[i] = wheel.frictionDir[0].y;
+	m_d0Z[i] = wheel.frictionDir[0].z;
+	m_d1X[i] = wheel.frictionDir[1].x;
+	m_d1Y[i] = wheel.frictionDir[1].y;
+	m_d1Z[i] = wheel.frictionDir[1].z;
+	m_w[i] = wheel.w;
+	m_radius[i] = wheel.radius;
+	m_invWheelInertia[i] = wheel.invInertia;
+	m_tractionMin[i] = wheel.tractionMin;
+	m_tractionMax[i] = wheel.tractionMax;
+	m_tractionApplied[i] = 0.f;
+	m_lateralMin[i] = wheel.lateralMin;
+	m_lateralMax[i] = wheel.lateralMax;
+	m_lateralApplied[i] = 0.f;
+
+	// kept here until PrepareBlock folds them into the gains
+	m_spin[i] = wheel.locked ? 0.f : 1.f;
+	m_tractionGain[i] = wheel.invWheelK;
+	m_chassisScale[i] = wheel.invMass;
+}
+
+//------------------------------------------------------------------------
+void CVehicleWheelSolver::Solve(Vec3& vel, Vec3& angVel)
+{
+	if (m_numWheels <= 0)
+		return;
+
+	for (int b = 0; b < m_numBlocks; ++b)
+	{
+		PrepareBlock(b * kLanes);
+	}
+
+	float erp = 1.f / (float)m_numWheels;
+	const float erpChange = (1.f - erp) / (float)(kNumIterations - 1);
+
+	// First pass is explicit, velocity is only added to the chassis after solving all wheels
+	Vec3 dVel(ZERO);
+	Vec3 dAngVel(ZERO);
+	for (int b = 0; b < m_numBlocks; ++b)
+	{
+		SolveBlock(b * kLanes, vel, angVel, erp, dVel, dAngVel);
+	}
+	vel += dVel;
+	angVel += dAngVel;
+	erp += erpChange;
+
+	for (int repeat = 1; repeat < kNumIterations; ++repeat)
+	{
+		for (int i = 0; i < m_numWheels; ++i)
+		{
+			SolveWheel(i, vel, angVel, erp);
+		}
+		erp += erpChange;
+	}
+}
+
+//------------------------------------------------------------------------
+void CVehicleWheelSolver::PrepareBlock(int first)
+{
+	const float invMass = m_invMass;
+	const float invInertia = m_invInertia;
+
+	for (int i = first; i < first + kLanes; ++i)
+	{
+		const float ox = m_offX[i], oy = m_offY[i], oz = m_offZ[i];
+
+		// Angular response to a unit impulse along each friction direction, assuming sphere inertia
+		const float w0x = (oy * m_d0Z[i] - oz * m_d0Y[i]) * invInertia;
+		const float w0y = (oz * m_d0X[i] - ox * m_d0Z[i]) * invInertia;
+		const float w0z = (ox * m_d0Y[i] - oy * m_d0X[i]) * invInertia;
+		const float w1x = (oy * m_d1Z[i] - oz * m_d1Y[i]) * invInertia;
+		const float w1y = (oz * m_d1X[i] - ox * m_d1Z[i]) * invInertia;
+		const float w1z = (ox * m_d1Y[i] - oy * m_d1X[i]) * invInertia;
+
+		// Velocity response at the contact along the same direction
+		const float k0 = max(m_d0X[i] * (w0y * oz - w0z * oy) + m_d0Y[i] * (w0z * ox - w0x * oz) + m_d0Z[i] * (w0x * oy - w0y * ox) + invMass, kMinResponse);
+		const float k1 = max(m_d1X[i] * (w1y * oz - w1z * oy) + m_d1Y[i] * (w1z * ox - w1x * oz) + m_d1Z[i] * (w1x * oy - w1y * ox) + invMass, kMinResponse);
+
+		m_w0X[i] = w0x; m_w0Y[i] = w0y; m_w0Z[i] = w0z;
+		m_w1X[i] = w1x; m_w1Y[i] = w1y; m_w1Z[i] = w1z;
+
+		// A rolling wheel takes the slip on its own inertia first and passes the change of its contact
+		// velocity on to the chassis, a locked one pushes the chassis directly
+		const float spin = m_spin[i];
+		const float wheelInvMass = m_chassisScale[i];
+		const float rollingScale = -wheelInvMass / (wheelInvMass + k0);
+		m_tractionGain[i] = (float)__fsel(spin - 0.5f, m_tractionGain[i], -1.f / k0);
+		m_chassisScale[i] = (float)__fsel(spin - 0.5f, rollingScale, 1.f);
+		m_lateralGain[i] = -1.f / k1;
+	}
+}
+
+//------------------------------------------------------------------------
+void CVehicleWheelSolver::SolveBlock(int first, const Vec3& vel, const Vec3& angVel, float erp, Vec3& dVel, Vec3& dAngVel)
+{
+	float tractionImpulse[kLanes];
+	float lateralImpulse[kLanes];
+
+	for (int l = 0; l < kLanes; ++l)
+	{
+		const int i = first + l;
+
+		const float vx = vel.x + angVel.y * m_offZ[i] - angVel.z * m_offY[i];
+		const float vy = vel.y + angVel.z * m_offX[i] - angVel.x * m_offZ[i];
+		const float vz = vel.z + angVel.x * m_offY[i] - angVel.y * m_offX[i];
+
+		// Inline
+		const float slip = vx * m_d0X[i] + vy * m_d0Y[i] + vz * m_d0Z[i] - m_spin[i] * m_w[i] * m_radius[i];
+		const float traction = ApplyClamped(m_tractionApplied[i], m_tractionMin[i], m_tractionMax[i], erp * m_tractionGain[i] * slip);
+		m_w[i] += m_spin[i] * traction * m_radius[i] * m_invWheelInertia[i];
+		tractionImpulse[l] = m_chassisScale[i] * traction;
+
+		// Lateral
+		const float errorV = vx * m_d1X[i] + vy * m_d1Y[i] + vz * m_d1Z[i];
+		lateralImpulse[l] = ApplyClamped(m_lateralApplied[i], m_lateralMin[i], m_lateralMax[i], erp * m_lateralGain[i] * errorV);
+	}
+
+	const float invMass = m_invMass;
+	for (int l = 0; l < kLanes; ++l)
+	{
+		const int i = first + l;
+		const float t = tractionImpulse[l];
+		const float s = lateralImpulse[l];
+
+		dVel.x += invMass * (t * m_d0X[i] + s * m_d1X[i]);
+		dVel.y += invMass * (t * m_d0Y[i] + s * m_d1Y[i]);
+		dVel.z += invMass * (t * m_d0Z[i] + s * m_d1Z[i]);
+		dAngVel.x += t * m_w0X[i] + s * m_w1X[i];
+		dAngVel.y += t * m_w0Y[i] + s * m_w1Y[i];
+		dAngVel.z += t * m_w0Z[i] + s * m_w1Z[i];
+	}
+}
+
+//------------------------------------------------------------------------
+void CVehicleWheelSolver::SolveWheel(int i, Vec3& vel, Vec3& angVel, float erp)
+{
+	const float vx = vel.x + angVel.y * m_offZ[i] - angVel.z * m_offY[i];
+	const float vy = vel.y + angVel.z * m_offX[i] - angVel.x * m_offZ[i];
+	const float vz = vel.z + angVel.x * m_offY[i] - angVel.y * m_offX[i];
+
+	const float slip = vx * m_d0X[i] + vy * m_d0Y[i] + vz * m_d0Z[i] - m_spin[i] * m_w[i] * m_radius[i];
+	const float traction = ApplyClamped(m_tractionApplied[i], m_tractionMin[i], m_tractionMax[i], erp * m_tractionGain[i] * slip);
+	m_w[i] += m_spin[i] * traction * m_radius[i] * m_invWheelInertia[i];
+	const float t = m_chassisScale[i] * traction;
+
+	const float errorV = vx * m_d1X[i] + vy * m_d1Y[i] + vz * m_d1Z[i];
+	const float s = ApplyClamped(m_lateralApplied[i], m_lateralMin[i], m_lateralMax[i], erp * m_lateralGain[i] * errorV);
+
+	vel.x += m_invMass * (t * m_d0X[i] + s * m_d1X[i]);
+	vel.y += m_invMass * (t * m_d0Y[i] + s * m_d1Y[i]);
+	vel.z += m_invMass * (t * m_d0Z[i] + s * m_d1Z[i]);
+	angVel.x += t * m_w0X[i] + s * m_w1X[i];
+	angVel.y += t * m_w0Y[i] + s * m_w1Y[i];
+	angVel.z += t * m_w0Z[i] + s * m_w1Z[i];
+}
+
+//------------------------------------------------------------------------
+namespace
+{
+	// The per wheel solver the streams replaced, as it was in CVehicleMovementArcadeWheeled. Only
+	// kept as the reference for CryVehicleWheelSolverTest
+	struct SRefImpulse
+	{
+		float min;
+		float max;
+		float applied;
+	};
+
+	float RefApply(SRefImpulse* c, float impulse)
+	{
+		float prev = c->applied;
+		float total = c->applied + impulse;
+		c->applied = clamp(total, c->min, c->max);
+		return c->applied - prev;
+	}
+
+	float RefDenominator(float invMass, float invInertia, const Vec3& offset, const Vec3& norm)
+	{
+		Vec3 cross = offset.cross(norm);
+		cross = cross * invInertia;
+		cross = cross.cross(offset);
+		return norm.dot(cross) + invMass;
+	}
+
+	void RefSolveWheel(Vec3& dVel, Vec3& dAngVel, const Vec3& vel, const Vec3& angVel, float chassisInvMass,
+		CVehicleWheelSolver::SWheel& w, const Vec3& chassisW0, const Vec3& chassisW1, float chassisK0, float chassisK1,
+		SRefImpulse* traction, SRefImpulse* lateral, float solverERP)
+	{
+		Vec3 wheelVel = vel + angVel.cross(w.worldOffset);
+
+		if (!w.locked)
+		{
+			float slipSpeed = -w.w * w.radius + wheelVel.dot(w.frictionDir[0]);
+			float impulse = RefApply(traction, solverERP * slipSpeed * w.invWheelK);
+			w.w += impulse * w.radius * w.invInertia;
+			float velChange = - impulse * w.invMass;
+			float denom = w.invMass + chassisK0;
+			impulse = velChange / denom;
+			dVel += (chassisInvMass * impulse) * w.frictionDir[0];
+			dAngVel += impulse * chassisW0;
+		}
+		else
+		{
+			float slipSpeed = wheelVel.dot(w.frictionDir[0]);
+			float impulse = RefApply(traction, -solverERP * slipSpeed / chassisK0);
+			dVel += (chassisInvMass * impulse) * w.frictionDir[0];
+			dAngVel += impulse * chassisW0;
+		}
+
+		{
+			float errorV = wheelVel.dot(w.frictionDir[1]);
+			float impulse = RefApply(lateral, -solverERP * errorV / chassisK1);
+			dVel += (chassisInvMass * impulse) * w.frictionDir[1];
+			dAngVel += impulse * chassisW1;
+		}
+	}
+
+	void RefSolve(CVehicleWheelSolver::SWheel* wheels, int numWheels, float invMass, float invInertia, Vec3& vel, Vec3& angVel)
+	{
+		Vec3 chassisW0[CVehicleWheelSolver::kMaxWheels], chassisW1[CVehicleWheelSolver::kMaxWheels];
+		float chassisK0[CVehicleWheelSolver::kMaxWheels], chassisK1[CVehicleWheelSolver::kMaxWheels];
+		SRefImpulse traction[CVehicleWheelSolver::kMaxWheels], lateral[CVehicleWheelSolver::kMaxWheels];
+
+		const int numIterations = CVehicleWheelSolver::kNumIterations;
+		float solverERP = 1.f / (float)numWheels;
+		float erpChange = (1.f - solverERP) / (float)(numIterations - 1);
+
+		Vec3 dVel(ZERO), dAngVel(ZERO);
+		for (int i = 0; i < numWheels; ++i)
+		{
+			CVehicleWheelSolver::SWheel& w = wheels[i];
+			traction[i].min = w.tractionMin; traction[i].max = w.tractionMax; traction[i].applied = 0.f;
+			lateral[i].min = w.lateralMin; lateral[i].max = w.lateralMax; lateral[i].applied = 0.f;
+			chassisW0[i] = w.worldOffset.cross(w.frictionDir[0]) * invInertia;
+			chassisW1[i] = w.worldOffset.cross(w.frictionDir[1]) * invInertia;
+			chassisK0[i] = RefDenominator(invMass, invInertia, w.worldOffset, w.frictionDir[0]);
+			chassisK1[i] = RefDenominator(invMass, invInertia, w.worldOffset, w.frictionDir[1]);
+			RefSolveWheel(dVel, dAngVel, vel, angVel, invMass, w, chassisW0[i], chassisW1[i], chassisK0[i], chassisK1[i], &traction[i], &lateral[i], solverERP);
+		}
+		vel += dVel;
+		angVel += dAngVel;
+		solverERP += erpChange;
+
+		for (int repeat = 1; repeat < numIterations; ++repeat)
+		{
+			for (int i = 0; i < numWheels; ++i)
+			{
+				dVel.zero();
+				dAngVel.zero();
+				RefSolveWheel(dVel, dAngVel, vel, angVel, invMass, wheels[i], chassisW0[i], chassisW1[i], chassisK0[i], chassisK1[i], &traction[i], &lateral[i], solverERP);
+				vel += dVel;
+				angVel += dAngVel;
+			}
+			solverERP += erpChange;
+		}
+	}
+
+	// A flat ground car without suspension, standing in for the physics
+	struct SBenchVehicle
+	{
+		Vec3 pos;
+		Vec3 vel;
+		Vec3 angVel;
+		float yaw;
+		int numWheels;
+		Vec3 offsets[CVehicleWheelSolver::kMaxWheels];
+		float w[CVehicleWheelSolver::kMaxWheels];
+	};
+
+	const float kBenchMass = 1500.f;
+	const float kBenchWheelRadius = 0.4f;
+	const float kBenchWheelMass = 20.f;
+	const float kBenchGravity = 9.8f;
+	const float kBenchTopSpeed = 30.f;
+
+	void InitBenchVehicle(SBenchVehicle& vehicle, int index)
+	{
+		vehicle.pos.Set(20.f * (float)index, 0.f, 0.f);
+		vehicle.vel.zero();
+		vehicle.angVel.zero();
+		vehicle.yaw = 0.f;
+
+		// 4, 6 and 8 wheels, so partly filled blocks are covered too
+		const int numAxles = 2 + (index % 3);
+		vehicle.numWheels = numAxles * 2;
+		for (int a = 0; a < numAxles; ++a)
+		{
+			const float y = 1.5f - 3.f * (float)a / (float)(numAxles - 1);
+			vehicle.offsets[a * 2 + 0].Set(-0.9f, y, -0.5f);
+			vehicle.offsets[a * 2 + 1].Set(+0.9f, y, -0.5f);
+		}
+
+		for (int i = 0; i < vehicle.numWheels; ++i)
+			vehicle.w[i] = 0.f;
+	}
+
+	// Fills the solver input the way InternalPhysicsTick does: throttle, steering on the front axle and a
+	// stretch of hand brake, with the limits derived from the weight per wheel
+	void PrepareBenchWheels(SBenchVehicle& vehicle, int step, float dt, CVehicleWheelSolver::SWheel* wheels)
+	{
+		const float time = (float)step * dt;
+		const float throttle = (time < 3.f) ? 1.f : 0.6f;
+		const float steer = (time < 2.f) ? 0.f : 0.4f * sinf(0.7f * time);
+		const bool handBrake = (time > 8.f && time < 9.5f);
+
+		const Matrix33 rot = Matrix33::CreateRotationZ(vehicle.yaw);
+		const Vec3 xAxis = rot.GetColumn0();
+		const Vec3 yAxis = rot.GetColumn1();
+		const Vec3 normal(0.f, 0.f, 1.f);
+
+		const float invNumWheels = 1.f / (float)vehicle.numWheels;
+		const float wheelInvMass = 1.f / kBenchWheelMass;
+		const float wheelInvInertia = 1.f / (0.5f * kBenchWheelMass * sqr(kBenchWheelRadius));
+		const float forcePerWheel = 8.f * kBenchMass * invNumWheels;
+		const float lateralImpulse = 1.2f * kBenchMass * kBenchGravity * invNumWheels * dt;
+		const float minTractionImpulse = kBenchMass * kBenchGravity * dt * invNumWheels;
+
+		for (int i = 0; i < vehicle.numWheels; ++i)
+		{
+			CVehicleWheelSolver::SWheel& w = wheels[i];
+			const float wheelSteer = (vehicle.offsets[i].y > 0.f) ? steer : 0.f;
+			const Vec3 axis = (xAxis * cosf(wheelSteer)) - (yAxis * sinf(wheelSteer));
+
+			w.worldOffset = rot * vehicle.offsets[i];
+			w.frictionDir[0] = (normal.cross(axis)).normalize();
+			w.frictionDir[1] = (w.frictionDir[0].cross(normal)).normalize();
+			w.radius = kBenchWheelRadius;
+			w.invMass = wheelInvMass;
+			w.invInertia = wheelInvInertia;
+			w.invWheelK = 1.f / (wheelInvMass + sqr(kBenchWheelRadius) * wheelInvInertia);
+			w.locked = handBrake && vehicle.offsets[i].y < 0.f;
+
+			if (w.locked)
+			{
+				vehicle.w[i] = 0.f;
+				const float frictionImpulse = 0.5f * kBenchMass * kBenchGravity * dt * invNumWheels;
+				w.tractionMin = -frictionImpulse;
+				w.tractionMax = frictionImpulse;
+			}
+			else
+			{
+				vehicle.w[i] += throttle * kBenchWheelRadius * forcePerWheel * dt * wheelInvInertia;
+				vehicle.w[i] = clamp(vehicle.w[i], -kBenchTopSpeed / kBenchWheelRadius, kBenchTopSpeed / kBenchWheelRadius);
+				const float frictionImpulse = max(forcePerWheel * dt, minTractionImpulse);
+				w.tractionMin = -frictionImpulse;
+				w.tractionMax = frictionImpulse;
+			}
+
+			w.w = vehicle.w[i];
+			w.lateralMin = -lateralImpulse;
+			w.lateralMax = lateralImpulse;
+		}
+	}
+
+	void IntegrateBenchVehicle(SBenchVehicle& vehicle, float dt)
+	{
+		// The ground takes roll and pitch
+		vehicle.vel.z = 0.f;
+		vehicle.angVel.x = 0.f;
+		vehicle.angVel.y = 0.f;
+		vehicle.pos += vehicle.vel * dt;
+		vehicle.yaw += vehicle.angVel.z * dt;
+	}
+}
+
+//------------------------------------------------------------------------
+namespace
+{
+	const float kBenchStepTime = 1.f / 60.f;
+	const float kBenchInvMass = 1.f / kBenchMass;
+	const float kBenchInvInertia = 1.f / (0.4f * kBenchMass * sqr(2.f));
+
+	void SolveBenchVehicle(CVehicleWheelSolver& solver, SBenchVehicle& vehicle, int step, CVehicleWheelSolver::SWheel* wheels)
+	{
+		PrepareBenchWheels(vehicle, step, kBenchStepTime, wheels);
+
+		solver.Begin(vehicle.numWheels, kBenchInvMass, kBenchInvInertia);
+		for (int i = 0; i < vehicle.numWheels; ++i)
+			solver.SetWheel(i, wheels[i]);
+		solver.Solve(vehicle.vel, vehicle.angVel);
+		for (int i = 0; i < vehicle.numWheels; ++i)
+			vehicle.w[i] = solver.GetWheelSpeed(i);
+
+		IntegrateBenchVehicle(vehicle, kBenchStepTime);
+	}
+}
+
+void CVehicleWheelSolver::RunBenchmark(int numVehicles, int numSteps)
+{
+	numVehicles = max(numVehicles, 1);
+	numSteps = max(numSteps, 1);
+
+	std::vector<SBenchVehicle> vehicles(numVehicles);
+	for (int v = 0; v < numVehicles; ++v)
+		InitBenchVehicle(vehicles[v], v);
+
+	CVehicleWheelSolver solver;
+	SWheel wheels[kMaxWheels];
+	CBenchmarkTimer timer;
+
+	for (int step = 0; step < numSteps; ++step)
+	{
+		timer.Start();
+		for (int v = 0; v < numVehicles; ++v)
+			SolveBenchVehicle(solver, vehicles[v], step, wheels);
+		timer.Stop();
+	}
+
+	CryLog("[v_wheeledSolverBench] %d vehicles, %d steps: %.3f us per vehicle step, worst step %.3f ms",
+		numVehicles, numSteps, 1000.f * timer.GetAverageMs() / numVehicles, timer.GetWorstMs());
+}
+
+//------------------------------------------------------------------------
+CRY_UNIT_TEST_SUITE(CryVehicleWheelSolverTest)
+{
+	// The streamed solver drives the same trajectories as the per wheel solver it replaced
+	CRY_UNIT_TEST(MatchesPerWheelSolver)
+	{
+		const int numVehicles = 12;
+		const int numSteps = 600;
+		const float kPosTolerance = 0.01f;
+		const float kVelTolerance = 0.01f;
+
+		std::vector<SBenchVehicle> refVehicles(numVehicles);
+		std::vector<SBenchVehicle> vehicles(numVehicles);
+		for (int v = 0; v < numVehicles; ++v)
+		{
+			InitBenchVehicle(refVehicles[v], v);
+			InitBenchVehicle(vehicles[v], v);
+		}
+
+		CVehicleWheelSolver solver;
+		CVehicleWheelSolver::SWheel wheels[CVehicleWheelSolver::kMaxWheels];
+		float maxPosError = 0.f;
+		float maxVelError = 0.f;
+
+		for (int step = 0; step < numSteps; ++step)
+		{
+			for (int v = 0; v < numVehicles; ++v)
+			{
+				SBenchVehicle& refVehicle = refVehicles[v];
+				PrepareBenchWheels(refVehicle, step, kBenchStepTime, wheels);
+				RefSolve(wheels, refVehicle.numWheels, kBenchInvMass, kBenchInvInertia, refVehicle.vel, refVehicle.angVel);
+				for (int i = 0; i < refVehicle.numWheels; ++i)
+					refVehicle.w[i] = wheels[i].w;
+				IntegrateBenchVehicle(refVehicle, kBenchStepTime);
+
+				SBenchVehicle& vehicle = vehicles[v];
+				SolveBenchVehicle(solver, vehicle, step, wheels);
+
+				maxPosError = max(maxPosError, vehicle.pos.GetDistance(refVehicle.pos));
+				maxVelError = max(maxVelError, vehicle.vel.GetDistance(refVehicle.vel));
+			}
+		}
+
+		CRY_UNIT_TEST_ASSERT(maxPosError <= kPosTolerance);
+		CRY_UNIT_TEST_ASSERT(maxVelError <= kVelTolerance);
+	}
+
+	// A chassis without mass has no velocity response at all, neither in its wheels nor in the padding lanes
+	CRY_UNIT_TEST(MasslessChassisStaysFinite)
+	{
+		SBenchVehicle vehicle;
+		InitBenchVehicle(vehicle, 1);
+
+		CVehicleWheelSolver::SWheel wheels[CVehicleWheelSolver::kMaxWheels];
+		PrepareBenchWheels(vehicle, 0, kBenchStepTime, wheels);
+
+		// three wheels, so one lane of the block is padding
+		CVehicleWheelSolver solver;
+		solver.Begin(3, 0.f, 0.f);
+		for (int i = 0; i < 3; ++i)
+			solver.SetWheel(i, wheels[i]);
+
+		Vec3 vel(1.f, 2.f, 0.f);
+		Vec3 angVel(0.f, 0.f, 0.5f);
+		solver.Solve(vel, angVel);
+
+		CRY_UNIT_TEST_ASSERT(vel.IsValid() && angVel.IsValid());
+		CRY_UNIT_TEST_ASSERT(vel == Vec3(1.f, 2.f, 0.f));
+		for (int i = 0; i < 3; ++i)
+			CRY_UNIT_TEST_ASSERT(NumberValid(solver.GetWheelSpeed(i)));
+	}
+}
@@ -0,0 +1,100 @@
+/*************************************************************************
+Crytek Source File.
+Copyright (C), Crytek Studios, 2001-2012.
+-------------------------------------------------------------------------
+$Id$
+$DateTime$
+Description: Wheel friction solver of the arcade wheeled movement. The
+	wheels of one vehicle are kept as streams in blocks of four, so the
+	per wheel setup and the explicit first pass run four wheels at a
+	time without branches. The following passes stay sequential, each
+	wheel sees the chassis velocity left by the one before it.
+
+-------------------------------------------------------------------------
+History:
+
+*************************************************************************/
+
+#ifndef __VEHICLEWHEELSOLVER_H__
+#define __VEHICLEWHEELSOLVER_H__
+
+#if _MSC_VER > 1000
+# pragma once
+#endif
+
+class CVehicleWheelSolver
+{
+public:
+	enum
+	{
+		kLanes = 4,
+		kMaxWheels = 20,		// CVehicleMovementArcadeWheeled::maxWheels rounded up to whole blocks
+		kNumIterations = 4,
+	};
+
+	struct SWheel
+	{
+		Vec3 worldOffset;			// contact point relative to the centre of mass
+		Vec3 frictionDir[2];	// [0] inline, [1] lateral
+		float w;
+		float radius;
+		float invMass;
+		float invInertia;
+		float invWheelK;
+		float tractionMin, tractionMax;
+		float lateralMin, lateralMax;
+		bool locked;
+	};
+
+	CVehicleWheelSolver();
+
+	void Begin(int numWheels, float chassisInvMass, float chassisInvInertia);
+	void SetWheel(int i, const SWheel& wheel);
+
+	// Applies the friction impulses of all wheels to vel and angVel, and spins the wheels
+	void Solve(Vec3& vel, Vec3& angVel);
+
+	float GetWheelSpeed(int i) const { return m_w[i]; }
+
+	// Drives synthetic vehicles without physics through the solver and logs the cost per vehicle.
+	// CryVehicleWheelSolverTest compares the trajectories with the per wheel solver it replaced
+	static void RunBenchmark(int numVehicles, int numSteps);
+
+private:
+	void PrepareBlock(int first);
+	void SolveBlock(int first, const Vec3& vel, const Vec3& angVel, float erp, Vec3& dVel, Vec3& dAngVel);
+	void SolveWheel(int i, Vec3& vel, Vec3& angVel, float erp);
+
+	static float ApplyClamped(float& applied, float mn, float mx, float impulse)
+	{
+		const float prev = applied;
+		applied = clamp(applied + impulse, mn, mx);
+		return applied - prev;
+	}
+
+	int m_numWheels;
+	int m_numBlocks;
+	float m_invMass;
+	float m_invInertia;
+
+	// inputs
+	float m_offX[kMaxWheels], m_offY[kMaxWheels], m_offZ[kMaxWheels];
+	float m_d0X[kMaxWheels], m_d0Y[kMaxWheels], m_d0Z[kMaxWheels];
+	float m_d1X[kMaxWheels], m_d1Y[kMaxWheels], m_d1Z[kMaxWheels];
+	float m_w[kMaxWheels];
+	float m_radius[kMaxWheels];
+	float m_invWheelInertia[kMaxWheels];
+	float m_tractionMin[kMaxWheels], m_tractionMax[kMaxWheels], m_tractionApplied[kMaxWheels];
+	float m_lateralMin[kMaxWheels], m_lateralMax[kMaxWheels], m_lateralApplied[kMaxWheels];
+
+	// Per wheel constants of one solve, a locked wheel folds into the same expressions as a rolling one:
+	// inline impulse = tractionGain * (v.d0 - spin*w*r), chassis share = chassisScale * impulse
+	float m_spin[kMaxWheels];
+	float m_tractionGain[kMaxWheels];
+	float m_chassisScale[kMaxWheels];
+	float m_lateralGain[kMaxWheels];
+	float m_w0X[kMaxWheels], m_w0Y[kMaxWheels], m_w0Z[kMaxWheels];
+	float m_w1X[kMaxWheels], m_w1Y[kMaxWheels], m_w1Z[kMaxWheels];
+};
+
+#endif // __VEHICLEWHEELSOLVER_H__
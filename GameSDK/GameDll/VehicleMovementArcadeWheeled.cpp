@@ -27,6 +27,7 @@ History:
 #include "IGameTokens.h"
 #include "Player.h"
 #include "NetInputChainDebug.h"
+#include "Environment/WaterQueryCache.h"
 
 DEFINE_SHARED_PARAMS_TYPE_INFO(CVehicleMovementArcadeWheeled::SSharedParams);
 
@@ -66,38 +67,12 @@ static void clampedImpulseInit(ClampedImpulse* c, float mx)
 	c->min = -fabsf(mx);
 }
 
-static float clampedImpulseApply(ClampedImpulse* c, float impulse)
-{
-	float prev = c->applied;
-	float total = c->applied + impulse;
-	c->applied = clamp(total, c->min, c->max);
-	return c->applied - prev;
-}
-
-static ILINE float computeDenominator(float invMass, float invInertia, const Vec3& offset, const Vec3& norm)
-{
-    // If you apply an impulse of 1.0f in the direction of 'norm'
-    // at position specified by 'offset' then the point will change
-    // velocity by the amount calculated here
-	Vec3 cross = offset.cross(norm);
-	cross = cross * invInertia;	// Assume sphere inertia for now
-	cross = cross.cross(offset);
-    return norm.dot(cross) + invMass;
-}
-
 static ILINE void addImpulseAtOffset(Vec3& vel, Vec3& angVel, float invMass, float invInertia, const Vec3& offset, const Vec3& impulse)
 {
 	vel = vel + impulse * invMass;
 	angVel = angVel + (offset.cross(impulse) * invInertia);
 }
 
-// Same as above but the angular change has been flattened into dW for a given offset and direction
-static ILINE void addImpulse(Vec3& vel, Vec3& angVel, float invMass, const Vec3& dW, float impulse, const Vec3& dir)
-{
-	vel += (invMass * impulse)*dir;
-	angVel += impulse * dW;
-}
-
 struct Vehicle3Settings
 {
 	bool useNewSystem;
@@ -116,6 +91,7 @@ CVehicleMovementArcadeWheeled::CVehicleMovementArcadeWheeled()
 {
 	m_iWaterLevelUpdate = 0;
 	m_wheelStatusLock = 0;
+	m_lockFreeInput = true;
 	m_frictionStateLock = 0;
 
 	m_passengerCount = 0;
@@ -1049,7 +1025,10 @@ bool CVehicleMovementArcadeWheeled::StartDriving(EntityId driverId)
 void CVehicleMovementArcadeWheeled::StopDriving()
 {
 	CVehicleMovementBase::StopDriving();
-	m_movementAction.Clear(true);
+
+	SVehicleMovementAction action = m_movementInput.action;
+	action.Clear(true);
+	SetMovementAction(action);
 
 	UpdateBrakes(0.f);
 	EnableLowLevelPhysics(k_frictionUseLowLevel, 0);
@@ -1238,10 +1217,9 @@ void CVehicleMovementArcadeWheeled::OnEvent(EVehicleMovementEvent event, const S
 void CVehicleMovementArcadeWheeled::OnAction(const TVehicleActionId actionId, int activationMode, float value)
 {
 
-	CryAutoCriticalSection netlk(m_networkLock);
-	CryAutoCriticalSection lk(m_lock);
+	CVehicleScopedLock netlk(m_networkLock);
 
-	CVehicleMovementBase::OnAction(actionId, activationMode, value);
+	OnActionLockFree(actionId, activationMode, value);
 
 }
 
@@ -1773,10 +1751,14 @@ void CVehicleMovementArcadeWheeled::GetCurrentWheelStatus(IPhysicalEntity* pPhys
 
 
 //------------------------------------------------------------------------
-void CVehicleMovementArcadeWheeled::Update(const float deltaTime)
+void CVehicleMovementArcadeWheeled::Update(const float frameTime)
 {
 	FUNCTION_PROFILER( GetISystem(), PROFILE_GAME );
 
+	float deltaTime = frameTime;
+	if (!BeginServerUpdate(deltaTime))
+		return;
+
 	IEntity* pEntity = m_pVehicle->GetEntity();
 	IPhysicalEntity* pPhysics = GetPhysics();
 	if(!pPhysics)
@@ -1804,7 +1786,8 @@ void CVehicleMovementArcadeWheeled::Update(const float deltaTime)
 
 	CVehicleMovementBase::Update(deltaTime);
 	UpdateWaterLevels();
-	UpdateSounds(deltaTime);
+	if (IsPresentationEnabled())
+		UpdateSounds(deltaTime);
 	UpdateBrakes(deltaTime);
 
 
@@ -2405,7 +2388,8 @@ void CVehicleMovementArcadeWheeled::ProcessMovement(const float deltaTime)
 
 	m_netActionSync.UpdateObject(this);
 
-	CryAutoCriticalSection lk(m_lock);
+	if (AcquireMovementInput())
+		m_aiRequest = m_movementInputExchange.Get().aiRequest;
 
 	CVehicleMovementBase::ProcessMovement(deltaTime);
 	
@@ -2567,7 +2551,13 @@ void CVehicleMovementArcadeWheeled::ProcessMovement(const float deltaTime)
 		if (m_frictionState!=(int8)k_frictionUseHiLevel)
 			EnableLowLevelPhysics(k_frictionUseHiLevel, THREAD_SAFE);
 		if (deltaTime>0.f)
-			InternalPhysicsTick(deltaTime);
+		{
+			// The wheel solver never steps further than v_wheeledSolverStep, longer physics steps are split up
+			// inside the tick and the chassis and wheel velocities carry over from one substep to the next
+			const float maxStep = g_pGameCVars->v_wheeledSolverStep;
+			const int numSubsteps = (maxStep > 0.f) ? clamp_tpl((int)ceilf(deltaTime / maxStep), 1, (int)maxSolverSubsteps) : 1;
+			InternalPhysicsTick(deltaTime, numSubsteps);
+		}
 	
 		if ( !bSteep && Boosting() )
 			ApplyBoost(speed, m_pSharedParams->handling.boostTopSpeed*GetWheelCondition()*damageMul, m_boostStrength, deltaTime);  
@@ -2671,40 +2661,6 @@ void CVehicleMovementArcadeWheeled::EnableLowLevelPhysics(int state, int bThread
 	}
 }
 
-static ILINE void SolveFriction(Vec3& dVel, Vec3& dAngVel, const Vec3& vel, const Vec3& angVel, SVehicleChassis* c, SVehicleWheel* w, ClampedImpulse* maxTractionImpulse, ClampedImpulse* maxLateralImpulse, float solverERP, float dt)
-{
-	Vec3 wheelVel = vel + angVel.cross(w->worldOffset);
-
-	// Inline
-	if (!w->locked)
-	{
-		float slipSpeed = -w->w * w->radius + wheelVel.dot(w->frictionDir[0]);
-		float impulse = clampedImpulseApply(maxTractionImpulse, solverERP * slipSpeed * w->invWheelK);
-		w->w += impulse * w->radius * w->invInertia;
-		float velChange = - impulse * w->invMass;	// This is the vel change imparted on just the wheel
-		// Bring velChange back to zero by applying impulse to chassis
-		float denom = w->invMass + w->chassisK0;
-		impulse = velChange / denom;
-		addImpulse(dVel, dAngVel, c->invMass, w->chassisW0, impulse, w->frictionDir[0]);
-	}
-	else
-	{
-		float slipSpeed = wheelVel.dot(w->frictionDir[0]);
-		float denom = w->chassisK0;
-		float impulse = clampedImpulseApply(maxTractionImpulse, -solverERP*slipSpeed / denom);
-		addImpulse(dVel, dAngVel, c->invMass, w->chassisW0, impulse, w->frictionDir[0]);
-	}
-
-	// Lateral
-	{
-		float errorV = wheelVel.dot(w->frictionDir[1]);
-		float denom = w->chassisK1;
-		float impulse0 = -solverERP * errorV / denom;
-		float impulse = clampedImpulseApply(maxLateralImpulse, impulse0);
-		addImpulse(dVel, dAngVel, c->invMass, w->chassisW1, impulse, w->frictionDir[1]);
-	}
-}
-
 float CVehicleMovementArcadeWheeled::CalcSteering(float steer, float speedRel, float rotateYaw, float dt)
 {
 	float steerMax = GetMaxSteer(speedRel);
@@ -2736,7 +2692,7 @@ float CVehicleMovementArcadeWheeled::CalcSteering(float steer, float speedRel, f
 	return steer;
 }
 
-void CVehicleMovementArcadeWheeled::InternalPhysicsTick(float dt)
+void CVehicleMovementArcadeWheeled::InternalPhysicsTick(float dt, int numSubsteps)
 {
 	IPhysicalEntity* pPhysics = GetPhysics();
 	if (pPhysics==NULL)
@@ -2966,7 +2922,6 @@ void CVehicleMovementArcadeWheeled::InternalPhysicsTick(float dt)
 		ClampedImpulse maxLateralImpulse[maxWheels];
 			
 		bool lockAllWheels = !isTank && (absSpeed > 2.f) && ((speed * throttle) < 0.f);			// When throttle is opposite to current speed
-		bool canDeccelerate = (absSpeed > (m_pSharedParams->handling.decceleration*dt));
 		const float accelerationMultiplier = m_pSharedParams->handling.accelMultiplier1 + (m_pSharedParams->handling.accelMultiplier2 - m_pSharedParams->handling.accelMultiplier1)*speedNorm;
 		float forcePerWheel = (m_boost ? m_pSharedParams->handling.boostAcceleration : m_pSharedParams->handling.acceleration) * m_chassis.mass * invNumWheels * m_accelFactor;	                // Assume all wheels are powered
 		float forcePerWheel2 = m_pSharedParams->handling.decceleration * m_chassis.mass * invNumWheels;
@@ -3012,9 +2967,6 @@ void CVehicleMovementArcadeWheeled::InternalPhysicsTick(float dt)
 		tankDiffSpeed = invertTankYaw ? -tankDiffSpeed : tankDiffSpeed;
 		tankDiffSpeed *= damageRPMScale;
 		
-		float averageSlipSpeedLateral = 0.f;
-		float averageSlipSpeedForward = 0.f;
-		
 		// find and store the friction per wheel
 		float surfaceFriction[maxWheels]; // per wheel
 		for (int i = 0; i < maxWheels; i++)
@@ -3040,190 +2992,202 @@ void CVehicleMovementArcadeWheeled::InternalPhysicsTick(float dt)
 			}
 		}
 
-		for (int i=0; i<numWheels; i++)
+		if (isTank && (numContacts>=1))
 		{
-			SVehicleWheel* w = &m_wheels[i];
+			float impulse = steering * m_pSharedParams->tankHandling.additionalTilt * dt;
+			angVel -= yAxis * impulse;
+		}
 
-			w->contactNormal = m_handling.contactNormal;
-			if (m_wheelStatus[i].bContact) w->contactNormal = w->contactNormal + m_wheelStatus[i].normContact;
-			//w->contactNormal = w->contactNormal - axis*(axis.dot(w->contactNormal));
-			w->contactNormal.normalize();
+		// Only the wheels and their contacts are substepped, the chassis terms above and below are applied once per tick
+		const float subDt = dt / (float)numSubsteps;
+		const float idleSpinDecay = (numSubsteps > 1) ? powf(0.9f, 1.f / (float)numSubsteps) : 0.9f;
+		float averageSlipSpeedLateral = 0.f;
+		float averageSlipSpeedForward = 0.f;
 
-			if (isTank)
-			{
-				// When turning, artifically bring wheels closer to the centre so that lateral friction does not stop the the tank from turning
-				float s = (0.3f - 0.25f * fabsf(steering));
-				w->worldOffset = (w->offset.x * xAxis) + ((s*w->offset.y) * yAxis) + (w->offset.z * zAxis);
-				w->w = avWheelSpeed;
-			}
-			else
+		for (int substep = 0; substep < numSubsteps; ++substep)
+		{
+			const bool canDeccelerate = (absSpeed > (m_pSharedParams->handling.decceleration*subDt));
+
+			if (isTank && substep > 0)
 			{
-				w->worldOffset = bodyRot * w->offset;
+				avWheelSpeed = 0.f;
+				for (int i=0; i<numWheels; i++)
+					avWheelSpeed += m_wheels[i].w;
+				avWheelSpeed *= invNumWheels;
 			}
 
-			Vec3 axis = (xAxis * cosf(m_wheelStatus[i].steer)) - (yAxis * sinf(m_wheelStatus[i].steer));
-
-			// Calc inline and lateral direction
-			w->frictionDir[0] = (w->contactNormal.cross(axis)).normalize();
-			w->frictionDir[1] = (w->frictionDir[0].cross(w->contactNormal)).normalize(); //axis;
-
-			Vec3 wheelVel = vel + angVel.cross(w->worldOffset);
-			w->slipSpeedLateral = wheelVel.dot(w->frictionDir[1]);
-			w->slipSpeed = fabsf(wheelVel.dot(w->frictionDir[0]) - w->w*w->radius);
-			averageSlipSpeedForward += w->slipSpeed;
-			averageSlipSpeedLateral += w->slipSpeedLateral;
+			averageSlipSpeedLateral = 0.f;
+			averageSlipSpeedForward = 0.f;
 
-			if (lockAllWheels || (m_action.bHandBrake & w->bCanLock))
-			{
-				float frictionImpulse = handBrakeForce * dt;
-				clampedImpulseInit(&maxTractionImpulse[i], -frictionImpulse, frictionImpulse);
-				w->locked = 1;
-				w->w = 0.f;
-			}
-			else 
+			for (int i=0; i<numWheels; i++)
 			{
-				float minFrictionImpulse = m_chassis.mass * gravity * dt * invNumWheels;
-				float frictionImpulse = forcePerWheel * dt;
-				frictionImpulse = max(frictionImpulse, minFrictionImpulse);
+				SVehicleWheel* w = &m_wheels[i];
 
-				// Grip based on slip speed
-				const float grip = m_pSharedParams->handling.grip1 + (m_pSharedParams->handling.grip2 - m_pSharedParams->handling.grip1) * approxOneExp(w->slipSpeed * m_pSharedParams->handling.gripK);
-				frictionImpulse *= grip * gravityScale;
-				clampedImpulseInit(&maxTractionImpulse[i], -frictionImpulse, frictionImpulse);
+				w->contactNormal = m_handling.contactNormal;
+				if (m_wheelStatus[i].bContact) w->contactNormal = w->contactNormal + m_wheelStatus[i].normContact;
+				//w->contactNormal = w->contactNormal - axis*(axis.dot(w->contactNormal));
+				w->contactNormal.normalize();
 
-				w->locked = 0;
-				if (fabsf(throttle) > 0.05f)
+				if (isTank)
 				{
-					if ((throttle*w->w>0.f) && (throttle*w->w < throttle*w->lastW))
-					{
-						// Resist the terrain from decreasing the speed of the wheels
-						w->w+=(w->w-w->lastW)*approxOneExp(dt);
-					}
-					float dw = contact*throttle * w->radius * accelerationMultiplier * forcePerWheel * dt * w->invInertia;
-					w->w += dw;
+					// When turning, artifically bring wheels closer to the centre so that lateral friction does not stop the the tank from turning
+					float s = (0.3f - 0.25f * fabsf(steering));
+					w->worldOffset = (w->offset.x * xAxis) + ((s*w->offset.y) * yAxis) + (w->offset.z * zAxis);
+					w->w = avWheelSpeed;
 				}
 				else
 				{
-					if (canDeccelerate)
-					{
-						float dw = fsgnf(speed) * w->radius * forcePerWheel2 * dt * w->invInertia;
-						w->w = (float)__fsel(fabsf(w->w)-fabsf(dw), w->w-dw, 0.f);
-					}
-					w->w *= 0.9f;
+					w->worldOffset = bodyRot * w->offset;
 				}
-				w->lastW = w->w;
 
-				if ((w->w * w->radius) > topSpeed)
+				Vec3 axis = (xAxis * cosf(m_wheelStatus[i].steer)) - (yAxis * sinf(m_wheelStatus[i].steer));
+
+				// Calc inline and lateral direction
+				w->frictionDir[0] = (w->contactNormal.cross(axis)).normalize();
+				w->frictionDir[1] = (w->frictionDir[0].cross(w->contactNormal)).normalize(); //axis;
+
+				Vec3 wheelVel = vel + angVel.cross(w->worldOffset);
+				w->slipSpeedLateral = wheelVel.dot(w->frictionDir[1]);
+				w->slipSpeed = fabsf(wheelVel.dot(w->frictionDir[0]) - w->w*w->radius);
+				averageSlipSpeedForward += w->slipSpeed;
+				averageSlipSpeedLateral += w->slipSpeedLateral;
+
+				if (lockAllWheels || (m_action.bHandBrake & w->bCanLock))
 				{
-					float target = topSpeed / w->radius;
-					w->w = target;
+					float frictionImpulse = handBrakeForce * subDt;
+					clampedImpulseInit(&maxTractionImpulse[i], -frictionImpulse, frictionImpulse);
+					w->locked = 1;
+					w->w = 0.f;
 				}
-				//else if ((w->w * w->radius) > topSpeed)
-				//{
-				//	float target = topSpeed / w->radius;
-				//	w->w += (target - w->w) * approxOneExp(m_pSharedParams->handling.reductionRate*dt);
-				//}
-				else if ((w->w * w->radius) < -topSpeed)
+				else 
 				{
-					float target = -topSpeed / w->radius;
-					w->w = target;
-				}
-			}
+					float minFrictionImpulse = m_chassis.mass * gravity * subDt * invNumWheels;
+					float frictionImpulse = forcePerWheel * subDt;
+					frictionImpulse = max(frictionImpulse, minFrictionImpulse);
 
-			if (isTank)
-			{
-				// Add on differential steering
-				w->w -= tankDiffSpeed * fsgnf(w->offset.x);
-			}
-
-			maxTractionImpulse[i].min *= m_handling.compressionScale * contact * surfaceFriction[i];
-			maxTractionImpulse[i].max *= m_handling.compressionScale * contact * surfaceFriction[i];
-
-			if (w->contactNormal.dot(zAxis)<0.3f)
-			{
-				maxTractionImpulse[i].min = 0.f;
-				maxTractionImpulse[i].max = 0.f;
-				maxLateralImpulse[i].min = 0.f;
-				maxLateralImpulse[i].max = 0.f;
-			}
+					// Grip based on slip speed
+					const float grip = m_pSharedParams->handling.grip1 + (m_pSharedParams->handling.grip2 - m_pSharedParams->handling.grip1) * approxOneExp(w->slipSpeed * m_pSharedParams->handling.gripK);
+					frictionImpulse *= grip * gravityScale;
+					clampedImpulseInit(&maxTractionImpulse[i], -frictionImpulse, frictionImpulse);
 
-			// Lateral Friction
-			{
-				float friction = w->axleIndex==0 ? m_pSharedParams->handling.backFriction : m_pSharedParams->handling.frontFriction;
-				float frictionImpulse = friction * m_chassis.mass * gravity * invNumWheels * dt;
-				if (m_action.bHandBrake & w->bCanLock)
-				{
-					if (w->axleIndex==0)
+					w->locked = 0;
+					if (fabsf(throttle) > 0.05f)
 					{
-						frictionImpulse *= m_pSharedParams->handling.handBrakeBackFrictionScale;
+						if ((throttle*w->w>0.f) && (throttle*w->w < throttle*w->lastW))
+						{
+							// Resist the terrain from decreasing the speed of the wheels
+							w->w+=(w->w-w->lastW)*approxOneExp(subDt);
+						}
+						float dw = contact*throttle * w->radius * accelerationMultiplier * forcePerWheel * subDt * w->invInertia;
+						w->w += dw;
 					}
 					else
 					{
-						frictionImpulse *= m_pSharedParams->handling.handBrakeFrontFrictionScale;
+						if (canDeccelerate)
+						{
+							float dw = fsgnf(speed) * w->radius * forcePerWheel2 * subDt * w->invInertia;
+							w->w = (float)__fsel(fabsf(w->w)-fabsf(dw), w->w-dw, 0.f);
+						}
+						w->w *= idleSpinDecay;
 					}
-				}
+					w->lastW = w->w;
 
-				clampedImpulseInit(&maxLateralImpulse[i], -frictionImpulse, frictionImpulse);
-			}
+					if ((w->w * w->radius) > topSpeed)
+					{
+						float target = topSpeed / w->radius;
+						w->w = target;
+					}
+					//else if ((w->w * w->radius) > topSpeed)
+					//{
+					//	float target = topSpeed / w->radius;
+					//	w->w += (target - w->w) * approxOneExp(m_pSharedParams->handling.reductionRate*subDt);
+					//}
+					else if ((w->w * w->radius) < -topSpeed)
+					{
+						float target = -topSpeed / w->radius;
+						w->w = target;
+					}
+				}
 
-			maxLateralImpulse[i].min *= m_handling.compressionScale * contact * gravityScale * surfaceFriction[i];
-			maxLateralImpulse[i].max *= m_handling.compressionScale * contact * gravityScale * surfaceFriction[i];
-		}
-		
-		m_movementInfo.averageSlipSpeedForward = averageSlipSpeedForward * m_invNumWheels * contact;
-		m_movementInfo.averageSlipSpeedLateral = averageSlipSpeedLateral * m_invNumWheels * contact;
+				if (isTank)
+				{
+					// Add on differential steering
+					w->w -= tankDiffSpeed * fsgnf(w->offset.x);
+				}
 
-		if (isTank && (numContacts>=1))
-		{
-			float impulse = steering * m_pSharedParams->tankHandling.additionalTilt * dt;
-			angVel -= yAxis * impulse;
-		}
+				maxTractionImpulse[i].min *= m_handling.compressionScale * contact * surfaceFriction[i];
+				maxTractionImpulse[i].max *= m_handling.compressionScale * contact * surfaceFriction[i];
 
-		const int numIterations = 4;
-		float solverERP = invNumWheels;
-		float erpChange = (1.f - solverERP)/(float)(numIterations-1);
+				if (w->contactNormal.dot(zAxis)<0.3f)
+				{
+					maxTractionImpulse[i].min = 0.f;
+					maxTractionImpulse[i].max = 0.f;
+					maxLateralImpulse[i].min = 0.f;
+					maxLateralImpulse[i].max = 0.f;
+				}
 
-		// Keep track of lateral friction impulses
-		Vec3 appliedImpulse[2]		= { Vec3Constants<float>::fVec3_Zero, Vec3Constants<float>::fVec3_Zero };
-		Vec3 appliedAngImpulse[2] = { Vec3Constants<float>::fVec3_Zero, Vec3Constants<float>::fVec3_Zero };
+				// Lateral Friction
+				{
+					float friction = w->axleIndex==0 ? m_pSharedParams->handling.backFriction : m_pSharedParams->handling.frontFriction;
+					float frictionImpulse = friction * m_chassis.mass * gravity * invNumWheels * subDt;
+					if (m_action.bHandBrake & w->bCanLock)
+					{
+						if (w->axleIndex==0)
+						{
+							frictionImpulse *= m_pSharedParams->handling.handBrakeBackFrictionScale;
+						}
+						else
+						{
+							frictionImpulse *= m_pSharedParams->handling.handBrakeFrontFrictionScale;
+						}
+					}
 
+					clampedImpulseInit(&maxLateralImpulse[i], -frictionImpulse, frictionImpulse);
+				}
 
-		if (contact > 0.f)
-		{
-			// Iterate
-			Vec3 dVel;
-			Vec3 dAngVel;
-			dVel.zero();
-			dAngVel.zero();
-			// First pass is explicit, velocity is only added to the chassis after solving all wheels
-			for (int i=0; i<numWheels; i++)
-			{
-				SVehicleWheel* w = &m_wheels[i];
-				w->chassisW0 = w->worldOffset.cross(w->frictionDir[0])*m_chassis.invInertia;
-				w->chassisW1 = w->worldOffset.cross(w->frictionDir[1])*m_chassis.invInertia;
-				w->chassisK0 = computeDenominator(m_chassis.invMass, m_chassis.invInertia, w->worldOffset, w->frictionDir[0]);
-				w->chassisK1 = computeDenominator(m_chassis.invMass, m_chassis.invInertia, w->worldOffset, w->frictionDir[1]);
-				SolveFriction(dVel, dAngVel, vel, angVel, &m_chassis, w, &maxTractionImpulse[i], &maxLateralImpulse[i], solverERP, dt);
+				maxLateralImpulse[i].min *= m_handling.compressionScale * contact * gravityScale * surfaceFriction[i];
+				maxLateralImpulse[i].max *= m_handling.compressionScale * contact * gravityScale * surfaceFriction[i];
 			}
-			vel = vel + dVel;
-			angVel = angVel + dAngVel;
-			solverERP = solverERP + erpChange;
+		
 
-			for (int repeat=1; repeat<numIterations; repeat++)
+			if (contact > 0.f)
 			{
+				COMPILE_TIME_ASSERT((int)maxWheels <= (int)CVehicleWheelSolver::kMaxWheels);
+				CVehicleWheelSolver& solver = m_wheelSolver;
+				solver.Begin(numWheels, m_chassis.invMass, m_chassis.invInertia);
+
+				for (int i=0; i<numWheels; i++)
+				{
+					const SVehicleWheel* w = &m_wheels[i];
+					CVehicleWheelSolver::SWheel wheel;
+					wheel.worldOffset = w->worldOffset;
+					wheel.frictionDir[0] = w->frictionDir[0];
+					wheel.frictionDir[1] = w->frictionDir[1];
+					wheel.w = w->w;
+					wheel.radius = w->radius;
+					wheel.invMass = w->invMass;
+					wheel.invInertia = w->invInertia;
+					wheel.invWheelK = w->invWheelK;
+					wheel.tractionMin = maxTractionImpulse[i].min;
+					wheel.tractionMax = maxTractionImpulse[i].max;
+					wheel.lateralMin = maxLateralImpulse[i].min;
+					wheel.lateralMax = maxLateralImpulse[i].max;
+					wheel.locked = w->locked != 0;
+					solver.SetWheel(i, wheel);
+				}
+
+				solver.Solve(vel, angVel);
+
 				for (int i=0; i<numWheels; i++)
 				{
-					SVehicleWheel* w = &m_wheels[i];
-					dVel.zero();
-					dAngVel.zero();
-					SolveFriction(dVel, dAngVel, vel, angVel, &m_chassis, w, &maxTractionImpulse[i], &maxLateralImpulse[i], solverERP, dt);
-					vel = vel + dVel;
-					angVel = angVel + dAngVel;
+					m_wheels[i].w = solver.GetWheelSpeed(i);
 				}
-				solverERP = solverERP + erpChange;
 			}
 		}
-	
+
+		m_movementInfo.averageSlipSpeedForward = averageSlipSpeedForward * m_invNumWheels * contact;
+		m_movementInfo.averageSlipSpeedLateral = averageSlipSpeedLateral * m_invNumWheels * contact;
+
 		//===============================
 		// Set the low level wheel speeds
 		//===============================
@@ -3424,7 +3388,7 @@ void CVehicleMovementArcadeWheeled::UpdateWaterLevels()
 		{
 			I3DEngine	*p3DEngine = gEnv->p3DEngine;
 
-			m_wheels[m_iWaterLevelUpdate].waterLevel = gEnv->p3DEngine->GetWaterLevel(&wheelStatus.ptContact);
+			m_wheels[m_iWaterLevelUpdate].waterLevel = g_pGame->GetWaterQueryCache()->GetWaterLevel(wheelStatus.ptContact, CWaterQueryCache::eWQ_Vehicle);
 		}
 		else
 		{
@@ -3613,19 +3577,18 @@ bool CVehicleMovementArcadeWheeled::RequestMovement(CMovementRequest& movementRe
 {
 	FUNCTION_PROFILER( gEnv->pSystem, PROFILE_GAME );
 
-	m_movementAction.isAI = true;
 	if (!m_isEnginePowered)
 		return false;
 
-	CryAutoCriticalSection lk(m_lock);
+	CMovementRequest& aiRequest = m_movementInput.aiRequest;
 
 	if (movementRequest.HasDirectionOffFromPath())
-		m_aiRequest.SetDirectionOffFromPath(movementRequest.GetDirOffFromPath());
+		aiRequest.SetDirectionOffFromPath(movementRequest.GetDirOffFromPath());
 
 	if (movementRequest.HasLookTarget())
-		m_aiRequest.SetLookTarget(movementRequest.GetLookTarget());
+		aiRequest.SetLookTarget(movementRequest.GetLookTarget());
 	else
-		m_aiRequest.ClearLookTarget();
+		aiRequest.ClearLookTarget();
 
 	if (movementRequest.HasMoveTarget())
 	{
@@ -3634,32 +3597,34 @@ bool CVehicleMovementArcadeWheeled::RequestMovement(CMovementRequest& movementRe
 		Vec3 end( movementRequest.GetMoveTarget() );
 		Vec3 pos = ( end - start ) * 100.0f;
 		pos +=start;
-		m_aiRequest.SetMoveTarget( pos );
+		aiRequest.SetMoveTarget( pos );
 	}
 	else
-		m_aiRequest.ClearMoveTarget();
+		aiRequest.ClearMoveTarget();
 
 	float fDesiredSpeed = 0.0f;
 
 	if (movementRequest.HasDesiredSpeed())
 		fDesiredSpeed = movementRequest.GetDesiredSpeed();
 	else
-		m_aiRequest.ClearDesiredSpeed();
+		aiRequest.ClearDesiredSpeed();
 
 	if (movementRequest.HasForcedNavigation())
 	{
 		const Vec3 forcedNavigation = movementRequest.GetForcedNavigation();
 		const Vec3 entityPos = m_pEntity->GetWorldPos();
-		m_aiRequest.SetForcedNavigation(forcedNavigation);
-		m_aiRequest.SetMoveTarget(entityPos+forcedNavigation.GetNormalizedSafe()*100.0f);
+		aiRequest.SetForcedNavigation(forcedNavigation);
+		aiRequest.SetMoveTarget(entityPos+forcedNavigation.GetNormalizedSafe()*100.0f);
 		
 		if (fabsf(fDesiredSpeed) <= FLT_EPSILON)
 			fDesiredSpeed = forcedNavigation.GetLength();
 	}
 	else
-		m_aiRequest.ClearForcedNavigation();
+		aiRequest.ClearForcedNavigation();
+
+	aiRequest.SetDesiredSpeed(fDesiredSpeed);
 
-	m_aiRequest.SetDesiredSpeed(fDesiredSpeed);
+	PublishMovementInput();
 
 	if(fabs(fDesiredSpeed) > FLT_EPSILON)
 	{
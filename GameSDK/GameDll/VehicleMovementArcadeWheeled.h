@@ -20,6 +20,7 @@ History:
 #include "IVehicleSystem.h"
 #include "VehicleMovementBase.h"
 #include "Vehicle/VehicleUtils.h"
+#include "Vehicle/VehicleWheelSolver.h"
 #include "VehicleSystem/VehicleNoiseGenerator.h"
 
 // There is no need to net serialise
@@ -86,11 +87,7 @@ struct SVehicleWheel
 		axleIndex        = 0;
 		bCanLock         = 0;
 		locked           = 0;
-		chassisK0        = 0.f;
-		chassisK1        = 0.f;
 		invWheelK        = 0.f;
-		chassisW0.zero();
-		chassisW1.zero();
 	}
 
 	Vec3 offset;
@@ -99,11 +96,6 @@ struct SVehicleWheel
 	Vec3 contactNormal;
 
 	// Solver constants
-	// Responses: An impluse of 1.0 produces this velocity response, i.e. velocityChange = k * impulse
-	float chassisK0;  // velocityChange = k0 * frictionDir[0] * impulseScale
-	float chassisK1;  // velocityChange = k1 * frictionDir[1] * impulseScale
-	Vec3 chassisW0;   // angVelocityChange = W0 * impulseScale,   if an impulse of frictionDir[0]*impulseScale is applied at the chassis
-	Vec3 chassisW1;   // angVelocityChange = W1 * impulseScale,   if an impulse of frictionDir[1]*impulseScale is applied at the chassis
 	float invWheelK;  // (inv) response at the contact point of the wheel with ground
 
 	IVehiclePart* wheelPart;
@@ -231,6 +223,7 @@ class CVehicleMovementArcadeWheeled
 	friend class CNetworkMovementArcadeWheeled;
 public:
 	enum {maxWheels=18};
+	enum {maxSolverSubsteps=4};
 	enum {k_frictionNotSet=0, k_frictionUseLowLevel, k_frictionUseHiLevel}; // Friction State
 
 public:
@@ -320,7 +313,7 @@ protected:
 	float CalcSteering(float steer, float speedRel, float rotateYaw, float dt);
 	void TickGears(float dt, float averageWheelSpeed, float throttle, float forwardSpeed, float contact);
 	void EnableLowLevelPhysics(int state, int bThreadSafe);
-	void InternalPhysicsTick(float dt);
+	void InternalPhysicsTick(float dt, int numSubsteps = 1);
 	void GetCurrentWheelStatus(IPhysicalEntity* pPhysics);
 
 	void UpdateWaterLevels();
@@ -488,6 +481,7 @@ protected:
 	float m_damageRPMScale;
 
 	SVehicleChassis m_chassis;
+	CVehicleWheelSolver m_wheelSolver;		// physics thread
 
 	typedef std::vector<SVehicleWheel> TWheelArray;
 	typedef std::vector<pe_status_wheel> TPEStatusWheelArray;
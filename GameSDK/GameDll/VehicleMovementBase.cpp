@@ -23,6 +23,7 @@ History:
 #include "GameUtils.h"
 #include "VehicleClient.h"
 #include "GamePhysicsSettings.h"
+#include "Vehicle/VehicleServerLod.h"
 
 #define RUNSOUND_FADEIN_TIME 0.5f
 #define RUNSOUND_FADEOUT_TIME 0.5f
@@ -76,7 +77,12 @@ CVehicleMovementBase::CVehicleMovementBase()
 	m_collisionForceFeedbackFxId(InvalidForceFeedbackFxId),
 	m_localSpeed(ZERO),
 	m_localAccel(ZERO),
-	m_engineIgnitionTime(1.6f)
+	m_engineIgnitionTime(1.6f),
+	m_serverUpdateFrameId(0),
+	m_serverSkippedTime(0.f),
+	m_serverUpdateSkipped(false),
+	m_acquiredSerial(0),
+	m_lockFreeInput(false)
 { 
 	m_pWind[0] = m_pWind[1] = NULL;
 	m_ejectionTimer = 0.f;
@@ -369,7 +375,7 @@ void CVehicleMovementBase::ResetInput()
 {
 	ResetBoost();
 
-	m_movementAction.Clear();
+	ClearMovementAction(false);
 }
 
 //------------------------------------------------------------------------
@@ -403,6 +409,9 @@ void CVehicleMovementBase::Reset()
 	m_isProbablyDistant = 0;
 	m_isProbablyVisible = 1;
 
+	m_serverSkippedTime = 0.f;
+	m_serverUpdateSkipped = false;
+
 	m_damage = 0.0f;
 
 	m_isEngineDisabled = false;
@@ -453,8 +462,7 @@ void CVehicleMovementBase::Reset()
 
 	//InitWind();
 
-	m_movementAction.Clear();
-	m_movementAction.brake = true;  
+	ClearMovementAction(true);
 	m_bMovementProcessingEnabled = true;
 
 	m_lastMeasuredVel.zero();
@@ -517,13 +525,15 @@ void CVehicleMovementBase::ProcessMovement(const float deltaTime)
 //------------------------------------------------------------------------
 void CVehicleMovementBase::RequestActions(const SVehicleMovementAction& movementAction)
 { 
-	m_movementAction = movementAction;
+	SVehicleMovementAction action = movementAction;
 
 	for (TVehicleMovementActionFilterList::iterator ite = m_actionFilters.begin(); ite != m_actionFilters.end(); ++ite)
 	{
 		IVehicleMovementActionFilter* pActionFilter = *ite;
-		pActionFilter->OnProcessActions(m_movementAction);
+		pActionFilter->OnProcessActions(action);
 	}
+
+	SetMovementAction(action);
 }
 
 //------------------------------------------------------------------------
@@ -535,10 +545,51 @@ void CVehicleMovementBase::UpdateSpeedRatio(const float deltaTime)
 }
 
 //------------------------------------------------------------------------
-void CVehicleMovementBase::Update(const float deltaTime)
+bool CVehicleMovementBase::BeginServerUpdate(float& deltaTime)
+{
+	// The override and the base update it calls get the same answer
+	const uint32 frameId = SVehicleServerLod::GetFrameId();
+	if (frameId == m_serverUpdateFrameId)
+		return !m_serverUpdateSkipped;
+
+	m_serverUpdateFrameId = frameId;
+
+	// Engine start and stop run at full rate, the state changes with them are gameplay
+	int interval = 1;
+	if (g_pGameCVars->v_serverLod && gEnv->bServer && !IsPresentationEnabled() && !m_isEngineStarting && !m_isEngineGoingOff)
+	{
+		if (!SVehicleServerLod::IsRelevant(m_pVehicle->GetEntity()->GetWorldPos()))
+			interval = max(g_pGameCVars->v_serverLodInterval, 1);
+	}
+
+	// spread the vehicles updating at a lower rate over the frames
+	m_serverUpdateSkipped = (interval > 1) && ((frameId + m_pVehicle->GetEntityId()) % interval) != 0;
+	if (m_serverUpdateSkipped)
+	{
+		m_serverSkippedTime += deltaTime;
+	}
+	else
+	{
+		deltaTime += m_serverSkippedTime;
+		m_serverSkippedTime = 0.f;
+	}
+
+	SVehicleServerLod::RecordUpdate(m_serverUpdateSkipped);
+
+	return !m_serverUpdateSkipped;
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementBase::Update(const float frameTime)
 {  
 	FUNCTION_PROFILER( GetISystem(), PROFILE_GAME );
 
+	float deltaTime = frameTime;
+	if (!BeginServerUpdate(deltaTime))
+		return;
+
+	const bool presentation = IsPresentationEnabled();
+
 	IPhysicalEntity* pPhysics = GetPhysics();
 
 	pe_status_pos psp;
@@ -605,7 +656,8 @@ void CVehicleMovementBase::Update(const float deltaTime)
 	}  
 
 #if ENABLE_VEHICLE_DEBUG
-	DebugDraw(deltaTime);
+	if (presentation)
+		DebugDraw(deltaTime);
 #endif
 
 	if (m_isEngineStarting)
@@ -617,7 +669,7 @@ void CVehicleMovementBase::Update(const float deltaTime)
 		if (m_runSoundDelay>0.f && m_engineStartup >= m_runSoundDelay)
 		{
 			ISound* pRunSound = GetSound(eSID_Run);
-			if (!pRunSound)
+			if (!pRunSound && presentation)
 			{
 				// start run 
 				pRunSound = PlaySound(eSID_Run, 0.f, m_enginePos);
@@ -633,9 +685,12 @@ void CVehicleMovementBase::Update(const float deltaTime)
 
 			m_rpmScale = fadeInRatio * ms_engineSoundIdleRatio;
 
-			SetSoundParam(eSID_Run, "rpm_scale", m_rpmScale);
-			SetSoundParam(eSID_Ambience, "speed", m_rpmScale);
-			SetSoundParam(eSID_Ambience, "rpm_scale", m_rpmScale);
+			if (presentation)
+			{
+				SetSoundParam(eSID_Run, "rpm_scale", m_rpmScale);
+				SetSoundParam(eSID_Ambience, "speed", m_rpmScale);
+				SetSoundParam(eSID_Ambience, "rpm_scale", m_rpmScale);
+			}
 
 			if(m_pVehicle->IsPlayerPassenger())
 			{
@@ -659,7 +714,7 @@ void CVehicleMovementBase::Update(const float deltaTime)
 
 		m_rpmScale = max(0.f, m_rpmScale - ms_engineSoundIdleRatio / RUNSOUND_FADEOUT_TIME * deltaTime);
 
-		if (m_rpmScale <= ms_engineSoundIdleRatio && !GetSound(eSID_Stop))
+		if (presentation && m_rpmScale <= ms_engineSoundIdleRatio && !GetSound(eSID_Stop))
 		{
 			// start stop sound and stop start sound, for now without fading
 			StopSound(eSID_Start);      
@@ -667,16 +722,19 @@ void CVehicleMovementBase::Update(const float deltaTime)
 		}
 
 		// handle run sound 
-		if (m_rpmScale <= 0.f)
+		if (presentation)
 		{
-			StopSound(eSID_Ambience);
-			StopSound(eSID_Run);
-			StopSound(eSID_Damage);
+			if (m_rpmScale <= 0.f)
+			{
+				StopSound(eSID_Ambience);
+				StopSound(eSID_Run);
+				StopSound(eSID_Damage);
+			}
+			else      
+			{ 
+				SetSoundParam(eSID_Run, "rpm_scale", m_rpmScale);
+			} 
 		}
-		else      
-		{ 
-			SetSoundParam(eSID_Run, "rpm_scale", m_rpmScale);
-		} 
 
 		if (m_engineStartup <= 0.0f && m_rpmScale <= 0.f)
 		{
@@ -709,15 +767,18 @@ void CVehicleMovementBase::Update(const float deltaTime)
 		}
 	}
 
-	m_soundStats.inout = 1.f;   
-	if (firstperson)
-	{ 
-		if (IVehicleSeat* pSeat = m_pVehicle->GetSeatForPassenger(pClientActor->GetEntityId()))
-			m_soundStats.inout = pSeat->GetSoundParams().inout;  
-	}
+	if (presentation)
+	{
+		m_soundStats.inout = 1.f;   
+		if (firstperson)
+		{ 
+			if (IVehicleSeat* pSeat = m_pVehicle->GetSeatForPassenger(pClientActor->GetEntityId()))
+				m_soundStats.inout = pSeat->GetSoundParams().inout;  
+		}
 
-	SetSoundParam(eSID_Run, "in_out", m_soundStats.inout);
-	SetSoundParam(eSID_Ambience, "thirdperson", 1.f-firstperson);
+		SetSoundParam(eSID_Run, "in_out", m_soundStats.inout);
+		SetSoundParam(eSID_Ambience, "thirdperson", 1.f-firstperson);
+	}
   
 	// Update Game Tokens
 	if(m_pVehicle->IsPlayerDriving(true)||m_pVehicle->IsPlayerPassenger())
@@ -851,7 +912,7 @@ void CVehicleMovementBase::SetDamage(float damage, bool fatal)
     m_isEngineStarting = false;
     m_isEngineGoingOff = false;
 
-    m_movementAction.Clear();
+    ClearMovementAction(false);
     StopExhaust();
     StopSounds();
   }
@@ -882,8 +943,7 @@ bool CVehicleMovementBase::StartDriving( EntityId driverId )
 
 	m_actorId = driverId;
 
-	m_movementAction.Clear();
-	m_movementAction.brake = false;
+	ClearMovementAction(false);
 
 	return StartEngine();
 }
@@ -946,8 +1006,7 @@ void CVehicleMovementBase::StopEngine()
 	m_isEngineStarting = false;
 	m_isEngineGoingOff = true;
 
-	m_movementAction.Clear();
-	m_movementAction.brake = true;
+	ClearMovementAction(true);
 
 	// Reset Game Tokens
 	if(m_pVehicle->IsPlayerDriving(true)||m_pVehicle->IsPlayerPassenger())
@@ -1011,32 +1070,41 @@ void CVehicleMovementBase::DisableEngine(bool disable)
 }
 
 //------------------------------------------------------------------------
-void CVehicleMovementBase::OnAction(const TVehicleActionId actionId, int activationMode, float value)
+/*static*/ bool CVehicleMovementBase::ApplyMovementAction(SVehicleMovementAction& movementAction, const TVehicleActionId actionId, float value)
 {
 	if (actionId == eVAI_RotatePitch)
-		m_movementAction.rotatePitch = value;
+		movementAction.rotatePitch = value;
 
 	else if (actionId == eVAI_RotateYaw)
-		m_movementAction.rotateRoll = value;
+		movementAction.rotateRoll = value;
 
 	else if (actionId == eVAI_MoveForward || actionId == eVAI_XIAccelerate)
 	{
-		m_movementAction.power = value;
+		movementAction.power = value;
 	}
   else if (actionId == eVAI_MoveBack || actionId == eVAI_XIDeccelerate)
 	{
-		m_movementAction.power = -value;
+		movementAction.power = -value;
 	}
 	else if (actionId == eVAI_TurnLeft)
-		m_movementAction.rotateYaw = -value;
+		movementAction.rotateYaw = -value;
 
 	else if (actionId == eVAI_TurnRight)
-		m_movementAction.rotateYaw = value;
+		movementAction.rotateYaw = value;
 
 	else if (actionId == eVAI_Brake)
-		m_movementAction.brake = (value > 0.0f);  
+		movementAction.brake = (value > 0.0f);  
 
-  else if (actionId == eVAI_Boost)
+	else
+		return false;
+
+	return true;
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementBase::OnAction(const TVehicleActionId actionId, int activationMode, float value)
+{
+	if (!ApplyMovementAction(m_movementAction, actionId, value) && actionId == eVAI_Boost)
   { 
     if (!Boosting() && activationMode == eAAM_OnPress)
       Boost(true);    
@@ -1050,6 +1118,81 @@ void CVehicleMovementBase::OnAction(const TVehicleActionId actionId, int activat
 	}
 }
 
+//------------------------------------------------------------------------
+void CVehicleMovementBase::OnActionLockFree(const TVehicleActionId actionId, int activationMode, float value)
+{
+	if (!ApplyMovementAction(m_movementInput.action, actionId, value))
+	{
+		// boost and the rest are handled on the main thread anyway
+		CVehicleMovementBase::OnAction(actionId, activationMode, value);
+		return;
+	}
+
+	PublishMovementInput();
+
+	if(fabs(m_movementInput.action.power) > FLT_EPSILON || fabs(m_movementInput.action.rotateYaw) > FLT_EPSILON)
+	{
+		m_pVehicle->NeedsUpdate(IVehicle::eVUF_AwakePhysics);
+	}
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementBase::SetMovementAction(const SVehicleMovementAction& action)
+{
+	if (!m_lockFreeInput)
+		m_movementAction = action;
+
+	m_movementInput.action = action;
+	++m_movementInput.actionSerial;
+	PublishMovementInput();
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementBase::ClearMovementAction(bool brake)
+{
+	SVehicleMovementAction action;
+	action.Clear();
+	action.brake = brake;
+	SetMovementAction(action);
+}
+
+//------------------------------------------------------------------------
+// NOTE: Called from ProcessMovement, must be thread-safe
+bool CVehicleMovementBase::AcquireMovementInput()
+{
+	if (!m_movementInputExchange.Acquire())
+		return false;
+
+	// Only what the main thread changed is taken over, the physics step (and the network sync
+	// of remote drivers) owns m_movementAction in between. An action set as a whole replaces it.
+	const SMovementInput& input = m_movementInputExchange.Get();
+	const SVehicleMovementAction& action = input.action;
+
+	if (input.actionSerial != m_acquiredSerial)
+	{
+		const bool isAI = m_movementAction.isAI;
+		m_movementAction = action;
+		m_movementAction.isAI = isAI;
+		m_acquiredSerial = input.actionSerial;
+	}
+	else
+	{
+		if (action.power != m_acquiredAction.power)
+			m_movementAction.power = action.power;
+		if (action.rotateYaw != m_acquiredAction.rotateYaw)
+			m_movementAction.rotateYaw = action.rotateYaw;
+		if (action.rotatePitch != m_acquiredAction.rotatePitch)
+			m_movementAction.rotatePitch = action.rotatePitch;
+		if (action.rotateRoll != m_acquiredAction.rotateRoll)
+			m_movementAction.rotateRoll = action.rotateRoll;
+		if (action.brake != m_acquiredAction.brake)
+			m_movementAction.brake = action.brake;
+	}
+
+	m_acquiredAction = action;
+	return true;
+}
+
 //------------------------------------------------------------------------
 void CVehicleMovementBase::ResetBoost()
 {  
@@ -2445,7 +2588,7 @@ void CVehicleMovementBase::Serialize(TSerialize ser, EEntityAspects aspects)
 //------------------------------------------------------------------------
 void CVehicleMovementBase::PostSerialize()
 {
-  m_movementAction.Clear();
+  ClearMovementAction(false);
 
   if (m_isEnginePowered || m_isEngineStarting)
   {
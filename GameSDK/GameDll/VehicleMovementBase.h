@@ -19,6 +19,7 @@ History:
 #include <IForceFeedbackSystem.h>
 #include "Actor.h"
 #include "IMaterialEffects.h"
+#include "Vehicle/VehicleThreadExchange.h"
 
 #define ENGINESOUND_MAX_DIST 150.f
 
@@ -415,6 +416,20 @@ protected:
 	ILINE IPhysicalEntity* GetPhysics() const { return m_pVehicle->GetEntity()->GetPhysics(); }
 	bool IsProfilingMovement();
 
+	// Nothing is drawn or heard on a dedicated server
+	static ILINE bool IsPresentationEnabled()
+	{
+#if defined(DEDICATED_SERVER)
+		return false;
+#else
+		return !gEnv->IsDedicated();
+#endif
+	}
+
+	// Update rate lod on dedicated servers, called first by Update and by the overrides of it.
+	// Returns false if this frame is skipped, otherwise adds the time of the skipped frames to deltaTime
+	bool BeginServerUpdate(float& deltaTime);
+
 	// sound methods
 	ISound* PlaySound(EVehicleMovementSound eSID, float pulse=0.f, const Vec3& offset=Vec3Constants<float>::fVec3_Zero, int soundFlags=0);
 	ISound* GetOrPlaySound(EVehicleMovementSound eSID, float pulse=0.f, const Vec3& offset=Vec3Constants<float>::fVec3_Zero, int soundFlags=0);
@@ -480,6 +495,16 @@ protected:
 
 	static void UpdatePhysicsStatus(SVehiclePhysicsStatus* status, const pe_status_pos* psp, const pe_status_dynamics* psd);
 
+	// lock-free input, for movements whose physics step picks its input up through m_movementInputExchange
+	static bool ApplyMovementAction(SVehicleMovementAction& movementAction, const TVehicleActionId actionId, float value);
+	void OnActionLockFree(const TVehicleActionId actionId, int activationMode, float value);
+	void PublishMovementInput() { m_movementInputExchange.Publish(m_movementInput); }
+	// main thread, replaces the whole action. With lock-free input only the physics step writes m_movementAction
+	void SetMovementAction(const SVehicleMovementAction& action);
+	void ClearMovementAction(bool brake);
+	// physics thread, returns true if new input was picked up
+	bool AcquireMovementInput();
+
 public:
 	enum { k_mainThread=0, k_physicsThread=1, k_numThreads };
 
@@ -493,6 +518,22 @@ protected:
 
 	SVehicleMovementAction m_movementAction;
 
+	// Input handed from the main thread to the physics step
+	struct SMovementInput
+	{
+		SMovementInput() : actionSerial(0) {}
+
+		SVehicleMovementAction action;
+		CMovementRequest aiRequest;
+		uint32 actionSerial;																// bumped by SetMovementAction
+	};
+
+	SMovementInput m_movementInput;											// main thread
+	SVehicleMovementAction m_acquiredAction;						// physics thread, last action picked up
+	uint32 m_acquiredSerial;														// physics thread
+	CVehicleStateExchange<SMovementInput> m_movementInputExchange;
+	bool m_lockFreeInput;																// set by the movements that use OnActionLockFree
+
 	bool m_keepEngineOn;	// If true, engine won't turn off if the driver leaves.
 	bool m_isEngineDisabled;
 	bool m_isEngineStarting;
@@ -500,6 +541,11 @@ protected:
 	uint8 m_isProbablyDistant : 1;
 	uint8 m_isProbablyVisible : 1;
 
+	// see BeginServerUpdate
+	uint32 m_serverUpdateFrameId;
+	float m_serverSkippedTime;
+	bool m_serverUpdateSkipped;
+
 	float m_engineStartup;
 	float m_engineIgnitionTime;
 	uint32 m_engineDisabledTimerId;
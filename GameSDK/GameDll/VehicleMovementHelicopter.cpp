@@ -22,6 +22,7 @@ History:
 #include "ICryAnimation.h"
 #include "GameUtils.h"
 #include "Vehicle/VehicleUtils.h"
+#include "Vehicle/VehicleServerLod.h"
 
 #include "IRenderAuxGeom.h"
 
@@ -103,6 +104,7 @@ CVehicleMovementHelicopter::CVehicleMovementHelicopter() :
 	m_bApplyNoiseAsVelocity(true),
 	m_sendTime(0.f),
 	m_sendTimer(0.f),
+	m_netUnchangedTime(0.f),
 	m_updateAspects(CNetworkMovementHelicopterCrysis2::CONTROLLED_ASPECT),
 	m_pNoise(&m_defaultNoise)
 {
@@ -372,7 +374,7 @@ void CVehicleMovementHelicopter::OnEvent(EVehicleMovementEvent event, const SVeh
 //------------------------------------------------------------------------
 void CVehicleMovementHelicopter::OnAction(const TVehicleActionId actionId, int activationMode, float value)
 {
-	CryAutoCriticalSection lk(m_lock);
+	CVehicleScopedLock lk(m_lock);
 
 	CVehicleMovementBase::OnAction(actionId, activationMode, value);
 
@@ -466,7 +468,7 @@ void CVehicleMovementHelicopter::ProcessAI(const float deltaTime)
 {
 	FUNCTION_PROFILER( GetISystem(), PROFILE_GAME );
 
-	CryAutoCriticalSection lk(m_lock);
+	CVehicleScopedLock lk(m_lock);
 	SVehiclePhysicsStatus* physStatus = &m_physStatus[k_physicsThread];
 		
 	if (m_arcade.m_handling.maxSpeedForward>0.f) // Use the new handling code
@@ -697,7 +699,7 @@ void CVehicleMovementHelicopter::ProcessMovement(const float deltaTime)
 	
 	if (m_arcade.m_handling.maxSpeedForward>0.f) // Use the new handling code
 	{
-		CryAutoCriticalSection lk(m_lock);
+		CVehicleScopedLock lk(m_lock);
 
 		if (!m_isEnginePowered)
 			return;
@@ -797,31 +799,52 @@ void CVehicleMovementHelicopter::UpdateEngine(float deltaTime)
 
 
 //------------------------------------------------------------------------
-void CVehicleMovementHelicopter::Update(const float deltaTime)
+void CVehicleMovementHelicopter::Update(const float frameTime)
 {
   FUNCTION_PROFILER( GetISystem(), PROFILE_GAME );
 
+	float deltaTime = frameTime;
+	if (!BeginServerUpdate(deltaTime))
+		return;
+
 	CVehicleMovementBase::Update(deltaTime);
 
 	UpdateDamages(deltaTime);
 	UpdateEngine(deltaTime);
 
 	{
-		CryAutoCriticalSection lk(m_lock);
+		CVehicleScopedLock lk(m_lock);
 		m_netActionSync.Read(this);
 		if (gEnv->bServer)
 		{
 			m_sendTimer -= deltaTime;
+			m_netUnchangedTime += deltaTime;
 			if (m_sendTimer<=0.f)
 			{
-				m_netActionSync.Write(this);
-				CHANGED_NETWORK_STATE(m_pVehicle, m_updateAspects);
 				m_sendTimer = m_sendTime;
+
+				// With the server lod on, state that hasn't moved since it was last sent only goes out to keep clients alive
+				CNetworkMovementHelicopterCrysis2 current(m_netActionSync.m_actionRep);
+				current.Write(this);
+
+				const bool unchanged = g_pGameCVars->v_serverLod && m_netUnchangedTime < g_pGameCVars->v_serverLodNetKeepAlive
+					&& current.IsEquivalent(m_netActionSync.m_actionRep);
+
+				if (!unchanged)
+				{
+					m_netActionSync.Write(this);
+					CHANGED_NETWORK_STATE(m_pVehicle, m_updateAspects);
+					m_netUnchangedTime = 0.f;
+				}
+
+				SVehicleServerLod::RecordNetSend(unchanged);
 			}
 		}
 	}
-			
-	SetSoundParam(eSID_Run, "rpm_scale", m_rpmScale);
+
+	const bool presentation = IsPresentationEnabled();
+	if (presentation)
+		SetSoundParam(eSID_Run, "rpm_scale", m_rpmScale);
 
 	// update animation
 	if(m_isEngineGoingOff)
@@ -836,7 +859,8 @@ void CVehicleMovementHelicopter::Update(const float deltaTime)
 		}
 	}
 
-	SetAnimationSpeed(eVMA_Engine, (m_enginePower / m_enginePowerMax));
+	if (presentation)
+		SetAnimationSpeed(eVMA_Engine, (m_enginePower / m_enginePowerMax));
 }
 
 //------------------------------------------------------------------------
@@ -875,7 +899,7 @@ bool CVehicleMovementHelicopter::RequestMovement(CMovementRequest& movementReque
   }
 
 
-	CryAutoCriticalSection lk(m_lock);
+	CVehicleScopedLock lk(m_lock);
 
 
 	if (movementRequest.HasLookTarget())
@@ -1108,6 +1132,17 @@ void CNetworkMovementHelicopterCrysis2::Write(CVehicleMovementHelicopter* pMovem
 	m_currentRot = ps.q;
 }
 
+//------------------------------------------------------------------------
+bool CNetworkMovementHelicopterCrysis2::IsEquivalent(const CNetworkMovementHelicopterCrysis2& other) const
+{
+	return m_netSyncFlags == other.m_netSyncFlags
+		&& m_currentPos.IsEquivalent(other.m_currentPos, 0.01f)
+		&& Quat::IsEquivalent(m_currentRot, other.m_currentRot, 0.001f)
+		&& m_lookTarget.IsEquivalent(other.m_lookTarget, 0.1f)
+		&& m_moveTarget.IsEquivalent(other.m_moveTarget, 0.1f)
+		&& fabs_tpl(m_desiredSpeed - other.m_desiredSpeed) < 0.01f;
+}
+
 //------------------------------------------------------------------------
 void CNetworkMovementHelicopterCrysis2::Read(CVehicleMovementHelicopter* pMovement)
 {
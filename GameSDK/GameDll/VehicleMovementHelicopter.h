@@ -21,6 +21,9 @@ public:
 	void Read(CVehicleMovementHelicopter* pMovement);
 	void Write(CVehicleMovementHelicopter* pMovement);
 	void Serialize(TSerialize ser, EEntityAspects aspects);
+
+	// Within what the clients would notice
+	bool IsEquivalent(const CNetworkMovementHelicopterCrysis2& other) const;
 	
 	ILINE uint16 GetFlags() { return m_netSyncFlags; }
 	ILINE void SetFlags(uint16 f) { m_netSyncFlags = f; }
@@ -194,6 +197,7 @@ protected:
 	// Network related
 	float m_sendTime;
 	float m_sendTimer;
+	float m_netUnchangedTime;				// since the state was last sent
 	NetworkAspectType m_updateAspects;
 	Vec3 m_netPosAdjust;
 	CVehicleNetActionSync<CNetworkMovementHelicopterCrysis2> m_netActionSync;
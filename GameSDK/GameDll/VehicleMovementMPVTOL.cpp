@@ -160,8 +160,12 @@ void CVehicleMovementMPVTOL::Reset()
 	m_rightWingRotationSmoothRate = 0.f;
 }
 
-void CVehicleMovementMPVTOL::Update(const float deltaTime)
+void CVehicleMovementMPVTOL::Update(const float frameTime)
 {
+	float deltaTime = frameTime;
+	if (!BeginServerUpdate(deltaTime))
+		return;
+
 	BaseClass::Update(deltaTime);
 
 	//Update wing rotation based on linear and angular velocities
@@ -365,7 +369,7 @@ void CVehicleMovementMPVTOL::PostInit()
 // NOTE: This function must be thread-safe. Before adding stuff contact MarcoC.
 void CVehicleMovementMPVTOL::ProcessAI( const float deltaTime )
 {
-	CryAutoCriticalSection lk(m_lock);
+	CVehicleScopedLock lk(m_lock);
 	const SVehiclePhysicsStatus& physStatus = m_physStatus[k_physicsThread];
 
 	if(!m_bApplyNoiseAsVelocity)
@@ -380,7 +384,7 @@ void CVehicleMovementMPVTOL::ProcessAI( const float deltaTime )
 
 void CVehicleMovementMPVTOL::SetPathInfo( const SPathFollowingAttachToPathParameters& params, const CWaypointPath* pPath )
 {
-	CryAutoCriticalSection lk(m_lock);
+	CVehicleScopedLock lk(m_lock);
 
 	m_pathing.SetPathInfo( params, pPath );
 
@@ -414,7 +418,7 @@ void CVehicleMovementMPVTOL::SnapToPathLoc( const SVTOLPathPosParams& data )
 
 void CVehicleMovementMPVTOL::ReceivedServerPathingData( const SVTOLPathPosParams& data )
 {
-	CryAutoCriticalSection lk(m_lock);
+	CVehicleScopedLock lk(m_lock);
 
 	//CryLog( "[VTOL] CLUPDATE: path[%d] loc[%f]", data.pathId, data.location );
 
@@ -439,7 +443,7 @@ void CVehicleMovementMPVTOL::ReceivedServerPathingData( const SVTOLPathPosParams
 
 void CVehicleMovementMPVTOL::UpdatePathSpeed( const float speed )
 {
-	CryAutoCriticalSection lk(m_lock);
+	CVehicleScopedLock lk(m_lock);
 
 	m_pathing.defaultSpeed = m_pathing.speed = speed;
 }
@@ -449,7 +453,7 @@ bool CVehicleMovementMPVTOL::FillPathingParams( struct SPathFollowingAttachToPat
 	if(!m_pathing.pCachedPathPtr)
 		return false;
 
-	CryAutoCriticalSection lk(m_lock);
+	CVehicleScopedLock lk(m_lock);
 
 	params.pathIndex = m_pathing.pathingData.pathId;
 	params.nodeIndex = m_pathing.currentNode;
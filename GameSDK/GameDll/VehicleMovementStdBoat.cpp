@@ -19,6 +19,9 @@ History:
 #include "VehicleMovementStdBoat.h"
 #include <IAgent.h>
 #include "Network/NetActionSync.h"
+#include "Utility/CryWatch.h"
+#include "Environment/WaterQueryCache.h"
+#include "AI/GameAISystem.h"
 
 
 //------------------------------------------------------------------------
@@ -52,15 +55,39 @@ CVehicleMovementStdBoat::CVehicleMovementStdBoat()
 , m_pWaveEffect(NULL)
 , m_factorMaxSpeed(1.f)
 , m_factorAccel(1.f)
+, m_netSnapshotTimer(0.f)
+, m_netClockOffset(0)
+, m_netCompact(false)
+, m_netSnapshotProducer(false)
+, m_netSnapshotValid(false)
+, m_netPublishedSnapshotId(0)
+, m_netSentSnapshotId(0)
+, m_useHullBuoyancy(false)
+, m_wakeUpdatePending(false)
+, m_steeringAgent(CShipSteeringManager::kInvalidId)
+, m_steeringObstacle(CShipSteeringManager::kInvalidId)
+, m_steeringObstaclePos(ZERO)
+, m_steeringGoal(ZERO)
+, m_steeringGoalValid(false)
 { 
   m_lateralDamping = 0.f;
 	m_rollAccel = 0.f;
-  m_netActionSync.PublishActions( CNetworkMovementStdBoat(this) );
+	m_lockFreeInput = true;
+  m_netActionSync.PublishActions( CNetworkMovementStdBoat(this, m_netSnapshot) );
 }
 
 //------------------------------------------------------------------------
 CVehicleMovementStdBoat::~CVehicleMovementStdBoat()
 {
+	if (g_pGame && g_pGame->GetBoatEffectsManager())
+		g_pGame->GetBoatEffectsManager()->UnregisterBoat(this);
+
+	if (g_pGame && g_pGame->GetGameAISystem())
+	{
+		CShipSteeringManager& manager = g_pGame->GetGameAISystem()->GetShipSteeringManager();
+		manager.RemoveAgent(m_steeringAgent);
+		manager.RemoveObstacle(m_steeringObstacle);
+	}
 }
 
 //------------------------------------------------------------------------
@@ -131,6 +158,8 @@ bool CVehicleMovementStdBoat::Init(IVehicle* pVehicle, const CVehicleParams& tab
   
   m_massOffset = bbox.GetCenter();
 
+  m_useHullBuoyancy = (g_pGameCVars->v_boatHullBuoyancy != 0) && m_hullBuoyancy.Init(table);
+
   //CryLog("[StdBoat movement]: got mass offset (%f, %f, %f)", m_massOffset.x, m_massOffset.y, m_massOffset.z);
 
 	m_pSplashPos = m_pVehicle->GetHelper("splashPos");
@@ -144,6 +173,9 @@ bool CVehicleMovementStdBoat::Init(IVehicle* pVehicle, const CVehicleParams& tab
 	MOVEMENT_VALUE_OPT("waveEffect", &waveEffect, table);
 	m_pWaveEffect = gEnv->pParticleManager->FindEffect(waveEffect, "MovementStdBoat");
 
+	if (gEnv->IsClient())
+		g_pGame->GetBoatEffectsManager()->RegisterBoat(this);
+
   m_waveTimer = Random()*gf_PI;
   m_diving = false;
   m_wakeSlot = -1;   
@@ -157,6 +189,11 @@ bool CVehicleMovementStdBoat::Init(IVehicle* pVehicle, const CVehicleParams& tab
 	m_factorMaxSpeed = 1.f;
 	m_factorAccel = 1.f;
 
+	// Ship network mode replaces the low level physics synchronisation with snapshots and dead reckoning
+	m_netCompact = gEnv->bMultiplayer && (g_pGameCVars->v_boatNetMode != 0);
+	if (m_netCompact)
+		m_pVehicle->GetGameObject()->DontSyncPhysics();
+
   return true;
 }
 
@@ -176,6 +213,19 @@ void CVehicleMovementStdBoat::Reset()
   m_inWater = false;  
 	m_factorMaxSpeed = 1.f;
 	m_factorAccel = 1.f;
+
+	m_netSnapshotTimer = 0.f;
+	m_netSnapshotValid = false;
+	m_netPublishedSnapshotId = 0;
+	m_netSentSnapshotId = 0;
+	m_netStats.Reset();
+
+	m_boatInput.floodMass = 0.f;
+	m_boatInput.floodCentre.zero();
+	m_boatInput.steerValid = false;
+	PublishBoatInput();
+
+	m_steeringGoalValid = false;
 }
 
 //------------------------------------------------------------------------
@@ -200,6 +250,15 @@ void CVehicleMovementStdBoat::PostPhysicalize()
     pfd.iForeignFlagsOR = PFF_UNIMPORTANT;    
     GetPhysics()->SetParams(&pfd);
   }  
+
+  // the hull points take over from the physics buoyancy, which treats the whole hull as one volume
+  if (m_useHullBuoyancy && m_hullBuoyancy.ReplacesPhysicsBuoyancy())
+  {
+    pe_params_buoyancy buoyancy;
+    buoyancy.kwaterDensity = 0.f;
+    buoyancy.kwaterResistance = 0.f;
+    GetPhysics()->SetParams(&buoyancy);
+  }
 }
 
 
@@ -235,22 +294,62 @@ void CVehicleMovementStdBoat::OnEvent(EVehicleMovementEvent event, const SVehicl
 void CVehicleMovementStdBoat::OnAction(const TVehicleActionId actionId, int activationMode, float value)
 {
 
-	CryAutoCriticalSection netlk(m_networkLock);
-	CryAutoCriticalSection lk(m_lock);
+	CVehicleScopedLock netlk(m_networkLock);
 
-	CVehicleMovementBase::OnAction(actionId, activationMode, value);
+	OnActionLockFree(actionId, activationMode, value);
 
 }
 
 //------------------------------------------------------------------------
-void CVehicleMovementStdBoat::Update(const float deltaTime)
+void CVehicleMovementStdBoat::Update(const float frameTime)
 {
+	float deltaTime = frameTime;
+	if (!BeginServerUpdate(deltaTime))
+		return;
+
 	CVehicleMovementBase::Update(deltaTime);
 
-	SetAnimationSpeed(eVMA_Engine, abs(m_rpmScaleSgn));
-	if (m_inWater)
-	{ 
-		SetSoundParam(eSID_Run, "slip", 0.2f*abs(m_localSpeed.x)); 
+	if (IsPresentationEnabled())
+	{
+		SetAnimationSpeed(eVMA_Engine, abs(m_rpmScaleSgn));
+		if (m_inWater)
+		{ 
+			SetSoundParam(eSID_Run, "slip", 0.2f*abs(m_localSpeed.x)); 
+		}
+	}
+
+	if (m_netCompact && m_bNetSync)
+		UpdateNetSnapshot(deltaTime);
+
+	if (m_bNetSync)
+		m_netStats.totalTime += deltaTime;
+
+	if (g_pGameCVars->v_boatNetStats)
+		UpdateNetStats(deltaTime);
+
+	if (gEnv->bServer || m_steeringAgent != CShipSteeringManager::kInvalidId || m_steeringObstacle != CShipSteeringManager::kInvalidId)
+		UpdateSteering();
+
+	if (m_useHullBuoyancy)
+	{
+		CVehicleHullBuoyancy::ELod lod = (CVehicleHullBuoyancy::ELod)g_pGameCVars->v_boatHullLod;
+		if (lod < CVehicleHullBuoyancy::eLod_Low || lod > CVehicleHullBuoyancy::eLod_High)
+		{
+			// A dedicated server has no camera, and its simulation is the one every client is corrected to
+			if (gEnv->bServer && !IsPresentationEnabled())
+				lod = CVehicleHullBuoyancy::eLod_High;
+			else
+			{
+				const float distSq = m_pVehicle->GetEntity()->GetWorldPos().GetSquaredDistance(gEnv->pRenderer->GetCamera().GetPosition());
+				lod = m_hullBuoyancy.SelectLod(distSq, m_pVehicle->GetGameObject()->IsProbablyVisible());
+			}
+		}
+
+		if (lod != m_boatInput.hullLod)
+		{
+			m_boatInput.hullLod = lod;
+			PublishBoatInput();
+		}
 	}
 
 #if ENABLE_VEHICLE_DEBUG
@@ -272,7 +371,7 @@ void CVehicleMovementStdBoat::Update(const float deltaTime)
 		static const float fWaterLevelMaxDiff = 0.15f; // max allowed height difference between propeller center and water level
 
 		Vec3 worldPropPos = wTM * m_pushOffset;  
-		float waterLevelWorld = gEnv->p3DEngine->GetWaterLevel( &worldPropPos );
+		float waterLevelWorld = g_pGame->GetWaterQueryCache()->GetWaterLevel(worldPropPos, CWaterQueryCache::eWQ_Vehicle);
 		float fWaterLevelDiff = worldPropPos.z - waterLevelWorld;  
 
 		// wave stuff 
@@ -339,6 +438,334 @@ void CVehicleMovementStdBoat::Update(const float deltaTime)
 #endif
 }
 
+//------------------------------------------------------------------------
+void CVehicleMovementStdBoat::UpdateNetSnapshot(const float deltaTime)
+{
+	// Whoever simulates the ship produces the snapshots: the local driver, or the server for AI and empty ships
+	IActor* pDriver = m_pVehicle->GetDriver();
+	const bool producer = (pDriver && pDriver->IsPlayer()) ? pDriver->IsClient() : gEnv->bServer;
+
+	CVehicleScopedLock netlk(m_networkLock);
+
+	// Snapshots are stamped with the server clock, the physics step gets it through the offset to the local one
+	const int64 clockOffset = (g_pGame->GetIGameFramework()->GetServerTime() - gEnv->pTimer->GetFrameStartTime()).GetMilliSecondsAsInt64();
+	const int64 clockDrift = clockOffset - m_boatInput.netClockOffset;
+
+	if (producer != m_boatInput.netSnapshotProducer || clockDrift > 5 || clockDrift < -5)
+	{
+		m_boatInput.netSnapshotProducer = producer;
+		m_boatInput.netClockOffset = clockOffset;
+		PublishBoatInput();
+	}
+
+	if (!producer)
+		return;
+
+	m_netSnapshotTimer -= deltaTime;
+	if (m_netSnapshotTimer > 0.f)
+		return;
+
+	m_netSnapshotTimer = 1.f / max(g_pGameCVars->v_boatNetSnapshotRate, 0.1f);
+
+	CNetworkMovementStdBoat::SSnapshot& snapshot = m_boatInput.netSnapshot;
+	const SVehiclePhysicsStatus& physStatus = m_physStatus[k_mainThread];
+	snapshot.pos = physStatus.pos;
+	snapshot.rot = physStatus.q;
+	snapshot.vel = physStatus.v;
+	snapshot.sendTime = (uint16)g_pGame->GetIGameFramework()->GetServerTime().GetMilliSecondsAsInt64();
+
+	// Id 0 is reserved for "no snapshot yet"
+	if (++snapshot.id == 0)
+		++snapshot.id;
+
+	PublishBoatInput();
+}
+
+//------------------------------------------------------------------------
+// NOTE: Called from ProcessMovement through the action sync, must be thread-safe
+void CVehicleMovementStdBoat::OnNetSnapshot(const CNetworkMovementStdBoat::SSnapshot& snapshot)
+{
+	m_netSnapshot = snapshot;
+	m_netSnapshotValid = true;
+
+	CryInterlockedIncrement(&m_netStats.snapshots);
+
+	// The server only receives snapshots from a driving client, which is not trusted to move faster than the hull can
+	if (gEnv->bServer)
+	{
+		const float maxSpeed = m_velMax * m_factorMaxSpeed * max(g_pGameCVars->v_boatNetMaxClientSpeedScale, 1.f);
+		if (m_netSnapshot.vel.GetLengthSquared() > sqr(maxSpeed))
+		{
+			m_netSnapshot.vel.SetLength(maxSpeed);
+			CryInterlockedIncrement(&m_netStats.clamps);
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+// NOTE: Called from ProcessMovement, must be thread-safe
+uint16 CVehicleMovementStdBoat::GetNetClock() const
+{
+	return (uint16)(gEnv->pTimer->GetFrameStartTime().GetMilliSecondsAsInt64() + m_netClockOffset);
+}
+
+//------------------------------------------------------------------------
+// NOTE: Called from ProcessMovement, must be thread-safe
+void CVehicleMovementStdBoat::ApplyNetCorrection(IPhysicalEntity* pPhysics, const SVehiclePhysicsStatus& physStatus, const float frameTime)
+{
+	static const float fMaxSnapshotAge = 1.f;
+	static const float fMaxYawError = DEG2RAD(45.f);
+
+	// Dead reckon the last snapshot forward from the time it was taken, both are on the server clock
+	const int16 ageMs = (int16)(uint16)(GetNetClock() - m_netSnapshot.sendTime);
+	const float age = clamp(ageMs * 0.001f, 0.f, fMaxSnapshotAge);
+	const Vec3 predictedPos = m_netSnapshot.pos + m_netSnapshot.vel * age;
+
+	// Buoyancy and the waves own heave, pitch and roll of the hull, so only the position on the
+	// water plane and the heading are corrected
+	Vec3 posError = predictedPos - physStatus.pos;
+	posError.z = 0.f;
+
+	const Vec3 netFwd = m_netSnapshot.rot.GetColumn1();
+	const Vec3 curFwd = physStatus.q.GetColumn1();
+	float yawError = atan2_tpl(curFwd.x*netFwd.y - curFwd.y*netFwd.x, curFwd.x*netFwd.x + curFwd.y*netFwd.y);
+
+	if (gEnv->bServer)
+	{
+		// A client driven ship is never snapped on the server, the client can only pull it by a bounded error
+		const float maxError = g_pGameCVars->v_boatNetMaxClientError;
+		if (posError.GetLengthSquared() > sqr(maxError) || fabsf(yawError) > fMaxYawError)
+		{
+			if (posError.GetLengthSquared() > sqr(maxError))
+				posError.SetLength(maxError);
+			yawError = clamp(yawError, -fMaxYawError, fMaxYawError);
+			CryInterlockedIncrement(&m_netStats.clamps);
+		}
+	}
+	else if (posError.GetLengthSquared() > sqr(g_pGameCVars->v_boatNetSnapDistance) || fabsf(yawError) > fMaxYawError)
+	{
+		pe_params_pos snapPos;
+		snapPos.pos = Vec3(predictedPos.x, predictedPos.y, physStatus.pos.z);
+		snapPos.q = m_netSnapshot.rot;
+		pPhysics->SetParams(&snapPos);
+
+		pe_action_set_velocity snapVel;
+		snapVel.v = m_netSnapshot.vel;
+		pPhysics->Action(&snapVel, 1);
+
+		CryInterlockedIncrement(&m_netStats.snaps);
+		return;
+	}
+
+	const float correctionRate = g_pGameCVars->v_boatNetCorrectionRate;
+	const float blend = min(1.f, frameTime * correctionRate);
+
+	Vec3 velError = m_netSnapshot.vel - physStatus.v;
+	velError.z = 0.f;
+
+	pe_action_impulse correction;
+	correction.impulse = (posError * correctionRate + velError) * (physStatus.mass * blend);
+	correction.angImpulse = Vec3(0.f, 0.f, yawError * correctionRate * blend * m_Inertia.z);
+	pPhysics->Action(&correction, 1);
+}
+
+//------------------------------------------------------------------------
+// NOTE: Called from ProcessMovement, must be thread-safe
+float CVehicleMovementStdBoat::ApplyHullBuoyancy(IPhysicalEntity* pPhysics, const SVehiclePhysicsStatus& physStatus, const float frameTime)
+{
+	CVehicleHullBuoyancy::SHullState state;
+	state.pos = physStatus.pos;
+	state.q = physStatus.q;
+	state.v = physStatus.v;
+	state.w = physStatus.w;
+	state.centerOfMass = physStatus.centerOfMass;
+	state.inertia = m_Inertia;
+	state.mass = physStatus.mass;
+
+	CVehicleHullBuoyancy::SHullImpulse result;
+	m_hullBuoyancy.Integrate(state, frameTime, result);
+
+	if (result.submergedFraction > 0.f)
+	{
+		// one impulse for the whole hull
+		pe_action_impulse hullImp;
+		hullImp.impulse = result.impulse;
+		hullImp.angImpulse = result.angImpulse;
+		pPhysics->Action(&hullImp, 1);
+	}
+
+	return result.submergedFraction;
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementStdBoat::SetFloodLoad(float mass, const Vec3& localCentre)
+{
+	m_boatInput.floodMass = mass;
+	m_boatInput.floodCentre = localCentre;
+	PublishBoatInput();
+
+	if (mass > 0.f)
+		m_pVehicle->NeedsUpdate(IVehicle::eVUF_AwakePhysics);
+}
+
+//------------------------------------------------------------------------
+// NOTE: Called from ProcessMovement, must be thread-safe
+void CVehicleMovementStdBoat::ApplyBoatInput(const SBoatInput& input)
+{
+	if (input.hullLod != m_hullBuoyancy.GetLod())
+		m_hullBuoyancy.SetLod(input.hullLod);
+
+	m_netSnapshotProducer = input.netSnapshotProducer;
+	m_netClockOffset = input.netClockOffset;
+	if (m_netSnapshotProducer)
+		m_netSnapshot = input.netSnapshot;
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementStdBoat::UpdateSteering()
+{
+	CGameAISystem* pGameAISystem = g_pGame->GetGameAISystem();
+	if (!pGameAISystem)
+		return;
+
+	CShipSteeringManager& manager = pGameAISystem->GetShipSteeringManager();
+	CShipSteeringManager::SSteering steering;
+
+	// at most this slow, a ship nobody steers is blocked out of the flow fields until it is twice as fast again
+	const float restSpeed = 0.5f;
+
+	if (g_pGameCVars->ai_shipSteering && gEnv->bServer)
+	{
+		AABB bounds;
+		m_pEntity->GetLocalBounds(bounds);
+
+		const Vec3 pos = m_pEntity->GetWorldPos();
+		const Vec3& vel = m_physStatus[k_mainThread].v;
+		const float radius = 0.5f * max(bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y);
+
+		// Every ship registers, player and moored ones included. Under way they are given way to, at rest
+		// and without a goal the AI routes around them, moving the obstacle only once they drifted off it
+		const float wakeSpeed = (m_steeringObstacle != CShipSteeringManager::kInvalidId) ? 2.f * restSpeed : restSpeed;
+		if (m_steeringGoalValid || vel.GetLengthSquared2D() > sqr(wakeSpeed))
+		{
+			manager.RemoveObstacle(m_steeringObstacle);
+			m_steeringObstacle = CShipSteeringManager::kInvalidId;
+
+			CShipSteeringManager::SAgentState state;
+			state.pos = pos;
+			state.vel = vel;
+			state.goal = m_steeringGoal;
+			state.radius = radius;
+			state.maxSpeed = m_maxSpeed * m_factorMaxSpeed;
+			state.desiredSpeed = m_movementInput.aiRequest.HasDesiredSpeed() ? m_movementInput.aiRequest.GetDesiredSpeed() : 0.f;
+			state.hasGoal = m_steeringGoalValid;
+
+			if (m_steeringAgent == CShipSteeringManager::kInvalidId || !manager.SetAgentState(m_steeringAgent, state))
+			{
+				m_steeringAgent = manager.AddAgent();
+				manager.SetAgentState(m_steeringAgent, state);
+			}
+
+			manager.GetSteering(m_steeringAgent, steering);
+		}
+		else
+		{
+			manager.RemoveAgent(m_steeringAgent);
+			m_steeringAgent = CShipSteeringManager::kInvalidId;
+
+			if (m_steeringObstacle == CShipSteeringManager::kInvalidId || pos.GetSquaredDistance2D(m_steeringObstaclePos) > sqr(0.25f * radius))
+				m_steeringObstaclePos = pos;
+
+			if (m_steeringObstacle == CShipSteeringManager::kInvalidId || !manager.MoveObstacle(m_steeringObstacle, m_steeringObstaclePos, radius))
+				m_steeringObstacle = manager.AddObstacle(m_steeringObstaclePos, radius);
+		}
+	}
+	else
+	{
+		manager.RemoveAgent(m_steeringAgent);
+		manager.RemoveObstacle(m_steeringObstacle);
+		m_steeringAgent = CShipSteeringManager::kInvalidId;
+		m_steeringObstacle = CShipSteeringManager::kInvalidId;
+	}
+
+	SBoatInput& input = m_boatInput;
+	if (steering.valid != input.steerValid || (steering.valid && (steering.dir.Dot(input.steerDir) < 0.9999f || fabsf(steering.speedScale - input.steerSpeedScale) > 0.01f)))
+	{
+		input.steerDir = steering.dir;
+		input.steerSpeedScale = steering.speedScale;
+		input.steerValid = steering.valid;
+		PublishBoatInput();
+	}
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementStdBoat::UpdateNetStats(const float deltaTime)
+{
+	m_netStats.timer += deltaTime;
+	if (m_netStats.timer >= 1.f)
+	{
+		const float invTime = 1.f / m_netStats.timer;
+		m_netStats.sendsPerSecond = m_netStats.sends * invTime;
+		m_netStats.snapshotsSentPerSecond = m_netStats.snapshotsSent * invTime;
+		m_netStats.snapshotsPerSecond = CryInterlockedExchange(&m_netStats.snapshots, 0) * invTime;
+
+		m_netStats.sends = 0;
+		m_netStats.snapshotsSent = 0;
+		m_netStats.timer = 0.f;
+	}
+
+	CryWatch("%s [%s]: sends %.1f/s, snapshots out %.1f/s, snapshots in %.1f/s, snaps %d, clamped %d", 
+		m_pEntity->GetName(), m_netCompact ? "ship" : "legacy", m_netStats.sendsPerSecond, m_netStats.snapshotsSentPerSecond, m_netStats.snapshotsPerSecond, (int)m_netStats.snaps, (int)m_netStats.clamps);
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementStdBoat::ReportNetStats(bool reset)
+{
+	// per network mode: legacy, ship
+	int ships[2] = { 0, 0 };
+	int sends[2] = { 0, 0 };
+	float sendsPerShipPerSecond[2] = { 0.f, 0.f };
+	float snapshotsPerShipPerSecond[2] = { 0.f, 0.f };
+
+	IVehicleIteratorPtr iter = g_pGame->GetIGameFramework()->GetIVehicleSystem()->CreateVehicleIterator();
+	while (IVehicle* pVehicle = iter->Next())
+	{
+		IVehicleMovement* pMovement = pVehicle->GetMovement();
+		if (!pMovement || pMovement->GetMovementType() != IVehicleMovement::eVMT_Sea)
+			continue;
+
+		CVehicleMovementStdBoat* pBoat = static_cast<CVehicleMovementStdBoat*>(pMovement);
+		if (!pBoat->m_bNetSync)
+			continue;
+
+		SNetStats& stats = pBoat->m_netStats;
+		const int mode = pBoat->m_netCompact ? 1 : 0;
+		++ships[mode];
+		sends[mode] += stats.totalSends;
+		if (stats.totalTime > 0.f)
+		{
+			sendsPerShipPerSecond[mode] += stats.totalSends / stats.totalTime;
+			snapshotsPerShipPerSecond[mode] += stats.totalSnapshotsSent / stats.totalTime;
+		}
+
+		if (reset)
+			stats.ResetTotals();
+	}
+
+	static const char* modeNames[2] = { "legacy", "ship" };
+	for (int mode = 0; mode < 2; ++mode)
+	{
+		if (ships[mode])
+		{
+			CryLogAlways("[BoatNet] %s mode: %d ships, %d sends, %.1f sends and %.1f snapshots per ship per second", 
+				modeNames[mode], ships[mode], sends[mode], sendsPerShipPerSecond[mode] / ships[mode], snapshotsPerShipPerSecond[mode] / ships[mode]);
+		}
+	}
+
+	if (!ships[0] && !ships[1])
+		CryLogAlways("[BoatNet] No network synced boats in the level");
+}
+
 //------------------------------------------------------------------------
 void CVehicleMovementStdBoat::UpdateRunSound(const float deltaTime)
 {
@@ -424,31 +851,114 @@ void CVehicleMovementStdBoat::UpdateRunSound(const float deltaTime)
 //------------------------------------------------------------------------
 void CVehicleMovementStdBoat::UpdateSurfaceEffects(const float deltaTime)
 {
-  FUNCTION_PROFILER( GetISystem(), PROFILE_GAME );
-
   if (0 == g_pGameCVars->v_pa_surface)
   {
     ResetParticles();
     return;
   }
-  
+
+  // the work is done by CBoatEffectsManager, together with the rest of the fleet
+  m_wakeUpdatePending = true;
+}
+
+//------------------------------------------------------------------------
+bool CVehicleMovementStdBoat::BeginWakeUpdate(CBoatEffectsManager::SWakeParams& params)
+{
+  if (!m_wakeUpdatePending)
+    return false;
+
+  m_wakeUpdatePending = false;
+
   IEntity* pEntity = m_pVehicle->GetEntity();
-  const Matrix34& worldTM = pEntity->GetWorldTM();
-  
-  float distSq = worldTM.GetTranslation().GetSquaredDistance(gEnv->pRenderer->GetCamera().GetPosition());
-  if (distSq > sqr(300.f) || (distSq > sqr(50.f) && !m_pVehicle->GetGameObject()->IsProbablyVisible()))
-    return;
+  params.worldTM = pEntity->GetWorldTM();
+  params.visible = m_pVehicle->GetGameObject()->IsProbablyVisible();
+
+  AABB bounds;
+  pEntity->GetLocalBounds(bounds);
+  params.radius = bounds.IsReset() ? 0.f : bounds.GetRadius();
+
+  return true;
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementStdBoat::GatherWakeSamples(std::vector<Vec3>& positions)
+{
+  const Matrix34& worldTM = m_pVehicle->GetEntity()->GetWorldTM();
+
+  SEnvParticleStatus::TEnvEmitters::const_iterator end = m_paStats.envStats.emitters.end();
+  for (SEnvParticleStatus::TEnvEmitters::const_iterator emitterIt = m_paStats.envStats.emitters.begin(); emitterIt!=end; ++emitterIt)
+  {
+    positions.push_back(worldTM * emitterIt->quatT.t);
+  }
+
+  // the wake splash comes last
+  positions.push_back(m_pSplashPos ? m_pSplashPos->GetWorldSpaceTranslation() : worldTM.GetTranslation());
+}
+
+//------------------------------------------------------------------------
+float CVehicleMovementStdBoat::ComputeWakeEmission(const CBoatEffectsManager::SWakeParams& params, const float* waterLevels, CBoatEffectsManager::SWakeEmission* emissions)
+{
+  const SVehicleStatus& status = m_pVehicle->GetStatus();
+  const float velDot = status.vel * params.worldTM.GetColumn1();
+  const float powerNorm = min(abs(m_movementAction.power), 1.f);
+  const bool submerged = m_physStatus[k_mainThread].submergedFraction >= 0.999f;
+
+  SEnvironmentParticles* envParams = m_pPaParams->GetEnvironmentParticles();
+
+  float totalCount = 0.f;
+  const int numEmitters = params.numSamples - 1;
+  for (int i = 0; i < numEmitters; ++i)
+  {
+    const TEnvEmitter& emitter = m_paStats.envStats.emitters[i];
+    CBoatEffectsManager::SWakeEmission& emission = emissions[i];
+
+    if (emitter.layer < 0)
+      continue;
+
+    const SEnvironmentLayer& layer = envParams->GetLayer(emitter.layer);
+
+    // check if helper position is beneath water level
+    const Vec3 emitterWorldPos = params.worldTM * emitter.quatT.t;
+    if (emitterWorldPos.z <= waterLevels[i]+0.1f && !submerged)
+    {
+      emission.inWater = true;
+      emission.countScale = 1.f;
+      emission.speed = status.speed;
+
+      if (!strcmp(layer.GetName(), "spray"))
+      {
+        // slip based
+        emission.speed -= abs(velDot);
+      }
+
+      GetParticleScale(layer, emission.speed, powerNorm, emission.countScale, emission.sizeScale, emission.speedScale);
+
+      emission.countScale *= params.detail;
+      totalCount += emission.countScale;
+    }
+  }
+
+  return totalCount;
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementStdBoat::ApplyWakeEffects(const CBoatEffectsManager::SWakeParams& params, const float* waterLevels, const CBoatEffectsManager::SWakeEmission* emissions, float countThrottle)
+{
+  FUNCTION_PROFILER( GetISystem(), PROFILE_GAME );
 
+  IEntity* pEntity = m_pVehicle->GetEntity();
+  const Matrix34& worldTM = params.worldTM;
   Matrix34 worldTMInv = worldTM.GetInverted();
   const SVehicleStatus& status = m_pVehicle->GetStatus();    
-  float velDot = status.vel * worldTM.GetColumn1();  
-  float powerNorm = min(abs(m_movementAction.power), 1.f);
 
   SEnvironmentParticles* envParams = m_pPaParams->GetEnvironmentParticles();
 
-  SEnvParticleStatus::TEnvEmitters::iterator end = m_paStats.envStats.emitters.end();
-  for (SEnvParticleStatus::TEnvEmitters::iterator emitterIt = m_paStats.envStats.emitters.begin(); emitterIt!=end; ++emitterIt)  
+  const int numEmitters = params.numSamples - 1;
+  for (int i = 0; i < numEmitters; ++i)
   { 
+    TEnvEmitter* emitterIt = &m_paStats.envStats.emitters[i];
+    const CBoatEffectsManager::SWakeEmission& emission = emissions[i];
+
     if (emitterIt->layer < 0)
     {
       assert(0);
@@ -461,36 +971,9 @@ void CVehicleMovementStdBoat::UpdateSurfaceEffects(const float deltaTime)
     info.pParticleEmitter = 0;
     pEntity->GetSlotInfo(emitterIt->slot, info);        
 
-    float countScale = 1.f;
-    float sizeScale = 1.f;
-		float speedScale = 1.f;
-    float speed = 0.f;
-
-    // check if helper position is beneath water level      
-                
-    Vec3 emitterWorldPos = worldTM * emitterIt->quatT.t;
-    float waterLevel = gEnv->p3DEngine->GetWaterLevel(&emitterWorldPos);
-    int matId = 0;
-    
-    if (emitterWorldPos.z <= waterLevel+0.1f && m_physStatus[k_mainThread].submergedFraction<0.999f)
-    {
-      matId = gEnv->pPhysicalWorld->GetWaterMat();
-      speed = status.speed;
-
-      bool spray = !strcmp(layer.GetName(), "spray");        
-      
-      if (spray)
-      {
-        // slip based          
-        speed -= abs(velDot);
-      }
-
-      GetParticleScale(layer, speed, powerNorm, countScale, sizeScale, speedScale);
-    }
-    else
-    {
-      countScale = 0.f;
-    }
+    float countScale = emission.countScale * countThrottle;
+    const float waterLevel = waterLevels[i];
+    const int matId = emission.inWater ? gEnv->pPhysicalWorld->GetWaterMat() : 0;
     
     if (matId && matId != emitterIt->matId)
     {
@@ -529,13 +1012,14 @@ void CVehicleMovementStdBoat::UpdateSurfaceEffects(const float deltaTime)
     if (info.pParticleEmitter)
     {
       SpawnParams sp;
-      sp.fSizeScale = sizeScale;
+      sp.fSizeScale = emission.sizeScale;
       sp.fCountScale = countScale;    
-			sp.fSpeedScale = speedScale;
+			sp.fSpeedScale = emission.speedScale;
       info.pParticleEmitter->SetSpawnParams(sp);
 
       if (layer.alignToWater && countScale > 0.f)
       {          
+        Vec3 emitterWorldPos = worldTM * emitterIt->quatT.t;
         Vec3 worldPos(emitterWorldPos.x, emitterWorldPos.y, waterLevel+0.05f);
 
         Matrix34 localTM(emitterIt->quatT);
@@ -557,22 +1041,14 @@ void CVehicleMovementStdBoat::UpdateSurfaceEffects(const float deltaTime)
       
       pAuxGeom->DrawSphere(ppos, 0.2f, red);
       pAuxGeom->DrawCone(ppos, slotTM.GetColumn1(), 0.1f, 0.5f, red);
-      gEnv->pRenderer->Draw2dLabel(50.f, (float)(400+10*emitterIt->slot), 1.2f, color, false, "<%s> water fx: slot %i [%s], speed %.1f, sizeScale %.2f, countScale %.2f (pos %.0f,%0.f,%0.f)", pEntity->GetName(), emitterIt->slot, effect, speed, sizeScale, countScale, ppos.x, ppos.y, ppos.z);        
+      gEnv->pRenderer->Draw2dLabel(50.f, (float)(400+10*emitterIt->slot), 1.2f, color, false, "<%s> water fx: slot %i [%s], speed %.1f, sizeScale %.2f, countScale %.2f (pos %.0f,%0.f,%0.f)", pEntity->GetName(), emitterIt->slot, effect, emission.speed, emission.sizeScale, countScale, ppos.x, ppos.y, ppos.z);        
     }  
 #endif
   }
 
   // generate water splashes
-	Vec3 wakePos;
-	if(m_pSplashPos)
-	{
-		wakePos = m_pSplashPos->GetWorldSpaceTranslation();
-	}
-	else
-	{
-		wakePos = worldTM.GetTranslation();
-	}
-  float wakeWaterLevel = gEnv->p3DEngine->GetWaterLevel(&wakePos);
+	const Vec3 wakePos = m_pSplashPos ? m_pSplashPos->GetWorldSpaceTranslation() : worldTM.GetTranslation();
+  const float wakeWaterLevel = waterLevels[numEmitters];
 
   const Vec3& localW = m_localSpeed;
   if (localW.x >= 0.f)
@@ -596,6 +1072,7 @@ void CVehicleMovementStdBoat::UpdateSurfaceEffects(const float deltaTime)
       spawnParams.fSizeScale = spawnParams.fCountScale = 0.5f + 0.25f*speedRatio;
       spawnParams.fSizeScale  += 0.4f*m_waveRandomMult;
       spawnParams.fCountScale += 0.4f*Random();
+      spawnParams.fCountScale *= params.detail * countThrottle;
 
       m_wakeSlot = pEntity->LoadParticleEmitter(m_wakeSlot, m_pWaveEffect, &spawnParams);        
     }
@@ -679,7 +1156,14 @@ void CVehicleMovementStdBoat::ProcessAI(const float deltaTime)
 
 	Vec3 vMove(ZERO);
 	{
-		if (m_aiRequest.HasMoveTarget())
+		// the shared steering routes around land and other ships, forced navigation is followed as it is
+		const SBoatInput& boatInput = m_boatInputExchange.Get();
+		if (boatInput.steerValid && m_aiRequest.HasMoveTarget() && !m_aiRequest.HasForcedNavigation())
+		{
+			vMove = boatInput.steerDir;
+			inputSpeed *= boatInput.steerSpeedScale;
+		}
+		else if (m_aiRequest.HasMoveTarget())
 			vMove = ( m_aiRequest.GetMoveTarget() - m_pEntity->GetWorldPos() ).GetNormalizedSafe();
 	}
 
@@ -777,11 +1261,16 @@ void CVehicleMovementStdBoat::ProcessMovement(const float deltaTime)
   static const float fWaterLevelMaxDiff = 0.15f; // max allowed height difference between propeller center and water level
   static const float fSubmergedMin = 0.01f;
   static const float fMinSpeedForTurn = 0.5f; // min speed so that turning becomes possible
+  static const float fGravity = 9.81f;
   
   if (m_bNetSync)
     m_netActionSync.UpdateObject(this);
 
-  CryAutoCriticalSection lk(m_lock);
+  if (AcquireMovementInput())
+    m_aiRequest = m_movementInputExchange.Get().aiRequest;
+
+  if (m_boatInputExchange.Acquire())
+    ApplyBoatInput(m_boatInputExchange.Get());
 
   CVehicleMovementBase::ProcessMovement(deltaTime);
 
@@ -811,10 +1300,24 @@ void CVehicleMovementStdBoat::ProcessMovement(const float deltaTime)
   
   // check if propeller is in water
   Vec3 worldPropPos = wTM * m_pushOffset;  
-  float waterLevelWorld = gEnv->p3DEngine->GetWaterLevel( &worldPropPos );
+  float waterLevelWorld = g_pGame->GetWaterQueryCache()->GetWaterLevel(worldPropPos, CWaterQueryCache::eWQ_Vehicle);
   float fWaterLevelDiff = worldPropPos.z - waterLevelWorld;  
   
-  bool submerged = physStatus->submergedFraction > fSubmergedMin;
+  float submergedFraction = physStatus->submergedFraction;
+  if (m_useHullBuoyancy)
+    submergedFraction = max(submergedFraction, ApplyHullBuoyancy(pPhysics, *physStatus, frameTime));
+
+  const SBoatInput& boatInput = m_boatInputExchange.Get();
+  if (boatInput.floodMass > 0.f)
+  {
+    // the water inside pulls the hull down and trims it towards the flooded end, buoyancy does the rest
+    pe_action_impulse floodImp;
+    floodImp.impulse = Vec3(0.f, 0.f, -boatInput.floodMass * fGravity * frameTime);
+    floodImp.point = wTM * boatInput.floodCentre;
+    pPhysics->Action(&floodImp, 1);
+  }
+
+  bool submerged = submergedFraction > fSubmergedMin;
   m_inWater = submerged && fWaterLevelDiff < fWaterLevelMaxDiff;
     
   float speed = physStatus->v.len2() > 0.001f ? physStatus->v.len() : 0.f;    
@@ -844,14 +1347,14 @@ void CVehicleMovementStdBoat::ProcessMovement(const float deltaTime)
   waveLoc = wTM * waveLoc;
 
   bool visible = m_pVehicle->GetGameObject()->IsProbablyVisible();
-  bool doWave = visible && submerged && physStatus->submergedFraction < 0.99f;
+  bool doWave = visible && submerged && submergedFraction < 0.99f;
     
   if (doWave && !m_isEnginePowered)
     m_pVehicle->NeedsUpdate(IVehicle::eVUF_AwakePhysics);
   
   if (m_isEnginePowered || (visible && !m_pVehicle->IsProbablyDistant()))
   {
-    if (doWave && (m_isEnginePowered || g_pGameCVars->v_rockBoats))
+    if (doWave && !m_useHullBuoyancy && (m_isEnginePowered || g_pGameCVars->v_rockBoats))
     { 
       pe_action_impulse waveImp;
       waveImp.angImpulse.x = Boosting() ? 0.f : sinf(m_waveTimer) * frameTime * m_Inertia.x * kx;
@@ -869,6 +1372,21 @@ void CVehicleMovementStdBoat::ProcessMovement(const float deltaTime)
   }
   // ~wave stuff 
 
+  if (m_netCompact && m_netSnapshotValid && !m_netSnapshotProducer)
+    ApplyNetCorrection(pPhysics, *physStatus, frameTime);
+
+	// The action sync is only published from here, ships without engine power included
+	if (!m_pVehicle->GetStatus().doingNetPrediction)
+	{
+		const CNetworkMovementStdBoat netMovement(this, m_netSnapshot);
+		if (m_bNetSync && m_netActionSync.PublishActions(netMovement))
+		{
+			if (netMovement.GetSnapshotId())
+				m_netPublishedSnapshotId = netMovement.GetSnapshotId();
+			CHANGED_NETWORK_STATE(m_pVehicle, CNetworkMovementStdBoat::CONTROLLED_ASPECT );
+		}
+	}
+
 	if (!m_isEnginePowered)
 		return;
 
@@ -1007,12 +1525,6 @@ void CVehicleMovementStdBoat::ProcessMovement(const float deltaTime)
   }
 
   EjectionTest(deltaTime);
-  
-	if (!m_pVehicle->GetStatus().doingNetPrediction)
-	{
-		if (m_bNetSync && m_netActionSync.PublishActions( CNetworkMovementStdBoat(this) ))
-			CHANGED_NETWORK_STATE(m_pVehicle, CNetworkMovementStdBoat::CONTROLLED_ASPECT );
-	}
 }
 
 #if ENABLE_VEHICLE_DEBUG
@@ -1037,16 +1549,20 @@ bool CVehicleMovementStdBoat::RequestMovement(CMovementRequest& movementRequest)
 {
 	FUNCTION_PROFILER( gEnv->pSystem, PROFILE_GAME );
  
-	m_movementAction.isAI = true;
 	if (!m_isEnginePowered)
 		return false;
 
-	CryAutoCriticalSection lk(m_lock);
+	CMovementRequest& aiRequest = m_movementInput.aiRequest;
+
+	// where the AI wants to go, before it is pushed out along the direction below
+	m_steeringGoalValid = movementRequest.HasMoveTarget() && !movementRequest.HasForcedNavigation();
+	if (m_steeringGoalValid)
+		m_steeringGoal = movementRequest.GetMoveTarget();
 
 	if (movementRequest.HasLookTarget())
-		m_aiRequest.SetLookTarget(movementRequest.GetLookTarget());
+		aiRequest.SetLookTarget(movementRequest.GetLookTarget());
 	else
-		m_aiRequest.ClearLookTarget();
+		aiRequest.ClearLookTarget();
 
 	if (movementRequest.HasMoveTarget())
 	{
@@ -1055,25 +1571,27 @@ bool CVehicleMovementStdBoat::RequestMovement(CMovementRequest& movementRequest)
 		Vec3 end( movementRequest.GetMoveTarget() );
 		Vec3 pos = ( end - start ) * 100.0f;
 		pos +=start;
-		m_aiRequest.SetMoveTarget( pos );
+		aiRequest.SetMoveTarget( pos );
 	}
 	else
-		m_aiRequest.ClearMoveTarget();
+		aiRequest.ClearMoveTarget();
 
 	if (movementRequest.HasDesiredSpeed())
-		m_aiRequest.SetDesiredSpeed(movementRequest.GetDesiredSpeed());
+		aiRequest.SetDesiredSpeed(movementRequest.GetDesiredSpeed());
 	else
-		m_aiRequest.ClearDesiredSpeed();
+		aiRequest.ClearDesiredSpeed();
 
 	if (movementRequest.HasForcedNavigation())
 	{
 		Vec3 entityPos = m_pEntity->GetWorldPos();
-		m_aiRequest.SetForcedNavigation(movementRequest.GetForcedNavigation());
-		m_aiRequest.SetDesiredSpeed(movementRequest.GetForcedNavigation().GetLength());
-		m_aiRequest.SetMoveTarget(entityPos+movementRequest.GetForcedNavigation().GetNormalizedSafe()*100.0f);
+		aiRequest.SetForcedNavigation(movementRequest.GetForcedNavigation());
+		aiRequest.SetDesiredSpeed(movementRequest.GetForcedNavigation().GetLength());
+		aiRequest.SetMoveTarget(entityPos+movementRequest.GetForcedNavigation().GetNormalizedSafe()*100.0f);
 	}
 	else
-		m_aiRequest.ClearForcedNavigation();
+		aiRequest.ClearForcedNavigation();
+
+	PublishMovementInput();
 
 	return true;
 		
@@ -1087,7 +1605,24 @@ void CVehicleMovementStdBoat::Serialize(TSerialize ser, EEntityAspects aspects)
   if (ser.GetSerializationTarget() == eST_Network) 
   {
     if (m_bNetSync && aspects & CNetworkMovementStdBoat::CONTROLLED_ASPECT)
+    {
       m_netActionSync.Serialize(ser, aspects);
+
+      if (!ser.IsReading())
+      {
+        // Read after the publish on the physics step, so a snapshot is never marked as sent before the action carrying it
+        const uint8 sentSnapshotId = m_netPublishedSnapshotId;
+        if (sentSnapshotId != 0 && sentSnapshotId != m_netSentSnapshotId)
+        {
+          m_netSentSnapshotId = sentSnapshotId;
+          ++m_netStats.snapshotsSent;
+          ++m_netStats.totalSnapshotsSent;
+        }
+
+        ++m_netStats.sends;
+        ++m_netStats.totalSends;
+      }
+    }
   }
   else
   {
@@ -1101,32 +1636,58 @@ void CVehicleMovementStdBoat::Serialize(TSerialize ser, EEntityAspects aspects)
 void CVehicleMovementStdBoat::GetMemoryUsage(ICrySizer * pSizer) const
 {
 	pSizer->Add(*this);
+	m_hullBuoyancy.GetMemoryUsage(pSizer);
 	CVehicleMovementBase::GetMemoryUsageInternal(pSizer);
 }
 
 
 //------------------------------------------------------------------------
 CNetworkMovementStdBoat::CNetworkMovementStdBoat()
-: m_steer(0.0f)
-, m_pedal(0.0f)
+: m_steerValue(0.0f)
+, m_pedalValue(0.0f)
+, m_steer(0)
+, m_pedal(0)
 , m_boost(false)
+, m_compact(false)
+, m_hasSnapshot(false)
 {
 }
 
 //------------------------------------------------------------------------
-CNetworkMovementStdBoat::CNetworkMovementStdBoat(CVehicleMovementStdBoat *pMovement)
+CNetworkMovementStdBoat::CNetworkMovementStdBoat(CVehicleMovementStdBoat *pMovement, const SSnapshot& snapshot)
 {
-  m_steer = pMovement->m_movementAction.rotateYaw;
-  m_pedal = pMovement->m_movementAction.power;  
+  m_steerValue = pMovement->m_movementAction.rotateYaw;
+  m_pedalValue = pMovement->m_movementAction.power;  
   m_boost = pMovement->m_boost;
+  m_compact = pMovement->m_netCompact;
+
+  // Quantised up front, so input noise below one step does not count as a change
+  m_steer = QuantiseControl(m_steerValue);
+  m_pedal = QuantiseControl(m_pedalValue);
+  m_snapshot = snapshot;
+
+  // A snapshot is only sent until it went out once, the server relays the ones of a driving client the same way
+  m_hasSnapshot = m_compact && (snapshot.id != 0) && (snapshot.id != pMovement->m_netSentSnapshotId);
 }
 
 //------------------------------------------------------------------------
 void CNetworkMovementStdBoat::UpdateObject(CVehicleMovementStdBoat *pMovement)
 {
-  pMovement->m_movementAction.rotateYaw = m_steer;
-  pMovement->m_movementAction.power = m_pedal;  
-  pMovement->m_boost = m_boost;
+  if (m_compact)
+  {
+    pMovement->m_movementAction.rotateYaw = DequantiseControl(m_steer);
+    pMovement->m_movementAction.power = DequantiseControl(m_pedal);
+    pMovement->m_boost = m_boost;
+
+    if (m_hasSnapshot && !pMovement->m_netSnapshotProducer && (m_snapshot.id != pMovement->m_netSnapshot.id || !pMovement->m_netSnapshotValid))
+      pMovement->OnNetSnapshot(m_snapshot);
+  }
+  else
+  {
+    pMovement->m_movementAction.rotateYaw = m_steerValue;
+    pMovement->m_movementAction.power = m_pedalValue;  
+    pMovement->m_boost = m_boost;
+  }
 }
 
 //------------------------------------------------------------------------
@@ -1136,9 +1697,32 @@ void CNetworkMovementStdBoat::Serialize(TSerialize ser, EEntityAspects aspects)
   {
 		NET_PROFILE_SCOPE("NetMovementStdBoat", ser.IsReading());
 
-    ser.Value("pedal", m_pedal, 'vPed');
-    ser.Value("steer", m_steer, 'vStr');   
-    ser.Value("boost", m_boost, 'bool');
+    // The format is self describing, so peers running the legacy mode can still talk to each other
+    ser.Value("compact", m_compact, 'bool');
+
+    if (m_compact)
+    {
+      ser.Value("pedal", m_pedal, 'i8');
+      ser.Value("steer", m_steer, 'i8');
+      ser.Value("boost", m_boost, 'bool');
+
+      // Control only updates leave the snapshot out
+      ser.Value("hasSnap", m_hasSnapshot, 'bool');
+      if (m_hasSnapshot)
+      {
+        ser.Value("snapId", m_snapshot.id, 'ui8');
+        ser.Value("snapTime", m_snapshot.sendTime, 'ui16');
+        ser.Value("pos", m_snapshot.pos, 'wrld');
+        ser.Value("rot", m_snapshot.rot, 'ori1');
+        ser.Value("vel", m_snapshot.vel, 'vel0');
+      }
+    }
+    else
+    {
+      ser.Value("pedal", m_pedalValue, 'vPed');
+      ser.Value("steer", m_steerValue, 'vStr');   
+      ser.Value("boost", m_boost, 'bool');
+    }
   }
 }
 
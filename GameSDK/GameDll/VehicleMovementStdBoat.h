@@ -17,6 +17,9 @@ History:
 
 #include "VehicleMovementBase.h"
 #include "Network/NetActionSync.h"
+#include "Vehicle/VehicleHullBuoyancy.h"
+#include "Vehicle/BoatEffectsManager.h"
+#include "AI/ShipSteeringManager.h"
 
 class CVehicleMovementStdWheeled;
 class CVehicleMovementArcadeWheeled;
@@ -27,13 +30,17 @@ class CNetworkMovementStdBoat
 {
 public:
   CNetworkMovementStdBoat();
-  CNetworkMovementStdBoat(CVehicleMovementStdBoat *pMovement);
+  CNetworkMovementStdBoat(CVehicleMovementStdBoat *pMovement, const SSnapshot& snapshot);
 
   typedef CVehicleMovementStdBoat * UpdateObjectSink;
 
   bool operator == (const CNetworkMovementStdBoat &rhs)
   { 
-    return false;
+    // The legacy path republishes every update
+    if (!m_compact || !rhs.m_compact)
+      return false;
+
+    return (m_steer == rhs.m_steer) && (m_pedal == rhs.m_pedal) && (m_boost == rhs.m_boost) && (m_snapshot.id == rhs.m_snapshot.id);
   };
 
   bool operator != (const CNetworkMovementStdBoat &rhs)
@@ -43,13 +50,37 @@ public:
 
   void UpdateObject( CVehicleMovementStdBoat *pMovement );
   void Serialize(TSerialize ser, EEntityAspects aspects);
+
+  uint8 GetSnapshotId() const { return m_hasSnapshot ? m_snapshot.id : 0; }
   
   static const NetworkAspectType CONTROLLED_ASPECT = eEA_GameClientN;
 
+  // Compact mode sends the controls as signed 8 bit steps
+  static const int CONTROL_STEPS = 127;
+
+  struct SSnapshot
+  {
+    SSnapshot() : pos(ZERO), rot(IDENTITY), vel(ZERO), sendTime(0), id(0) {}
+
+    Vec3 pos;
+    Quat rot;
+    Vec3 vel;
+    uint16 sendTime;    // server clock in ms, wraps every 65 s
+    uint8 id;
+  };
+
 private:
-  float m_steer;
-  float m_pedal;  
+  static int8 QuantiseControl(float value) { return (int8)(int_round(clamp(value, -1.f, 1.f) * CONTROL_STEPS)); }
+  static float DequantiseControl(int8 value) { return (float)value * (1.f / CONTROL_STEPS); }
+
+  float m_steerValue;
+  float m_pedalValue;
+  int8  m_steer;
+  int8  m_pedal;
   bool  m_boost;      
+  bool  m_compact;
+  bool  m_hasSnapshot;
+  SSnapshot m_snapshot;
 };
 
 
@@ -79,11 +110,20 @@ public:
 	virtual void OnAction(const TVehicleActionId actionId, int activationMode, float value);
 
 	virtual void Serialize(TSerialize ser, EEntityAspects aspects);
-  virtual void SetAuthority( bool auth ) { m_netActionSync.CancelReceived(); }
+  virtual void SetAuthority( bool auth ) { m_netActionSync.CancelReceived(); m_netSnapshotValid = false; }
 
 	virtual void GetMemoryUsage(ICrySizer * pSizer) const;
   // ~IVehicleMovement
 
+  // Water taken on by a damaged ship, carried as extra weight at localCentre (vehicle space)
+  void SetFloodLoad(float mass, const Vec3& localCentre);
+
+  // Wake and spray, driven by CBoatEffectsManager once per frame for all boats that asked for it
+  bool BeginWakeUpdate(CBoatEffectsManager::SWakeParams& params);
+  void GatherWakeSamples(std::vector<Vec3>& positions);
+  float ComputeWakeEmission(const CBoatEffectsManager::SWakeParams& params, const float* waterLevels, CBoatEffectsManager::SWakeEmission* emissions);
+  void ApplyWakeEffects(const CBoatEffectsManager::SWakeParams& params, const float* waterLevels, const CBoatEffectsManager::SWakeEmission* emissions, float countThrottle);
+
   friend class CNetworkMovementStdBoat;
 
 protected:
@@ -94,6 +134,26 @@ protected:
   void Lift(bool lift);
   bool IsLifted();
 
+  // Ship network mode: the side simulating the ship (local driver, or the server for AI and empty ships)
+  // sends periodic snapshots, everybody else dead reckons towards them. The server keeps simulating
+  // client driven ships and only lets their snapshots pull it within v_boatNetMaxClientError
+  void UpdateNetSnapshot(const float deltaTime);
+  void OnNetSnapshot(const CNetworkMovementStdBoat::SSnapshot& snapshot);
+  void ApplyNetCorrection(IPhysicalEntity* pPhysics, const SVehiclePhysicsStatus& physStatus, const float frameTime);
+  void UpdateNetStats(const float deltaTime);
+  uint16 GetNetClock() const;
+
+public:
+  // Bytes per ship per second of the boats in the level, by network mode, since the last reset
+  static void ReportNetStats(bool reset);
+
+protected:
+
+  // AI ships ask the shared steering for their heading, published to ProcessAI through the boat input
+  void UpdateSteering();
+
+  float ApplyHullBuoyancy(IPhysicalEntity* pPhysics, const SVehiclePhysicsStatus& physStatus, const float frameTime);
+
 #if ENABLE_VEHICLE_DEBUG
   void DrawImpulse(const pe_action_impulse& action, const Vec3& offset=Vec3(ZERO), float scale=1, const ColorB& col=ColorB(255,0,0,255));
 #endif
@@ -140,6 +200,12 @@ protected:
   bool m_inWater;
   IVehicleHelper* m_pSplashPos;
   IParticleEffect* m_pWaveEffect;
+  bool m_wakeUpdatePending;
+
+  // multi-point hull buoyancy, replaces the fake wave impulse when the vehicle defines hull points
+  CVehicleHullBuoyancy m_hullBuoyancy;
+  bool m_useHullBuoyancy;
+
 
   float m_waveSoundPitch;
   float m_waveSoundAmount;  
@@ -148,6 +214,68 @@ protected:
   CNetActionSync<CNetworkMovementStdBoat> m_netActionSync;
   bool m_bNetSync; 
 
+  // ship network mode
+  // The bytes on the wire are not counted here, the network profiler has them under the NetMovementStdBoat scope
+  struct SNetStats
+  {
+    SNetStats() { Reset(); }
+    void Reset() { sends = snapshotsSent = snapshots = snaps = clamps = 0; timer = sendsPerSecond = snapshotsSentPerSecond = snapshotsPerSecond = 0.f; ResetTotals(); }
+    void ResetTotals() { totalSends = totalSnapshotsSent = 0; totalTime = 0.f; }
+
+    // counters of the current measuring window, main thread
+    int sends;
+    int snapshotsSent;
+    float timer;
+
+    // counted on the physics step, read on the main thread
+    volatile LONG snapshots;                            // received, reset every window
+    volatile LONG snaps;
+    volatile LONG clamps;                               // client snapshots the server limited
+
+    // rates of the last complete window
+    float sendsPerSecond;
+    float snapshotsSentPerSecond;
+    float snapshotsPerSecond;
+
+    // totals for v_boatNetReport
+    int totalSends;
+    int totalSnapshotsSent;
+    float totalTime;
+  };
+
+  CNetworkMovementStdBoat::SSnapshot m_netSnapshot;     // physics thread: last snapshot taken (producer) or received (receiver)
+  float m_netSnapshotTimer;
+  int64 m_netClockOffset;                               // physics thread, see SBoatInput
+  bool m_netCompact;
+  bool m_netSnapshotProducer;
+  bool m_netSnapshotValid;
+  volatile uint8 m_netPublishedSnapshotId;              // physics thread: snapshot carried by the published action, 0 for none
+  volatile uint8 m_netSentSnapshotId;                   // main thread: snapshot the network serialized last
+  SNetStats m_netStats;
+
+  // Boat state set on the main thread and used by the physics step
+  struct SBoatInput
+  {
+    SBoatInput() : floodMass(0.f), floodCentre(ZERO), hullLod(CVehicleHullBuoyancy::eLod_High), netSnapshotProducer(false), netClockOffset(0), steerDir(ZERO), steerSpeedScale(1.f), steerValid(false) {}
+
+    float floodMass;                                      // see CShipFlooding
+    Vec3 floodCentre;
+    CVehicleHullBuoyancy::ELod hullLod;
+    CNetworkMovementStdBoat::SSnapshot netSnapshot;       // last snapshot taken, producer only
+    bool netSnapshotProducer;
+    int64 netClockOffset;                                 // ms from the local frame start time to the server clock
+    Vec3 steerDir;                                        // see CShipSteeringManager
+    float steerSpeedScale;
+    bool steerValid;
+  };
+
+  void PublishBoatInput() { m_boatInputExchange.Publish(m_boatInput); }
+  // physics thread, takes over the hull LOD and the snapshot to send
+  void ApplyBoatInput(const SBoatInput& input);
+
+  SBoatInput m_boatInput;                                 // main thread
+  CVehicleStateExchange<SBoatInput> m_boatInputExchange;
+
 	//------------------------------------------------------------------------------
 	// AI related
 	// PID controller for speed control.	
@@ -156,6 +284,13 @@ protected:
 
 	CMovementRequest m_aiRequest;
 
+	// main thread
+	CShipSteeringManager::TAgentId m_steeringAgent;
+	CShipSteeringManager::TObstacleId m_steeringObstacle;
+	Vec3 m_steeringObstaclePos;
+	Vec3 m_steeringGoal;
+	bool m_steeringGoalValid;
+
 };
 
 #endif
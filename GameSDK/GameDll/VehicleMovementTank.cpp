@@ -119,9 +119,8 @@ void CVehicleMovementTank::OnEvent(EVehicleMovementEvent event, const SVehicleMo
 //------------------------------------------------------------------------
 void CVehicleMovementTank::OnAction(const TVehicleActionId actionId, int activationMode, float value)
 {
-	CryAutoCriticalSection netlk(m_networkLock);
-	CryAutoCriticalSection lk(m_lock);
-	CVehicleMovementBase::OnAction(actionId, activationMode, value);
+	CVehicleScopedLock netlk(m_networkLock);
+	OnActionLockFree(actionId, activationMode, value);
 }
 
 //------------------------------------------------------------------------
@@ -305,12 +304,17 @@ void CVehicleMovementTank::ProcessAI(const float deltaTime)
 }
 
 //------------------------------------------------------------------------
-void CVehicleMovementTank::Update(const float deltaTime)
+void CVehicleMovementTank::Update(const float frameTime)
 {
+	float deltaTime = frameTime;
+	if (!BeginServerUpdate(deltaTime))
+		return;
+
 	inherited::Update(deltaTime); 
 
 #if ENABLE_VEHICLE_DEBUG
-	DebugDrawMovement(deltaTime);
+	if (IsPresentationEnabled())
+		DebugDrawMovement(deltaTime);
 #endif
 }
 
@@ -58,8 +58,11 @@ History:
 #include "GameCodeCoverage/GameCodeCoverageTracker.h"
 
 #include "FireModePlugin.h"
+#include "IStatoscope.h"
+#include "Utility/LoadTimeline.h"
 
 #define LINKED_PROJ_MAP_RESERVE 24 //3 shots of 8 pellets should be plenty
+#define AMMO_POOL_MANIFEST_FILE "AmmoPools.xml"
 
 //////////////////////////////////////////////////////////////////////////
 //Zoom/Fire-modes pool allocator
@@ -230,6 +233,8 @@ void CWeaponSystem::Update(float frameTime)
 	m_tracerManager.Update(frameTime);
 	m_detonationRMIQueue.Update(frameTime);
 
+	UpdatePoolTopUp();
+
 #ifdef DEBUG_BULLET_PENETRATION
 	if (g_pGameCVars->g_bulletPenetrationDebug)
 	{
@@ -297,6 +302,7 @@ void CWeaponSystem::LoadItemParams(IItemSystem* pItemSystem)
 	MEMSTAT_CONTEXT(EMemStatContextTypes::MSC_Other, 0, "WeaponSystem: Load Item Params" );
 
 	LOADING_TIME_PROFILE_SECTION(gEnv->pSystem);
+	LOAD_TIMELINE_SCOPE("CWeaponSystem::LoadItemParams");
 	
 	int numItems = pItemSystem->GetItemParamsCount();
 
@@ -304,6 +310,40 @@ void CWeaponSystem::LoadItemParams(IItemSystem* pItemSystem)
 
 	pStorage->ClearItemParamSets();
 
+	// The files are read and parsed on worker threads first, the base files of inherited items once
+	// the items are known. The parameters are then read from them in item order on this thread
+	const int numThreads = max(g_pGameCVars->i_itemParamsLoadThreads, 0);
+	const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+
+	std::vector<string> files;
+	files.reserve(numItems);
+	for (int i = 0; i < numItems; i++)
+	{
+		if (const char* itemFile = pItemSystem->GetItemParamsDescriptionFile(pItemSystem->GetItemParamName(i)))
+			files.push_back(itemFile);
+	}
+
+	m_paramsCache.Prefetch(files, numThreads);
+
+	const CTimeValue itemsTime = gEnv->pTimer->GetAsyncTime();
+
+	files.clear();
+	for (int i = 0; i < numItems; i++)
+	{
+		const char* itemFile = pItemSystem->GetItemParamsDescriptionFile(pItemSystem->GetItemParamName(i));
+		XmlNodeRef itemRootNodeParams = itemFile ? m_paramsCache.LoadXml(itemFile) : XmlNodeRef();
+		const char* inheritItem = itemRootNodeParams ? itemRootNodeParams->getAttr("inherit") : NULL;
+		if (inheritItem && inheritItem[0] != 0)
+		{
+			if (const char* baseItemFile = pItemSystem->GetItemParamsDescriptionFile(inheritItem))
+				files.push_back(baseItemFile);
+		}
+	}
+
+	m_paramsCache.Prefetch(files, numThreads);
+
+	const CTimeValue baseTime = gEnv->pTimer->GetAsyncTime();
+
 	for(int i = 0; i < numItems; i++)
 	{
 		SLICE_AND_SLEEP();
@@ -312,11 +352,12 @@ void CWeaponSystem::LoadItemParams(IItemSystem* pItemSystem)
 		const char* itemFile = pItemSystem->GetItemParamsDescriptionFile(pItemName);
 
 		CItemSharedParams* pItemShared = pStorage->GetItemSharedParameters(pItemName, true);
-		XmlNodeRef itemRootNodeParams = m_pSystem->LoadXmlFromFile(itemFile);
+		XmlNodeRef itemRootNodeParams = m_paramsCache.LoadXml(itemFile);
 
 		if (!itemRootNodeParams)
 		{
 			// Can be NULL during PS3 game shutdown
+			m_paramsCache.Flush();
 			return;
 		}
 
@@ -343,7 +384,7 @@ void CWeaponSystem::LoadItemParams(IItemSystem* pItemSystem)
 		{
 			const char* baseItemFile = pItemSystem->GetItemParamsDescriptionFile(inheritItem);
 			overrideParamsNode = itemRootNodeParams;
-			itemRootNodeParams = gEnv->pSystem->LoadXmlFromFile(baseItemFile);
+			itemRootNodeParams = m_paramsCache.LoadXml(baseItemFile);
 			CRY_ASSERT_MESSAGE(itemRootNodeParams != NULL, "No xml found for base item params");
 
 			m_weaponAlias.AddAlias(inheritItem, pItemName);
@@ -377,7 +418,23 @@ void CWeaponSystem::LoadItemParams(IItemSystem* pItemSystem)
 		}
 	}
 
+	const CTimeValue readTime = gEnv->pTimer->GetAsyncTime();
+
+	m_paramsCache.Flush();
+
 	m_itemPackages.Load();
+
+	const CTimeValue endTime = gEnv->pTimer->GetAsyncTime();
+	CryLog("Item parameters of %d items: %.1f ms loading items (%d threads), %.1f ms loading base files, %.1f ms reading parameters, %.1f ms packages",
+		numItems, (itemsTime - startTime).GetMilliSeconds(), numThreads, (baseTime - itemsTime).GetMilliSeconds(), (readTime - baseTime).GetMilliSeconds(), (endTime - readTime).GetMilliSeconds());
+}
+
+//------------------------------------------------------------------------
+void CWeaponSystem::CookItemParams()
+{
+	m_paramsCache.Invalidate();
+
+	Reload();
 }
 
 //------------------------------------------------------------------------
@@ -405,6 +462,9 @@ void CWeaponSystem::OnLoadingStart(ILevelInfo *pLevel)
 
 	CRY_ASSERT(m_linkedProjectiles.size() == 0);
 
+	ResetPoolStats();
+	LoadPoolManifest(pLevel);
+
 #if SHARED_STRING_TRACK_LEVEL_HEAP_LEAKS
 	if (!gEnv->IsEditor())
 	{
@@ -417,11 +477,18 @@ void CWeaponSystem::OnLoadingStart(ILevelInfo *pLevel)
 void CWeaponSystem::OnLoadingComplete(ILevel *pLevel)
 {
 	CCCPOINT(WeaponSystem_OnLoadingComplete);
+
+	PrewarmPools();
 }
 
 //------------------------------------------------------------------------
 void CWeaponSystem::OnUnloadComplete(ILevel* pLevel)
 {
+	SavePoolManifest();
+
+	m_poolTargets.clear();
+	m_poolManifestFile.clear();
+
 	if (!gEnv->IsEditor())
 	{
 		for (TWeaponComponentPoolFreeFunctions::iterator poolIt = m_freePoolHandlers.begin(); poolIt != m_freePoolHandlers.end(); ++poolIt)
@@ -799,7 +866,7 @@ void CWeaponSystem::Scan(const char *folderName)
 				continue;
 
 			xmlFile = folder + "/" + fd.name;
-			XmlNodeRef rootNode = m_pSystem->LoadXmlFromFile(xmlFile.c_str());
+			XmlNodeRef rootNode = m_paramsCache.LoadXml(xmlFile.c_str());
 
 			if (!rootNode)
 			{
@@ -816,7 +883,10 @@ void CWeaponSystem::Scan(const char *folderName)
 	}
 
 	if (!m_recursing)
+	{
+		m_paramsCache.Flush();
 		CryLog("Finished loading ammo XML definitions from '%s'!", folderName);
+	}
 
 	if (!m_reloading && !m_recursing)
 		m_folders.push_back(folderName);
@@ -997,6 +1067,31 @@ uint16 CWeaponSystem::GetPoolSize(IEntityClass *pClass)
 	return it->second.size;
 }
 
+//------------------------------------------------------------------------
+bool CWeaponSystem::GrowPool(IEntityClass *pClass, SAmmoPoolDesc &desc)
+{
+	const SAmmoParams *pAmmoParams = GetAmmoParams(pClass);
+	if (!pAmmoParams || !pAmmoParams->reusable)
+		return false;
+
+	CProjectile *pProjectile = DoSpawnAmmo(pClass, false, pAmmoParams);
+	if (!pProjectile)
+		return false;
+
+	++desc.size;
+	++desc.grows;
+
+	// Freshly spawned projectiles arm their lifetime/show timers in Init, which would
+	// destroy them while they sit in the pool; ReInitFromPool() sets them again on use
+	pProjectile->GetEntity()->KillTimer(-1);
+	desc.frees.push_back(pProjectile);
+
+	pProjectile->GetEntity()->Hide(true);
+	pProjectile->GetEntity()->SetWorldTM(IDENTITY);
+
+	return true;
+}
+
 //------------------------------------------------------------------------
 CProjectile *CWeaponSystem::UseFromPool(IEntityClass *pClass, const SAmmoParams *pAmmoParams)
 {
@@ -1015,6 +1110,9 @@ CProjectile *CWeaponSystem::UseFromPool(IEntityClass *pClass, const SAmmoParams
 		CProjectile *pProjectile=desc.frees.front();
 		desc.frees.pop_front();
 
+		++desc.hits;
+		desc.highWaterMark = max(desc.highWaterMark, desc.GetNumInUse());
+
 		pProjectile->GetEntity()->Hide(false);
 		pProjectile->ReInitFromPool();
 		return pProjectile;
@@ -1023,6 +1121,18 @@ CProjectile *CWeaponSystem::UseFromPool(IEntityClass *pClass, const SAmmoParams
 	{
 		CProjectile *pProjectile=DoSpawnAmmo(pClass, false, pAmmoParams);
 		++desc.size;
+		++desc.misses;
+		++desc.grows;
+		desc.highWaterMark = max(desc.highWaterMark, desc.size);
+
+#if ENABLE_STATOSCOPE
+		if (gEnv->pStatoscope && desc.prewarmTarget)
+		{
+			CryFixedStringT<128> buffer;
+			buffer.Format("Pool miss: %s (size %d, prewarmed %d)", pClass->GetName(), (int)desc.size, (int)desc.prewarmTarget);
+			gEnv->pStatoscope->AddUserMarker("AmmoPool", buffer.c_str());
+		}
+#endif // ENABLE_STATOSCOPE
 		
 		return pProjectile;
 	}
@@ -1068,8 +1178,153 @@ void CWeaponSystem::DumpPoolSizes()
 	CryLog("Ammo Pool Statistics:");
 	for (TAmmoPoolMap::iterator it=m_pools.begin(); it!=m_pools.end(); ++it)
 	{
-		int size=it->second.size;
-		CryLog("%s: %d", it->first->GetName(), size);
+		const SAmmoPoolDesc &desc=it->second;
+		CryLog("%s: %d (free %d, prewarm %d, peak %d) hits %u misses %u grows %u", it->first->GetName(), (int)desc.size, (int)desc.frees.size(),
+			(int)desc.prewarmTarget, (int)desc.highWaterMark, desc.hits, desc.misses, desc.grows);
+	}
+}
+
+//------------------------------------------------------------------------
+void CWeaponSystem::ResetPoolStats()
+{
+	for (TAmmoPoolMap::iterator it=m_pools.begin(); it!=m_pools.end(); ++it)
+	{
+		it->second.ResetStats();
+		it->second.prewarmTarget = 0;
+	}
+}
+
+//------------------------------------------------------------------------
+// The manifest lists the peak number of simultaneously used projectiles per
+// pooled ammo class, as recorded in previous matches on the level
+void CWeaponSystem::LoadPoolManifest(ILevelInfo *pLevel)
+{
+	m_poolTargets.clear();
+	m_poolManifestFile.clear();
+
+	if (!pLevel || gEnv->IsEditor())
+		return;
+
+	m_poolManifestFile.Format("%s/%s", pLevel->GetPath(), AMMO_POOL_MANIFEST_FILE);
+
+	if (!gEnv->pCryPak->IsFileExist(m_poolManifestFile.c_str()))
+		return;
+
+	XmlNodeRef rootNode = m_pSystem->LoadXmlFromFile(m_poolManifestFile.c_str());
+	if (!rootNode)
+		return;
+
+	IEntityClassRegistry *pClassRegistry = gEnv->pEntitySystem->GetClassRegistry();
+
+	const int numPools = rootNode->getChildCount();
+	for (int i = 0; i < numPools; ++i)
+	{
+		XmlNodeRef poolNode = rootNode->getChild(i);
+
+		int peak = 0;
+		IEntityClass *pClass = pClassRegistry->FindClass(poolNode->getAttr("class"));
+		if (!pClass || !poolNode->getAttr("peak", peak) || peak <= 0)
+			continue;
+
+		// Same rule as SpawnAmmo(): only local, non net-bound projectiles are ever pooled
+		const SAmmoParams *pAmmoParams = GetAmmoParams(pClass);
+		if (!pAmmoParams || !pAmmoParams->reusable || pAmmoParams->serverSpawn ||
+			!(pAmmoParams->flags&(ENTITY_FLAG_CLIENT_ONLY|ENTITY_FLAG_SERVER_ONLY)))
+			continue;
+
+		// The recorded peak is kept as is so it survives a later save, i_ammoPoolPrewarmMax only limits the prewarm
+		m_poolTargets[pClass] = (uint16)min(peak, 0xffff);
+	}
+
+	CryLog("CWeaponSystem: loaded ammo pool manifest '%s' (%d classes)", m_poolManifestFile.c_str(), (int)m_poolTargets.size());
+}
+
+//------------------------------------------------------------------------
+void CWeaponSystem::SavePoolManifest()
+{
+	if (!g_pGameCVars->i_ammoPoolRecordManifest || m_poolManifestFile.empty())
+		return;
+
+	// Keep the largest peak seen so far, so the manifest converges over several matches
+	TAmmoPoolTargets peaks = m_poolTargets;
+	for (TAmmoPoolMap::iterator it=m_pools.begin(); it!=m_pools.end(); ++it)
+	{
+		uint16 &peak = peaks[it->first];
+		peak = max(peak, it->second.highWaterMark);
+	}
+
+	XmlNodeRef rootNode = gEnv->pSystem->CreateXmlNode("AmmoPools");
+	for (TAmmoPoolTargets::iterator it=peaks.begin(); it!=peaks.end(); ++it)
+	{
+		if (it->second == 0)
+			continue;
+
+		XmlNodeRef poolNode = rootNode->newChild("Pool");
+		poolNode->setAttr("class", it->first->GetName());
+		poolNode->setAttr("peak", (int)it->second);
+	}
+
+	if (rootNode->saveToFile(m_poolManifestFile.c_str()))
+	{
+		CryLog("CWeaponSystem: saved ammo pool manifest '%s'", m_poolManifestFile.c_str());
+	}
+	else
+	{
+		GameWarning("CWeaponSystem: failed to save ammo pool manifest '%s'", m_poolManifestFile.c_str());
+	}
+}
+
+//------------------------------------------------------------------------
+void CWeaponSystem::PrewarmPools()
+{
+	if (m_poolTargets.empty())
+		return;
+
+	LOADING_TIME_PROFILE_SECTION(gEnv->pSystem);
+
+	const int maxPoolSize = max(g_pGameCVars->i_ammoPoolPrewarmMax, 0);
+
+	for (TAmmoPoolTargets::iterator it=m_poolTargets.begin(); it!=m_poolTargets.end(); ++it)
+	{
+		IEntityClass *pClass = it->first;
+
+		CreatePool(pClass);
+		SAmmoPoolDesc &desc = m_pools.find(pClass)->second;
+		desc.prewarmTarget = (uint16)min((int)it->second, maxPoolSize);
+
+		while (desc.size < desc.prewarmTarget)
+		{
+			if (!GrowPool(pClass, desc))
+				break;
+		}
+	}
+
+	// Only count growth that happens during the match itself
+	for (TAmmoPoolMap::iterator it=m_pools.begin(); it!=m_pools.end(); ++it)
+	{
+		it->second.grows = 0;
+	}
+}
+
+//------------------------------------------------------------------------
+// Pooled projectiles removed by the entity system (e.g. net or serialisation
+// clean-up) are replaced a few at a time between frames
+void CWeaponSystem::UpdatePoolTopUp()
+{
+	int budget = g_pGameCVars->i_ammoPoolTopUpPerFrame;
+
+	for (TAmmoPoolMap::iterator it=m_pools.begin(); (budget > 0) && (it!=m_pools.end()); ++it)
+	{
+		SAmmoPoolDesc &desc = it->second;
+		while ((budget > 0) && (desc.size < desc.prewarmTarget))
+		{
+			--budget;
+			if (!GrowPool(it->first, desc))
+			{
+				desc.prewarmTarget = desc.size;
+				break;
+			}
+		}
 	}
 }
 
@@ -1096,6 +1351,7 @@ void CWeaponSystem::GetMemoryStatistics(ICrySizer * s)
 	//s->AddObject(m_projectileregistry);
 	s->AddContainer(m_folders);
 	s->AddContainer(m_queryResults);
+	m_paramsCache.GetMemoryUsage(s);
 
 	{
 		SIZER_SUBCOMPONENT_NAME(s, "AmmoParams");
@@ -32,6 +32,7 @@ History:
 #include "WeaponAlias.h"
 #include "FireModePluginParams.h"
 #include "GameTypeInfo.h"
+#include "ItemParamsCache.h"
 
 class CGame;
 class CProjectile;
@@ -125,10 +126,25 @@ class CWeaponSystem : public ILevelSystemListener
 
 	struct SAmmoPoolDesc
 	{
-		SAmmoPoolDesc(): size(0) {};
+		SAmmoPoolDesc()
+			: size(0)
+			, prewarmTarget(0)
+			, highWaterMark(0)
+			, hits(0)
+			, misses(0)
+			, grows(0)
+		{};
 		void GetMemoryUsage( ICrySizer *pSizer ) const; 		
+		void ResetStats() { highWaterMark = 0; hits = 0; misses = 0; grows = 0; }
+		uint16 GetNumInUse() const { return size - (uint16)frees.size(); }
+
 		std::deque<CProjectile *>	frees;
 		uint16										size;
+		uint16										prewarmTarget;	// Entities the level manifest expects this pool to need
+		uint16										highWaterMark;	// Peak number of entities in use at once
+		uint32										hits;						// Requests served from the free list
+		uint32										misses;					// Requests that had to spawn a new entity
+		uint32										grows;					// Entities added to the pool (on demand or by top-up)
 	};
 
 	typedef std::map<const CGameTypeInfo*, IFireModePlugin*(*)()>				TFireModePluginCreationRegistry;
@@ -145,6 +161,7 @@ class CWeaponSystem : public ILevelSystemListener
 	typedef std::vector<IEntity*>																				TIEntityVector;
 
 	typedef VectorMap<IEntityClass *, SAmmoPoolDesc>							TAmmoPoolMap;	
+	typedef VectorMap<IEntityClass *, uint16>											TAmmoPoolTargets;
 
 public:
 	CWeaponSystem(CGame *pGame, ISystem *pSystem);
@@ -178,6 +195,9 @@ public:
 	void Reload();
 	void LoadItemParams(IItemSystem* pItemSystem);
 
+	// Parses every item and ammo file again and writes the cooked parameters
+	void CookItemParams();
+
 	// ILevelSystemListener
 	virtual void OnLevelNotFound(const char *levelName) {};
 	virtual void OnLoadingStart(ILevelInfo *pLevel);
@@ -237,6 +257,7 @@ public:
 	void RemoveFromPool(CProjectile *pProjectile);
 	void DumpPoolSizes();
 	void FreePools();
+	void PrewarmPools();
 
 	void OnResumeAfterHostMigration();
 
@@ -262,6 +283,12 @@ private:
 	void CreatePool(IEntityClass *pClass);
 	void FreePool(IEntityClass *pClass);
 	uint16 GetPoolSize(IEntityClass *pClass);
+	bool GrowPool(IEntityClass *pClass, SAmmoPoolDesc &desc);
+	void UpdatePoolTopUp();
+
+	void LoadPoolManifest(ILevelInfo *pLevel);
+	void SavePoolManifest();
+	void ResetPoolStats();
 	
 	CProjectile *DoSpawnAmmo(IEntityClass* pAmmoType, bool isRemote, const SAmmoParams *pAmmoParams);
 
@@ -290,8 +317,11 @@ private:
 	TLinkedProjectileMap	m_linkedProjectiles;
 
 	TAmmoPoolMap				m_pools;
+	TAmmoPoolTargets		m_poolTargets;
+	string							m_poolManifestFile;
 
 	TFolderList					m_folders;
+	CItemParamsCache		m_paramsCache;
 	bool								m_reloading;
 	bool								m_recursing;
 
@@ -1,24 +1,51 @@
 #include "StdAfx.h"
 #include "ship.h"
+#include "GameCVars.h"
+#include "GameRules.h"
+#include "VehicleMovementStdBoat.h"
+#include <IVehicleSystem.h>
 
 CShip::CShip()
+: m_bEnabled(false)
+, m_numTexturesReady(0)
+, m_updateWork(0)
+, m_appliedFloodMass(0.f)
+, m_appliedFloodCentre(ZERO)
 {
 }
 
 CShip::~CShip() 
 {
+	CancelTextureStream();
 }
 
 
 bool CShip::Init(IGameObject *pGameObject)
 {
+	SetGameObject(pGameObject);
 	CryLogAlways("Init");
 	return true;
 }
 
 void CShip::Update(SEntityUpdateContext &ctx, int updateSlot)
 {
+	if (m_updateWork & eUW_CannonBattery)
+	{
+		m_cannonBattery.Update(GetEntity());
 
+		if (!m_cannonBattery.NeedsUpdate())
+			CompleteWork(eUW_CannonBattery);
+	}
+
+	if (m_updateWork & eUW_TextureStream)
+	{
+		UpdateTextureStream();
+	}
+
+	if (m_updateWork & eUW_Flooding)
+	{
+		UpdateFlooding(ctx.fFrameTime);
+	}
 
 }
 
@@ -82,14 +109,30 @@ void CShip::Release()
 
 void CShip::PostInit(IGameObject *pGameObject)
 {
-	pGameObject->EnableUpdateSlot(this, 0);
-	pGameObject->EnablePostUpdates(this);
+	// no update slot here, see RegisterWork
+	PreloadTextures();
 }
 
 void CShip::FullSerialize(TSerialize ser)
 {
 }
 
+bool CShip::NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int pflags)
+{
+	if (aspect == ASPECT_FLOOD_LOAD)
+	{
+		float floodMass = m_appliedFloodMass;
+		Vec3 floodCentre = m_appliedFloodCentre;
+		ser.Value("floodMass", floodMass);
+		ser.Value("floodCentre", floodCentre);
+
+		if (ser.IsReading() && !gEnv->bServer)
+			ApplyFloodLoad(floodMass, floodCentre);
+	}
+
+	return true;
+}
+
 bool CShip::ReloadExtension( IGameObject * pGameObject, const SEntitySpawnParams &params )
 {
 	return true;
@@ -102,5 +145,218 @@ bool CShip::GetEntityPoolSignature( TSerialize signature )
 
 void CShip::OnHit(const HitInfo* hitInfo)
 {
-	CryLogAlways("Hit");
-}
\ No newline at end of file
+	// the server owns the damage, clients get the flood load through ASPECT_FLOOD_LOAD
+	if (!gEnv->bServer || !hitInfo || hitInfo->damage <= 0.f)
+		return;
+
+	if (!m_flooding.HasCompartments())
+		InitCompartments();
+
+	const Vec3 localPos = GetEntity()->GetWorldTM().GetInverted() * hitInfo->pos;
+	if (m_flooding.AddBreach(localPos, hitInfo->damage * g_pGameCVars->g_shipBreachAreaPerDamage))
+	{
+		RegisterWork(eUW_Flooding);
+	}
+}
+
+void CShip::RegisterWork(uint32 work)
+{
+	const uint32 previousWork = m_updateWork;
+	m_updateWork |= work;
+
+	if (!previousWork && m_updateWork)
+	{
+		GetGameObject()->EnableUpdateSlot(this, 0);
+	}
+}
+
+void CShip::CompleteWork(uint32 work)
+{
+	const uint32 previousWork = m_updateWork;
+	m_updateWork &= ~work;
+
+	if (previousWork && !m_updateWork)
+	{
+		GetGameObject()->DisableUpdateSlot(this, 0);
+	}
+}
+
+bool CShip::FireCannon(EntityId cannonId, const Vec3& recoilDir, const Vec3& firingPos, const Vec3& firingDir)
+{
+	if (!m_cannonBattery.Fire(cannonId, recoilDir, firingPos, firingDir))
+		return false;
+
+	RegisterWork(eUW_CannonBattery);
+	return true;
+}
+
+void CShip::PreloadTextures()
+{
+	LOADING_TIME_PROFILE_SECTION(gEnv->pSystem);
+
+	const char* textureList = "Scripts/Entities/Vessels/ShipTextures.xml";
+
+	SmartScriptTable properties;
+	IScriptTable* pScriptTable = GetEntity()->GetScriptTable();
+	if (pScriptTable && pScriptTable->GetValue("Properties", properties))
+	{
+		properties->GetValue("fileTextureList", textureList);
+	}
+
+	XmlNodeRef root = (textureList && textureList[0]) ? GetISystem()->LoadXmlFromFile(textureList) : XmlNodeRef();
+	if (!root)
+		return;
+
+	const int numEntries = root->getChildCount();
+	for (int i = 0; i < numEntries; i++)
+	{
+		XmlNodeRef entry = root->getChild(i);
+		if (!entry->isTag("entry"))
+			continue;
+
+		STextureRequest request;
+		request.name = entry->getContent();
+
+		// check attributes to modify the loading flags
+		int nNoMips = 0;
+		if (entry->getAttr("nomips", nNoMips) && nNoMips)
+			request.flags |= FT_NOMIPS;
+
+		entry->getAttr("priority", request.priority);
+
+		if (!request.name.empty())
+		{
+			m_textureRequests.push_back(request);
+		}
+	}
+
+	if (!m_textureRequests.empty())
+	{
+		// highest priority ends up at the back, entries of equal priority load in file order
+		std::reverse(m_textureRequests.begin(), m_textureRequests.end());
+		std::stable_sort(m_textureRequests.begin(), m_textureRequests.end());
+
+		m_textureStreamStart = gEnv->pTimer->GetAsyncTime();
+		RegisterWork(eUW_TextureStream);
+	}
+}
+
+void CShip::UpdateTextureStream()
+{
+	static const float fTextureStreamTimeOut = 30.0f;
+
+	// A few texture headers per frame, the texel data is streamed by the renderer
+	const int loadsPerFrame = max(1, g_pGameCVars->g_shipTexturePrefetchPerFrame);
+	for (int i = 0; i < loadsPerFrame && !m_textureRequests.empty(); ++i)
+	{
+		const STextureRequest& request = m_textureRequests.back();
+		if (ITexture* pTexture = gEnv->pRenderer->EF_LoadTexture(request.name.c_str(), request.flags))
+		{
+			m_Textures.push_back(pTexture);
+		}
+		m_textureRequests.pop_back();
+	}
+
+	// Ships closer to the camera ask for their mips first
+	const float distanceSq = GetEntity()->GetWorldPos().GetSquaredDistance(gEnv->pRenderer->GetCamera().GetPosition());
+
+	const int numTextures = m_Textures.size();
+	for (int i = m_numTexturesReady; i < numTextures; ++i)
+	{
+		ITexture* pTexture = m_Textures[i];
+		if (pTexture->IsTextureLoaded() || (pTexture->GetFlags() & FT_FAILED))
+		{
+			std::swap(m_Textures[i], m_Textures[m_numTexturesReady]);
+			++m_numTexturesReady;
+		}
+		else
+		{
+			gEnv->pRenderer->EF_PrecacheResource(pTexture, distanceSq, 0.f, 0, -1);
+		}
+	}
+
+	const float elapsed = (gEnv->pTimer->GetAsyncTime() - m_textureStreamStart).GetSeconds();
+	const bool finished = m_textureRequests.empty() && (m_numTexturesReady == numTextures);
+
+	if (finished || elapsed > fTextureStreamTimeOut)
+	{
+		CryLog("[Ship] %s: %d/%d textures streamed in %.0f ms%s", GetEntity()->GetName(), m_numTexturesReady, numTextures,
+			elapsed * 1000.f, finished ? "" : " (timed out)");
+
+		m_textureRequests.clear();
+		CompleteWork(eUW_TextureStream);
+	}
+}
+
+void CShip::CancelTextureStream()
+{
+	m_textureRequests.clear();
+
+	for (TTextureList::iterator it = m_Textures.begin(), itEnd = m_Textures.end(); it != itEnd; ++ it)
+	{
+		(*it)->Release();
+	}
+	m_Textures.clear();
+	m_numTexturesReady = 0;
+}
+
+void CShip::InitCompartments()
+{
+	const char* compartmentFile = "";
+
+	SmartScriptTable properties;
+	IScriptTable* pScriptTable = GetEntity()->GetScriptTable();
+	if (pScriptTable && pScriptTable->GetValue("Properties", properties))
+	{
+		properties->GetValue("fileCompartments", compartmentFile);
+	}
+
+	if (!m_flooding.InitFromXml(compartmentFile))
+	{
+		AABB bounds;
+		GetEntity()->GetLocalBounds(bounds);
+		if (bounds.GetVolume() > 0.f)
+		{
+			m_flooding.InitFromBounds(bounds, 4);
+		}
+	}
+}
+
+void CShip::UpdateFlooding(float frameTime)
+{
+	const bool flooding = m_flooding.Update(frameTime, GetEntity()->GetWorldTM());
+
+	// settled water keeps its load, the boat already carries it
+	if (!m_flooding.IsSettled() || m_flooding.GetFloodMass() != m_appliedFloodMass)
+	{
+		ApplyFloodLoad(m_flooding.GetFloodMass(), m_flooding.GetFloodCentre());
+		CHANGED_NETWORK_STATE(this, ASPECT_FLOOD_LOAD);
+	}
+
+	if (!flooding)
+		CompleteWork(eUW_Flooding);
+}
+
+void CShip::ApplyFloodLoad(float mass, const Vec3& centre)
+{
+	IVehicleSystem* pVehicleSystem = g_pGame->GetIGameFramework()->GetIVehicleSystem();
+	IEntity* pEntity = GetEntity();
+
+	// the ship is either the vehicle itself or mounted on it
+	Vec3 floodCentre = centre;
+	IVehicle* pVehicle = pVehicleSystem->GetVehicle(pEntity->GetId());
+	if (!pVehicle && pEntity->GetParent())
+	{
+		pVehicle = pVehicleSystem->GetVehicle(pEntity->GetParent()->GetId());
+		floodCentre = pEntity->GetLocalTM() * floodCentre;
+	}
+
+	IVehicleMovement* pMovement = pVehicle ? pVehicle->GetMovement() : NULL;
+	if (pMovement && pMovement->GetMovementType() == IVehicleMovement::eVMT_Sea)
+	{
+		static_cast<CVehicleMovementStdBoat*>(pMovement)->SetFloodLoad(mass, floodCentre);
+	}
+
+	m_appliedFloodMass = mass;
+	m_appliedFloodCentre = centre;
+}